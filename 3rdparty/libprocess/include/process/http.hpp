@@ -24,6 +24,7 @@
 #include <queue>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/functional/hash.hpp>
@@ -40,6 +41,7 @@
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
+#include <stout/result.hpp>
 #include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
@@ -332,6 +334,12 @@ public:
     // was unable to continue reading!
     Future<Nothing> readerClosed() const;
 
+    // Returns Nothing once the reader has read all the data written
+    // so far, or the read-end is closed. This lets a writer producing
+    // a large stream wait for the reader to catch up rather than
+    // buffering the whole stream in the pipe.
+    Future<Nothing> drained();
+
     // Comparison operators useful for checking connection equality.
     bool operator==(const Writer& other) const { return data == other.data; }
     bool operator!=(const Writer& other) const { return !(*this == other); }
@@ -379,6 +387,9 @@ private:
     // empty strings as they serve as a signal for end-of-file.
     std::queue<std::string> writes;
 
+    // Represents writers waiting for the unread writes to be read.
+    std::queue<Owned<Promise<Nothing>>> drains;
+
     // Signals when the read-end is closed before the write-end.
     Promise<Nothing> readerClosure;
 
@@ -697,6 +708,20 @@ std::string encode(const hashmap<std::string, std::string>& query);
 } // namespace query {
 
 
+// Parses the value of a 'Range' request header (RFC 7233) for a
+// representation of 'size' bytes. Returns the first and the last
+// byte position of the requested range (both inclusive), None if the
+// header is to be ignored because it is malformed or asks for more
+// than one range, or an Error if the range is not satisfiable, i.e.,
+// if it starts at or beyond 'size'. For example:
+//
+//   range("bytes=10-19", 100)  // (10, 19)
+//   range("bytes=90-", 100)    // (90, 99)
+//   range("bytes=-5", 100)     // (95, 99)
+//   range("bytes=100-", 100)   // Error
+Result<std::pair<size_t, size_t>> range(const std::string& value, size_t size);
+
+
 /**
  * Represents a connection to an HTTP server. Pipelining will be
  * used when there are multiple requests in-flight.
@@ -15,13 +15,21 @@
 #ifndef __PROCESS_METRICS_GAUGE_HPP__
 #define __PROCESS_METRICS_GAUGE_HPP__
 
+#include <atomic>
 #include <memory>
 #include <string>
 
+#include <process/clock.hpp>
 #include <process/defer.hpp>
+#include <process/future.hpp>
+#include <process/time.hpp>
 
 #include <process/metrics/metric.hpp>
 
+#include <stout/duration.hpp>
+#include <stout/option.hpp>
+#include <stout/synchronized.hpp>
+
 namespace process {
 namespace metrics {
 
@@ -33,22 +41,58 @@ public:
   // 'name' is the unique name for the instance of Gauge being constructed.
   // It will be the key exposed in the JSON endpoint.
   // 'f' is the deferred object called when the Metric value is requested.
+  // 'interval', if specified, is the minimum amount of time between two
+  // calls of 'f': in the meantime the last value is returned without
+  // dispatching to the owner of 'f' (see also PushGauge).
   Gauge(const std::string& name,
-        const Deferred<Future<double> (void)>& f)
+        const Deferred<Future<double> (void)>& f,
+        const Option<Duration>& interval = None())
     : Metric(name, None()),
-      data(new Data(f)) {}
+      data(new Data(f, interval)) {}
 
   virtual ~Gauge() {}
 
-  virtual Future<double> value() const { return data->f(); }
+  virtual Future<double> value() const
+  {
+    if (data->interval.isNone()) {
+      return data->f();
+    }
+
+    Future<double> sample;
+
+    synchronized (data->lock) {
+      // NOTE: A pending sample is shared rather than evaluating 'f'
+      // again, so that requests do not pile up behind a busy owner.
+      if (data->sample.isNone() ||
+          (!data->sample.get().isPending() &&
+           (!data->sample.get().isReady() ||
+            Clock::now() - data->sampled >= data->interval.get()))) {
+        data->sample = data->f();
+        data->sampled = Clock::now();
+      }
+
+      sample = data->sample.get();
+    }
+
+    return sample;
+  }
 
 private:
   struct Data
   {
-    explicit Data(const Deferred<Future<double> (void)>& _f)
-      : f(_f) {}
+    Data(const Deferred<Future<double> (void)>& _f,
+         const Option<Duration>& _interval)
+      : f(_f),
+        interval(_interval) {}
 
     const Deferred<Future<double> (void)> f;
+    const Option<Duration> interval;
+
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+
+    // The last sample of 'f' (only used with an 'interval').
+    Option<Future<double>> sample;
+    Time sampled;
   };
 
   std::shared_ptr<Data> data;
@@ -23,7 +23,9 @@
 
 namespace process {
 
-// The upper bound for the poll interval in the reaper.
+// The upper bound for the poll interval in the reaper, used when the
+// reaper cannot be notified of a process exit directly (e.g., on
+// kernels without pidfd support).
 Duration MAX_REAP_INTERVAL();
 
 // Returns the exit status of the specified process if and only if
@@ -252,8 +252,14 @@ public:
 class FileEncoder : public Encoder
 {
 public:
-  FileEncoder(const network::Socket& s, int _fd, size_t _size)
-    : Encoder(s), fd(_fd), size(_size), index(0) {}
+  // Sends the bytes of the file from 'offset' up to (excluding)
+  // '_size'.
+  FileEncoder(
+      const network::Socket& s,
+      int _fd,
+      size_t _size,
+      off_t offset = 0)
+    : Encoder(s), fd(_fd), size(_size), index(offset) {}
 
   virtual ~FileEncoder()
   {
@@ -29,6 +29,7 @@
 #include <string>
 #include <sstream>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include <process/async.hpp>
@@ -48,6 +49,8 @@
 #include <stout/nothing.hpp>
 #include <stout/numify.hpp>
 #include <stout/option.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/try.hpp>
@@ -314,6 +317,7 @@ Pipe::Writer Pipe::writer() const
 Future<string> Pipe::Reader::read()
 {
   Future<string> future;
+  queue<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::CLOSED) {
@@ -321,6 +325,11 @@ Future<string> Pipe::Reader::read()
     } else if (!data->writes.empty()) {
       future = data->writes.front();
       data->writes.pop();
+
+      // Extract the writers waiting for the pipe to be drained.
+      if (data->writes.empty()) {
+        std::swap(data->drains, drains);
+      }
     } else if (data->writeEnd == Writer::CLOSED) {
       future = ""; // End-of-file.
     } else if (data->writeEnd == Writer::FAILED) {
@@ -332,6 +341,13 @@ Future<string> Pipe::Reader::read()
     }
   }
 
+  // NOTE: We set the promises outside the critical section to avoid
+  // triggering callbacks that try to reacquire the lock.
+  while (!drains.empty()) {
+    drains.front()->set(Nothing());
+    drains.pop();
+  }
+
   return future;
 }
 
@@ -341,6 +357,7 @@ bool Pipe::Reader::close()
   bool closed = false;
   bool notify = false;
   queue<Owned<Promise<string>>> reads;
+  queue<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::OPEN) {
@@ -349,8 +366,10 @@ bool Pipe::Reader::close()
         data->writes.pop();
       }
 
-      // Extract the pending reads so we can fail them.
+      // Extract the pending reads so we can fail them, and the
+      // writers waiting for the pipe to be drained.
       std::swap(data->reads, reads);
+      std::swap(data->drains, drains);
 
       closed = true;
       data->readEnd = Reader::CLOSED;
@@ -368,6 +387,11 @@ bool Pipe::Reader::close()
       reads.pop();
     }
 
+    while (!drains.empty()) {
+      drains.front()->set(Nothing());
+      drains.pop();
+    }
+
     if (notify) {
       data->readerClosure.set(Nothing());
     }
@@ -467,6 +491,25 @@ Future<Nothing> Pipe::Writer::readerClosed() const
 }
 
 
+Future<Nothing> Pipe::Writer::drained()
+{
+  Future<Nothing> future;
+
+  synchronized (data->lock) {
+    // NOTE: The unread writes are thrown away when the read-end is
+    // closed, so the pipe is drained then as well.
+    if (data->writes.empty()) {
+      future = Nothing();
+    } else {
+      data->drains.push(Owned<Promise<Nothing>>(new Promise<Nothing>()));
+      future = data->drains.back()->future();
+    }
+  }
+
+  return future;
+}
+
+
 namespace path {
 
 Try<hashmap<string, string>> parse(const string& pattern, const string& path)
@@ -645,6 +688,78 @@ std::string encode(const hashmap<std::string, std::string>& query)
 } // namespace query {
 
 
+Result<std::pair<size_t, size_t>> range(const std::string& value, size_t size)
+{
+  const std::string unit = "bytes=";
+
+  if (!strings::startsWith(value, unit)) {
+    return None();
+  }
+
+  const std::string spec = strings::trim(value.substr(unit.size()));
+
+  // We do not serve multipart responses, which RFC 7233 permits by
+  // ignoring the header.
+  if (strings::contains(spec, ",")) {
+    return None();
+  }
+
+  const size_t dash = spec.find('-');
+  if (dash == std::string::npos) {
+    return None();
+  }
+
+  const std::string first = strings::trim(spec.substr(0, dash));
+  const std::string last = strings::trim(spec.substr(dash + 1));
+
+  const std::string digits = "0123456789";
+
+  if ((first.empty() && last.empty()) ||
+      first.find_first_not_of(digits) != std::string::npos ||
+      last.find_first_not_of(digits) != std::string::npos) {
+    return None();
+  }
+
+  if (first.empty()) {
+    // A suffix range, i.e., the last 'last' bytes.
+    Try<size_t> suffix = numify<size_t>(last);
+    if (suffix.isError()) {
+      return None();
+    }
+
+    if (suffix.get() == 0 || size == 0) {
+      return Error("Range '" + value + "' is empty");
+    }
+
+    return std::make_pair(size - std::min(suffix.get(), size), size - 1);
+  }
+
+  Try<size_t> start = numify<size_t>(first);
+  if (start.isError()) {
+    return None();
+  }
+
+  Option<size_t> end;
+  if (!last.empty()) {
+    Try<size_t> _end = numify<size_t>(last);
+    if (_end.isError() || _end.get() < start.get()) {
+      return None();
+    }
+
+    end = _end.get();
+  }
+
+  if (start.get() >= size) {
+    return Error(
+        "Range '" + value + "' starts beyond " + stringify(size) + " bytes");
+  }
+
+  return std::make_pair(
+      start.get(),
+      end.isSome() ? std::min(end.get(), size - 1) : size - 1);
+}
+
+
 ostream& operator<<(ostream& stream, const URL& url)
 {
   if (url.scheme.isSome()) {
@@ -90,6 +90,8 @@
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/thread_local.hpp>
@@ -1115,18 +1117,58 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
         VLOG(1) << "Returning '404 Not Found' for directory '" << path << "'";
         socket_manager->send(NotFound(), request, socket);
       } else {
+        // Send only the requested range of a successful response, if
+        // any (see RFC 7233).
+        size_t first = 0;
+        size_t last = s.st_size; // Exclusive.
+
+        response.headers["Accept-Ranges"] = "bytes";
+
+        Option<string> header = request.headers.get("Range");
+        if (header.isSome() && response.code == http::Status::OK) {
+          Result<pair<size_t, size_t>> range =
+            http::range(header.get(), s.st_size);
+
+          if (range.isError()) {
+            VLOG(1) << "Returning '416 Requested range not satisfiable' for"
+                    << " path '" << path << "': " << range.error();
+
+            os::close(fd);
+
+            Response unsatisfiable(
+                http::Status::REQUESTED_RANGE_NOT_SATISFIABLE);
+            unsatisfiable.headers["Content-Range"] =
+              "bytes */" + stringify(s.st_size);
+
+            socket_manager->send(unsatisfiable, request, socket);
+            return true; // All done, can process next request.
+          } else if (range.isSome()) {
+            first = range.get().first;
+            last = range.get().second + 1;
+
+            response.code = http::Status::PARTIAL_CONTENT;
+            response.status =
+              http::Status::string(http::Status::PARTIAL_CONTENT);
+            response.headers["Content-Range"] =
+              "bytes " + stringify(first) + "-" + stringify(last - 1) +
+              "/" + stringify(s.st_size);
+          }
+        }
+
         // While the user is expected to properly set a 'Content-Type'
         // header, we fill in (or overwrite) 'Content-Length' header.
         stringstream out;
-        out << s.st_size;
+        out << last - first;
         response.headers["Content-Length"] = out.str();
 
-        if (s.st_size == 0) {
+        if (last == first) {
+          os::close(fd);
           socket_manager->send(response, request, socket);
           return true; // All done, can process next request.
         }
 
-        VLOG(1) << "Sending file at '" << path << "' with length " << s.st_size;
+        VLOG(1) << "Sending file at '" << path << "' with length "
+                << last - first << " from offset " << first;
 
         // TODO(benh): Consider a way to have the socket manager turn
         // on TCP_CORK for both sends and then turn it off.
@@ -1136,7 +1178,7 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
 
         // Note the file descriptor gets closed by FileEncoder.
         socket_manager->send(
-            new FileEncoder(socket, fd, s.st_size),
+            new FileEncoder(socket, fd, last, first),
             request.keepAlive);
       }
     }
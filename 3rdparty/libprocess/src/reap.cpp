@@ -14,30 +14,53 @@
 
 #include <glog/logging.h>
 
+#include <errno.h>
+
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif // __linux__
+
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
+#include <process/io.hpp>
 #include <process/once.hpp>
 #include <process/owned.hpp>
 #include <process/reap.hpp>
 
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+#include <stout/lambda.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/os.hpp>
 #include <stout/result.hpp>
 #include <stout/try.hpp>
 
-namespace process {
+#if defined(__linux__) && !defined(__NR_pidfd_open)
+// Older headers may not define the syscall number yet; it is the same
+// on every architecture since it was added in Linux 5.3.
+#define __NR_pidfd_open 434
+#endif
+
 
+namespace process {
 
-// TODO(bmahler): This can be optimized to use a thread per pid, where
-// each thread makes a blocking call to waitpid. This eliminates the
-// unfortunate poll delay.
+// On Linux (>= 5.3) every watched pid, child or not, gets a pidfd
+// that becomes readable once the process has terminated. The pidfd is
+// polled from the event loop so an exit is noticed as soon as it
+// happens and an idle pid costs nothing. If pidfds are unavailable
+// the reaper falls back to polling 'waitpid' on the interval below.
+//
+// NOTE: We deliberately do not use a signalfd for SIGCHLD: it would
+// require SIGCHLD to be blocked in every thread, a mask which would
+// then be inherited across exec by every subprocess we launch. It
+// would also not help with pids that are not our children.
 //
 // Simple bounded linear model for computing the poll interval.
 // Values were chosen such that at (50 pids, 100 ms) the CPU usage is
@@ -71,7 +94,11 @@ public:
     // Check to see if this pid exists.
     if (os::exists(pid)) {
       Owned<Promise<Option<int> > > promise(new Promise<Option<int> >());
+      const bool watched = promises.contains(pid);
       promises.put(pid, promise);
+      if (!watched) {
+        watch(pid);
+      }
       return promise->future();
     } else {
       return None();
@@ -79,7 +106,63 @@ public:
   }
 
 protected:
-  virtual void initialize() { wait(); }
+  void watch(pid_t pid)
+  {
+#ifdef __linux__
+    if (pidfds) {
+      int fd = ::syscall(__NR_pidfd_open, pid, 0);
+      if (fd >= 0) {
+        io::poll(fd, io::READ)
+          .onAny(defer(self(), &ReaperProcess::exited, pid, fd, lambda::_1));
+        return;
+      }
+
+      if (errno == ENOSYS) {
+        VLOG(1) << "pidfd_open is not supported, "
+                << "falling back to polling for process exits";
+        pidfds = false;
+      }
+
+      // Otherwise (e.g., ESRCH because the process has already been
+      // reaped elsewhere) we let the poll loop sort it out.
+    }
+#endif // __linux__
+
+    poll(pid);
+  }
+
+  void poll(pid_t pid)
+  {
+    polled.insert(pid);
+
+    if (!polling) {
+      polling = true;
+      wait();
+    }
+  }
+
+  void exited(pid_t pid, int fd, const Future<short>& future)
+  {
+    os::close(fd);
+
+    if (!future.isReady()) {
+      LOG(WARNING) << "Failed to poll the pidfd for process " << pid << ": "
+                   << (future.isFailed() ? future.failure() : "discarded")
+                   << "; falling back to polling";
+      poll(pid);
+      return;
+    }
+
+    // The process has terminated. If it is our child it is now a
+    // zombie and we can collect its exit status, otherwise it will be
+    // (or already has been) reaped by someone else.
+    int status;
+    if (waitpid(pid, &status, WNOHANG) > 0) {
+      notify(pid, status);
+    } else {
+      notify(pid, None());
+    }
+  }
 
   void wait()
   {
@@ -93,7 +176,7 @@ protected:
     // NOTE: A child can only be reaped by us, the parent. If a child exits
     // between waitpid and the (!exists) conditional it will still exist as a
     // zombie; it will be reaped by us on the next loop.
-    foreach (pid_t pid, promises.keys()) {
+    foreach (pid_t pid, hashset<pid_t>(polled)) {
       int status;
       if (waitpid(pid, &status, WNOHANG) > 0) {
         // We have reaped a child.
@@ -104,7 +187,12 @@ protected:
       }
     }
 
-    delay(interval(), self(), &ReaperProcess::wait); // Reap forever!
+    if (polled.empty()) {
+      polling = false;
+      return;
+    }
+
+    delay(interval(), self(), &ReaperProcess::wait);
   }
 
   void notify(pid_t pid, Result<int> status)
@@ -119,12 +207,13 @@ protected:
       }
     }
     promises.remove(pid);
+    polled.erase(pid);
   }
 
 private:
   const Duration interval()
   {
-    size_t count = promises.size();
+    size_t count = polled.size();
 
     if (count <= LOW_PID_COUNT) {
       return MIN_REAP_INTERVAL();
@@ -141,6 +230,15 @@ private:
   }
 
   multihashmap<pid_t, Owned<Promise<Option<int> > > > promises;
+
+  // The pids which are watched by polling 'waitpid' rather than
+  // through a pidfd.
+  hashset<pid_t> polled;
+  bool polling = false;
+
+#ifdef __linux__
+  bool pidfds = true;
+#endif // __linux__
 };
 
 
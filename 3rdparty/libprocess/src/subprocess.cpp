@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -174,7 +175,15 @@ static int childMain(
     }
   }
 
-  os::execvpe(path.c_str(), argv, envp);
+  // A path containing a slash is not looked up in PATH, so exec it
+  // directly rather than through 'os::execvpe' which temporarily
+  // swaps 'environ'. This matters when the child was cloned with
+  // CLONE_VM and hence still shares 'environ' with the parent.
+  if (strchr(path.c_str(), '/') != NULL) {
+    ::execve(path.c_str(), argv, envp);
+  } else {
+    os::execvpe(path.c_str(), argv, envp);
+  }
 
   ABORT("Failed to os::execvpe on path '" + path + "': " + strerror(errno));
 }
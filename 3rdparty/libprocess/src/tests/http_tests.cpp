@@ -20,6 +20,7 @@
 #include <netinet/tcp.h>
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <process/address.hpp>
@@ -301,6 +302,45 @@ TEST(HTTPTest, PipeFailure)
 
 
 
+TEST(HTTPTest, PipeDrained)
+{
+  http::Pipe pipe;
+  http::Pipe::Reader reader = pipe.reader();
+  http::Pipe::Writer writer = pipe.writer();
+
+  // An empty pipe is drained.
+  EXPECT_TRUE(writer.drained().isReady());
+
+  // Data handed to a pending 'read' is not buffered in the pipe.
+  Future<string> read = reader.read();
+  EXPECT_TRUE(writer.write("hello"));
+  AWAIT_EQ("hello", read);
+  EXPECT_TRUE(writer.drained().isReady());
+
+  // The pipe is drained once all buffered writes have been read.
+  EXPECT_TRUE(writer.write("hello"));
+  EXPECT_TRUE(writer.write("world"));
+
+  Future<Nothing> drained = writer.drained();
+  EXPECT_TRUE(drained.isPending());
+
+  AWAIT_EQ("hello", reader.read());
+  EXPECT_TRUE(drained.isPending());
+
+  AWAIT_EQ("world", reader.read());
+  EXPECT_TRUE(drained.isReady());
+
+  // Closing the read end throws away the buffered writes.
+  EXPECT_TRUE(writer.write("!"));
+
+  drained = writer.drained();
+  EXPECT_TRUE(drained.isPending());
+
+  EXPECT_TRUE(reader.close());
+  EXPECT_TRUE(drained.isReady());
+}
+
+
 TEST(HTTPTest, PipeReaderCloses)
 {
   http::Pipe pipe;
@@ -432,6 +472,31 @@ http::Response validateGetWithQuery(const http::Request& request)
 }
 
 
+TEST(HTTPTest, Range)
+{
+  typedef std::pair<size_t, size_t> Range;
+
+  EXPECT_SOME_EQ(Range(10, 19), http::range("bytes=10-19", 100));
+  EXPECT_SOME_EQ(Range(90, 99), http::range("bytes=90-", 100));
+  EXPECT_SOME_EQ(Range(90, 99), http::range("bytes=90-1000", 100));
+  EXPECT_SOME_EQ(Range(95, 99), http::range("bytes=-5", 100));
+  EXPECT_SOME_EQ(Range(0, 99), http::range("bytes=-1000", 100));
+
+  // Ignored.
+  EXPECT_NONE(http::range("items=0-1", 100));
+  EXPECT_NONE(http::range("bytes=0-1,5-6", 100));
+  EXPECT_NONE(http::range("bytes=5-1", 100));
+  EXPECT_NONE(http::range("bytes=-", 100));
+  EXPECT_NONE(http::range("bytes=a-b", 100));
+  EXPECT_NONE(http::range("bytes=--1", 100));
+
+  // Not satisfiable.
+  EXPECT_ERROR(http::range("bytes=100-", 100));
+  EXPECT_ERROR(http::range("bytes=-0", 100));
+  EXPECT_ERROR(http::range("bytes=-5", 0));
+}
+
+
 TEST(HTTPTest, Get)
 {
   Http http;
@@ -31,6 +31,7 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
 #include <process/metrics/timer.hpp>
 
 namespace http = process::http;
@@ -42,6 +43,7 @@ using http::Response;
 
 using metrics::Counter;
 using metrics::Gauge;
+using metrics::PushGauge;
 using metrics::Timer;
 
 using process::Clock;
@@ -58,11 +60,19 @@ using std::string;
 class GaugeProcess : public Process<GaugeProcess>
 {
 public:
+  GaugeProcess() : calls(0) {}
+
   double get()
   {
     return 42.0;
   }
 
+  // Returns the number of times it has been called.
+  double count()
+  {
+    return ++calls;
+  }
+
   Future<double> fail()
   {
     return Failure("failure");
@@ -72,6 +82,9 @@ public:
   {
     return Future<double>();
   }
+
+private:
+  int calls;
 };
 
 
@@ -132,6 +145,68 @@ TEST(MetricsTest, Gauge)
 }
 
 
+TEST(MetricsTest, SampledGauge)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  GaugeProcess process;
+  PID<GaugeProcess> pid = spawn(&process);
+  ASSERT_TRUE(pid);
+
+  Clock::pause();
+
+  Gauge gauge("test/gauge", defer(pid, &GaugeProcess::count), Seconds(10));
+
+  AWAIT_READY(metrics::add(gauge));
+
+  AWAIT_EXPECT_EQ(1.0, gauge.value());
+
+  // The gauge is not evaluated again within the interval.
+  Clock::advance(Seconds(5));
+  AWAIT_EXPECT_EQ(1.0, gauge.value());
+
+  Clock::advance(Seconds(5));
+  AWAIT_EXPECT_EQ(2.0, gauge.value());
+  AWAIT_EXPECT_EQ(2.0, gauge.value());
+
+  AWAIT_READY(metrics::remove(gauge));
+
+  Clock::resume();
+
+  terminate(process);
+  wait(process);
+}
+
+
+TEST(MetricsTest, PushGauge)
+{
+  PushGauge gauge("test/gauge");
+
+  AWAIT_READY(metrics::add(gauge));
+
+  AWAIT_EXPECT_EQ(0.0, gauge.value());
+
+  ++gauge;
+  AWAIT_EXPECT_EQ(1.0, gauge.value());
+
+  gauge += 42;
+  AWAIT_EXPECT_EQ(43.0, gauge.value());
+
+  --gauge;
+  AWAIT_EXPECT_EQ(42.0, gauge.value());
+
+  gauge -= 0.5;
+  AWAIT_EXPECT_EQ(41.5, gauge.value());
+
+  gauge = 42;
+  AWAIT_EXPECT_EQ(42.0, gauge.value());
+
+  EXPECT_NONE(gauge.statistics());
+
+  AWAIT_READY(metrics::remove(gauge));
+}
+
+
 TEST(MetricsTest, Statistics)
 {
   Counter counter("test/counter", process::TIME_SERIES_WINDOW);
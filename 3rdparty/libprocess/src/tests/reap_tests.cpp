@@ -17,9 +17,13 @@
 
 #include <sys/wait.h>
 
+#include <iostream>
+#include <list>
+
 #include <gtest/gtest.h>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/dispatch.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -29,6 +33,7 @@
 #include <stout/gtest.hpp>
 #include <stout/os/fork.hpp>
 #include <stout/os/pstree.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/try.hpp>
 
 using process::Clock;
@@ -39,6 +44,10 @@ using os::Exec;
 using os::Fork;
 using os::ProcessTree;
 
+using std::cout;
+using std::endl;
+using std::list;
+
 using testing::_;
 using testing::DoDefault;
 
@@ -193,3 +202,44 @@ TEST(ReapTest, TerminatedChildProcess)
 
   Clock::resume();
 }
+
+
+// Measures how long it takes to reap a large number of short-lived
+// child processes. Without an event-driven reaper each exit would
+// only be noticed on the next poll of 'waitpid'.
+TEST(ReapTest, Reap_BENCHMARK_ShortLivedProcesses)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  const size_t count = 2000;
+
+  list<Future<Option<int> > > statuses;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < count; i++) {
+    pid_t pid = ::fork();
+    ASSERT_NE(-1, pid);
+
+    if (pid == 0) {
+      ::_exit(0);
+    }
+
+    statuses.push_back(process::reap(pid));
+  }
+
+  Future<list<Option<int> > > reaped = process::collect(statuses);
+
+  AWAIT_READY_FOR(reaped, Seconds(60));
+
+  watch.stop();
+
+  foreach (const Option<int>& status, reaped.get()) {
+    ASSERT_SOME(status);
+    EXPECT_TRUE(WIFEXITED(status.get()));
+    EXPECT_EQ(0, WEXITSTATUS(status.get()));
+  }
+
+  cout << "Reaped " << count << " processes in " << watch.elapsed() << endl;
+}
@@ -32,6 +32,7 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
@@ -83,6 +84,15 @@ public:
   virtual process::Future<ResourceStatistics> usage(
       const ContainerID& containerId) = 0;
 
+  // Gather resource usage statistics for a batch of containers in a
+  // single pass. Containers whose statistics cannot be gathered are
+  // left out of the result. Isolators that can share work between
+  // containers (e.g., reading a cgroup hierarchy or the process
+  // table once) should override this; the default implementation
+  // calls usage() for each of the containers.
+  virtual process::Future<hashmap<ContainerID, ResourceStatistics>>
+    batchUsage(const hashset<ContainerID>& containerIds);
+
   // Clean up a terminated container. This is called after the
   // executor and all processes in the container have terminated.
   virtual process::Future<Nothing> cleanup(
@@ -16,17 +16,24 @@
 * limitations under the License
 */
 
+#include <dirent.h>
 #include <unistd.h>
 
 #include <sys/stat.h>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif // __linux__
+
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <boost/shared_array.hpp>
 
+#include <process/defer.hpp>
 #include <process/deferred.hpp> // TODO(benh): This is required by Clang.
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -36,6 +43,7 @@
 #include <process/mime.hpp>
 #include <process/process.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
@@ -66,17 +74,74 @@ using process::http::BadRequest;
 using process::http::InternalServerError;
 using process::http::NotFound;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Response;
 using process::http::Request;
 
 using std::list;
 using std::map;
+using std::pair;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 
 namespace mesos {
 namespace internal {
 
+// How long a request that follows a file waits for the file to grow
+// by default, respectively at most.
+static const Duration DEFAULT_FOLLOW_TIMEOUT = Seconds(30);
+static const Duration MAX_FOLLOW_TIMEOUT = Minutes(5);
+
+// How many directory entries are written to a listing's response at
+// a time, before other requests are served. The next batch is only
+// written once the client has read the previous one, so that a slow
+// client does not make us buffer the whole listing.
+static const size_t BROWSE_BATCH_SIZE = 1024;
+
+
+// A directory listing that is streamed in batches (see
+// FilesProcess::_browse()).
+struct Listing
+{
+  explicit Listing(const Pipe::Writer& _writer)
+    : dir(NULL), index(0), count(0), stat(true), writer(_writer) {}
+
+  ~Listing()
+  {
+    if (dir != NULL) {
+      closedir(dir);
+    }
+  }
+
+  // The virtual and the resolved path of the directory.
+  string path;
+  string resolved;
+
+  // Set while enumerating unsorted, in which case the cursor is the
+  // position in the directory stream after the last entry.
+  DIR* dir;
+
+  // Set when sorting, in which case the cursor is the name of the
+  // last entry. Holds the names and types (see 'readdir') of all
+  // entries.
+  Option<vector<pair<string, unsigned char>>> names;
+  size_t index;
+
+  // Number of entries written so far, and at most, if paginated.
+  size_t count;
+  Option<size_t> limit;
+
+  // Whether to stat entries for the full file info.
+  bool stat;
+
+  Option<string> cursor;
+  Option<string> jsonp;
+
+  Pipe::Writer writer;
+};
+
+
 class FilesProcess : public Process<FilesProcess>
 {
 public:
@@ -88,6 +153,7 @@ public:
 
 protected:
   virtual void initialize();
+  virtual void finalize();
 
 private:
   // Resolves the virtual path to an actual path.
@@ -106,10 +172,64 @@ private:
   // in the path (see files::jsonFileInfo for the format).
   Future<Response> browse(const Request& request);
 
+  // Writes the next batch of entries of the listing.
+  void _browse(const shared_ptr<Listing>& listing);
+
   // Reads data from a file at a given offset and for a given length.
   // See the jquery pailer for the expected behavior.
   Future<Response> read(const Request& request);
 
+  // Serves the raw bytes of the file (see 'format=raw').
+  Future<Response> _read(
+      const Request& request,
+      const string& path,
+      bool follow,
+      const Duration& timeout);
+
+  // Waits for the file to grow beyond 'size' (or for 'timeout') and
+  // then serves the request again, this time without following.
+  Future<Response> follow(
+      const Request& request,
+      const string& path,
+      off_t size,
+      const Duration& timeout);
+
+  // Returns a future that becomes ready once the file at 'path' has
+  // grown beyond 'size', was moved or removed, or after 'timeout'.
+  Future<Nothing> grown(
+      const string& path,
+      off_t size,
+      const Duration& timeout);
+
+#ifdef __linux__
+  // A request waiting for a file to grow (see grown()).
+  struct Follower
+  {
+    string path;
+    off_t size;
+    shared_ptr<Promise<Nothing>> promise;
+  };
+
+  // Handles the events of all watches, then waits for more.
+  void notified();
+
+  // Satisfies the followers of the watch whose file has grown, or
+  // all of them if the file is 'gone'. Removes the watch once it has
+  // no more followers.
+  void check(int wd, bool gone);
+
+  // Removes the follower once it is satisfied or timed out.
+  void unfollow(int wd, const shared_ptr<Promise<Nothing>>& promise);
+
+  // A single inotify instance is shared by all followers, since the
+  // number of instances per user is limited (128 by default) while
+  // the number of watches is not as tight. Followers are keyed by the
+  // watch descriptor, which is the same for all paths of a file.
+  Option<int> inotify;
+  Future<short> polling;
+  hashmap<int, list<Follower>> followers;
+#endif // __linux__
+
   // Returns the raw file contents for a given path.
   // Requests have the following parameters:
   //   path: The directory to browse. Required.
@@ -164,6 +284,23 @@ void FilesProcess::initialize()
 }
 
 
+void FilesProcess::finalize()
+{
+#ifdef __linux__
+  if (inotify.isSome()) {
+    polling.discard();
+    os::close(inotify.get());
+  }
+
+  foreachvalue (const list<Follower>& _followers, followers) {
+    foreach (const Follower& follower, _followers) {
+      follower.promise->discard();
+    }
+  }
+#endif // __linux__
+}
+
+
 Future<Nothing> FilesProcess::attach(const string& path, const string& name)
 {
   Result<string> result = os::realpath(path);
@@ -209,7 +346,20 @@ const string FilesProcess::BROWSE_HELP = HELP(
         "",
         "Query parameters:",
         "",
-        ">        path=VALUE          The path of directory to browse."));
+        ">        path=VALUE          The path of directory to browse.",
+        ">        limit=VALUE         Maximum number of entries to list.",
+        ">                            The response is then an object with",
+        ">                            the 'entries' and, unless the listing",
+        ">                            is complete, a 'cursor' to continue.",
+        ">        cursor=VALUE        Continues a listing after the entry",
+        ">                            the cursor was returned with.",
+        ">        sort=VALUE          'true' to sort entries by name,",
+        ">                            which reads all names up front,",
+        ">                            'false' (default) to list them in",
+        ">                            directory order.",
+        ">        stat=VALUE          'true' (default) for the full file",
+        ">                            info, 'false' for only 'path' and",
+        ">                            'type' (without stat'ing entries)."));
 
 
 Future<Response> FilesProcess::browse(const Request& request)
@@ -220,6 +370,36 @@ Future<Response> FilesProcess::browse(const Request& request)
     return BadRequest("Expecting 'path=value' in query.\n");
   }
 
+  Pipe pipe;
+
+  shared_ptr<Listing> listing(new Listing(pipe.writer()));
+  listing->path = path.get();
+  listing->jsonp = request.url.query.get("jsonp");
+
+  if (request.url.query.get("limit").isSome()) {
+    Try<size_t> result = numify<size_t>(request.url.query.get("limit").get());
+
+    if (result.isError()) {
+      return BadRequest("Failed to parse limit: " + result.error() + ".\n");
+    }
+
+    listing->limit = result.get();
+  }
+
+  Option<string> sort = request.url.query.get("sort");
+  if (sort.isSome() && sort.get() != "true" && sort.get() != "false") {
+    return BadRequest("Expecting 'sort=true' or 'sort=false' in query.\n");
+  }
+
+  Option<string> stat = request.url.query.get("stat");
+  if (stat.isSome() && stat.get() != "true" && stat.get() != "false") {
+    return BadRequest("Expecting 'stat=true' or 'stat=false' in query.\n");
+  }
+
+  listing->stat = stat.isNone() || stat.get() == "true";
+
+  Option<string> cursor = request.url.query.get("cursor");
+
   Result<string> resolvedPath = resolve(path.get());
 
   if (resolvedPath.isError()) {
@@ -228,35 +408,198 @@ Future<Response> FilesProcess::browse(const Request& request)
     return NotFound();
   }
 
-  // The result will be a sorted (on path) array of files and dirs:
-  // [{"name": "README", "path": "dir/README" "dir":False, "size":42}, ...]
-  map<string, JSON::Object> files;
-  Try<list<string> > entries = os::ls(resolvedPath.get());
-  if (entries.isSome()) {
-    foreach (const string& entry, entries.get()) {
+  listing->resolved = resolvedPath.get();
+
+  // Like a failing 'ls', a directory that cannot be opened (e.g.,
+  // because it is a file) yields an empty listing.
+  listing->dir = opendir(resolvedPath.get().c_str());
+
+  if (listing->dir == NULL) {
+    // Nothing to list.
+  } else if (sort.isNone() || sort.get() == "false") {
+    if (cursor.isSome()) {
+      Try<long> position = numify<long>(cursor.get());
+      if (position.isError()) {
+        return BadRequest(
+            "Failed to parse cursor: " + position.error() + ".\n");
+      }
+
+      seekdir(listing->dir, position.get());
+    }
+  } else {
+    // Sorting needs all names, but we still only stat the entries
+    // of the requested page.
+    vector<pair<string, unsigned char>> names;
+
+    struct dirent* entry;
+    while ((entry = readdir(listing->dir)) != NULL) {
+      if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+        names.push_back(std::make_pair(entry->d_name, entry->d_type));
+      }
+    }
+
+    closedir(listing->dir);
+    listing->dir = NULL;
+
+    std::sort(names.begin(), names.end());
+
+    if (cursor.isSome()) {
+      // The first entry named after the cursor (the types of
+      // entries with the same name are irrelevant).
+      listing->index = std::upper_bound(
+          names.begin(),
+          names.end(),
+          std::make_pair(cursor.get(), (unsigned char) 255)) - names.begin();
+    }
+
+    listing->names = names;
+  }
+
+  OK response;
+  response.type = Response::PIPE;
+  response.reader = pipe.reader();
+  response.headers["Content-Type"] =
+    listing->jsonp.isSome() ? "text/javascript" : "application/json";
+
+  string header;
+  if (listing->jsonp.isSome()) {
+    header += listing->jsonp.get() + "(";
+  }
+
+  header += listing->limit.isSome() ? "{\"entries\":[" : "[";
+
+  listing->writer.write(header);
+
+  dispatch(self(), &FilesProcess::_browse, listing);
+
+  return response;
+}
+
+
+void FilesProcess::_browse(const shared_ptr<Listing>& listing)
+{
+  string chunk;
+  bool done = false;
+
+  for (size_t i = 0; i < BROWSE_BATCH_SIZE; i++) {
+    if (listing->limit.isSome() && listing->count >= listing->limit.get()) {
+      done = true;
+      break;
+    }
+
+    string name;
+    unsigned char type;
+
+    if (listing->names.isSome()) {
+      if (listing->index >= listing->names.get().size()) {
+        done = true;
+        break;
+      }
+
+      name = listing->names.get()[listing->index].first;
+      type = listing->names.get()[listing->index].second;
+      listing->index++;
+    } else if (listing->dir != NULL) {
+      struct dirent* entry = readdir(listing->dir);
+      if (entry == NULL) {
+        done = true;
+        break;
+      }
+
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        continue;
+      }
+
+      name = entry->d_name;
+      type = entry->d_type;
+    } else {
+      done = true;
+      break;
+    }
+
+    JSON::Object file;
+
+    if (listing->stat) {
       struct stat s;
-      string fullPath = path::join(resolvedPath.get(), entry);
+      string fullPath = path::join(listing->resolved, name);
 
-      if (stat(fullPath.c_str(), &s) < 0) {
+      if (::stat(fullPath.c_str(), &s) < 0) {
         PLOG(WARNING) << "Found " << fullPath << " in ls but stat failed";
         continue;
       }
 
-      files[fullPath] = jsonFileInfo(path::join(path.get(), entry), s);
+      file = jsonFileInfo(path::join(listing->path, name), s);
+    } else {
+      file.values["path"] = path::join(listing->path, name);
+
+      // The type is omitted if the file system does not report it.
+      switch (type) {
+        case DT_DIR:  file.values["type"] = "d"; break;
+        case DT_LNK:  file.values["type"] = "l"; break;
+        case DT_CHR:  file.values["type"] = "c"; break;
+        case DT_BLK:  file.values["type"] = "b"; break;
+        case DT_FIFO: file.values["type"] = "p"; break;
+        case DT_SOCK: file.values["type"] = "s"; break;
+        case DT_REG:  file.values["type"] = "-"; break;
+        default: break;
+      }
     }
+
+    if (listing->count > 0) {
+      chunk += ",";
+    }
+
+    chunk += stringify(file);
+
+    listing->count++;
+
+    listing->cursor = listing->names.isSome()
+      ? name
+      : stringify(telldir(listing->dir));
   }
 
-  JSON::Array listing;
-  foreachvalue (const JSON::Object& file, files) {
-    listing.values.push_back(file);
+  if (done) {
+    if (listing->limit.isSome()) {
+      chunk += "]";
+
+      // There may be more entries if the page is full (and not
+      // sorted, in which case we know).
+      bool more = listing->count >= listing->limit.get() &&
+        (listing->names.isNone() ||
+         listing->index < listing->names.get().size());
+
+      if (more && listing->cursor.isSome()) {
+        chunk += ",\"cursor\":" +
+          stringify(JSON::String(listing->cursor.get()));
+      }
+
+      chunk += "}";
+    } else {
+      chunk += "]";
+    }
+
+    if (listing->jsonp.isSome()) {
+      chunk += ");";
+    }
   }
 
-  return OK(listing, request.url.query.get("jsonp"));
+  // Stop listing if the client went away.
+  if (!chunk.empty() && !listing->writer.write(chunk)) {
+    return;
+  }
+
+  if (done) {
+    listing->writer.close();
+    return;
+  }
+
+  listing->writer.drained()
+    .onAny(defer(self(), &FilesProcess::_browse, listing));
 }
 
 
 // TODO(benh): Remove 'const &' from size after fixing libprocess.
-Future<Response> _read(int fd,
+Future<Response> __read(int fd,
                        const size_t& size,
                        off_t offset,
                        const boost::shared_array<char>& data,
@@ -282,7 +625,17 @@ const string FilesProcess::READ_HELP = HELP(
         ">        path=VALUE          The path of directory to browse.",
         ">        offset=VALUE        Value added to base address to obtain "
         "a second address",
-        ">        length=VALUE        Length of file to read."));
+        ">        length=VALUE        Length of file to read.",
+        ">        format=VALUE        'json' (default) or 'raw'. With 'raw',",
+        ">                            the bytes of the file are returned as",
+        ">                            they are, and a 'Range' header is used",
+        ">                            instead of 'offset' and 'length'.",
+        ">        follow=VALUE        If 'true' and there is nothing to read",
+        ">                            at the requested offset (respectively",
+        ">                            range), waits for the file to grow.",
+        ">        timeout=VALUE       How long to follow the file, e.g.,",
+        ">                            '10secs' (default: 30secs, at most",
+        ">                            5mins)."));
 
 
 Future<Response> FilesProcess::read(const Request& request)
@@ -318,6 +671,37 @@ Future<Response> FilesProcess::read(const Request& request)
     length = result.get();
   }
 
+  bool raw = false;
+
+  Option<string> format = request.url.query.get("format");
+  if (format.isSome() && format.get() == "raw") {
+    if (request.url.query.contains("offset") ||
+        request.url.query.contains("length")) {
+      return BadRequest(
+          "Expecting a 'Range' header instead of 'offset' and 'length' "
+          "with 'format=raw'.\n");
+    }
+
+    raw = true;
+  } else if (format.isSome() && format.get() != "json") {
+    return BadRequest("Unknown format '" + format.get() + "'.\n");
+  }
+
+  const bool follow = request.url.query.get("follow") == Option<string>("true");
+
+  Duration timeout = DEFAULT_FOLLOW_TIMEOUT;
+
+  if (request.url.query.get("timeout").isSome()) {
+    Try<Duration> result =
+      Duration::parse(request.url.query.get("timeout").get());
+
+    if (result.isError()) {
+      return BadRequest("Failed to parse timeout: " + result.error() + ".\n");
+    }
+
+    timeout = std::min(result.get(), MAX_FOLLOW_TIMEOUT);
+  }
+
   Result<string> resolvedPath = resolve(path.get());
 
   if (resolvedPath.isError()) {
@@ -331,6 +715,10 @@ Future<Response> FilesProcess::read(const Request& request)
     return BadRequest("Cannot read a directory.\n");
   }
 
+  if (raw) {
+    return _read(request, resolvedPath.get(), follow, timeout);
+  }
+
   // TODO(benh): Cache file descriptors so we aren't constantly
   // opening them and paging the data in from disk.
   Try<int> fd = os::open(resolvedPath.get(), O_RDONLY | O_CLOEXEC);
@@ -366,6 +754,14 @@ Future<Response> FilesProcess::read(const Request& request)
   if (offset >= size) {
     os::close(fd.get());
 
+    if (follow) {
+      // Pin the offset, which otherwise defaults to the (new) size.
+      Request _request = request;
+      _request.url.query["offset"] = stringify(offset);
+
+      return this->follow(_request, resolvedPath.get(), size, timeout);
+    }
+
     JSON::Object object;
     object.values["offset"] = size;
     object.values["data"] = "";
@@ -395,7 +791,7 @@ Future<Response> FilesProcess::read(const Request& request)
 
   return io::read(fd.get(), data.get(), static_cast<size_t>(length))
     .then(lambda::bind(
-        _read,
+        __read,
         fd.get(),
         lambda::_1,
         offset,
@@ -405,12 +801,261 @@ Future<Response> FilesProcess::read(const Request& request)
 }
 
 
+Future<Response> FilesProcess::_read(
+    const Request& request,
+    const string& path,
+    bool follow,
+    const Duration& timeout)
+{
+  // Only a range that starts at or beyond the end of the file can be
+  // followed (see http::range()).
+  Option<string> range = request.headers.get("Range");
+  if (follow && range.isSome()) {
+    Try<Bytes> size = os::stat::size(path);
+    if (size.isError()) {
+      string error = strings::format("Failed to stat file at '%s': %s",
+          path, size.error()).get();
+      LOG(WARNING) << error;
+      return InternalServerError(error + ".\n");
+    }
+
+    if (http::range(range.get(), size.get().bytes()).isError()) {
+      return this->follow(request, path, size.get().bytes(), timeout);
+    }
+  }
+
+  // Let libprocess 'sendfile' the (requested range of the) file
+  // instead of copying it through a JSON string.
+  OK response;
+  response.type = response.PATH;
+  response.path = path;
+  response.headers["Content-Type"] = "application/octet-stream";
+
+  return response;
+}
+
+
+// Returns a future that becomes ready after a little while, at most
+// after 'timeout', after which a follower serves whatever is there
+// and the client polls again.
+static Future<Nothing> later(const Duration& timeout)
+{
+  return Future<Nothing>()
+    .after(std::min(timeout, Duration(Seconds(1))),
+           [](const Future<Nothing>&) -> Future<Nothing> {
+             return Nothing();
+           });
+}
+
+
+Future<Nothing> FilesProcess::grown(
+    const string& path,
+    off_t size,
+    const Duration& timeout)
+{
+#ifdef __linux__
+  if (inotify.isNone()) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+      // E.g., EMFILE if the user ran out of inotify instances. We
+      // try again for the next follower.
+      PLOG(WARNING) << "Failed to initialize inotify";
+      return later(timeout);
+    }
+
+    inotify = fd;
+
+    polling = io::poll(inotify.get(), io::READ);
+    polling.onAny(defer(self(), &FilesProcess::notified));
+  }
+
+  int wd = inotify_add_watch(
+      inotify.get(),
+      path.c_str(),
+      IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+
+  if (wd < 0) {
+    // E.g., ENOSPC if the user ran out of inotify watches.
+    PLOG(WARNING) << "Failed to watch '" << path << "'";
+    return later(timeout);
+  }
+
+  Follower follower;
+  follower.path = path;
+  follower.size = size;
+  follower.promise.reset(new Promise<Nothing>());
+
+  followers[wd].push_back(follower);
+
+  // The file may have grown before we started watching it.
+  check(wd, false);
+
+  shared_ptr<Promise<Nothing>> promise = follower.promise;
+
+  return promise->future()
+    .after(timeout, [](const Future<Nothing>&) -> Future<Nothing> {
+      return Nothing();
+    })
+    .onAny(defer(self(), [=](const Future<Nothing>&) {
+      unfollow(wd, promise);
+    }));
+#else
+  return later(timeout);
+#endif // __linux__
+}
+
+
+#ifdef __linux__
+void FilesProcess::notified()
+{
+  if (polling.isDiscarded()) {
+    return;
+  } else if (polling.isFailed()) {
+    LOG(ERROR) << "Failed to poll inotify: " << polling.failure();
+
+    // Let the followers serve whatever is there and start over with
+    // a new inotify instance for the next ones.
+    foreachvalue (const list<Follower>& _followers, followers) {
+      foreach (const Follower& follower, _followers) {
+        follower.promise->set(Nothing());
+      }
+    }
+
+    followers.clear();
+    os::close(inotify.get());
+    inotify = None();
+    return;
+  }
+
+  // Collect the events first, since checking a watch may remove it.
+  hashmap<int, bool> events;
+
+  char buffer[4096]
+    __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+  while (true) {
+    ssize_t length = ::read(inotify.get(), buffer, sizeof(buffer));
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        PLOG(ERROR) << "Failed to read inotify events";
+      }
+      break;
+    }
+
+    for (char* p = buffer; p < buffer + length;) {
+      const struct inotify_event* event = (struct inotify_event*) p;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Events were lost, so we check all watches.
+        foreachkey (int wd, followers) {
+          if (!events.contains(wd)) {
+            events[wd] = false;
+          }
+        }
+      } else {
+        const bool gone =
+          (event->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED)) != 0;
+
+        events[event->wd] = events[event->wd] || gone;
+      }
+
+      p += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  foreachpair (int wd, bool gone, events) {
+    check(wd, gone);
+  }
+
+  polling = io::poll(inotify.get(), io::READ);
+  polling.onAny(defer(self(), &FilesProcess::notified));
+}
+
+
+void FilesProcess::check(int wd, bool gone)
+{
+  if (!followers.contains(wd)) {
+    return;
+  }
+
+  list<Follower>& _followers = followers[wd];
+
+  // A modification that did not grow the file, e.g., a truncation or
+  // a change of its attributes, leaves the follower waiting.
+  list<Follower>::iterator iterator = _followers.begin();
+  while (iterator != _followers.end()) {
+    Try<Bytes> current = os::stat::size(iterator->path);
+    if (gone ||
+        current.isError() ||
+        current.get().bytes() > (uint64_t) iterator->size) {
+      iterator->promise->set(Nothing());
+      iterator = _followers.erase(iterator);
+    } else {
+      ++iterator;
+    }
+  }
+
+  if (_followers.empty()) {
+    followers.erase(wd);
+
+    // The watch may already be gone, in which case this fails.
+    inotify_rm_watch(inotify.get(), wd);
+  }
+}
+
+
+void FilesProcess::unfollow(
+    int wd,
+    const shared_ptr<Promise<Nothing>>& promise)
+{
+  if (!followers.contains(wd)) {
+    return;
+  }
+
+  list<Follower>& _followers = followers[wd];
+
+  list<Follower>::iterator iterator = _followers.begin();
+  while (iterator != _followers.end()) {
+    if (iterator->promise == promise) {
+      iterator = _followers.erase(iterator);
+    } else {
+      ++iterator;
+    }
+  }
+
+  if (_followers.empty()) {
+    followers.erase(wd);
+    inotify_rm_watch(inotify.get(), wd);
+  }
+}
+#endif // __linux__
+
+
+Future<Response> FilesProcess::follow(
+    const Request& request,
+    const string& path,
+    off_t size,
+    const Duration& timeout)
+{
+  Request _request = request;
+  _request.url.query.erase("follow");
+
+  return grown(path, size, timeout)
+    .then(defer(self(), [this, _request]() {
+      return read(_request);
+    }));
+}
+
+
 const string FilesProcess::DOWNLOAD_HELP = HELP(
     TLDR(
         "Returns the raw file contents for a given path."),
     DESCRIPTION(
         "This endpoint will return the raw file contents for the",
-        "given path.",
+        "given path. A single byte range can be requested with a",
+        "'Range' header.",
         "",
         "Query parameters:",
         "",
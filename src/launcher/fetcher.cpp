@@ -16,14 +16,22 @@
  * limitations under the License.
  */
 
+#include <signal.h>
+#include <stdio.h>
+
+#include <curl/curl.h>
+
+#include <list>
 #include <string>
 
 #include <mesos/mesos.hpp>
 
 #include <mesos/fetcher/fetcher.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/json.hpp>
 #include <stout/net.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
@@ -46,6 +54,7 @@ using mesos::fetcher::FetcherInfo;
 
 using mesos::internal::slave::Fetcher;
 
+using std::list;
 using std::string;
 
 
@@ -93,6 +102,290 @@ static Try<bool> extract(
 }
 
 
+// Returns the command that extracts an archive of the type of
+// sourcePath read from its standard input into directory, or None
+// if the archive cannot be extracted this way. Zip archives keep
+// their directory at the end of the file, so they cannot be.
+static Option<string> streamingExtractCommand(
+    const string& sourcePath,
+    const string& destinationDirectory)
+{
+  // Unlike for a file, tar does not detect the compression of
+  // an archive on its standard input.
+  if (strings::endsWith(sourcePath, ".tgz") ||
+      strings::endsWith(sourcePath, ".tar.gz")) {
+    return "tar -C '" + destinationDirectory + "' -xzf -";
+  } else if (strings::endsWith(sourcePath, ".tbz2") ||
+             strings::endsWith(sourcePath, ".tar.bz2")) {
+    return "tar -C '" + destinationDirectory + "' -xjf -";
+  } else if (strings::endsWith(sourcePath, ".txz") ||
+             strings::endsWith(sourcePath, ".tar.xz")) {
+    return "tar -C '" + destinationDirectory + "' -xJf -";
+  } else if (strings::endsWith(sourcePath, ".gz")) {
+    string pathWithoutExtension = sourcePath.substr(0, sourcePath.length() - 3);
+    string filename = Path(pathWithoutExtension).basename();
+    return "gzip -dc > '" + destinationDirectory + "/" + filename + "'";
+  }
+
+  return None();
+}
+
+
+// Where the data received by downloadAndExtract() goes.
+struct Stream
+{
+  FILE* extractor;
+  Option<FILE*> file;
+  Bytes received;
+  Bytes reported;
+  Option<Bytes> length;
+};
+
+
+// How often downloadAndExtract() logs its progress.
+static const Bytes PROGRESS_INTERVAL = Megabytes(64);
+
+
+static size_t streamWrite(char* data, size_t size, size_t nmemb, void* _stream)
+{
+  Stream* stream = static_cast<Stream*>(_stream);
+
+  const size_t length = size * nmemb;
+
+  if (fwrite(data, 1, length, stream->extractor) != length) {
+    return 0; // Makes libcurl fail with CURLE_WRITE_ERROR.
+  }
+
+  if (stream->file.isSome() &&
+      fwrite(data, 1, length, stream->file.get()) != length) {
+    return 0;
+  }
+
+  stream->received += Bytes(length);
+
+  if (stream->received - stream->reported >= PROGRESS_INTERVAL) {
+    stream->reported = stream->received;
+
+    if (stream->length.isSome()) {
+      LOG(INFO) << "Downloaded and extracted " << stream->received << " of "
+                << stream->length.get();
+    } else {
+      LOG(INFO) << "Downloaded and extracted " << stream->received;
+    }
+  }
+
+  return length;
+}
+
+
+static size_t streamHeader(char* data, size_t size, size_t nmemb, void* _stream)
+{
+  Stream* stream = static_cast<Stream*>(_stream);
+
+  // Remember the length of the content, only to log progress.
+  const string header(data, size * nmemb);
+
+  if (strings::startsWith(strings::lower(header), "content-length:")) {
+    Try<uint64_t> length = numify<uint64_t>(
+        strings::trim(header.substr(strlen("content-length:"))));
+
+    if (length.isSome()) {
+      stream->length = Bytes(length.get());
+    }
+  }
+
+  return size * nmemb;
+}
+
+
+// Downloads sourceUri and extracts it into destinationDirectory while
+// it is being received, so that the archive is neither written to
+// disk nor read back (unless it also goes into the cache file at
+// cachePath). The decompressors verify the checksums embedded in
+// gzip, bzip2 and xz streams as they go, so a corrupted download
+// fails the extraction. Returns false if the archive type cannot be
+// extracted while streaming.
+static Try<bool> downloadAndExtract(
+    const string& sourceUri,
+    const string& sourcePath,
+    const string& destinationDirectory,
+    const Option<string>& cachePath = None())
+{
+  CHECK(Fetcher::isNetUri(sourceUri));
+
+  Option<string> command =
+    streamingExtractCommand(sourcePath, destinationDirectory);
+
+  if (command.isNone()) {
+    return false;
+  }
+
+  LOG(INFO) << "Downloading resource from '" << sourceUri
+            << "' and extracting it with command: " << command.get();
+
+  // Extraction failures surface as write errors rather than SIGPIPE.
+  sighandler_t pipe = signal(SIGPIPE, SIG_IGN);
+
+  Stream stream;
+  stream.extractor = popen(command.get().c_str(), "w");
+
+  if (stream.extractor == NULL) {
+    signal(SIGPIPE, pipe);
+    return ErrnoError("Failed to run command " + command.get());
+  }
+
+  if (cachePath.isSome()) {
+    stream.file = fopen(cachePath.get().c_str(), "w");
+
+    if (stream.file.get() == NULL) {
+      ErrnoError error("Failed to open '" + cachePath.get() + "'");
+      pclose(stream.extractor);
+      signal(SIGPIPE, pipe);
+      return error;
+    }
+  }
+
+  net::initialize();
+
+  CURL* curl = curl_easy_init();
+
+  if (curl == NULL) {
+    pclose(stream.extractor);
+    if (stream.file.isSome()) {
+      fclose(stream.file.get());
+    }
+    signal(SIGPIPE, pipe);
+    return Error("Failed to initialize libcurl");
+  }
+
+  curl_easy_setopt(curl, CURLOPT_URL, sourceUri.c_str());
+  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, true);
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &streamWrite);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &stream);
+  curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &streamHeader);
+  curl_easy_setopt(curl, CURLOPT_HEADERDATA, &stream);
+
+  CURLcode curlErrorCode = curl_easy_perform(curl);
+
+  long code = 0;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+  curl_easy_cleanup(curl);
+
+  int status = pclose(stream.extractor);
+
+  signal(SIGPIPE, pipe);
+
+  if (stream.file.isSome() && fclose(stream.file.get()) != 0) {
+    return ErrnoError("Failed to close '" + cachePath.get() + "'");
+  }
+
+  if (curlErrorCode != 0) {
+    return Error("Error downloading resource: " +
+                 string(curl_easy_strerror(curlErrorCode)));
+  }
+
+  // The status code for successful HTTP requests is 200, the status code
+  // for successful FTP file transfers is 226.
+  if (strings::startsWith(sourceUri, "ftp://") ||
+      strings::startsWith(sourceUri, "ftps://")) {
+    if (code != 226) {
+      return Error("Error downloading resource, received FTP return code " +
+                   stringify(code));
+    }
+  } else if (code != 200) {
+    return Error("Error downloading resource, received HTTP return code " +
+                 stringify(code));
+  }
+
+  if (status != 0) {
+    return Error("Failed to extract: command " + command.get() +
+                 " exited with status: " + stringify(status));
+  }
+
+  LOG(INFO) << "Downloaded and extracted " << stream.received << " from '"
+            << sourceUri << "' into '" << destinationDirectory << "'";
+
+  return true;
+}
+
+
+// Moves the files and directories in sourceDirectory into
+// destinationDirectory, merging them with the directories which
+// exist there already the way extracting into it would.
+static Try<Nothing> merge(
+    const string& sourceDirectory,
+    const string& destinationDirectory)
+{
+  Try<list<string>> entries = os::ls(sourceDirectory);
+  if (entries.isError()) {
+    return Error("Failed to list '" + sourceDirectory + "': " +
+                 entries.error());
+  }
+
+  foreach (const string& entry, entries.get()) {
+    const string source = path::join(sourceDirectory, entry);
+    const string destination = path::join(destinationDirectory, entry);
+
+    if (os::stat::isdir(source) && !os::stat::islink(source) &&
+        os::stat::isdir(destination) && !os::stat::islink(destination)) {
+      Try<Nothing> merged = merge(source, destination);
+      if (merged.isError()) {
+        return merged;
+      }
+
+      continue;
+    }
+
+    Try<Nothing> rename = os::rename(source, destination);
+    if (rename.isError()) {
+      return Error("Failed to move '" + source + "' to '" + destination +
+                   "': " + rename.error());
+    }
+  }
+
+  return Nothing();
+}
+
+
+// Like downloadAndExtract(), but extracts into a staging directory
+// inside destinationDirectory first. Its contents are only moved into
+// destinationDirectory once the download and the extraction succeed,
+// so that a failed fetch does not leave partial output behind.
+static Try<bool> downloadAndExtractStaged(
+    const string& sourceUri,
+    const string& sourcePath,
+    const string& destinationDirectory,
+    const Option<string>& cachePath = None())
+{
+  Try<string> staging =
+    os::mkdtemp(path::join(destinationDirectory, ".fetch.XXXXXX"));
+
+  if (staging.isError()) {
+    return Error("Failed to create extraction directory: " +
+                 staging.error());
+  }
+
+  Try<bool> extracted =
+    downloadAndExtract(sourceUri, sourcePath, staging.get(), cachePath);
+
+  if (extracted.isSome() && extracted.get()) {
+    Try<Nothing> merged = merge(staging.get(), destinationDirectory);
+    if (merged.isError()) {
+      extracted = Error("Failed to move extraction into place: " +
+                        merged.error());
+    }
+  }
+
+  Try<Nothing> rmdir = os::rmdir(staging.get());
+  if (rmdir.isError()) {
+    LOG(WARNING) << "Failed to remove extraction directory '"
+                 << staging.get() << "': " << rmdir.error();
+  }
+
+  return extracted;
+}
+
+
 // Attempt to get the uri using the hadoop client.
 static Try<string> downloadWithHadoopClient(
     const string& sourceUri,
@@ -255,6 +548,20 @@ static Try<string> fetchBypassingCache(
 
   string path = path::join(sandboxDirectory, basename.get());
 
+  // Archives from the network are extracted while being downloaded.
+  const string sourceUri = strings::trim(uri.value(), strings::PREFIX);
+
+  if (!uri.executable() && uri.extract() && Fetcher::isNetUri(sourceUri)) {
+    Try<bool> extracted =
+      downloadAndExtractStaged(sourceUri, path, sandboxDirectory);
+
+    if (extracted.isError()) {
+      return Error(extracted.error());
+    } else if (extracted.get()) {
+      return sandboxDirectory;
+    }
+  }
+
   Try<string> downloaded = download(uri.value(), path, frameworksHome);
   if (downloaded.isError()) {
     return Error(downloaded.error());
@@ -277,12 +584,111 @@ static Try<string> fetchBypassingCache(
 }
 
 
+// Copies, clones or hard links (as per 'delivery') the file or the
+// contents of the directory at sourcePath from the cache to
+// destinationPath in the sandbox.
+static Try<Nothing> deliver(
+    const string& sourcePath,
+    const string& destinationPath,
+    const FetcherInfo::Delivery& delivery)
+{
+  const string source =
+    os::stat::isdir(sourcePath) ? path::join(sourcePath, ".") : sourcePath;
+
+  string command;
+  switch (delivery) {
+    case FetcherInfo::COPY:
+      command = "cp -a";
+      break;
+    case FetcherInfo::REFLINK:
+      // Falls back to copying by itself.
+      command = "cp -a --reflink=auto";
+      break;
+    case FetcherInfo::HARDLINK:
+      command = "cp -a -l";
+      break;
+  }
+
+  command += " '" + source + "' '" + destinationPath + "'";
+
+  LOG(INFO) << "Delivering resource from cache with command: " << command;
+
+  int status = os::system(command);
+
+  if (status != 0 && delivery == FetcherInfo::HARDLINK) {
+    // E.g., the cache and the sandbox are on different file systems.
+    // Remove what has been linked already, rather than overwriting
+    // the file shared with the cache.
+    command = "cp -a --remove-destination '" + source + "' '" +
+              destinationPath + "'";
+
+    LOG(WARNING) << "Failed to hard link resource from cache, "
+                 << "copying with command: " << command;
+
+    status = os::system(command);
+  }
+
+  if (status != 0) {
+    return Error("Failed to deliver resource from cache with command '" +
+                 command + "', exit status: " + stringify(status));
+  }
+
+  return Nothing();
+}
+
+
+// Makes sure that the archive in the cache file at cachePath is
+// extracted into the cache, so that it can be delivered from there.
+// If another fetcher is done extracting the same cache file first,
+// its result is used. If sourceUri is given, the archive is also
+// downloaded into cachePath while it is being extracted. Returns
+// false if the cache file is not an archive (or, when downloading,
+// cannot be extracted while streaming).
+static Try<bool> extractIntoCache(
+    const string& cachePath,
+    const Option<string>& sourceUri = None())
+{
+  const string extractedPath = Fetcher::extractedPath(cachePath);
+
+  if (sourceUri.isNone() && os::exists(extractedPath)) {
+    return true;
+  }
+
+  Try<string> staging = os::mkdtemp(extractedPath + ".XXXXXX");
+  if (staging.isError()) {
+    return Error("Failed to create extraction directory in cache: " +
+                 staging.error());
+  }
+
+  Try<bool> extracted = sourceUri.isSome()
+    ? downloadAndExtract(sourceUri.get(), cachePath, staging.get(), cachePath)
+    : extract(cachePath, staging.get());
+
+  if (extracted.isError() || !extracted.get()) {
+    os::rmdir(staging.get());
+    return extracted;
+  }
+
+  Try<Nothing> rename = os::rename(staging.get(), extractedPath);
+  if (rename.isError()) {
+    os::rmdir(staging.get());
+
+    if (!os::exists(extractedPath)) {
+      return Error("Failed to move extraction into cache: " + rename.error());
+    }
+  }
+
+  return true;
+}
+
+
 // Returns the resulting file or in case of extraction the destination
 // directory (for logging).
 static Try<string> fetchFromCache(
     const FetcherInfo::Item& item,
     const string& cacheDirectory,
-    const string& sandboxDirectory)
+    const string& sandboxDirectory,
+    const FetcherInfo::Delivery& delivery)
 {
   LOG(INFO) << "Fetching from cache";
 
@@ -299,17 +705,38 @@ static Try<string> fetchFromCache(
   string sourcePath = path::join(cacheDirectory, item.cache_filename());
 
   if (item.uri().executable()) {
-    Try<string> copied = copyFile(sourcePath, destinationPath);
-    if (copied.isError()) {
-      return Error(copied.error());
+    if (delivery == FetcherInfo::COPY) {
+      Try<string> copied = copyFile(sourcePath, destinationPath);
+      if (copied.isError()) {
+        return Error(copied.error());
+      }
+    } else {
+      Try<Nothing> delivered = deliver(sourcePath, destinationPath, delivery);
+      if (delivered.isError()) {
+        return Error(delivered.error());
+      }
     }
 
-    return chmodExecutable(copied.get());
+    return chmodExecutable(destinationPath);
   } else if (item.uri().extract()) {
-    Try<bool> extracted = extract(sourcePath, sandboxDirectory);
+    Try<bool> extracted = delivery == FetcherInfo::COPY
+      ? extract(sourcePath, sandboxDirectory)
+      : extractIntoCache(sourcePath);
+
     if (extracted.isError()) {
       return Error(extracted.error());
     } else if (extracted.get()) {
+      if (delivery != FetcherInfo::COPY) {
+        Try<Nothing> delivered = deliver(
+            Fetcher::extractedPath(sourcePath),
+            sandboxDirectory,
+            delivery);
+
+        if (delivered.isError()) {
+          return Error(delivered.error());
+        }
+      }
+
       return sandboxDirectory;
     } else {
       LOG(WARNING) << "Copying instead of extracting resource from URI with "
@@ -318,7 +745,16 @@ static Try<string> fetchFromCache(
     }
   }
 
-  return copyFile(sourcePath, destinationPath);
+  if (delivery == FetcherInfo::COPY) {
+    return copyFile(sourcePath, destinationPath);
+  }
+
+  Try<Nothing> delivered = deliver(sourcePath, destinationPath, delivery);
+  if (delivered.isError()) {
+    return Error(delivered.error());
+  }
+
+  return destinationPath;
 }
 
 
@@ -328,7 +764,8 @@ static Try<string> fetchThroughCache(
     const FetcherInfo::Item& item,
     const Option<string>& cacheDirectory,
     const string& sandboxDirectory,
-    const Option<string>& frameworksHome)
+    const Option<string>& frameworksHome,
+    const FetcherInfo::Delivery& delivery)
 {
   if (cacheDirectory.isNone() || cacheDirectory.get().empty()) {
     return Error("Cache directory not specified");
@@ -352,17 +789,62 @@ static Try<string> fetchThroughCache(
                    cacheDirectory.get() + "': " + mkdir.error());
     }
 
-    Try<string> downloaded = download(
-        item.uri().value(),
-        path::join(cacheDirectory.get(), item.cache_filename()),
-        frameworksHome);
+    const string cachePath =
+      path::join(cacheDirectory.get(), item.cache_filename());
+
+    // Extract archives from the network while they are being
+    // downloaded into the cache, rather than reading them back.
+    // When delivering from the cache by link, they are extracted
+    // into the cache rather than into the sandbox.
+    const string sourceUri =
+      strings::trim(item.uri().value(), strings::PREFIX);
+
+    if (!item.uri().executable() &&
+        item.uri().extract() &&
+        Fetcher::isNetUri(sourceUri)) {
+      Try<bool> extracted = false;
+
+      if (delivery == FetcherInfo::COPY) {
+        Try<string> basename = Fetcher::basename(item.uri().value());
+        if (basename.isError()) {
+          return Error(basename.error());
+        }
+
+        extracted = downloadAndExtractStaged(
+            sourceUri,
+            path::join(sandboxDirectory, basename.get()),
+            sandboxDirectory,
+            cachePath);
+
+        if (extracted.isSome() && extracted.get()) {
+          return sandboxDirectory;
+        }
+      } else {
+        extracted = extractIntoCache(cachePath, sourceUri);
+      }
+
+      if (extracted.isError()) {
+        return Error(extracted.error());
+      }
+    }
+
+    if (!os::exists(cachePath)) {
+      Try<string> downloaded = download(
+          item.uri().value(),
+          cachePath,
+          frameworksHome);
 
-    if (downloaded.isError()) {
-      return Error(downloaded.error());
+      if (downloaded.isError()) {
+        return Error(downloaded.error());
+      }
     }
   }
 
-  return fetchFromCache(item, cacheDirectory.get(), sandboxDirectory);
+  return fetchFromCache(
+      item,
+      cacheDirectory.get(),
+      sandboxDirectory,
+      delivery);
 }
 
 
@@ -372,7 +854,8 @@ static Try<string> fetch(
     const FetcherInfo::Item& item,
     const Option<string>& cacheDirectory,
     const string& sandboxDirectory,
-    const Option<string>& frameworksHome)
+    const Option<string>& frameworksHome,
+    const FetcherInfo::Delivery& delivery)
 {
   LOG(INFO) << "Fetching URI '" << item.uri().value() << "'";
 
@@ -387,7 +870,8 @@ static Try<string> fetch(
       item,
       cacheDirectory,
       sandboxDirectory,
-      frameworksHome);
+      frameworksHome,
+      delivery);
 }
 
 
@@ -443,10 +927,27 @@ int main(int argc, char* argv[])
       Option<string>::some(fetcherInfo.get().frameworks_home()) :
         Option<string>::none();
 
+  FetcherInfo::Delivery delivery = fetcherInfo.get().delivery();
+
+  // Hard links share their inodes with the cache, thus chowning the
+  // sandbox below would hand the cache entries over to the user, whose
+  // tasks could then modify what the tasks of other users receive.
+  if (fetcherInfo.get().has_user() && delivery == FetcherInfo::HARDLINK) {
+    LOG(INFO) << "Copying instead of hard linking resources from cache, "
+              << "because they are fetched for user '"
+              << fetcherInfo.get().user() << "'";
+
+    delivery = FetcherInfo::COPY;
+  }
+
   // Fetch each URI to a local file, chmod, then chown if a user is provided.
   foreach (const FetcherInfo::Item& item, fetcherInfo.get().items()) {
-    Try<string> fetched =
-      fetch(item, cacheDirectory, sandboxDirectory, frameworksHome);
+    Try<string> fetched = fetch(
+        item,
+        cacheDirectory,
+        sandboxDirectory,
+        frameworksHome,
+        delivery);
     if (fetched.isError()) {
       EXIT(1) << "Failed to fetch '" << item.uri().value()
               << "': " + fetched.error();
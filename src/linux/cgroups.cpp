@@ -16,11 +16,13 @@
  * limitations under the License.
  */
 
+#include <ctype.h>
 #include <errno.h>
 #include <fts.h>
 #include <signal.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <sys/syscall.h>
@@ -1864,6 +1866,217 @@ Try<hashmap<string, uint64_t>> stat(
 }
 
 
+Try<Owned<Control>> Control::open(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control)
+{
+  Option<Error> error = verify(hierarchy, cgroup, control);
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  return open(path::join(hierarchy, cgroup, control));
+}
+
+
+Try<Owned<Control>> Control::open(const string& path)
+{
+  Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  return Owned<Control>(new Control(path, fd.get()));
+}
+
+
+Control::Control(const string& _path, int _fd)
+  : path_(_path), fd(_fd), buffer(BUFFER_SIZE), size_(0) {}
+
+
+Control::~Control()
+{
+  os::close(fd);
+}
+
+
+Try<Nothing> Control::read()
+{
+  // NOTE: Control files are generated by the kernel on each read
+  // from offset 0, so pread(2) always returns fresh contents without
+  // having to reopen or seek the file.
+  size_ = 0;
+
+  while (true) {
+    // Read until the end of the file, growing the buffer if it is full.
+    if (size_ == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+    }
+
+    ssize_t length =
+      ::pread(fd, buffer.data() + size_, buffer.size() - size_, size_);
+
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return ErrnoError("Failed to read '" + path_ + "'");
+    } else if (length == 0) {
+      return Nothing();
+    }
+
+    size_ += length;
+  }
+}
+
+
+Try<Owned<Control>> Controls::get(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control)
+{
+  Option<Owned<Control>> cached = controls.get(control);
+  if (cached.isSome()) {
+    return cached.get();
+  }
+
+  Try<Owned<Control>> open = Control::open(hierarchy, cgroup, control);
+  if (open.isError()) {
+    return Error(open.error());
+  }
+
+  controls[control] = open.get();
+
+  return open.get();
+}
+
+
+namespace internal {
+
+// A field of a flat keyed control file, e.g., 'total_rss' in
+// 'memory.stat'.
+struct Field
+{
+  const char* name;
+  Option<uint64_t>* value;
+};
+
+
+// Parses the unsigned integer in [begin, end), which may only be
+// surrounded by whitespace.
+static bool parse(const char* begin, const char* end, uint64_t* value)
+{
+  while (begin < end && isspace(*begin)) {
+    ++begin;
+  }
+
+  while (end > begin && isspace(*(end - 1))) {
+    --end;
+  }
+
+  if (begin == end) {
+    return false;
+  }
+
+  uint64_t result = 0;
+
+  for (; begin < end; ++begin) {
+    if (*begin < '0' || *begin > '9') {
+      return false;
+    }
+
+    const uint64_t digit = *begin - '0';
+
+    if (result > (UINT64_MAX - digit) / 10) {
+      return false;
+    }
+
+    result = result * 10 + digit;
+  }
+
+  *value = result;
+  return true;
+}
+
+
+// Parses the current contents of a control holding a single
+// unsigned integer, e.g., 'memory.usage_in_bytes'.
+static Try<uint64_t> parse(const Control& control)
+{
+  uint64_t value;
+  if (!parse(control.data(), control.data() + control.size(), &value)) {
+    return Error(
+        "Unexpected format in " + control.path() + ": " +
+        string(control.data(), control.size()));
+  }
+
+  return value;
+}
+
+
+// Parses the current contents of a flat keyed control, i.e., one
+// "<name> <value>" pair per line, into the given fields. Names not
+// asked for are skipped. Nothing is allocated unless the contents
+// are malformed.
+template <size_t N>
+static Try<Nothing> parse(const Control& control, const Field (&fields)[N])
+{
+  const char* data = control.data();
+  const char* end = data + control.size();
+
+  while (data < end) {
+    const char* line = data;
+    const char* eol =
+      static_cast<const char*>(memchr(line, '\n', end - line));
+
+    if (eol == NULL) {
+      eol = end;
+    }
+
+    data = eol < end ? eol + 1 : end;
+
+    // Skip empty lines.
+    const char* name = line;
+    while (name < eol && isspace(*name)) {
+      ++name;
+    }
+
+    if (name == eol) {
+      continue;
+    }
+
+    const char* separator = name;
+    while (separator < eol && !isspace(*separator)) {
+      ++separator;
+    }
+
+    // Expected line format: "%s %llu".
+    uint64_t value;
+    if (!parse(separator, eol, &value)) {
+      return Error(
+          "Unexpected line format in " + control.path() + ": " +
+          string(line, eol - line));
+    }
+
+    const size_t length = separator - name;
+
+    for (size_t i = 0; i < N; i++) {
+      if (strlen(fields[i].name) == length &&
+          memcmp(fields[i].name, name, length) == 0) {
+        *fields[i].value = value;
+        break;
+      }
+    }
+  }
+
+  return Nothing();
+}
+
+} // namespace internal {
+
+
 namespace internal {
 
 // Helper for finding the cgroup of the specified pid for the
@@ -1985,6 +2198,35 @@ Try<Nothing> cfs_quota_us(
       stringify(static_cast<int64_t>(duration.us())));
 }
 
+
+Try<Stats> stat(Control* control)
+{
+  Try<Nothing> read = control->read();
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  Stats stats;
+  Option<uint64_t> throttled_time;
+
+  const internal::Field fields[] = {
+    {"nr_periods", &stats.nr_periods},
+    {"nr_throttled", &stats.nr_throttled},
+    {"throttled_time", &throttled_time}
+  };
+
+  Try<Nothing> parse = internal::parse(*control, fields);
+  if (parse.isError()) {
+    return Error(parse.error());
+  }
+
+  if (throttled_time.isSome()) {
+    stats.throttled_time = Nanoseconds(throttled_time.get());
+  }
+
+  return stats;
+}
+
 } // namespace cpu {
 
 namespace cpuacct {
@@ -1999,27 +2241,51 @@ Try<Stats> stat(
     const string& hierarchy,
     const string& cgroup)
 {
-  const Try<hashmap<string, uint64_t>> stats =
-    cgroups::stat(hierarchy, cgroup, "cpuacct.stat");
+  Try<Owned<Control>> control =
+    Control::open(hierarchy, cgroup, "cpuacct.stat");
 
-  if (!stats.isSome()) {
-    return Error(stats.error());
+  if (control.isError()) {
+    return Error(control.error());
   }
 
-  if (!stats.get().contains("user") || !stats.get().contains("system")) {
+  return stat(control.get().get());
+}
+
+
+Try<Stats> stat(Control* control)
+{
+  Try<Nothing> read = control->read();
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  Option<uint64_t> userTicks;
+  Option<uint64_t> systemTicks;
+
+  const internal::Field fields[] = {
+    {"user", &userTicks},
+    {"system", &systemTicks}
+  };
+
+  Try<Nothing> parse = internal::parse(*control, fields);
+  if (parse.isError()) {
+    return Error(parse.error());
+  }
+
+  if (userTicks.isNone() || systemTicks.isNone()) {
     return Error("Failed to get user/system value from cpuacct.stat");
   }
 
   // Get user ticks per second. This value is constant for the lifetime of a
   // process.
   // TODO(Jojy): Move system constants to a separate compilation unit.
-  static long userTicks = sysconf(_SC_CLK_TCK);
-  if (userTicks <= 0) {
+  static long ticks = sysconf(_SC_CLK_TCK);
+  if (ticks <= 0) {
     return ErrnoError("Failed to get _SC_CLK_TCK");
   }
 
   Try<Duration> user =
-    Duration::create((double) stats.get().at("user") / userTicks);
+    Duration::create((double) userTicks.get() / ticks);
 
   if (user.isError()) {
     return Error(
@@ -2027,7 +2293,7 @@ Try<Stats> stat(
   }
 
   Try<Duration> system =
-    Duration::create((double) stats.get().at("system") / userTicks);
+    Duration::create((double) systemTicks.get() / ticks);
 
   if (system.isError()) {
     return Error(
@@ -2191,6 +2457,22 @@ Try<Bytes> memsw_usage_in_bytes(const string& hierarchy, const string& cgroup)
 }
 
 
+Try<Bytes> usage_in_bytes(Control* control)
+{
+  Try<Nothing> read = control->read();
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  Try<uint64_t> value = internal::parse(*control);
+  if (value.isError()) {
+    return Error(value.error());
+  }
+
+  return Bytes(value.get());
+}
+
+
 Try<Bytes> max_usage_in_bytes(const string& hierarchy, const string& cgroup)
 {
   Try<string> read = cgroups::read(
@@ -2204,6 +2486,37 @@ Try<Bytes> max_usage_in_bytes(const string& hierarchy, const string& cgroup)
 }
 
 
+Try<Stats> stat(Control* control)
+{
+  Try<Nothing> read = control->read();
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  Stats stats;
+
+  const internal::Field fields[] = {
+    {"cache", &stats.cache},
+    {"rss", &stats.rss},
+    {"mapped_file", &stats.mapped_file},
+    {"swap", &stats.swap},
+    {"unevictable", &stats.unevictable},
+    {"total_cache", &stats.total_cache},
+    {"total_rss", &stats.total_rss},
+    {"total_mapped_file", &stats.total_mapped_file},
+    {"total_swap", &stats.total_swap},
+    {"total_unevictable", &stats.total_unevictable}
+  };
+
+  Try<Nothing> parse = internal::parse(*control, fields);
+  if (parse.isError()) {
+    return Error(parse.error());
+  }
+
+  return stats;
+}
+
+
 namespace oom {
 
 Future<Nothing> listen(const string& hierarchy, const string& cgroup)
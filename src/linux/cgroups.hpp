@@ -29,6 +29,7 @@
 #include <sys/types.h>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
 #include <process/timeout.hpp>
 
 #include <stout/bytes.hpp>
@@ -388,6 +389,74 @@ Try<hashmap<std::string, uint64_t>> stat(
     const std::string& file);
 
 
+// A control file that is kept open so that it can be polled with a
+// single pread(2) rather than an open/read/close cycle on every call.
+// The contents are read into a buffer owned by the handle, which only
+// grows when the contents outgrow it, hence polling a control does not
+// allocate once the buffer fits. The subsystem specific
+// parsers below (e.g., cgroups::memory::stat) take a handle and
+// re-read it before parsing.
+class Control
+{
+public:
+  // Opens the given control of a cgroup. The hierarchy, cgroup and
+  // control are verified once here rather than on every read.
+  static Try<process::Owned<Control>> open(
+      const std::string& hierarchy,
+      const std::string& cgroup,
+      const std::string& control);
+
+  // Opens the control file at the given path without verifying that
+  // it belongs to a mounted hierarchy.
+  static Try<process::Owned<Control>> open(const std::string& path);
+
+  ~Control();
+
+  // Re-reads the control file from its beginning. The contents are
+  // valid until the next call to 'read'.
+  Try<Nothing> read();
+
+  const std::string& path() const { return path_; }
+  const char* data() const { return buffer.data(); }
+  size_t size() const { return size_; }
+
+private:
+  // The initial size of the buffer, which is large enough for the
+  // 'stat' controls of all supported kernels.
+  static const size_t BUFFER_SIZE = 8192;
+
+  Control(const std::string& path, int fd);
+
+  Control(const Control&) = delete;
+  Control& operator=(const Control&) = delete;
+
+  const std::string path_;
+  const int fd;
+  std::vector<char> buffer;
+  size_t size_;
+};
+
+
+// A cache of open control files of a cgroup, keyed by control name.
+// Control names are prefixed by their subsystem, so one cache can be
+// shared across the hierarchies the cgroup lives in.
+class Controls
+{
+public:
+  // Returns the handle of the given control, opening it on first use.
+  Try<process::Owned<Control>> get(
+      const std::string& hierarchy,
+      const std::string& cgroup,
+      const std::string& control);
+
+  // Closes all the cached controls, e.g., before the cgroup is removed.
+  void clear() { controls.clear(); }
+
+private:
+  hashmap<std::string, process::Owned<Control>> controls;
+};
+
+
 // Cpu controls.
 namespace cpu {
 
@@ -429,6 +498,21 @@ Try<Nothing> cfs_quota_us(
     const std::string& cgroup,
     const Duration& duration);
 
+
+// Encapsulates the 'stat' information exposed by the cpu subsystem
+// when CFS bandwidth control is enabled.
+struct Stats
+{
+  Option<uint64_t> nr_periods;
+  Option<uint64_t> nr_throttled;
+  Option<Duration> throttled_time;
+};
+
+
+// Re-reads the given 'cpu.stat' control and parses it into 'Stats'
+// without allocating.
+Try<Stats> stat(Control* control);
+
 } // namespace cpu {
 
 
@@ -464,6 +548,11 @@ Try<Stats> stat(
     const std::string& hierarchy,
     const std::string& cgroup);
 
+
+// Re-reads the given 'cpuacct.stat' control and parses it into
+// 'Stats' without allocating.
+Try<Stats> stat(Control* control);
+
 } // namespace cpuacct {
 
 
@@ -531,12 +620,42 @@ Try<Bytes> memsw_usage_in_bytes(
     const std::string& cgroup);
 
 
+// Re-reads the given memory.usage_in_bytes or
+// memory.memsw.usage_in_bytes control and returns its value.
+Try<Bytes> usage_in_bytes(Control* control);
+
+
 // Returns the max memory usage from memory.max_usage_in_bytes.
 Try<Bytes> max_usage_in_bytes(
     const std::string& hierarchy,
     const std::string& cgroup);
 
 
+// Encapsulates the 'stat' information exposed by the memory subsystem
+// that is used for resource statistics. Fields that the kernel does
+// not expose (e.g., 'total_swap' without swap accounting) are None.
+struct Stats
+{
+  Option<uint64_t> cache;
+  Option<uint64_t> rss;
+  Option<uint64_t> mapped_file;
+  Option<uint64_t> swap;
+  Option<uint64_t> unevictable;
+
+  // Hierarchical counters, including the child cgroups.
+  Option<uint64_t> total_cache;
+  Option<uint64_t> total_rss;
+  Option<uint64_t> total_mapped_file;
+  Option<uint64_t> total_swap;
+  Option<uint64_t> total_unevictable;
+};
+
+
+// Re-reads the given 'memory.stat' control and parses it into 'Stats'
+// without allocating.
+Try<Stats> stat(Control* control);
+
+
 // Out-of-memory (OOM) controls.
 namespace oom {
 
@@ -290,6 +290,27 @@ Try<FileSystemTable> FileSystemTable::read()
 }
 
 
+Try<bool> supported(const string& fsname)
+{
+  Try<string> read = os::read("/proc/filesystems");
+  if (read.isError()) {
+    return Error("Failed to read /proc/filesystems: " + read.error());
+  }
+
+  // Each line is an optional 'nodev' followed by the type, e.g.:
+  //   nodev   overlay
+  //           ext4
+  foreach (const string& line, strings::tokenize(read.get(), "\n")) {
+    vector<string> tokens = strings::tokenize(line, " \t");
+    if (!tokens.empty() && tokens.back() == fsname) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
 Try<Nothing> mount(const Option<string>& source,
                    const string& target,
                    const Option<string>& type,
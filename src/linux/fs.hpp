@@ -297,6 +297,11 @@ struct FileSystemTable {
 };
 
 
+// Returns whether the kernel supports the given file system type
+// (i.e., whether it is listed in /proc/filesystems).
+Try<bool> supported(const std::string& fsname);
+
+
 // Mount a file system.
 // @param   source    Specify the file system (often a device name but
 //                    it can also be a directory for a bind mount).
@@ -16,17 +16,27 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <linux/perf_event.h>
+
 #include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <algorithm>
+#include <limits>
 #include <list>
 #include <ostream>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include <process/clock.hpp>
@@ -36,7 +46,11 @@
 #include <process/process.hpp>
 #include <process/subprocess.hpp>
 
+#include <stout/error.hpp>
+#include <stout/numify.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/unreachable.hpp>
 
@@ -52,6 +66,7 @@ using process::await;
 
 using std::list;
 using std::ostringstream;
+using std::pair;
 using std::set;
 using std::string;
 using std::tuple;
@@ -508,4 +523,471 @@ Try<hashmap<string, mesos::PerfStatistics>> parse(
   return statistics;
 }
 
+
+namespace internal {
+
+// The generic hardware and software events, named as by perf(1).
+static const struct
+{
+  const char* name;
+  uint32_t type;
+  uint64_t config;
+} EVENTS[] = {
+  {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {"cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+  {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+  {"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+  {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  {"bus-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES},
+  {"stalled-cycles-frontend",
+   PERF_TYPE_HARDWARE,
+   PERF_COUNT_HW_STALLED_CYCLES_FRONTEND},
+  {"stalled-cycles-backend",
+   PERF_TYPE_HARDWARE,
+   PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+  {"ref-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES},
+  {"cpu-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK},
+  {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+  {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+  {"minor-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN},
+  {"major-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ},
+  {"context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+  {"cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+  {"alignment-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_ALIGNMENT_FAULTS},
+  {"emulation-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_EMULATION_FAULTS}
+};
+
+
+// The hardware cache events are named '<cache>-<operation>s' for the
+// accesses and '<cache>-<operation>-misses' for the misses, e.g.,
+// 'LLC-loads' and 'LLC-load-misses'.
+static const struct
+{
+  const char* name;
+  uint64_t id;
+} CACHES[] = {
+  {"L1-dcache", PERF_COUNT_HW_CACHE_L1D},
+  {"L1-icache", PERF_COUNT_HW_CACHE_L1I},
+  {"LLC", PERF_COUNT_HW_CACHE_LL},
+  {"dTLB", PERF_COUNT_HW_CACHE_DTLB},
+  {"iTLB", PERF_COUNT_HW_CACHE_ITLB},
+  {"branch", PERF_COUNT_HW_CACHE_BPU},
+  {"node", PERF_COUNT_HW_CACHE_NODE}
+}, OPERATIONS[] = {
+  {"load", PERF_COUNT_HW_CACHE_OP_READ},
+  {"store", PERF_COUNT_HW_CACHE_OP_WRITE},
+  {"prefetch", PERF_COUNT_HW_CACHE_OP_PREFETCH}
+};
+
+
+// Returns the perf_event_open(2) type and config of the named event.
+// Names are matched after normalization, so that 'LLC-loads' and
+// 'llc_loads' are the same event.
+static Option<pair<uint32_t, uint64_t>> lookup(const string& name)
+{
+  const string event = normalize(name);
+
+  foreach (const auto& generic, EVENTS) {
+    if (normalize(generic.name) == event) {
+      return std::make_pair(generic.type, generic.config);
+    }
+  }
+
+  foreach (const auto& cache, CACHES) {
+    foreach (const auto& operation, OPERATIONS) {
+      const string prefix = string(cache.name) + "-" + operation.name;
+
+      if (normalize(prefix + "s") == event) {
+        return std::make_pair(
+            (uint32_t) PERF_TYPE_HW_CACHE,
+            cache.id |
+            (operation.id << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16));
+      }
+
+      if (normalize(prefix + "-misses") == event) {
+        return std::make_pair(
+            (uint32_t) PERF_TYPE_HW_CACHE,
+            cache.id |
+            (operation.id << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+      }
+    }
+  }
+
+  return None();
+}
+
+
+static struct perf_event_attr attributes(uint32_t type, uint64_t config)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+
+  // Read the whole group at once, along with the times needed to
+  // scale the counts when the kernel multiplexes the counters.
+  attr.read_format =
+    PERF_FORMAT_GROUP |
+    PERF_FORMAT_TOTAL_TIME_ENABLED |
+    PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return attr;
+}
+
+
+// Returns the cpus which are online, e.g., 0, 1, 2, 3 and 6 for
+// "0-3,6". The offline cpus are not necessarily the last ones.
+static Try<vector<int>> online()
+{
+  const string path = "/sys/devices/system/cpu/online";
+
+  Try<string> read = os::read(path);
+  if (read.isError()) {
+    return Error("Failed to read '" + path + "': " + read.error());
+  }
+
+  vector<int> cpus;
+
+  foreach (const string& range, strings::tokenize(read.get(), ",\n")) {
+    vector<string> bounds = strings::split(range, "-");
+
+    Try<int> first = numify<int>(bounds.front());
+    Try<int> last = numify<int>(bounds.back());
+
+    if (bounds.size() > 2 ||
+        first.isError() ||
+        last.isError() ||
+        first.get() > last.get()) {
+      return Error("Unexpected cpu range '" + range + "' in '" + path + "'");
+    }
+
+    for (int cpu = first.get(); cpu <= last.get(); cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+
+// NOTE: glibc does not provide a wrapper for perf_event_open(2).
+static int open(
+    struct perf_event_attr* attr,
+    pid_t pid,
+    int cpu,
+    int group,
+    unsigned long flags)
+{
+  return ::syscall(__NR_perf_event_open, attr, pid, cpu, group, flags);
+}
+
+} // namespace internal {
+
+
+// The counters of a cgroup, opened as one group per cpu with the group
+// leader first, along with the values read by the previous sample.
+struct Sampler::Cgroup
+{
+  struct Group
+  {
+    Group() : enabled(0), running(0) {}
+
+    vector<int> fds;
+    vector<uint64_t> values;
+    uint64_t enabled;
+    uint64_t running;
+  };
+
+  Cgroup() : fd(-1), descriptors(0) {}
+
+  ~Cgroup()
+  {
+    foreach (const Group& group, groups) {
+      // Close the group leader last.
+      for (auto it = group.fds.rbegin(); it != group.fds.rend(); ++it) {
+        os::close(*it);
+      }
+    }
+
+    if (fd >= 0) {
+      os::close(fd);
+    }
+  }
+
+  // The cgroup directory, passed to perf_event_open(2) as the 'pid'.
+  int fd;
+
+  vector<Group> groups;
+
+  // The number of descriptors held, including 'fd'.
+  size_t descriptors;
+
+  // The start of the period counted by the next sample.
+  Time start;
+};
+
+
+Try<Owned<Sampler>> Sampler::create(
+    const set<string>& events,
+    const Option<size_t>& limit)
+{
+  if (events.empty()) {
+    return Error("No perf events specified");
+  }
+
+  vector<Event> _events;
+
+  foreach (const string& name, events) {
+    Option<pair<uint32_t, uint64_t>> event = internal::lookup(name);
+    if (event.isNone()) {
+      return Error("Unknown perf event '" + name + "'");
+    }
+
+    const string field = internal::normalize(name);
+
+    if (mesos::PerfStatistics::descriptor()->FindFieldByName(field) == NULL) {
+      return Error("Unexpected perf event '" + name + "'");
+    }
+
+    // Make sure the event can be counted on this host by opening it
+    // for the calling thread, with the same attributes as the counters
+    // of the cgroups.
+    struct perf_event_attr attr =
+      internal::attributes(event.get().first, event.get().second);
+
+    int fd = internal::open(&attr, 0, -1, -1, 0);
+    if (fd < 0) {
+      return ErrnoError("Failed to open perf event '" + name + "'");
+    }
+
+    os::close(fd);
+
+    _events.push_back({field, event.get().first, event.get().second});
+  }
+
+  if (limit.isSome()) {
+    return Owned<Sampler>(new Sampler(_events, limit.get()));
+  }
+
+  struct rlimit nofile;
+  if (::getrlimit(RLIMIT_NOFILE, &nofile) < 0) {
+    return ErrnoError("Failed to get the limit on open files");
+  }
+
+  return Owned<Sampler>(new Sampler(
+      _events,
+      nofile.rlim_cur == RLIM_INFINITY
+        ? std::numeric_limits<size_t>::max()
+        : nofile.rlim_cur / 2));
+}
+
+
+Sampler::Sampler(const vector<Event>& _events, size_t _limit)
+  : events(_events),
+    limit(_limit),
+    descriptors(0) {}
+
+
+Sampler::~Sampler() {}
+
+
+Try<Nothing> Sampler::add(const string& hierarchy, const string& cgroup)
+{
+  if (cgroups.contains(cgroup)) {
+    return Nothing();
+  }
+
+  Try<vector<int>> cpus = internal::online();
+  if (cpus.isError()) {
+    return Error("Failed to get the online cpus: " + cpus.error());
+  }
+
+  // One descriptor for the cgroup and one per event on each cpu.
+  const size_t needed = 1 + events.size() * cpus.get().size();
+
+  if (descriptors + needed > limit) {
+    return Error(
+        "Sampling cgroup '" + cgroup + "' would exceed the limit of " +
+        stringify(limit) + " perf event descriptors (" +
+        stringify(descriptors) + " in use, " + stringify(needed) +
+        " needed)");
+  }
+
+  Owned<Cgroup> counters(new Cgroup());
+
+  Try<int> fd =
+    os::open(path::join(hierarchy, cgroup), O_RDONLY | O_CLOEXEC);
+
+  if (fd.isError()) {
+    return Error("Failed to open cgroup '" + cgroup + "': " + fd.error());
+  }
+
+  counters->fd = fd.get();
+
+  // Counting the events of a cgroup is only supported per cpu.
+  foreach (int cpu, cpus.get()) {
+    counters->groups.push_back(Cgroup::Group());
+    Cgroup::Group& group = counters->groups.back();
+
+    foreach (const Event& event, events) {
+      struct perf_event_attr attr =
+        internal::attributes(event.type, event.config);
+
+      int counter = internal::open(
+          &attr,
+          counters->fd,
+          cpu,
+          group.fds.empty() ? -1 : group.fds.front(),
+          PERF_FLAG_PID_CGROUP);
+
+      if (counter < 0) {
+        // Skip the cpus that went offline since they were listed.
+        if (errno == ENODEV && group.fds.empty()) {
+          break;
+        }
+
+        return ErrnoError(
+            "Failed to open perf event '" + event.field + "' for cgroup '" +
+            cgroup + "' on cpu " + stringify(cpu));
+      }
+
+      group.fds.push_back(counter);
+
+      Try<Nothing> cloexec = os::cloexec(counter);
+      if (cloexec.isError()) {
+        return Error(
+            "Failed to set close-on-exec on perf event: " + cloexec.error());
+      }
+    }
+
+    if (group.fds.empty()) {
+      counters->groups.pop_back();
+    } else {
+      group.values.resize(events.size(), 0);
+    }
+  }
+
+  counters->descriptors = 1;
+  foreach (const Cgroup::Group& group, counters->groups) {
+    counters->descriptors += group.fds.size();
+  }
+
+  descriptors += counters->descriptors;
+
+  counters->start = Clock::now();
+
+  cgroups.put(cgroup, counters);
+
+  return Nothing();
+}
+
+
+void Sampler::remove(const string& cgroup)
+{
+  if (cgroups.contains(cgroup)) {
+    descriptors -= cgroups[cgroup]->descriptors;
+    cgroups.erase(cgroup);
+  }
+}
+
+
+hashmap<string, mesos::PerfStatistics> Sampler::sample()
+{
+  const Time now = Clock::now();
+
+  hashmap<string, mesos::PerfStatistics> statistics;
+
+  // The layout of a group read with PERF_FORMAT_GROUP,
+  // PERF_FORMAT_TOTAL_TIME_ENABLED and PERF_FORMAT_TOTAL_TIME_RUNNING:
+  // the number of counters, the times enabled and running, followed
+  // by the value of each counter in the order they were opened.
+  vector<uint64_t> buffer(3 + events.size());
+  vector<double> counts(events.size());
+
+  foreachpair (const string& cgroup, const Owned<Cgroup>& counters, cgroups) {
+    std::fill(counts.begin(), counts.end(), 0.0);
+
+    Option<Error> error = None();
+
+    foreach (Cgroup::Group& group, counters->groups) {
+      ssize_t length = ::read(
+          group.fds.front(),
+          buffer.data(),
+          buffer.size() * sizeof(uint64_t));
+
+      if (length < 0) {
+        error = ErrnoError("Failed to read perf events");
+        break;
+      } else if ((size_t) length != buffer.size() * sizeof(uint64_t) ||
+                 buffer[0] != events.size()) {
+        error = Error("Unexpected perf event group read");
+        break;
+      }
+
+      const uint64_t enabled = buffer[1] - group.enabled;
+      const uint64_t running = buffer[2] - group.running;
+
+      for (size_t i = 0; i < events.size(); i++) {
+        const uint64_t value = buffer[3 + i] - group.values[i];
+
+        // Scale the count up when the group only ran for part of the
+        // period because the kernel multiplexed the counters. Counts
+        // of a group that did not run at all are reported as zero,
+        // like '<not counted>' by 'perf stat'.
+        if (running > 0) {
+          counts[i] += (double) value * enabled / running;
+        }
+
+        group.values[i] = buffer[3 + i];
+      }
+
+      group.enabled = buffer[1];
+      group.running = buffer[2];
+    }
+
+    if (error.isSome()) {
+      LOG(WARNING) << "Failed to sample perf events for cgroup '"
+                   << cgroup << "': " << error.get().message;
+      continue;
+    }
+
+    mesos::PerfStatistics sample;
+    sample.set_timestamp(counters->start.secs());
+    sample.set_duration((now - counters->start).secs());
+
+    const google::protobuf::Reflection* reflection = sample.GetReflection();
+
+    for (size_t i = 0; i < events.size(); i++) {
+      const google::protobuf::FieldDescriptor* field =
+        sample.GetDescriptor()->FindFieldByName(events[i].field);
+
+      CHECK_NOTNULL(field);
+
+      switch (field->type()) {
+        case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+          // The clock events are counted in nanoseconds, while
+          // 'perf stat' reports them in milliseconds.
+          reflection->SetDouble(&sample, field, counts[i] / 1000000.0);
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_UINT64:
+          reflection->SetUInt64(&sample, field, (uint64_t) counts[i]);
+          break;
+        default:
+          UNREACHABLE();
+      }
+    }
+
+    counters->start = now;
+
+    statistics.put(cgroup, sample);
+  }
+
+  return statistics;
+}
+
 } // namespace perf {
@@ -19,15 +19,22 @@
 #ifndef __PERF_HPP__
 #define __PERF_HPP__
 
+#include <stdint.h>
 #include <unistd.h>
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
+#include <process/time.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
 
 // For PerfStatistics protobuf.
 #include "mesos/mesos.hpp"
@@ -48,6 +55,74 @@ process::Future<hashmap<std::string, mesos::PerfStatistics>> sample(
 bool valid(const std::set<std::string>& events);
 
 
+// Counts events for the processes in perf_event cgroups using counters
+// opened in-process with perf_event_open(2), rather than by running
+// 'perf stat' for every sample. The counters are kept open for as long
+// as a cgroup is sampled, hence consecutive samples cover consecutive
+// periods without gaps. The events of a cgroup are opened as a single
+// group on each cpu so that they are read with one read(2) per cpu;
+// counts are scaled when the kernel multiplexes the group.
+//
+// NOTE: Only the events that have a field in the PerfStatistics
+// protobuf are supported, e.g., 'cycles', 'task-clock' or
+// 'L1-dcache-load-misses'.
+//
+// NOTE: Each sampled cgroup holds one file descriptor per event per
+// cpu (plus one for the cgroup itself), i.e., the number of open
+// descriptors grows as events x cpus x cgroups. The sampler bounds it
+// by 'limit': cgroups that would exceed it are not sampled.
+class Sampler
+{
+public:
+  // Returns an error if any of the events is unknown or can not be
+  // opened on this host. The 'limit' on the number of descriptors held
+  // by the sampler defaults to half of the soft RLIMIT_NOFILE.
+  static Try<process::Owned<Sampler>> create(
+      const std::set<std::string>& events,
+      const Option<size_t>& limit = None());
+
+  ~Sampler();
+
+  // Starts counting the events for the given cgroup of the perf_event
+  // hierarchy, e.g., 'mesos/test' for /sys/fs/cgroup/perf_event/mesos/test.
+  // Returns an error if sampling the cgroup would exceed the limit.
+  Try<Nothing> add(const std::string& hierarchy, const std::string& cgroup);
+
+  // Stops counting for the given cgroup and closes its counters.
+  void remove(const std::string& cgroup);
+
+  // Returns the events counted for each cgroup since the previous
+  // sample, or since the cgroup was added. The returned hashmap is
+  // keyed by cgroup; cgroups whose counters fail to be read are
+  // logged and left out.
+  hashmap<std::string, mesos::PerfStatistics> sample();
+
+private:
+  // An event as passed to perf_event_open(2), along with the name of
+  // its field in the PerfStatistics protobuf.
+  struct Event
+  {
+    std::string field;
+    uint32_t type;
+    uint64_t config;
+  };
+
+  struct Cgroup;
+
+  Sampler(const std::vector<Event>& events, size_t limit);
+
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  const std::vector<Event> events;
+  hashmap<std::string, process::Owned<Cgroup>> cgroups;
+
+  // The maximum and current number of descriptors held.
+  const size_t limit;
+  size_t descriptors;
+};
+
+
 // Returns whether perf is supported on this host. Returns false if
 // the kernel is too old (requires >= 2.6.39).
 bool supported();
@@ -19,10 +19,12 @@
 #ifndef __LINUX_ROUTING_FILTER_FILTER_HPP__
 #define __LINUX_ROUTING_FILTER_FILTER_HPP__
 
+#include <string>
 #include <vector>
 
 #include <process/shared.hpp>
 
+#include <stout/none.hpp>
 #include <stout/option.hpp>
 
 #include "linux/routing/handle.hpp"
@@ -117,6 +119,74 @@ public:
   std::vector<process::Shared<action::Action>> actions;
 };
 
+
+// A batch of operations (creations and removals) on the filters
+// attached to a 'parent' on a 'link'. Applying the operations one at
+// a time costs a few netlink round trips each (e.g., dumping the
+// existing filters to check for duplicates). A batch is instead
+// applied at once using a single dump of the existing filters and a
+// pipelined sequence of netlink messages (see, e.g., 'ip::apply').
+template <typename Classifier>
+struct Batch
+{
+public:
+  struct Operation
+  {
+    enum Type
+    {
+      CREATE,
+      REMOVE
+    };
+
+    Operation(Type _type, const Filter<Classifier>& _filter)
+      : type(_type), filter(_filter) {}
+
+    Type type;
+
+    // The filter to create, or the filter with the classifier to
+    // remove.
+    Filter<Classifier> filter;
+  };
+
+  Batch(const std::string& _link, const Handle& _parent)
+    : link(_link), parent(_parent) {}
+
+  // Queues the creation of a filter with the given classifier which
+  // takes the given action. Note that the handle of the filter is
+  // always picked automatically.
+  template <typename Action>
+  void create(
+      const Classifier& classifier,
+      const Option<Priority>& priority,
+      const Option<Handle>& classid,
+      const Action& action)
+  {
+    operations.push_back(Operation(
+        Operation::CREATE,
+        Filter<Classifier>(
+            parent,
+            classifier,
+            priority,
+            None(),
+            classid,
+            action)));
+  }
+
+  // Queues the removal of the filter that matches the classifier.
+  void remove(const Classifier& classifier)
+  {
+    operations.push_back(Operation(
+        Operation::REMOVE,
+        Filter<Classifier>(parent, classifier, None(), None(), None())));
+  }
+
+  std::string link;
+  Handle parent;
+
+  // The queued operations, which are applied in order.
+  std::vector<Operation> operations;
+};
+
 } // namespace filter {
 } // namespace routing {
 
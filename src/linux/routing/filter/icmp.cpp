@@ -276,6 +276,12 @@ Try<bool> remove(
 }
 
 
+Try<vector<bool>> apply(const Batch<Classifier>& batch)
+{
+  return internal::apply(batch);
+}
+
+
 Try<bool> update(
     const string& link,
     const Handle& parent,
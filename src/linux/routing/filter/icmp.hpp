@@ -113,6 +113,14 @@ Try<bool> remove(
     const Classifier& classifier);
 
 
+// Applies a batch of ICMP packet filter operations in order (see
+// 'Batch' for details). Returns, for each operation, true if it took
+// effect, or false if the filter to create already exists or the
+// filter to remove is not found. Returns an error if an operation
+// fails, in which case the filters created by the batch are removed.
+Try<std::vector<bool>> apply(const Batch<Classifier>& batch);
+
+
 // Updates the action of the ICMP packet filter attached to the given
 // parent that matches the specified classifier on the link. Returns
 // false if such a filter is not found.
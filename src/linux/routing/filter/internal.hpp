@@ -23,6 +23,8 @@
 
 #include <netlink/cache.h>
 #include <netlink/errno.h>
+#include <netlink/msg.h>
+#include <netlink/netlink.h>
 #include <netlink/object.h>
 #include <netlink/socket.h>
 
@@ -35,7 +37,9 @@
 #include <netlink/route/cls/basic.h>
 #include <netlink/route/cls/u32.h>
 
+#include <deque>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <process/shared.hpp>
@@ -84,13 +88,29 @@ template <typename Classifier>
 Result<Classifier> decode(const Netlink<struct rtnl_cls>& cls);
 
 
-// Attaches a redirect action to the libnl filter (rtnl_cls).
+// Looks up the link by its name, either in the given dump of all the
+// links or, if none is given, by dumping the links from the kernel.
+inline Result<Netlink<struct rtnl_link>> lookup(
+    const std::string& link,
+    const Option<Netlink<struct nl_cache>>& links)
+{
+  if (links.isSome()) {
+    return link::internal::get(link, links.get());
+  }
+
+  return link::internal::get(link);
+}
+
+
+// Attaches a redirect action to the libnl filter (rtnl_cls). The
+// optional 'links' is a dump of all the links used to resolve the
+// target link.
 inline Try<Nothing> attach(
     const Netlink<struct rtnl_cls>& cls,
-    const action::Redirect& redirect)
+    const action::Redirect& redirect,
+    const Option<Netlink<struct nl_cache>>& links = None())
 {
-  Result<Netlink<struct rtnl_link>> link =
-    link::internal::get(redirect.link);
+  Result<Netlink<struct rtnl_link>> link = lookup(redirect.link, links);
 
   if (link.isError()) {
     return Error(link.error());
@@ -151,15 +171,18 @@ inline Try<Nothing> attach(
 }
 
 
-// Attaches a mirror action to the libnl filter (rtnl_cls).
+// Attaches a mirror action to the libnl filter (rtnl_cls). The
+// optional 'links' is a dump of all the links used to resolve the
+// target links.
 inline Try<Nothing> attach(
     const Netlink<struct rtnl_cls>& cls,
-    const action::Mirror& mirror)
+    const action::Mirror& mirror,
+    const Option<Netlink<struct nl_cache>>& links = None())
 {
   const std::string kind = rtnl_tc_get_kind(TC_CAST(cls.get()));
 
   foreach (const std::string& _link, mirror.links) {
-    Result<Netlink<struct rtnl_link>> link = link::internal::get(_link);
+    Result<Netlink<struct rtnl_link>> link = lookup(_link, links);
     if (link.isError()) {
       return Error(link.error());
     } else if (link.isNone()) {
@@ -249,18 +272,19 @@ inline Try<Nothing> attach(
 // depending on the type of the action.
 inline Try<Nothing> attach(
     const Netlink<struct rtnl_cls>& cls,
-    const process::Shared<action::Action>& action)
+    const process::Shared<action::Action>& action,
+    const Option<Netlink<struct nl_cache>>& links = None())
 {
   const action::Redirect* redirect =
     dynamic_cast<const action::Redirect*>(action.get());
   if (redirect != NULL) {
-    return attach(cls, *redirect);
+    return attach(cls, *redirect, links);
   }
 
   const action::Mirror* mirror =
     dynamic_cast<const action::Mirror*>(action.get());
   if (mirror != NULL) {
-    return attach(cls, *mirror);
+    return attach(cls, *mirror, links);
   }
 
   const action::Terminal* terminal =
@@ -273,67 +297,71 @@ inline Try<Nothing> attach(
 }
 
 
-// Generates the handle for the given filter on the link. Returns none
-// if we decide to let the kernel choose the handle.
-template <typename Classifier>
-Result<U32Handle> generateU32Handle(
-    const Netlink<struct rtnl_link>& link,
-    const Filter<Classifier>& filter)
+// The u32 handles used by the existing filters attached to a parent,
+// used to pick unused handles for new u32 filters (see below).
+struct U32Handles
 {
-  // If the user does not specify a priority, we have no choice but
-  // let the kernel choose the handle because we do not know the
-  // 'htid' that is associated with that priority.
-  if (filter.priority.isNone()) {
-    return None();
-  }
-
-  // Scan all the filters attached to the given parent on the link.
-  Try<Netlink<struct nl_sock>> socket = routing::socket();
-  if (socket.isError()) {
-    return Error(socket.error());
-  }
-
-  // Dump all the libnl filters (i.e., rtnl_cls) attached to the given
-  // parent on the link.
-  struct nl_cache* c = NULL;
-  int error = rtnl_cls_alloc_cache(
-      socket.get().get(),
-      rtnl_link_get_ifindex(link.get()),
-      filter.parent.get(),
-      &c);
-
-  if (error != 0) {
-    return Error(
-        "Failed to get filter info from kernel: " +
-        std::string(nl_geterror(error)));
-  }
-
-  Netlink<struct nl_cache> cache(c);
-
   // A map from priority to the corresponding 'htid'.
   hashmap<uint16_t, uint32_t> htids;
 
   // A map from 'htid' to a set of already used nodes.
   hashmap<uint32_t, hashset<uint32_t>> nodes;
 
-  for (struct nl_object* o = nl_cache_get_first(cache.get());
-       o != NULL; o = nl_cache_get_next(o)) {
-    struct rtnl_cls* cls = (struct rtnl_cls*) o;
+  // Records the handle of a u32 filter with the given priority.
+  void add(uint16_t priority, const U32Handle& handle)
+  {
+    htids[priority] = handle.htid();
+    nodes[handle.htid()].insert(handle.node());
+  }
+};
 
+
+// Collects the u32 handles used by the given libnl filters.
+inline U32Handles getU32Handles(
+    const std::vector<Netlink<struct rtnl_cls>>& clses)
+{
+  U32Handles handles;
+
+  foreach (const Netlink<struct rtnl_cls>& cls, clses) {
     // Only look at u32 filters. For other type of filters, their
     // handles are generated by the kernel correctly.
-    if (rtnl_tc_get_kind(TC_CAST(cls)) == std::string("u32")) {
-      U32Handle handle(rtnl_tc_get_handle(TC_CAST(cls)));
-
-      htids[rtnl_cls_get_prio(cls)] = handle.htid();
-      nodes[handle.htid()].insert(handle.node());
+    if (rtnl_tc_get_kind(TC_CAST(cls.get())) == std::string("u32")) {
+      handles.add(
+          rtnl_cls_get_prio(cls.get()),
+          U32Handle(rtnl_tc_get_handle(TC_CAST(cls.get()))));
     }
   }
 
+  return handles;
+}
+
+
+// Forward declaration. Returns all the libnl filters (rtnl_cls)
+// attached to the given parent on the link.
+inline Try<std::vector<Netlink<struct rtnl_cls>>> getClses(
+    const Netlink<struct rtnl_link>& link,
+    const Handle& parent);
+
+
+// Generates the handle for the given filter given the u32 handles
+// already in use. Returns none if we decide to let the kernel choose
+// the handle.
+template <typename Classifier>
+Result<U32Handle> generateU32Handle(
+    const U32Handles& handles,
+    const Filter<Classifier>& filter)
+{
+  // If the user does not specify a priority, we have no choice but
+  // let the kernel choose the handle because we do not know the
+  // 'htid' that is associated with that priority.
+  if (filter.priority.isNone()) {
+    return None();
+  }
+
   // If this filter has a new priority, we need to let the kernel
   // decide the handle because we don't know which 'htid' this
   // priority will be associated with.
-  if (!htids.contains(filter.priority.get().get())) {
+  if (!handles.htids.contains(filter.priority.get().get())) {
     return None();
   }
 
@@ -341,9 +369,10 @@ Result<U32Handle> generateU32Handle(
   // means all filters will be in hash bucket 0. Also, kernel assigns
   // node id starting from 0x800 by default. Here, we keep the same
   // semantics as kernel.
-  uint32_t htid = htids[filter.priority.get().get()];
+  uint32_t htid = handles.htids.at(filter.priority.get().get());
   for (uint32_t node = 0x800; node <= 0xfff; node++) {
-    if (!nodes[htid].contains(node)) {
+    if (!handles.nodes.contains(htid) ||
+        !handles.nodes.at(htid).contains(node)) {
       return U32Handle(htid, 0x0, node);
     }
   }
@@ -355,10 +384,15 @@ Result<U32Handle> generateU32Handle(
 // Encodes a filter (in our representation) to a libnl filter
 // (rtnl_cls). We use template here so that it works for any type of
 // classifier.
+// The optional 'handles' and 'links' allow callers encoding many
+// filters to reuse a single dump of the u32 handles in use on the
+// parent and of all the links respectively.
 template <typename Classifier>
 Try<Netlink<struct rtnl_cls>> encodeFilter(
     const Netlink<struct rtnl_link>& link,
-    const Filter<Classifier>& filter)
+    const Filter<Classifier>& filter,
+    const Option<U32Handles>& handles = None(),
+    const Option<Netlink<struct nl_cache>>& links = None())
 {
   struct rtnl_cls* c = rtnl_cls_alloc();
   if (c == NULL) {
@@ -383,7 +417,7 @@ Try<Netlink<struct rtnl_cls>> encodeFilter(
 
   // Attach actions to the libnl filter.
   foreach (const process::Shared<action::Action>& action, filter.actions) {
-    Try<Nothing> attaching = attach(cls, action);
+    Try<Nothing> attaching = attach(cls, action, links);
     if (attaching.isError()) {
       return Error("Failed to attach an action " + attaching.error());
     }
@@ -402,7 +436,24 @@ Try<Netlink<struct rtnl_cls>> encodeFilter(
     // handle of the filter by picking an unused handle.
     // TODO(jieyu): Revisit this once the kernel bug is fixed.
     if (rtnl_tc_get_kind(TC_CAST(cls.get())) == std::string("u32")) {
-      Result<U32Handle> handle = generateU32Handle(link, filter);
+      Result<U32Handle> handle = None();
+
+      if (handles.isSome()) {
+        handle = generateU32Handle(handles.get(), filter);
+      } else if (filter.priority.isSome()) {
+        // Scan all the filters attached to the given parent on the
+        // link to find out the handles that are already used.
+        Try<std::vector<Netlink<struct rtnl_cls>>> clses =
+          getClses(link, filter.parent);
+
+        if (clses.isError()) {
+          return Error(
+              "Failed to find an unused u32 handle: " + clses.error());
+        }
+
+        handle = generateU32Handle(getU32Handles(clses.get()), filter);
+      }
+
       if (handle.isError()) {
         return Error("Failed to find an unused u32 handle: " + handle.error());
       }
@@ -764,6 +815,269 @@ Try<bool> update(const std::string& _link, const Filter<Classifier>& filter)
 }
 
 
+// The maximum number of netlink messages of a batch (see below) sent
+// to the kernel before waiting for their acknowledgements. This
+// bounds the number of acknowledgements queued on the netlink socket.
+constexpr size_t BATCH_WINDOW = 64;
+
+
+// Decodes the libnl filters (rtnl_cls) that match the classifier
+// type, and returns them along with their classifiers. We use
+// template here so that it works for any type of classifier.
+template <typename Classifier>
+Try<std::vector<std::pair<Classifier, Netlink<struct rtnl_cls>>>>
+decodeClses(const std::vector<Netlink<struct rtnl_cls>>& clses)
+{
+  std::vector<std::pair<Classifier, Netlink<struct rtnl_cls>>> results;
+
+  foreach (const Netlink<struct rtnl_cls>& cls, clses) {
+    Result<Filter<Classifier>> filter = decodeFilter<Classifier>(cls);
+    if (filter.isError()) {
+      return Error("Failed to decode: " + filter.error());
+    } else if (filter.isSome()) {
+      results.push_back(std::make_pair(filter.get().classifier, cls));
+    }
+  }
+
+  return results;
+}
+
+
+// Applies a batch of filter operations on the link. Returns, for each
+// operation, true if it took effect, or false if the filter to create
+// already exists or the filter to remove is not found. The existing
+// filters are dumped once for the whole batch and the netlink
+// messages are pipelined, i.e., up to BATCH_WINDOW messages are in
+// flight before we wait for their acknowledgements. If an operation
+// fails, the filters created by the batch are removed again before
+// the error is returned (removed filters are not restored). We use
+// template here so that it works for any type of classifier.
+template <typename Classifier>
+Try<std::vector<bool>> apply(const Batch<Classifier>& batch)
+{
+  typedef typename Batch<Classifier>::Operation Operation;
+
+  std::vector<bool> results(batch.operations.size(), false);
+
+  if (batch.operations.empty()) {
+    return results;
+  }
+
+  // Resolve the link and the targets of all the actions using a
+  // single dump of the links.
+  Try<Netlink<struct nl_cache>> links = link::internal::links();
+  if (links.isError()) {
+    return Error(links.error());
+  }
+
+  Result<Netlink<struct rtnl_link>> link =
+    link::internal::get(batch.link, links.get());
+
+  if (link.isError()) {
+    return Error(link.error());
+  } else if (link.isNone()) {
+    // Like 'remove' above, there is nothing to remove from a link
+    // that does not exist, but we cannot create filters on it.
+    foreach (const Operation& operation, batch.operations) {
+      if (operation.type == Operation::CREATE) {
+        return Error("Link '" + batch.link + "' is not found");
+      }
+    }
+
+    return results;
+  }
+
+  // The filters attached to the parent and the u32 handles they use.
+  // We keep them up to date as we go through the operations, so that
+  // the kernel only needs to be asked once.
+  std::vector<std::pair<Classifier, Netlink<struct rtnl_cls>>> filters;
+  U32Handles handles;
+
+  auto dump = [&]() -> Try<Nothing> {
+    Try<std::vector<Netlink<struct rtnl_cls>>> clses =
+      getClses(link.get(), batch.parent);
+
+    if (clses.isError()) {
+      return Error(clses.error());
+    }
+
+    Try<std::vector<std::pair<Classifier, Netlink<struct rtnl_cls>>>>
+      decoded = decodeClses<Classifier>(clses.get());
+
+    if (decoded.isError()) {
+      return Error(decoded.error());
+    }
+
+    filters = decoded.get();
+    handles = getU32Handles(clses.get());
+
+    return Nothing();
+  };
+
+  Try<Nothing> dumped = dump();
+  if (dumped.isError()) {
+    return Error(dumped.error());
+  }
+
+  Try<Netlink<struct nl_sock>> socket = routing::socket();
+  if (socket.isError()) {
+    return Error(socket.error());
+  }
+
+  // The operations sent to the kernel but not acknowledged yet, and
+  // the creations that have been acknowledged.
+  std::deque<size_t> pending;
+  std::vector<size_t> created;
+
+  Option<Error> error = None();
+
+  // Waits for the acknowledgements of all the pending operations.
+  // NOTE: The kernel acknowledges the messages in the order they are
+  // sent. We keep draining after an error so that no acknowledgement
+  // is left behind on the socket.
+  auto wait = [&]() {
+    while (!pending.empty()) {
+      size_t i = pending.front();
+      pending.pop_front();
+
+      const typename Operation::Type type = batch.operations[i].type;
+
+      int _error = nl_wait_for_ack(socket.get().get());
+      if (_error == 0) {
+        results[i] = true;
+
+        if (type == Operation::CREATE) {
+          created.push_back(i);
+        }
+      } else if (type == Operation::CREATE && _error == -NLE_EXIST) {
+        results[i] = false;
+      } else if (type == Operation::REMOVE &&
+                 _error == -NLE_OBJ_NOTFOUND) {
+        results[i] = false;
+      } else if (error.isNone()) {
+        error = Error(std::string(nl_geterror(_error)));
+      }
+    }
+  };
+
+  for (size_t i = 0; i < batch.operations.size(); i++) {
+    const Operation& operation = batch.operations[i];
+
+    Option<size_t> index = None();
+    for (size_t j = 0; j < filters.size(); j++) {
+      if (filters[j].first == operation.filter.classifier) {
+        index = j;
+        break;
+      }
+    }
+
+    struct nl_msg* msg = NULL;
+
+    // Whether the kernel picks the handle of the filter to create. In
+    // that case, we dump the filters again once it has been created
+    // to learn about the handle (see 'generateU32Handle').
+    bool redump = false;
+
+    if (operation.type == Operation::CREATE) {
+      // The filter already exists.
+      if (index.isSome()) {
+        continue;
+      }
+
+      Try<Netlink<struct rtnl_cls>> cls = encodeFilter(
+          link.get(),
+          operation.filter,
+          handles,
+          links.get());
+
+      if (cls.isError()) {
+        error = Error("Failed to encode the filter: " + cls.error());
+        break;
+      }
+
+      int _error = rtnl_cls_build_add_request(
+          cls.get().get(),
+          NLM_F_CREATE | NLM_F_EXCL,
+          &msg);
+
+      if (_error != 0) {
+        error = Error(std::string(nl_geterror(_error)));
+        break;
+      }
+
+      if (rtnl_tc_get_kind(TC_CAST(cls.get().get())) == std::string("u32")) {
+        uint32_t handle = rtnl_tc_get_handle(TC_CAST(cls.get().get()));
+        if (handle != 0) {
+          handles.add(rtnl_cls_get_prio(cls.get().get()), U32Handle(handle));
+        } else {
+          redump = true;
+        }
+      }
+
+      filters.push_back(
+          std::make_pair(operation.filter.classifier, cls.get()));
+    } else {
+      // The filter is not found.
+      if (index.isNone()) {
+        continue;
+      }
+
+      int _error = rtnl_cls_build_delete_request(
+          filters[index.get()].second.get(),
+          0,
+          &msg);
+
+      if (_error != 0) {
+        error = Error(std::string(nl_geterror(_error)));
+        break;
+      }
+
+      filters.erase(filters.begin() + index.get());
+    }
+
+    int _error = nl_send_auto(socket.get().get(), msg);
+    nlmsg_free(msg);
+
+    if (_error < 0) {
+      error = Error(std::string(nl_geterror(_error)));
+      break;
+    }
+
+    pending.push_back(i);
+
+    if (pending.size() >= BATCH_WINDOW || redump) {
+      wait();
+
+      if (error.isSome()) {
+        break;
+      }
+    }
+
+    if (redump) {
+      dumped = dump();
+      if (dumped.isError()) {
+        error = Error(dumped.error());
+        break;
+      }
+    }
+  }
+
+  wait();
+
+  if (error.isSome()) {
+    // Roll back the filters created by this batch, in reverse order.
+    // This is best effort, the error is returned regardless.
+    for (auto i = created.rbegin(); i != created.rend(); ++i) {
+      remove(batch.link, batch.parent, batch.operations[*i].filter.classifier);
+    }
+
+    return error.get();
+  }
+
+  return results;
+}
+
+
 // Returns all the filters attached to the given parent on the link.
 // Returns None if the link or the parent is not found. We use
 // template here so that it works for any type of classifier.
@@ -547,6 +547,12 @@ Try<bool> remove(
 }
 
 
+Try<vector<bool>> apply(const Batch<Classifier>& batch)
+{
+  return internal::apply(batch);
+}
+
+
 Result<vector<Filter<Classifier>>> filters(
     const string& link,
     const Handle& parent)
@@ -190,6 +190,14 @@ Try<bool> remove(
     const Classifier& classifier);
 
 
+// Applies a batch of IP packet filter operations in order (see
+// 'Batch' for details). Returns, for each operation, true if it took
+// effect, or false if the filter to create already exists or the
+// filter to remove is not found. Returns an error if an operation
+// fails, in which case the filters created by the batch are removed.
+Try<std::vector<bool>> apply(const Batch<Classifier>& batch);
+
+
 // Returns all the IP packet filters attached to the given parent on
 // the link. Returns none if the link or the parent is not found.
 Result<std::vector<Filter<Classifier>>> filters(
@@ -48,29 +48,51 @@ namespace link {
 namespace internal {
 
 // Returns the netlink link object associated with a given link by its
-// name. Returns None if the link is not found.
-inline Result<Netlink<struct rtnl_link>> get(const std::string& link)
+// name from a dump of all the links (see 'links()' below). Returns
+// None if the link is not found.
+inline Result<Netlink<struct rtnl_link>> get(
+    const std::string& link,
+    const Netlink<struct nl_cache>& cache)
+{
+  struct rtnl_link* l = rtnl_link_get_by_name(cache.get(), link.c_str());
+  if (l == NULL) {
+    return None();
+  }
+
+  return Netlink<struct rtnl_link>(l);
+}
+
+
+// Dumps all the netlink link objects from kernel. This can be used
+// to look up many links (see above) at the cost of a single dump.
+inline Try<Netlink<struct nl_cache>> links()
 {
   Try<Netlink<struct nl_sock>> socket = routing::socket();
   if (socket.isError()) {
     return Error(socket.error());
   }
 
-  // Dump all the netlink link objects from kernel. Note that the flag
-  // AF_UNSPEC means all available families.
+  // Note that the flag AF_UNSPEC means all available families.
   struct nl_cache* c = NULL;
   int error = rtnl_link_alloc_cache(socket.get().get(), AF_UNSPEC, &c);
   if (error != 0) {
     return Error(nl_geterror(error));
   }
 
-  Netlink<struct nl_cache> cache(c);
-  struct rtnl_link* l = rtnl_link_get_by_name(cache.get(), link.c_str());
-  if (l == NULL) {
-    return None();
+  return Netlink<struct nl_cache>(c);
+}
+
+
+// Returns the netlink link object associated with a given link by its
+// name. Returns None if the link is not found.
+inline Result<Netlink<struct rtnl_link>> get(const std::string& link)
+{
+  Try<Netlink<struct nl_cache>> cache = links();
+  if (cache.isError()) {
+    return Error(cache.error());
   }
 
-  return Netlink<struct rtnl_link>(l);
+  return get(link, cache.get());
 }
 
 
@@ -113,6 +113,13 @@ Try<bool> setMTU(const std::string& link, unsigned int mtu);
 // Returns the statistics of the link.
 Result<hashmap<std::string, uint64_t>> statistics(const std::string& link);
 
+
+// Returns the statistics of all the links, keyed by link name. Unlike
+// calling the function above once per link, this only dumps the links
+// from the kernel once, which makes it the preferred way to sample
+// the statistics of many links at the same time.
+Try<hashmap<std::string, hashmap<std::string, uint64_t>>> statistics();
+
 } // namespace link {
 } // namespace routing {
 
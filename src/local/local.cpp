@@ -198,8 +198,14 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
           1,
           path::join(flags.work_dir.get(), "replicated_log"),
           set<UPID>(),
-          flags.log_auto_initialize);
-      storage = new state::LogStorage(log);
+          flags.log_auto_initialize,
+          flags.log_storage);
+      // The registry is only written as deltas when the operator opts
+      // in with '--registry_diffs_between_snapshots'.
+      storage = new state::LogStorage(
+          log,
+          flags.registry_diffs_between_snapshots,
+          true);
     } else {
       EXIT(1) << "'" << flags.registry << "' is not a supported"
               << " option for registry persistence";
@@ -347,7 +353,8 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
     // Use a different work directory for each slave.
     flags.work_dir = path::join(flags.work_dir, stringify(i));
 
-    garbageCollectors->push_back(new GarbageCollector());
+    garbageCollectors->push_back(
+        new GarbageCollector(flags.gc_workers, flags.gc_removal_rate));
     statusUpdateManagers->push_back(new StatusUpdateManager(flags));
     fetchers->push_back(new Fetcher());
 
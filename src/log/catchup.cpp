@@ -18,13 +18,22 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <list>
+#include <set>
 
 #include <process/collect.hpp>
+#include <process/delay.hpp>
+#include <process/executor.hpp>
 #include <process/id.hpp>
 #include <process/process.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/stringify.hpp>
 
@@ -36,11 +45,62 @@
 using namespace process;
 
 using std::list;
+using std::set;
 
 namespace mesos {
 namespace internal {
 namespace log {
 
+// Progress of the catch-up operations, which are shared by all the
+// replicas in this process.
+struct Metrics
+{
+  Metrics()
+    : remaining(0),
+      positions_remaining(
+          "log/catchup_positions_remaining",
+          executor.defer(
+              lambda::bind(&Metrics::_positions_remaining, this))),
+      positions_transferred("log/catchup_positions_transferred"),
+      positions_filled("log/catchup_positions_filled")
+  {
+    process::metrics::add(positions_remaining);
+    process::metrics::add(positions_transferred);
+    process::metrics::add(positions_filled);
+  }
+
+  Future<double> _positions_remaining()
+  {
+    return static_cast<double>(remaining.load());
+  }
+
+  // The metrics do not belong to any process, thus we use an
+  // executor to defer the gauge.
+  process::Executor executor;
+
+  // The number of positions that ongoing catch-up operations have yet
+  // to catch-up. Updated by the catch-up processes directly since
+  // they run concurrently.
+  std::atomic<int64_t> remaining;
+
+  process::metrics::Gauge positions_remaining;
+
+  // Positions caught-up by transferring learned actions from other
+  // replicas, and by running Paxos, respectively.
+  process::metrics::Counter positions_transferred;
+  process::metrics::Counter positions_filled;
+};
+
+
+static Metrics* metrics()
+{
+  // NOTE: The metrics are never deleted so that they can be updated
+  // by catch-up processes until the very end.
+  static Metrics* metrics = new Metrics();
+  return metrics;
+}
+
+
 class CatchUpProcess : public Process<CatchUpProcess>
 {
 public:
@@ -203,11 +263,17 @@ protected:
     // Catch-up sequentially.
     current = positions.lower();
 
+    metrics()->remaining += positions.upper() - positions.lower();
+
     catchup();
   }
 
   virtual void finalize()
   {
+    if (current < positions.upper()) {
+      metrics()->remaining -= positions.upper() - current;
+    }
+
     catching.discard();
 
     // TODO(benh): Discard our promise only after 'catching' has
@@ -263,6 +329,9 @@ private:
   {
     ++current;
 
+    --metrics()->remaining;
+    ++metrics()->positions_filled;
+
     // The single position catch-up function: 'log::catchup' will
     // return the highest proposal number seen so far. We use this
     // proposal number for the next 'catchup' as it is highly likely
@@ -310,12 +379,319 @@ static Future<Nothing> catchup(
 }
 
 
-/////////////////////////////////////////////////
-// Public interfaces below.
-/////////////////////////////////////////////////
+// Catches-up a set of log positions in the local replica by asking
+// the other replicas for the learned actions of a range of missing
+// positions and persisting the actions they send back all at once,
+// one batch after another. Since no Paxos round is involved, this can
+// only catch-up the positions that some replica has learned. We use
+// the first response which has any action and ignore the others (all
+// learned actions of a position are the same), and give up on a range
+// once a quorum of the other replicas responded without any action. The
+// positions that are still missing in the end are returned, so that
+// the caller can fill them using Paxos.
+class RangeCatchUpProcess : public Process<RangeCatchUpProcess>
+{
+public:
+  RangeCatchUpProcess(
+      size_t _quorum,
+      const Shared<Replica>& _replica,
+      const Shared<Network>& _network,
+      const IntervalSet<uint64_t>& _positions,
+      const Duration& _timeout)
+    : ProcessBase(ID::generate("log-range-catch-up")),
+      quorum(_quorum),
+      replica(_replica),
+      network(_network),
+      positions(_positions),
+      timeout(_timeout),
+      round(0),
+      misses(0),
+      remaining(0) {}
 
+  virtual ~RangeCatchUpProcess() {}
 
-Future<Nothing> catchup(
+  Future<IntervalSet<uint64_t>> future() { return promise.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    // Stop when no one cares.
+    promise.future().onDiscard(lambda::bind(
+        static_cast<void(*)(const UPID&, bool)>(terminate), self(), true));
+
+    if (positions.empty()) {
+      promise.set(positions);
+      terminate(self());
+      return;
+    }
+
+    first = positions.begin()->lower();
+    last = positions.rbegin()->upper() - 1;
+
+    // Positions before the cursor are either caught-up or have been
+    // requested from the other replicas already.
+    cursor = first;
+
+    check();
+  }
+
+  virtual void finalize()
+  {
+    metrics()->remaining -= remaining;
+
+    checking.discard();
+    broadcasting.discard();
+    discard(responses);
+    learning.discard();
+
+    // TODO(jieyu): Discard our promise only after all the futures
+    // above have completed (ready, failed, or discarded).
+    promise.discard();
+  }
+
+private:
+  void check()
+  {
+    checking = replica->missing(first, last);
+    checking.onAny(defer(self(), &Self::checked));
+  }
+
+  void checked()
+  {
+    // The future 'checking' can only be discarded in 'finalize'.
+    CHECK(!checking.isDiscarded());
+
+    if (checking.isFailed()) {
+      promise.fail("Failed to get missing positions: " + checking.failure());
+      terminate(self());
+      return;
+    }
+
+    IntervalSet<uint64_t> missing = checking.get();
+    missing &= positions;
+
+    if (round == 0) {
+      remaining = missing.size();
+      metrics()->remaining += remaining;
+    }
+
+    IntervalSet<uint64_t> requesting = missing;
+    requesting &= (Bound<uint64_t>::closed(cursor),
+                   Bound<uint64_t>::closed(last));
+
+    if (requesting.empty()) {
+      promise.set(missing);
+      terminate(self());
+      return;
+    }
+
+    // Request the first range of missing positions. NOTE: The upper
+    // bound of an interval is exclusive.
+    const Interval<uint64_t>& range = *requesting.begin();
+
+    request.set_from(range.lower());
+    request.set_to(range.upper() - 1);
+
+    // The local replica is missing these positions, thus we only ask
+    // the other replicas (and only count their responses as misses).
+    broadcasting = network->broadcast(
+        protocol::learnedRange,
+        request,
+        {replica->pid()});
+
+    broadcasting.onAny(defer(self(), &Self::broadcasted));
+  }
+
+  void broadcasted()
+  {
+    // The future 'broadcasting' can only be discarded in 'finalize'.
+    CHECK(!broadcasting.isDiscarded());
+
+    if (broadcasting.isFailed()) {
+      promise.fail(
+          "Failed to broadcast learned range request: " +
+          broadcasting.failure());
+      terminate(self());
+      return;
+    }
+
+    round++;
+    misses = 0;
+
+    responses = broadcasting.get();
+
+    if (responses.empty()) {
+      skip();
+      return;
+    }
+
+    foreach (const Future<LearnedRangeResponse>& response, responses) {
+      response.onAny(defer(self(), &Self::received, round, response));
+    }
+
+    // Older replicas do not respond to learned range requests, thus
+    // we also stop waiting for the responses after a timeout.
+    delay(timeout, self(), &Self::timedout, round);
+  }
+
+  void received(
+      uint64_t _round,
+      const Future<LearnedRangeResponse>& response)
+  {
+    // Ignore the responses to the previous requests.
+    if (_round != round || responses.count(response) == 0) {
+      return;
+    }
+
+    responses.erase(response);
+
+    if (response.isReady() && response.get().actions_size() > 0) {
+      discard(responses);
+      responses.clear();
+
+      learn(response.get());
+    } else if (++misses >= quorum || responses.empty()) {
+      // It is likely that no replica has learned any of the requested
+      // positions, and we do not want to wait for the replicas which
+      // are not responding. We leave the positions to Paxos and move
+      // on to the next range, if any.
+      discard(responses);
+      responses.clear();
+
+      skip();
+    }
+  }
+
+  void timedout(uint64_t _round)
+  {
+    if (_round != round || responses.empty()) {
+      return;
+    }
+
+    LOG(INFO) << "Unable to get learned positions " << request.from()
+              << " -> " << request.to() << " in " << timeout
+              << ", leaving them to Paxos";
+
+    discard(responses);
+    responses.clear();
+
+    skip();
+  }
+
+  void skip()
+  {
+    cursor = request.to() + 1;
+
+    check();
+  }
+
+  void learn(const LearnedRangeResponse& response)
+  {
+    list<Action> actions;
+
+    // Only take the learned actions in the requested range, which we
+    // have yet to catch-up.
+    foreach (const Action& action, response.actions()) {
+      if (action.position() >= request.from() &&
+          action.position() <= request.to() &&
+          action.has_learned() &&
+          action.learned()) {
+        actions.push_back(action);
+      }
+    }
+
+    if (actions.empty()) {
+      skip();
+      return;
+    }
+
+    // Continue after the last position we received: the replica
+    // which sent us the actions has not learned the positions we
+    // did not receive, thus we leave them to Paxos.
+    cursor = actions.back().position() + 1;
+
+    learning = replica->learn(actions);
+    learning.onAny(defer(self(), &Self::learned, actions.size()));
+  }
+
+  void learned(size_t count)
+  {
+    // The future 'learning' can only be discarded in 'finalize'.
+    CHECK(!learning.isDiscarded());
+
+    if (learning.isFailed() || !learning.get()) {
+      promise.fail(
+          "Failed to persist learned positions " + stringify(request.from()) +
+          " -> " + stringify(request.to()) +
+          (learning.isFailed() ? ": " + learning.failure() : ""));
+      terminate(self());
+      return;
+    }
+
+    VLOG(2) << "Caught-up " << count << " positions from " << request.from();
+
+    count = std::min(count, remaining);
+    remaining -= count;
+
+    metrics()->remaining -= count;
+    metrics()->positions_transferred += count;
+
+    check();
+  }
+
+  const size_t quorum;
+  const Shared<Replica> replica;
+  const Shared<Network> network;
+  const IntervalSet<uint64_t> positions;
+  const Duration timeout;
+
+  uint64_t first;
+  uint64_t last;
+  uint64_t cursor;
+
+  // The current request, the number of requests sent so far, and the
+  // number of responses without any action to the current request.
+  LearnedRangeRequest request;
+  uint64_t round;
+  size_t misses;
+
+  // The number of positions we have counted in the metrics as yet to
+  // catch-up.
+  size_t remaining;
+
+  process::Promise<IntervalSet<uint64_t>> promise;
+  Future<IntervalSet<uint64_t>> checking;
+  Future<set<Future<LearnedRangeResponse>>> broadcasting;
+  set<Future<LearnedRangeResponse>> responses;
+  Future<bool> learning;
+};
+
+
+// Catches-up the learned positions in the set, and returns the
+// positions that are still missing afterwards.
+static Future<IntervalSet<uint64_t>> transfer(
+    size_t quorum,
+    const Shared<Replica>& replica,
+    const Shared<Network>& network,
+    const IntervalSet<uint64_t>& positions,
+    const Duration& timeout)
+{
+  RangeCatchUpProcess* process =
+    new RangeCatchUpProcess(
+        quorum,
+        replica,
+        network,
+        positions,
+        timeout);
+
+  Future<IntervalSet<uint64_t>> future = process->future();
+  spawn(process, true);
+  return future;
+}
+
+
+// Catches-up each interval of the set sequentially, using Paxos.
+static Future<Nothing> fillPositions(
     size_t quorum,
     const Shared<Replica>& replica,
     const Shared<Network>& network,
@@ -349,6 +725,33 @@ Future<Nothing> catchup(
   return future;
 }
 
+
+/////////////////////////////////////////////////
+// Public interfaces below.
+/////////////////////////////////////////////////
+
+
+Future<Nothing> catchup(
+    size_t quorum,
+    const Shared<Replica>& replica,
+    const Shared<Network>& network,
+    const Option<uint64_t>& proposal,
+    const IntervalSet<uint64_t>& positions,
+    const Duration& timeout)
+{
+  // Transfer the positions that other replicas have learned first,
+  // and only run Paxos for the positions still missing afterwards.
+  return transfer(quorum, replica, network, positions, timeout)
+    .then(lambda::bind(
+        &fillPositions,
+        quorum,
+        replica,
+        network,
+        proposal,
+        lambda::_1,
+        timeout));
+}
+
 } // namespace log {
 } // namespace internal {
 } // namespace mesos {
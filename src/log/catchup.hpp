@@ -43,7 +43,9 @@ namespace log {
 // use, he can just use none. We also allow the user to specify a
 // timeout for the catch-up operation on each position and retry the
 // operation if timeout happens. This can help us tolerate network
-// blips.
+// blips. The positions which other replicas have learned are first
+// transferred from them in large batches, and only the positions that
+// are still missing afterwards are caught-up using Paxos.
 extern process::Future<Nothing> catchup(
     size_t quorum,
     const process::Shared<Replica>& replica,
@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <list>
 #include <set>
 
 #include <process/defer.hpp>
@@ -37,6 +38,7 @@
 
 using namespace process;
 
+using std::list;
 using std::set;
 
 namespace mesos {
@@ -65,6 +67,35 @@ static bool isRejectedWrite(const WriteResponse& response) {
 }
 
 
+static WriteRequest createWriteRequest(
+    uint64_t proposal,
+    const Action& action)
+{
+  WriteRequest request;
+  request.set_proposal(proposal);
+  request.set_position(action.position());
+  request.set_type(action.type());
+  switch (action.type()) {
+    case Action::NOP:
+      CHECK(action.has_nop());
+      request.mutable_nop();
+      break;
+    case Action::APPEND:
+      CHECK(action.has_append());
+      request.mutable_append()->CopyFrom(action.append());
+      break;
+    case Action::TRUNCATE:
+      CHECK(action.has_truncate());
+      request.mutable_truncate()->CopyFrom(action.truncate());
+      break;
+    default:
+      LOG(FATAL) << "Unknown Action::Type " << action.type();
+  }
+
+  return request;
+}
+
+
 class ExplicitPromiseProcess : public Process<ExplicitPromiseProcess>
 {
 public:
@@ -492,25 +523,7 @@ private:
 
     CHECK_GE(future.get(), quorum);
 
-    request.set_proposal(proposal);
-    request.set_position(action.position());
-    request.set_type(action.type());
-    switch (action.type()) {
-      case Action::NOP:
-        CHECK(action.has_nop());
-        request.mutable_nop();
-        break;
-      case Action::APPEND:
-        CHECK(action.has_append());
-        request.mutable_append()->CopyFrom(action.append());
-        break;
-      case Action::TRUNCATE:
-        CHECK(action.has_truncate());
-        request.mutable_truncate()->CopyFrom(action.truncate());
-        break;
-      default:
-        LOG(FATAL) << "Unknown Action::Type " << action.type();
-    }
+    request = createWriteRequest(proposal, action);
 
     network->broadcast(protocol::write, request)
       .onAny(defer(self(), &Self::broadcasted, lambda::_1));
@@ -603,6 +616,172 @@ private:
 };
 
 
+class WriteBatchProcess : public Process<WriteBatchProcess>
+{
+public:
+  WriteBatchProcess(
+      size_t _quorum,
+      const Shared<Network>& _network,
+      uint64_t _proposal,
+      const list<Action>& _actions)
+    : ProcessBase(ID::generate("log-write-batch")),
+      quorum(_quorum),
+      network(_network),
+      proposal(_proposal),
+      actions(_actions),
+      responsesReceived(0),
+      ignoresReceived(0) {}
+
+  virtual ~WriteBatchProcess() {}
+
+  Future<WriteResponse> future() { return promise.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    // Stop when no one cares.
+    promise.future().onDiscard(lambda::bind(
+        static_cast<void(*)(const UPID&, bool)>(terminate), self(), true));
+
+    // Wait until there are enough (i.e., quorum of) replicas in the
+    // network. This is because if there are less than quorum number
+    // of replicas in the network, the operation will not finish.
+    network->watch(quorum, Network::GREATER_THAN_OR_EQUAL_TO)
+      .onAny(defer(self(), &Self::watched, lambda::_1));
+  }
+
+  virtual void finalize()
+  {
+    // This process will be terminated when we get responses from a
+    // quorum of replicas. In that case, we no longer care about
+    // responses from other replicas, thus discarding them here.
+    discard(responses);
+
+    promise.discard();
+  }
+
+private:
+  void watched(const Future<size_t>& future)
+  {
+    if (!future.isReady()) {
+      promise.fail(
+          future.isFailed() ?
+          future.failure() :
+          "Not expecting discarded future");
+
+      terminate(self());
+      return;
+    }
+
+    CHECK_GE(future.get(), quorum);
+
+    foreach (const Action& action, actions) {
+      request.add_requests()->CopyFrom(createWriteRequest(proposal, action));
+    }
+
+    network->broadcast(protocol::writeBatch, request)
+      .onAny(defer(self(), &Self::broadcasted, lambda::_1));
+  }
+
+  void broadcasted(const Future<set<Future<WriteBatchResponse> > >& future)
+  {
+    if (!future.isReady()) {
+      promise.fail(
+          future.isFailed() ?
+          "Failed to broadcast the write request: " + future.failure() :
+          "Not expecting discarded future");
+      terminate(self());
+      return;
+    }
+
+    responses = future.get();
+    foreach (const Future<WriteBatchResponse>& response, responses) {
+      response.onReady(defer(self(), &Self::received, lambda::_1));
+    }
+  }
+
+  void received(const WriteBatchResponse& response)
+  {
+    CHECK_EQ(response.responses_size(), request.requests_size());
+
+    // A replica which is not in VOTING status ignores all the
+    // requests in a batch.
+    bool ignored = true;
+
+    for (int i = 0; i < response.responses_size(); i++) {
+      const WriteResponse& write = response.responses(i);
+
+      CHECK_EQ(write.position(), request.requests(i).position());
+
+      if (!write.has_type() || write.type() != WriteResponse::IGNORE) {
+        ignored = false;
+      }
+
+      if (isRejectedWrite(write)) {
+        // A position in the batch has been promised to a proposer
+        // with a higher proposal number. We treat this as a NACK for
+        // the whole batch.
+        if (highestNackProposal.isNone() ||
+            highestNackProposal.get() < write.proposal()) {
+          highestNackProposal = write.proposal();
+        }
+      }
+    }
+
+    if (ignored) {
+      ignoresReceived++;
+
+      if (ignoresReceived >= quorum) {
+        LOG(INFO) << "Aborting write request because "
+                  << ignoresReceived << " ignores received";
+
+        // If the "type" is WriteResponse::IGNORE, the rest of the
+        // fields don't matter.
+        WriteResponse result;
+        result.set_type(WriteResponse::IGNORE);
+
+        promise.set(result);
+        terminate(self());
+      }
+
+      return;
+    }
+
+    responsesReceived++;
+
+    if (responsesReceived >= quorum) {
+      // A quorum of replicas have replied.
+      WriteResponse result;
+
+      if (highestNackProposal.isSome()) {
+        result.set_type(WriteResponse::REJECT);
+        result.set_okay(false);
+        result.set_proposal(highestNackProposal.get());
+      } else {
+        result.set_type(WriteResponse::ACCEPT);
+        result.set_okay(true);
+      }
+
+      promise.set(result);
+      terminate(self());
+    }
+  }
+
+  const size_t quorum;
+  const Shared<Network> network;
+  const uint64_t proposal;
+  const list<Action> actions;
+
+  WriteBatchRequest request;
+  set<Future<WriteBatchResponse> > responses;
+  size_t responsesReceived;
+  size_t ignoresReceived;
+  Option<uint64_t> highestNackProposal;
+
+  process::Promise<WriteResponse> promise;
+};
+
+
 class FillProcess : public Process<FillProcess>
 {
 public:
@@ -844,6 +1023,27 @@ Future<WriteResponse> write(
 }
 
 
+Future<WriteResponse> write(
+    size_t quorum,
+    const Shared<Network>& network,
+    uint64_t proposal,
+    const list<Action>& actions)
+{
+  CHECK(!actions.empty());
+
+  WriteBatchProcess* process =
+    new WriteBatchProcess(
+        quorum,
+        network,
+        proposal,
+        actions);
+
+  Future<WriteResponse> future = process->future();
+  spawn(process, true);
+  return future;
+}
+
+
 Future<Nothing> learn(const Shared<Network>& network, const Action& action)
 {
   LearnedMessage message;
@@ -857,6 +1057,22 @@ Future<Nothing> learn(const Shared<Network>& network, const Action& action)
 }
 
 
+Future<Nothing> learn(
+    const Shared<Network>& network,
+    const list<Action>& actions)
+{
+  LearnedBatchMessage message;
+
+  foreach (const Action& action, actions) {
+    Action* learned = message.add_actions();
+    learned->CopyFrom(action);
+    learned->set_learned(true);
+  }
+
+  return network->broadcast(message);
+}
+
+
 Future<Action> fill(
     size_t quorum,
     const Shared<Network>& network,
@@ -21,6 +21,8 @@
 
 #include <stdint.h>
 
+#include <list>
+
 #include <process/future.hpp>
 #include <process/shared.hpp>
 
@@ -104,6 +106,19 @@ extern process::Future<WriteResponse> write(
     const Action& action);
 
 
+// Runs the write phase for a batch of actions, which are sent to each
+// replica in a single WriteBatchRequest. This phase succeeds if a
+// quorum of replicas accept all the actions in the batch. If any of
+// the actions is rejected by a replica, the whole batch is considered
+// rejected (i.e., the 'okay' field is set to false). Note that
+// replicas which do not support batches never reply.
+extern process::Future<WriteResponse> write(
+    size_t quorum,
+    const process::Shared<Network>& network,
+    uint64_t proposal,
+    const std::list<Action>& actions);
+
+
 // Runs the learn phase (a.k.a, the commit phase) in Paxos. In fact,
 // this phase is not required, but treated as an optimization. In this
 // phase, a proposer broadcasts a learned message to replicas,
@@ -115,6 +130,13 @@ extern process::Future<Nothing> learn(
     const Action& action);
 
 
+// Runs the learn phase for a batch of actions, broadcasting them in a
+// single LearnedBatchMessage.
+extern process::Future<Nothing> learn(
+    const process::Shared<Network>& network,
+    const std::list<Action>& actions);
+
+
 // Tries to reach consensus for the given log position by running a
 // full Paxos round (i.e., promise -> write -> learn). If no value has
 // been previously agreed on for the given log position, a NOP will be
@@ -22,12 +22,17 @@
 
 #include <mesos/type_utils.hpp>
 
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/lambda.hpp>
 #include <stout/none.hpp>
+#include <stout/stringify.hpp>
 
 #include "log/catchup.hpp"
 #include "log/consensus.hpp"
@@ -37,26 +42,37 @@
 
 using namespace process;
 
+using std::list;
 using std::string;
 
 namespace mesos {
 namespace internal {
 namespace log {
 
+// How long a coordinator waits for a quorum of replicas to answer a
+// batch of writes before it writes the positions of the batch one by
+// one instead. Replicas which do not support batches drop them.
+static const Duration BATCH_WRITE_TIMEOUT = Seconds(10);
+
+
 class CoordinatorProcess : public Process<CoordinatorProcess>
 {
 public:
   CoordinatorProcess(
       size_t _quorum,
       const Shared<Replica>& _replica,
-      const Shared<Network>& _network)
+      const Shared<Network>& _network,
+      size_t _window)
     : ProcessBase(ID::generate("log-coordinator")),
       quorum(_quorum),
       replica(_replica),
       network(_network),
+      window(_window),
       state(INITIAL),
       proposal(0),
-      index(0) {}
+      index(0),
+      writes(0),
+      batching(true) {}
 
   virtual ~CoordinatorProcess() {}
 
@@ -64,6 +80,7 @@ public:
   Future<Option<uint64_t> > elect();
   Future<uint64_t> demote();
   Future<Option<uint64_t> > append(const string& bytes);
+  Future<Option<uint64_t> > append(const list<string>& entries);
   Future<Option<uint64_t> > truncate(uint64_t to);
 
 protected:
@@ -94,22 +111,30 @@ private:
   // Writing related functions.  //
   /////////////////////////////////
 
-  Future<Option<uint64_t> > write(const Action& action);
-  Future<WriteResponse> runWritePhase(const Action& action);
+  Future<Option<uint64_t> > write(const list<Action>& actions);
+  Future<WriteResponse> runWritePhase(const list<Action>& actions);
+  Future<WriteResponse> runWritePhaseEach(const list<Action>& actions);
   Future<Option<uint64_t> > checkWritePhase(
-      const Action& action,
+      const list<Action>& actions,
       const WriteResponse& response);
-  Future<Nothing> runLearnPhase(const Action& action);
-  Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t> > updateIndexAfterWritten(bool missing);
-  void writingFinished();
-  void writingFailed();
-  void writingAborted();
+  Future<Nothing> runLearnPhase(const list<Action>& actions);
+  Future<IntervalSet<uint64_t> > checkLearnPhase(
+      const list<Action>& actions);
+  Future<Option<uint64_t> > checkLearnedPosition(
+      const list<Action>& actions,
+      const IntervalSet<uint64_t>& missing);
+  Future<Option<uint64_t> > checkPreviousWrite(
+      const Future<Option<uint64_t> >& written,
+      const Option<uint64_t>& previous);
+  void writingFinished(const Future<Option<uint64_t> >& future);
 
   const size_t quorum;
   const Shared<Replica> replica;
   const Shared<Network> network;
 
+  // The maximum number of writes in progress at any time.
+  const size_t window;
+
   // The current state of the coordinator. A coordinator needs to be
   // elected first to perform append and truncate operations. If one
   // tries to do an append or a truncate while the coordinator is not
@@ -117,7 +142,8 @@ private:
   // coordinator does not declare itself as elected until it wins the
   // election and has filled all existing positions. A coordinator is
   // put in electing state after it decides to go for an election and
-  // before it is elected.
+  // before it is elected. An elected coordinator is put in writing
+  // state while 'window' writes are in progress.
   enum
   {
     INITIAL,
@@ -132,11 +158,40 @@ private:
   // The position to which the next entry will be written.
   uint64_t index;
 
+  // The number of writes in progress.
+  size_t writes;
+
+  // Whether batches are written (and learned) as a whole. Cleared
+  // when a quorum does not answer a batch in time, in which case the
+  // positions of batches are written one by one until the coordinator
+  // is elected again.
+  bool batching;
+
   Future<Option<uint64_t> > electing;
+
+  // The last write in progress (or the outcome of the last write, or
+  // of the election if there has not been any write). Each write is
+  // chained onto the previous one so that writes complete in order.
   Future<Option<uint64_t> > writing;
 };
 
 
+// Completes the promise returned for a write with the outcome of the
+// write.
+static void complete(
+    const Owned<process::Promise<Option<uint64_t> > >& promise,
+    const Future<Option<uint64_t> >& future)
+{
+  if (future.isReady()) {
+    promise->set(future.get());
+  } else if (future.isFailed()) {
+    promise->fail(future.failure());
+  } else {
+    promise->discard();
+  }
+}
+
+
 /////////////////////////////////////////////////
 // Handles elect/demote in CoordinatorProcess.
 /////////////////////////////////////////////////
@@ -146,14 +201,21 @@ Future<Option<uint64_t> > CoordinatorProcess::elect()
 {
   if (state == ELECTING) {
     return electing;
-  } else if (state == ELECTED) {
+  } else if (state == ELECTED && writes == 0) {
     return index - 1; // The last learned position!
-  } else if (state == WRITING) {
+  } else if (state == ELECTED || state == WRITING) {
     return Failure("Coordinator already elected, and is currently writing");
   }
 
   CHECK_EQ(state, INITIAL);
 
+  // The writes that were in progress when the coordinator got demoted
+  // are still being completed (as demoted or failed).
+  if (writes > 0) {
+    LOG(INFO) << "Coordinator is still completing " << writes << " writes";
+    return None();
+  }
+
   state = ELECTING;
 
   electing = getLastProposal()
@@ -265,6 +327,12 @@ void CoordinatorProcess::electingFinished(const Option<uint64_t>& position)
     state = INITIAL;
   } else {
     state = ELECTED;
+
+    // The first write does not need to wait for any other write.
+    writing = position;
+
+    // Try batches again, the replicas may have been upgraded.
+    batching = true;
   }
 }
 
@@ -289,7 +357,7 @@ Future<uint64_t> CoordinatorProcess::demote()
     return Failure("Coordinator is not elected");
   } else if (state == ELECTING) {
     return Failure("Coordinator is being elected");
-  } else if (state == WRITING) {
+  } else if (state == WRITING || writes > 0) {
     return Failure("Coordinator is currently writing");
   }
 
@@ -321,7 +389,39 @@ Future<Option<uint64_t> > CoordinatorProcess::append(const string& bytes)
   Action::Append* append = action.mutable_append();
   append->set_bytes(bytes);
 
-  return write(action);
+  return write(list<Action>(1, action));
+}
+
+
+Future<Option<uint64_t> > CoordinatorProcess::append(
+    const list<string>& entries)
+{
+  if (state == INITIAL || state == ELECTING) {
+    return None();
+  } else if (state == WRITING) {
+    return Failure("Coordinator is currently writing");
+  }
+
+  if (entries.empty()) {
+    return Failure("No entries to append");
+  }
+
+  list<Action> actions;
+  uint64_t position = index;
+
+  foreach (const string& bytes, entries) {
+    Action action;
+    action.set_position(position++);
+    action.set_promised(proposal);
+    action.set_performed(proposal);
+    action.set_type(Action::APPEND);
+    Action::Append* append = action.mutable_append();
+    append->set_bytes(bytes);
+
+    actions.push_back(action);
+  }
+
+  return write(actions);
 }
 
 
@@ -341,38 +441,124 @@ Future<Option<uint64_t> > CoordinatorProcess::truncate(uint64_t to)
   Action::Truncate* truncate = action.mutable_truncate();
   truncate->set_to(to);
 
-  return write(action);
+  return write(list<Action>(1, action));
 }
 
 
-Future<Option<uint64_t> > CoordinatorProcess::write(const Action& action)
+Future<Option<uint64_t> > CoordinatorProcess::write(
+    const list<Action>& actions)
 {
+  CHECK(!actions.empty());
+
+  const Action& action = actions.front();
+
   LOG(INFO) << "Coordinator attempting to write " << action.type()
-            << " action at position " << action.position();
+            << " action at position " << action.position()
+            << (actions.size() > 1
+                ? " (and " + stringify(actions.size() - 1) + " more)"
+                : "");
 
   CHECK_EQ(state, ELECTED);
   CHECK(action.has_performed() && action.has_type());
+  CHECK_EQ(action.position(), index);
+
+  // Reserve the positions so that the next write can be issued to the
+  // following position before this one completes.
+  index += actions.size();
+
+  if (++writes == window) {
+    state = WRITING;
+  }
+
+  // The write and learn phases of this position run concurrently
+  // with those of the other positions in progress.
+  Future<Option<uint64_t> > written = runWritePhase(actions)
+    .then(defer(self(), &Self::checkWritePhase, actions, lambda::_1));
+
+  // But a write only completes once the write to the preceding
+  // position has completed.
+  writing = writing
+    .then(defer(self(), &Self::checkPreviousWrite, written, lambda::_1))
+    .onAny(defer(self(), &Self::writingFinished, lambda::_1));
+
+  // NOTE: We do not return 'writing' directly since discarding it
+  // would discard the writes to all the preceding positions as well.
+  // Discarding the returned future only discards this write (and
+  // hence the writes to the following positions).
+  Owned<process::Promise<Option<uint64_t> > > promise(
+      new process::Promise<Option<uint64_t> >());
+
+  promise->future()
+    .onDiscard([=]() mutable { written.discard(); });
+
+  writing.onAny(lambda::bind(&complete, promise, lambda::_1));
 
-  state = WRITING;
+  return promise->future();
+}
+
+
+Future<WriteResponse> CoordinatorProcess::runWritePhase(
+    const list<Action>& actions)
+{
+  // A single action is written with a plain WriteRequest so that
+  // replicas which do not support batches can still accept it.
+  if (actions.size() == 1) {
+    return log::write(quorum, network, proposal, actions.front());
+  } else if (!batching) {
+    return runWritePhaseEach(actions);
+  }
 
-  writing = runWritePhase(action)
-    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
-    .onFailed(defer(self(), &Self::writingFailed))
-    .onDiscarded(defer(self(), &Self::writingAborted));
+  return log::write(quorum, network, proposal, actions)
+    .after(BATCH_WRITE_TIMEOUT,
+           defer(self(), [=](Future<WriteResponse> future)
+               -> Future<WriteResponse> {
+             LOG(WARNING) << "A quorum of replicas did not answer a batch of "
+                          << actions.size() << " writes within "
+                          << BATCH_WRITE_TIMEOUT << ", writing them one by "
+                          << "one instead";
 
-  return writing;
+             future.discard();
+             batching = false;
+
+             return runWritePhaseEach(actions);
+           }));
 }
 
 
-Future<WriteResponse> CoordinatorProcess::runWritePhase(const Action& action)
+Future<WriteResponse> CoordinatorProcess::runWritePhaseEach(
+    const list<Action>& actions)
 {
-  return log::write(quorum, network, proposal, action);
+  list<Future<WriteResponse> > futures;
+  foreach (const Action& action, actions) {
+    futures.push_back(log::write(quorum, network, proposal, action));
+  }
+
+  return collect(futures)
+    .then([](const list<WriteResponse>& responses) -> WriteResponse {
+      // Like a batch, the positions are rejected as a whole if any
+      // of them is, with the highest proposal number seen.
+      Option<WriteResponse> result;
+
+      foreach (const WriteResponse& response, responses) {
+        if (response.okay()) {
+          continue;
+        }
+
+        if (result.isNone() ||
+            (response.type() != WriteResponse::IGNORE &&
+             (result.get().type() == WriteResponse::IGNORE ||
+              response.proposal() > result.get().proposal()))) {
+          result = response;
+        }
+      }
+
+      return result.isSome() ? result.get() : responses.front();
+    });
 }
 
 
 Future<Option<uint64_t> > CoordinatorProcess::checkWritePhase(
-    const Action& action,
+    const list<Action>& actions,
     const WriteResponse& response)
 {
   if (!response.okay()) {
@@ -383,59 +569,93 @@ Future<Option<uint64_t> > CoordinatorProcess::checkWritePhase(
     return None();
   }
 
-  return runLearnPhase(action)
-    .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
+  return runLearnPhase(actions)
+    .then(defer(self(), &Self::checkLearnPhase, actions))
+    .then(defer(self(), &Self::checkLearnedPosition, actions, lambda::_1));
 }
 
 
-Future<Nothing> CoordinatorProcess::runLearnPhase(const Action& action)
+Future<Nothing> CoordinatorProcess::runLearnPhase(const list<Action>& actions)
 {
-  return log::learn(network, action);
+  if (actions.size() == 1) {
+    return log::learn(network, actions.front());
+  } else if (!batching) {
+    list<Future<Nothing> > futures;
+    foreach (const Action& action, actions) {
+      futures.push_back(log::learn(network, action));
+    }
+
+    return collect(futures)
+      .then([]() { return Nothing(); });
+  }
+
+  return log::learn(network, actions);
 }
 
 
-Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
+Future<IntervalSet<uint64_t> > CoordinatorProcess::checkLearnPhase(
+    const list<Action>& actions)
 {
   // Make sure that the local replica has learned the newly written
-  // log entry. Since messages are delivered and dispatched in order
-  // locally, we should always have the new entry learned by now.
-  return replica->missing(action.position());
+  // log entries. Since messages are delivered and dispatched in order
+  // locally, we should always have the new entries learned by now.
+  return replica->missing(
+      actions.front().position(),
+      actions.back().position());
 }
 
 
-Future<Option<uint64_t> > CoordinatorProcess::updateIndexAfterWritten(
-    bool missing)
+Future<Option<uint64_t> > CoordinatorProcess::checkLearnedPosition(
+    const list<Action>& actions,
+    const IntervalSet<uint64_t>& missing)
 {
-  CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+  CHECK(missing.empty())
+    << "Not expecting local replica to be missing positions " << missing
+    << " after the writing is done";
 
-  return index++;
+  return actions.back().position();
 }
 
 
-void CoordinatorProcess::writingFinished()
+Future<Option<uint64_t> > CoordinatorProcess::checkPreviousWrite(
+    const Future<Option<uint64_t> >& written,
+    const Option<uint64_t>& previous)
 {
-  CHECK_EQ(state, WRITING);
-  state = ELECTED;
+  // The coordinator was demoted while writing the preceding position.
+  // Writes to the following positions are reported as demoted too,
+  // even though some of them might have been accepted by a quorum.
+  // Like any position whose outcome is unknown, they will be filled
+  // by the next elected coordinator (see 'catchupMissingPositions').
+  if (previous.isNone()) {
+    return None();
+  }
+
+  return written;
 }
 
 
-void CoordinatorProcess::writingFailed()
+void CoordinatorProcess::writingFinished(
+    const Future<Option<uint64_t> >& future)
 {
-  CHECK_EQ(state, WRITING);
-  state = INITIAL;
-}
+  CHECK_GT(writes, 0u);
+  writes--;
 
+  // The coordinator was already demoted by a write to a preceding
+  // position.
+  if (state != ELECTED && state != WRITING) {
+    return;
+  }
 
-void CoordinatorProcess::writingAborted()
-{
-  CHECK_EQ(state, WRITING);
+  if (future.isReady() && future.get().isSome()) {
+    state = ELECTED;
+    return;
+  }
 
-  // Demote the coordinator if a write operation is discarded since we
-  // don't actually know the write was successful or not and we really
-  // need to "catch-up" that position before we try and do another
-  // write (see MESOS-1038 for more details).
+  // Demote the coordinator if a write operation fails, is discarded
+  // or is rejected by a quorum. Since we don't actually know whether
+  // the writes that were in progress were successful or not, we
+  // really need to "catch-up" their positions before we try and do
+  // another write (see MESOS-1038 for more details).
   state = INITIAL;
 }
 
@@ -448,9 +668,12 @@ void CoordinatorProcess::writingAborted()
 Coordinator::Coordinator(
     size_t quorum,
     const Shared<Replica>& replica,
-    const Shared<Network>& network)
+    const Shared<Network>& network,
+    size_t window)
 {
-  process = new CoordinatorProcess(quorum, replica, network);
+  CHECK_GT(window, 0u);
+
+  process = new CoordinatorProcess(quorum, replica, network, window);
   spawn(process);
 }
 
@@ -477,7 +700,20 @@ Future<uint64_t> Coordinator::demote()
 
 Future<Option<uint64_t> > Coordinator::append(const string& bytes)
 {
-  return dispatch(process, &CoordinatorProcess::append, bytes);
+  // NOTE: We need to cast the overloaded member function pointer.
+  Future<Option<uint64_t> > (CoordinatorProcess::*append)(const string&) =
+    &CoordinatorProcess::append;
+
+  return dispatch(process, append, bytes);
+}
+
+
+Future<Option<uint64_t> > Coordinator::append(const list<string>& entries)
+{
+  Future<Option<uint64_t> > (CoordinatorProcess::*append)(
+      const list<string>&) = &CoordinatorProcess::append;
+
+  return dispatch(process, append, entries);
 }
 
 
@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 
+#include <list>
 #include <string>
 
 #include <process/future.hpp>
@@ -42,10 +43,15 @@ class CoordinatorProcess;
 class Coordinator
 {
 public:
+  // The coordinator writes up to 'window' log positions concurrently,
+  // i.e., it accepts a new append or truncate before the previous
+  // ones have completed, as long as fewer than 'window' writes are in
+  // progress. Writes always complete in the order of their positions.
   Coordinator(
       size_t _quorum,
       const process::Shared<Replica>& _replica,
-      const process::Shared<Network>& _network);
+      const process::Shared<Network>& _network,
+      size_t _window = 1);
 
   ~Coordinator();
 
@@ -62,13 +68,28 @@ public:
 
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
-  // if the coordinator was demoted.
+  // if the coordinator was demoted. The returned future is only set
+  // once all the writes to preceding positions have completed; if
+  // any of them fails or is demoted, so is this one. Fails
+  // immediately if 'window' writes are already in progress.
   process::Future<Option<uint64_t> > append(const std::string& bytes);
 
+  // Appends the specified entries to consecutive positions at the end
+  // of the log, using a single round-trip to each replica (i.e., the
+  // entries are written as one WriteBatchRequest and each replica
+  // persists them at once). Returns the position of the last entry if
+  // the operation succeeds or none if the coordinator was demoted. A
+  // batch counts as a single write towards the 'window'. Replicas
+  // which do not support batches drop them (see log.proto): if a
+  // quorum does not answer a batch in time, the coordinator writes
+  // the entries one by one instead, until it is elected again.
+  process::Future<Option<uint64_t> > append(
+      const std::list<std::string>& entries);
+
   // Removes all log entries preceding the log entry at the given
   // position (to). Returns the position at which the truncate
   // operation is written if the operation succeeds or none if the
-  // coordinator was demoted.
+  // coordinator was demoted. Writes are pipelined as for 'append'.
   process::Future<Option<uint64_t> > truncate(uint64_t to);
 
 private:
@@ -41,9 +41,14 @@ public:
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::list<Action>& actions);
   virtual Try<Action> read(uint64_t position);
 
 private:
+  // Deletes the positions truncated by the specified learned truncate
+  // action.
+  void truncate(const Action& action);
+
   leveldb::DB* db;
 
   // First position still in leveldb, used during truncation.
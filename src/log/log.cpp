@@ -18,6 +18,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -44,6 +46,7 @@ using namespace process;
 using std::list;
 using std::set;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -56,7 +59,8 @@ public:
       size_t _quorum,
       const string& path,
       const set<UPID>& pids,
-      bool _autoInitialize);
+      bool _autoInitialize,
+      const string& storage);
 
   LogProcess(
       size_t _quorum,
@@ -65,7 +69,8 @@ public:
       const Duration& timeout,
       const string& znode,
       const Option<zookeeper::Authentication>& auth,
-      bool _autoInitialize);
+      bool _autoInitialize,
+      const string& storage);
 
   // Recovers the log by catching up if needed. Returns a shared
   // pointer to the local replica if the recovery succeeds.
@@ -154,10 +159,11 @@ private:
 class LogWriterProcess : public Process<LogWriterProcess>
 {
 public:
-  explicit LogWriterProcess(Log* log);
+  LogWriterProcess(Log* log, size_t window, size_t batch);
 
   Future<Option<Log::Position> > start();
   Future<Option<Log::Position> > append(const string& bytes);
+  Future<Option<Log::Position> > append(const list<string>& entries);
   Future<Option<Log::Position> > truncate(const Log::Position& to);
 
 protected:
@@ -179,10 +185,23 @@ private:
   Future<Option<Log::Position> > _start();
   Option<Log::Position> __start(const Option<uint64_t>& position);
 
+  Future<Option<uint64_t> > _append(
+      const Shared<vector<string> >& entries,
+      size_t next,
+      list<Future<Option<uint64_t> > > appending);
+
+  Future<Option<uint64_t> > __append(
+      const Shared<vector<string> >& entries,
+      size_t next,
+      const list<Future<Option<uint64_t> > >& appending,
+      const Option<uint64_t>& position);
+
   void failed(const string& message, const string& reason);
 
   const size_t quorum;
   const Shared<Network> network;
+  const size_t window;
+  const size_t batch;
 
   Future<Shared<Replica> > recovering;
   list<process::Promise<Nothing>*> promises;
@@ -201,10 +220,11 @@ LogProcess::LogProcess(
     size_t _quorum,
     const string& path,
     const set<UPID>& pids,
-    bool _autoInitialize)
+    bool _autoInitialize,
+    const string& storage)
   : ProcessBase(ID::generate("log")),
     quorum(_quorum),
-    replica(new Replica(path)),
+    replica(new Replica(path, storage)),
     network(new Network(pids + (UPID) replica->pid())),
     autoInitialize(_autoInitialize),
     group(NULL) {}
@@ -217,10 +237,11 @@ LogProcess::LogProcess(
     const Duration& timeout,
     const string& znode,
     const Option<zookeeper::Authentication>& auth,
-    bool _autoInitialize)
+    bool _autoInitialize,
+    const string& storage)
   : ProcessBase(ID::generate("log")),
     quorum(_quorum),
-    replica(new Replica(path)),
+    replica(new Replica(path, storage)),
     network(new ZooKeeperNetwork(
         servers,
         timeout,
@@ -567,10 +588,15 @@ Log::Position LogReaderProcess::position(uint64_t value)
 /////////////////////////////////////////////////
 
 
-LogWriterProcess::LogWriterProcess(Log* log)
+LogWriterProcess::LogWriterProcess(
+    Log* log,
+    size_t _window,
+    size_t _batch)
   : ProcessBase(ID::generate("log-writer")),
     quorum(log->process->quorum),
     network(log->process->network),
+    window(_window),
+    batch(_batch),
     recovering(dispatch(log->process, &LogProcess::recover)),
     coordinator(NULL),
     error(None()) {}
@@ -656,7 +682,7 @@ Future<Option<Log::Position> > LogWriterProcess::_start()
 
   CHECK_READY(recovering);
 
-  coordinator = new Coordinator(quorum, recovering.get(), network);
+  coordinator = new Coordinator(quorum, recovering.get(), network, window);
 
   LOG(INFO) << "Attempting to start the writer";
 
@@ -698,6 +724,80 @@ Future<Option<Log::Position> > LogWriterProcess::append(const string& bytes)
 }
 
 
+Future<Option<Log::Position> > LogWriterProcess::append(
+    const list<string>& entries)
+{
+  LOG(INFO) << "Attempting to append " << entries.size()
+            << " entries to the log";
+
+  if (coordinator == NULL) {
+    return Failure("No election has been performed");
+  }
+
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  if (entries.empty()) {
+    return Failure("No entries to append");
+  }
+
+  Shared<vector<string> > _entries(
+      new vector<string>(entries.begin(), entries.end()));
+
+  return _append(_entries, 0, list<Future<Option<uint64_t> > >())
+    .then(lambda::bind(&Self::position, lambda::_1))
+    .onFailed(defer(self(), &Self::failed, "Failed to append", lambda::_1));
+}
+
+
+Future<Option<uint64_t> > LogWriterProcess::_append(
+    const Shared<vector<string> >& entries,
+    size_t next,
+    list<Future<Option<uint64_t> > > appending)
+{
+  // Fill the window with batches of the next entries. Note that the
+  // coordinator writes a batch of a single entry like a plain append.
+  while (next < entries->size() && appending.size() < window) {
+    list<string> batched;
+    while (next < entries->size() && batched.size() < batch) {
+      batched.push_back(entries->at(next++));
+    }
+
+    appending.push_back(coordinator->append(batched));
+  }
+
+  // The appends complete in order, so the last one completes last.
+  if (next == entries->size()) {
+    return appending.back();
+  }
+
+  // Otherwise, wait for the oldest append to complete to make room
+  // for the next entry.
+  Future<Option<uint64_t> > oldest = appending.front();
+  appending.pop_front();
+
+  return oldest
+    .then(defer(self(), &Self::__append, entries, next, appending, lambda::_1));
+}
+
+
+Future<Option<uint64_t> > LogWriterProcess::__append(
+    const Shared<vector<string> >& entries,
+    size_t next,
+    const list<Future<Option<uint64_t> > >& appending,
+    const Option<uint64_t>& position)
+{
+  // The writer has lost its promise, the remaining entries are not
+  // appended.
+  if (position.isNone()) {
+    return None();
+  }
+
+  return _append(entries, next, appending);
+}
+
+
 Future<Option<Log::Position> > LogWriterProcess::truncate(
     const Log::Position& to)
 {
@@ -743,7 +843,8 @@ Log::Log(
     int quorum,
     const string& path,
     const set<UPID>& pids,
-    bool autoInitialize)
+    bool autoInitialize,
+    const string& storage)
 {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
@@ -752,7 +853,8 @@ Log::Log(
         quorum,
         path,
         pids,
-        autoInitialize);
+        autoInitialize,
+        storage);
 
   spawn(process);
 }
@@ -764,7 +866,8 @@ Log::Log(
     const Duration& timeout,
     const string& znode,
     const Option<zookeeper::Authentication>& auth,
-    bool autoInitialize)
+    bool autoInitialize,
+    const string& storage)
 {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
@@ -776,7 +879,8 @@ Log::Log(
         timeout,
         znode,
         auth,
-        autoInitialize);
+        autoInitialize,
+        storage);
 
   spawn(process);
 }
@@ -835,9 +939,11 @@ Future<Log::Position> Log::Reader::ending()
 /////////////////////////////////////////////////
 
 
-Log::Writer::Writer(Log* log)
+Log::Writer::Writer(Log* log, size_t window, size_t batch)
 {
-  process = new LogWriterProcess(log);
+  CHECK_GT(batch, 0u);
+
+  process = new LogWriterProcess(log, window, batch);
   spawn(process);
 }
 
@@ -858,7 +964,22 @@ Future<Option<Log::Position> > Log::Writer::start()
 
 Future<Option<Log::Position> > Log::Writer::append(const string& data)
 {
-  return dispatch(process, &LogWriterProcess::append, data);
+  // NOTE: We need to cast the overloaded member function pointer.
+  Future<Option<Log::Position> > (LogWriterProcess::*append)(
+      const string&) = &LogWriterProcess::append;
+
+  return dispatch(process, append, data);
+}
+
+
+Future<Option<Log::Position> > Log::Writer::append(
+    const list<string>& entries)
+{
+  // NOTE: We need to cast the overloaded member function pointer.
+  Future<Option<Log::Position> > (LogWriterProcess::*append)(
+      const list<string>&) = &LogWriterProcess::append;
+
+  return dispatch(process, append, entries);
 }
 
 
@@ -157,8 +157,14 @@ public:
     // one writer (local or remote) can be valid at any point in
     // time. A writer becomes invalid if either Writer::append or
     // Writer::truncate return None, in which case, the writer (or
-    // another writer) must be restarted.
-    explicit Writer(Log* log);
+    // another writer) must be restarted. Up to 'window' appends and
+    // truncates can be in progress at the same time (e.g., a caller
+    // can issue the next append without waiting for the previous one
+    // to complete). They complete in the order they were issued.
+    // A batched append (see below) writes up to 'batch' entries to
+    // each replica at once; if the replicas do not support batched
+    // writes, the entries are written one by one after a timeout.
+    explicit Writer(Log* log, size_t window = 1, size_t batch = 1);
     ~Writer();
 
     // Attempts to get a promise (from the log's replicas) for
@@ -174,6 +180,16 @@ public:
     // by invoking Writer::start).
     process::Future<Option<Position> > append(const std::string& data);
 
+    // Attempts to append the specified entries to the log, in order,
+    // in batches of up to 'batch' entries and keeping up to 'window'
+    // batches in progress at a time. Returns
+    // the new ending position of the log (i.e., the position of the
+    // last entry) or 'none' if this writer has lost it's promise to
+    // exclusively write, in which case some of the entries might not
+    // have been appended.
+    process::Future<Option<Position> > append(
+        const std::list<std::string>& entries);
+
     // Attempts to truncate the log up to but not including the
     // specificed position. Returns the new ending position of the log
     // or 'none' if this writer has lost it's promise to exclusively
@@ -186,11 +202,14 @@ public:
 
   // Creates a new replicated log that assumes the specified quorum
   // size, is backed by a file at the specified path, and coordinates
-  // with other replicas via the set of process PIDs.
+  // with other replicas via the set of process PIDs. If the local
+  // replica does not have a log yet, it is stored using the specified
+  // storage engine (see Replica).
   Log(int quorum,
       const std::string& path,
       const std::set<process::UPID>& pids,
-      bool autoInitialize = false);
+      bool autoInitialize = false,
+      const std::string& storage = "leveldb");
 
   // Creates a new replicated log that assumes the specified quorum
   // size, is backed by a file at the specified path, and coordinates
@@ -202,7 +221,8 @@ public:
       const Duration& timeout,
       const std::string& znode,
       const Option<zookeeper::Authentication>& auth = None(),
-      bool autoInitialize = false);
+      bool autoInitialize = false,
+      const std::string& storage = "leveldb");
 
   ~Log();
 
@@ -19,29 +19,34 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/check.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/os.hpp>
 #include <stout/result.hpp>
 #include <stout/try.hpp>
 #include <stout/utils.hpp>
 
 #include "log/leveldb.hpp"
 #include "log/replica.hpp"
+#include "log/segmented.hpp"
 #include "log/storage.hpp"
 
 using namespace process;
 
 using std::list;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -52,17 +57,36 @@ namespace protocol {
 // Some replica protocol definitions.
 Protocol<PromiseRequest, PromiseResponse> promise;
 Protocol<WriteRequest, WriteResponse> write;
+Protocol<WriteBatchRequest, WriteBatchResponse> writeBatch;
 Protocol<RecoverRequest, RecoverResponse> recover;
+Protocol<LearnedRangeRequest, LearnedRangeResponse> learnedRange;
 
 } // namespace protocol {
 
 
+// The size above which a replica stops adding actions to a response
+// to a learned range request.
+static const Bytes MAX_LEARNED_RANGE_RESPONSE_SIZE = Megabytes(4);
+
+
+// Returns true if the specified path does not hold any log yet.
+static bool isEmpty(const string& path)
+{
+  if (!os::exists(path)) {
+    return true;
+  }
+
+  Try<list<string> > entries = os::ls(path);
+  return entries.isSome() && entries.get().empty();
+}
+
+
 class ReplicaProcess : public ProtobufProcess<ReplicaProcess>
 {
 public:
   // Constructs a new replica process using specified path to a
   // directory for storing the underlying log.
-  explicit ReplicaProcess(const string& path);
+  ReplicaProcess(const string& path, const string& storage);
 
   virtual ~ReplicaProcess();
 
@@ -102,6 +126,10 @@ public:
   // to storage. Returns true on success and false otherwise.
   bool update(const Metadata::Status& status);
 
+  // Persists the specified learned actions all at once. Returns true
+  // on success and false otherwise.
+  bool learn(const list<Action>& actions);
+
 private:
   // Handles a request from a proposer to promise not to accept writes
   // from any other proposer with lower proposal number.
@@ -110,15 +138,37 @@ private:
   // Handles a request from a proposer to write an action.
   void write(const UPID& from, const WriteRequest& request);
 
+  // Handles a request from a proposer to write a batch of actions.
+  void writeBatch(const UPID& from, const WriteBatchRequest& request);
+
+  // Determines the response to the specified write request. If the
+  // request is accepted, the action that needs to be persisted before
+  // responding is stored in 'accepted'. Returns none if this replica
+  // should not respond to the request.
+  Option<WriteResponse> prepare(
+      const UPID& from,
+      const WriteRequest& request,
+      Option<Action>* accepted);
+
   // Handles a request from a recover process.
   void recover(const UPID& from, const RecoverRequest& request);
 
+  // Handles a request for the learned actions of a range of positions.
+  void learnedRange(const UPID& from, const LearnedRangeRequest& request);
+
   // Handles a message notifying of a learned action.
   void learned(const UPID& from, const Action& action);
 
-  // Persists the specified action to storage. Returns true on success
-  // and false otherwise.
+  // Handles a message notifying of a batch of learned actions.
+  void learnedBatch(const UPID& from, const vector<Action>& actions);
+
+  // Persists the specified action(s) to storage. Returns true on
+  // success and false otherwise.
   bool persist(const Action& action);
+  bool persist(const list<Action>& actions);
+
+  // Updates the positions of the log after an action was persisted.
+  void updatePositions(const Action& action);
 
   // Updates the highest promise this replica has given. The update
   // will be persisted to storage. Returns true on success and false
@@ -149,13 +199,23 @@ private:
 };
 
 
-ReplicaProcess::ReplicaProcess(const string& path)
+ReplicaProcess::ReplicaProcess(const string& path, const string& _storage)
   : ProcessBase(ID::generate("log-replica")),
     begin(0),
     end(0)
 {
-  // TODO(benh): Factor out and expose storage.
-  storage = new LevelDBStorage();
+  CHECK(_storage == "leveldb" || _storage == "segmented")
+    << "Unknown log storage '" << _storage << "'";
+
+  // An existing segmented log is recognized by its metadata file,
+  // anything else is assumed to be a leveldb log unless it is a new
+  // log for which the segmented storage is requested.
+  if (SegmentedStorage::exists(path) ||
+      (_storage == "segmented" && isEmpty(path))) {
+    storage = new SegmentedStorage();
+  } else {
+    storage = new LevelDBStorage();
+  }
 
   restore(path);
 
@@ -166,12 +226,22 @@ ReplicaProcess::ReplicaProcess(const string& path)
   install<WriteRequest>(
       &ReplicaProcess::write);
 
+  install<WriteBatchRequest>(
+      &ReplicaProcess::writeBatch);
+
   install<RecoverRequest>(
       &ReplicaProcess::recover);
 
+  install<LearnedRangeRequest>(
+      &ReplicaProcess::learnedRange);
+
   install<LearnedMessage>(
       &ReplicaProcess::learned,
       &LearnedMessage::action);
+
+  install<LearnedBatchMessage>(
+      &ReplicaProcess::learnedBatch,
+      &LearnedBatchMessage::actions);
 }
 
 
@@ -521,6 +591,63 @@ void ReplicaProcess::promise(const UPID& from, const PromiseRequest& request)
 
 
 void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
+{
+  Option<Action> accepted;
+  Option<WriteResponse> response = prepare(from, request, &accepted);
+
+  if (response.isNone()) {
+    return;
+  }
+
+  if (accepted.isSome() && !persist(accepted.get())) {
+    return;
+  }
+
+  reply(response.get());
+}
+
+
+void ReplicaProcess::writeBatch(
+    const UPID& from,
+    const WriteBatchRequest& request)
+{
+  LOG(INFO) << "Replica received write request for "
+            << request.requests_size() << " positions from " << from;
+
+  WriteBatchResponse response;
+  list<Action> actions;
+
+  foreach (const WriteRequest& write, request.requests()) {
+    Option<Action> accepted;
+    Option<WriteResponse> result = prepare(from, write, &accepted);
+
+    // Like for a single write, we do not reply if we cannot respond
+    // to one of the requests. The proposer then considers this
+    // replica as unavailable for all the positions in the batch.
+    if (result.isNone()) {
+      return;
+    }
+
+    if (accepted.isSome()) {
+      actions.push_back(accepted.get());
+    }
+
+    response.add_responses()->CopyFrom(result.get());
+  }
+
+  // Persist all the accepted actions with a single write.
+  if (!actions.empty() && !persist(actions)) {
+    return;
+  }
+
+  reply(response);
+}
+
+
+Option<WriteResponse> ReplicaProcess::prepare(
+    const UPID& from,
+    const WriteRequest& request,
+    Option<Action>* accepted)
 {
   // Ignore write requests if this replica is not in VOTING status; we
   // also inform the requester, so that they can retry promptly.
@@ -533,8 +660,7 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
     response.set_okay(false);
     response.set_proposal(request.proposal());
     response.set_position(request.position());
-    reply(response);
-    return;
+    return response;
   }
 
   LOG(INFO) << "Replica received write request for position "
@@ -552,7 +678,7 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
       response.set_okay(false);
       response.set_proposal(promised());
       response.set_position(request.position());
-      reply(response);
+      return response;
     } else {
       Action action;
       action.set_position(request.position());
@@ -578,14 +704,14 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
           LOG(FATAL) << "Unknown Action::Type!";
       }
 
-      if (persist(action)) {
-        WriteResponse response;
-        response.set_type(WriteResponse::ACCEPT);
-        response.set_okay(true);
-        response.set_proposal(request.proposal());
-        response.set_position(request.position());
-        reply(response);
-      }
+      *accepted = action;
+
+      WriteResponse response;
+      response.set_type(WriteResponse::ACCEPT);
+      response.set_okay(true);
+      response.set_proposal(request.proposal());
+      response.set_position(request.position());
+      return response;
     }
   } else if (result.isSome()) {
     Action action = result.get();
@@ -597,7 +723,7 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
       response.set_okay(false);
       response.set_proposal(action.promised());
       response.set_position(request.position());
-      reply(response);
+      return response;
     } else {
       if (action.has_learned() && action.learned()) {
         // We ignore the write request if this position has already
@@ -657,17 +783,19 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
             LOG(FATAL) << "Unknown Action::Type!";
         }
 
-        if (persist(action)) {
-          WriteResponse response;
-          response.set_type(WriteResponse::ACCEPT);
-          response.set_okay(true);
-          response.set_proposal(request.proposal());
-          response.set_position(request.position());
-          reply(response);
-        }
+        *accepted = action;
+
+        WriteResponse response;
+        response.set_type(WriteResponse::ACCEPT);
+        response.set_okay(true);
+        response.set_proposal(request.proposal());
+        response.set_position(request.position());
+        return response;
       }
     }
   }
+
+  return None();
 }
 
 
@@ -689,6 +817,64 @@ void ReplicaProcess::recover(const UPID& from, const RecoverRequest& request)
 }
 
 
+void ReplicaProcess::learnedRange(
+    const UPID& from,
+    const LearnedRangeRequest& request)
+{
+  VLOG(2) << "Replica received a learned range request for positions "
+          << request.from() << " -> " << request.to() << " from " << from;
+
+  LearnedRangeResponse response;
+
+  // NOTE: Truncated positions are treated as learned by 'missing' but
+  // can not be read anymore, and positions past our end are unknown.
+  const uint64_t first = std::max(request.from(), begin);
+  const uint64_t last = std::min(request.to(), end);
+
+  // Only visit the learned positions in the range, rather than every
+  // position, since the range might span many holes.
+  IntervalSet<uint64_t> learned;
+
+  if (first <= last) {
+    learned += (Bound<uint64_t>::closed(first),
+                Bound<uint64_t>::closed(last));
+
+    learned -= unlearned;
+    learned -= holes;
+  }
+
+  Bytes size = 0;
+
+  foreach (const Interval<uint64_t>& interval, learned) {
+    for (uint64_t position = interval.lower();
+         position < interval.upper();
+         position++) {
+      if (size >= MAX_LEARNED_RANGE_RESPONSE_SIZE) {
+        reply(response);
+        return;
+      }
+
+      Result<Action> action = read(position);
+
+      if (action.isError()) {
+        LOG(ERROR) << "Failed to read position " << position
+                   << " for a learned range request: " << action.error();
+        reply(response);
+        return;
+      }
+
+      CHECK_SOME(action);
+      CHECK(action.get().has_learned() && action.get().learned());
+
+      size += Bytes(action.get().ByteSize());
+      response.add_actions()->CopyFrom(action.get());
+    }
+  }
+
+  reply(response);
+}
+
+
 void ReplicaProcess::learned(const UPID& from, const Action& action)
 {
   LOG(INFO) << "Replica received learned notice for position "
@@ -703,15 +889,54 @@ void ReplicaProcess::learned(const UPID& from, const Action& action)
 }
 
 
+void ReplicaProcess::learnedBatch(
+    const UPID& from,
+    const vector<Action>& actions)
+{
+  LOG(INFO) << "Replica received learned notice for " << actions.size()
+            << " positions from " << from;
+
+  if (learn(list<Action>(actions.begin(), actions.end()))) {
+    LOG(INFO) << "Replica learned " << actions.size() << " actions";
+  }
+}
+
+
+bool ReplicaProcess::learn(const list<Action>& actions)
+{
+  foreach (const Action& action, actions) {
+    CHECK(action.learned());
+  }
+
+  return persist(actions);
+}
+
+
 bool ReplicaProcess::persist(const Action& action)
 {
-  Try<Nothing> persisted = storage->persist(action);
+  return persist(list<Action>(1, action));
+}
+
+
+bool ReplicaProcess::persist(const list<Action>& actions)
+{
+  Try<Nothing> persisted = storage->persist(actions);
 
   if (persisted.isError()) {
     LOG(ERROR) << "Error writing to log: " << persisted.error();
     return false;
   }
 
+  foreach (const Action& action, actions) {
+    updatePositions(action);
+  }
+
+  return true;
+}
+
+
+void ReplicaProcess::updatePositions(const Action& action)
+{
   LOG(INFO) << "Persisted action at " << action.position();
 
   // No longer a hole here (if there even was one).
@@ -748,8 +973,6 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
-
-  return true;
 }
 
 
@@ -784,9 +1007,9 @@ void ReplicaProcess::restore(const string& path)
 }
 
 
-Replica::Replica(const string& path)
+Replica::Replica(const string& path, const string& storage)
 {
-  process = new ReplicaProcess(path);
+  process = new ReplicaProcess(path, storage);
   spawn(process);
 }
 
@@ -848,6 +1071,12 @@ Future<bool> Replica::update(const Metadata::Status& status)
 }
 
 
+Future<bool> Replica::learn(const list<Action>& actions)
+{
+  return dispatch(process, &ReplicaProcess::learn, actions);
+}
+
+
 PID<ReplicaProcess> Replica::pid() const
 {
   return process->self();
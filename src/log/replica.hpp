@@ -41,7 +41,9 @@ namespace protocol {
 // Some replica protocol declarations.
 extern Protocol<PromiseRequest, PromiseResponse> promise;
 extern Protocol<WriteRequest, WriteResponse> write;
+extern Protocol<WriteBatchRequest, WriteBatchResponse> writeBatch;
 extern Protocol<RecoverRequest, RecoverResponse> recover;
+extern Protocol<LearnedRangeRequest, LearnedRangeResponse> learnedRange;
 
 } // namespace protocol {
 
@@ -58,8 +60,13 @@ public:
   // with an empty log, it will not be allowed to vote (i.e., cannot
   // reply to any request except the recover request). The recover
   // process will later decide if this replica can be re-allowed to
-  // vote depending on the status of other replicas.
-  explicit Replica(const std::string& path);
+  // vote depending on the status of other replicas. A new log is
+  // stored using the specified storage engine ("leveldb" or
+  // "segmented"), while an existing log is always opened with the
+  // storage engine it was created with.
+  explicit Replica(
+      const std::string& path,
+      const std::string& storage = "leveldb");
   virtual ~Replica();
 
   // Returns all the actions between the specified positions, unless
@@ -96,6 +103,11 @@ public:
   // mocking in tests.
   virtual process::Future<bool> update(const Metadata::Status& status);
 
+  // Persists the specified learned actions (e.g., received from other
+  // replicas while catching up) all at once. Returns true on success
+  // and false otherwise.
+  process::Future<bool> learn(const std::list<Action>& actions);
+
   // Returns the PID associated with this replica.
   process::PID<ReplicaProcess> pid() const;
 
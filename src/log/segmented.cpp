@@ -0,0 +1,663 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include <stout/check.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
+
+#include "log/segmented.hpp"
+
+using std::list;
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace log {
+
+// The file storing the metadata of the replica.
+static const string METADATA = "METADATA";
+
+// The file locked while the log is open.
+static const string LOCK = "LOCK";
+
+// The prefix of the segment files, which are named after their
+// (zero-padded) identifier so that they are listed in order.
+static const string SEGMENT_PREFIX = "SEGMENT-";
+
+// Each record is prefixed by a header holding the length and the
+// checksum (CRC-32) of the serialized record, in host byte order.
+// Since segments are preallocated (i.e., zero-filled), a header with
+// a zero length marks the end of the records in a segment.
+struct Header
+{
+  uint32_t length;
+  uint32_t checksum;
+};
+
+
+const Bytes SegmentedStorage::DEFAULT_SEGMENT_SIZE = Megabytes(64);
+
+
+static uint32_t checksum(const char* data, size_t length)
+{
+  return ::crc32(
+      ::crc32(0L, Z_NULL, 0),
+      reinterpret_cast<const Bytef*>(data),
+      length);
+}
+
+
+// Syncs the specified directory so that the files created in (or
+// renamed into) it survive a crash.
+static Try<Nothing> fsyncDirectory(const string& directory)
+{
+  Try<int> fd = os::open(directory, O_RDONLY | O_CLOEXEC);
+  if (fd.isError()) {
+    return Error(fd.error());
+  }
+
+  if (::fsync(fd.get()) != 0) {
+    ErrnoError error("Failed to sync directory '" + directory + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  os::close(fd.get());
+  return Nothing();
+}
+
+
+bool SegmentedStorage::exists(const string& path)
+{
+  return os::exists(path::join(path, METADATA));
+}
+
+
+SegmentedStorage::SegmentedStorage(const Bytes& _segmentSize)
+  : segmentSize(_segmentSize)
+{
+  CHECK_GT(segmentSize, Bytes(sizeof(Header)));
+}
+
+
+SegmentedStorage::~SegmentedStorage()
+{
+  foreachvalue (const Segment& segment, segments) {
+    os::close(segment.fd);
+  }
+
+  if (lock.isSome()) {
+    os::close(lock.get()); // Releases the lock.
+  }
+}
+
+
+Try<Storage::State> SegmentedStorage::restore(const string& _path)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  Try<Nothing> mkdir = os::mkdir(_path);
+  if (mkdir.isError()) {
+    return Error("Failed to create '" + _path + "': " + mkdir.error());
+  }
+
+  Try<int> fd = os::open(
+      path::join(_path, LOCK),
+      O_RDWR | O_CREAT | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error("Failed to open lock file: " + fd.error());
+  }
+
+  if (::flock(fd.get(), LOCK_EX | LOCK_NB) != 0) {
+    ErrnoError error("Failed to lock '" + _path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  lock = fd.get();
+  path = _path;
+
+  State state;
+  state.begin = 0;
+  state.end = 0;
+
+  // Restore the metadata, or write the initial (empty) metadata so
+  // that this path is known to hold a segmented log from now on.
+  if (exists(path.get())) {
+    Try<string> read = os::read(path::join(path.get(), METADATA));
+    if (read.isError()) {
+      return Error("Failed to read metadata: " + read.error());
+    }
+
+    Record record;
+    if (!record.ParseFromString(read.get()) ||
+        record.type() != Record::METADATA) {
+      return Error("Failed to deserialize metadata");
+    }
+
+    state.metadata.CopyFrom(record.metadata());
+  } else {
+    state.metadata.set_status(Metadata::EMPTY);
+    state.metadata.set_promised(0);
+
+    Try<Nothing> persist = this->persist(state.metadata);
+    if (persist.isError()) {
+      return Error(persist.error());
+    }
+  }
+
+  Try<list<string> > entries = os::ls(path.get());
+  if (entries.isError()) {
+    return Error("Failed to list '" + path.get() + "': " + entries.error());
+  }
+
+  foreach (const string& entry, entries.get()) {
+    if (!strings::startsWith(entry, SEGMENT_PREFIX)) {
+      continue;
+    }
+
+    Try<uint64_t> id =
+      numify<uint64_t>(strings::remove(entry, SEGMENT_PREFIX, strings::PREFIX));
+
+    if (id.isError()) {
+      return Error("Unexpected segment '" + entry + "': " + id.error());
+    }
+
+    Segment segment;
+    segment.path = path::join(path.get(), entry);
+    segment.offset = 0;
+    segment.sealed = false;
+
+    Try<int> fd = os::open(segment.path, O_RDWR | O_CLOEXEC);
+    if (fd.isError()) {
+      return Error("Failed to open segment: " + fd.error());
+    }
+
+    segment.fd = fd.get();
+
+    struct stat s;
+    if (::fstat(segment.fd, &s) != 0) {
+      ErrnoError error("Failed to stat segment '" + segment.path + "'");
+      os::close(segment.fd);
+      return error;
+    }
+
+    segment.size = s.st_size;
+
+    segments[id.get()] = segment;
+  }
+
+  // Replay the segments in the order in which they were written.
+  uint64_t records = 0;
+  foreachpair (uint64_t id, Segment& segment, segments) {
+    Try<uint64_t> replayed = replay(id, &segment, &state);
+    if (replayed.isError()) {
+      return Error(replayed.error());
+    }
+
+    records += replayed.get();
+  }
+
+  LOG(INFO) << "Replayed " << records << " records in "
+            << segments.size() << " segments in " << stopwatch.elapsed();
+
+  return state;
+}
+
+
+Try<uint64_t> SegmentedStorage::replay(
+    uint64_t id,
+    Segment* segment,
+    State* state)
+{
+  if (segment->size == 0) {
+    return 0;
+  }
+
+  void* mapped = ::mmap(
+      NULL, segment->size, PROT_READ, MAP_SHARED, segment->fd, 0);
+
+  if (mapped == MAP_FAILED) {
+    return ErrnoError("Failed to map segment '" + segment->path + "'");
+  }
+
+  ::madvise(mapped, segment->size, MADV_SEQUENTIAL);
+
+  const char* data = static_cast<const char*>(mapped);
+
+  uint64_t records = 0;
+
+  while (segment->offset + sizeof(Header) <= segment->size) {
+    Header header;
+    memcpy(&header, data + segment->offset, sizeof(header));
+
+    // We reached the (preallocated) end of the records.
+    if (header.length == 0) {
+      break;
+    }
+
+    const uint64_t length = sizeof(Header) + header.length;
+    const char* bytes = data + segment->offset + sizeof(Header);
+
+    // A record which was only partially written (e.g., because of a
+    // crash) is the end of the segment. We never append to such a
+    // segment again since it is not known where the record ends.
+    Record record;
+    if (segment->offset + length > segment->size ||
+        checksum(bytes, header.length) != header.checksum ||
+        !record.ParseFromArray(bytes, header.length) ||
+        record.type() != Record::ACTION) {
+      LOG(WARNING) << "Ignoring the records of segment '" << segment->path
+                   << "' past the invalid record at offset "
+                   << segment->offset;
+
+      segment->sealed = true;
+      break;
+    }
+
+    const Action& action = record.action();
+
+    Location location;
+    location.segment = id;
+    location.offset = segment->offset;
+    location.length = header.length;
+
+    index[action.position()] = location;
+
+    segment->last = max(segment->last, action.position());
+
+    if (action.has_learned() && action.learned()) {
+      state->learned.insert(action.position());
+      state->unlearned.erase(action.position());
+      if (action.has_type() && action.type() == Action::TRUNCATE) {
+        state->begin = std::max(state->begin, action.truncate().to());
+
+        // Forget the truncated positions, as if their records had
+        // already been deleted along with their segments.
+        const Interval<uint64_t> truncated =
+          (Bound<uint64_t>::closed(0),
+           Bound<uint64_t>::open(action.truncate().to()));
+
+        state->learned -= truncated;
+        state->unlearned -= truncated;
+
+        index.erase(index.begin(), index.lower_bound(action.truncate().to()));
+      }
+    } else {
+      state->learned.erase(action.position());
+      state->unlearned.insert(action.position());
+    }
+
+    state->end = std::max(state->end, action.position());
+
+    segment->offset += length;
+    records++;
+  }
+
+  ::munmap(mapped, segment->size);
+
+  return records;
+}
+
+
+Try<Nothing> SegmentedStorage::persist(const Metadata& metadata)
+{
+  CHECK_SOME(path);
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  Record record;
+  record.set_type(Record::METADATA);
+  record.mutable_metadata()->CopyFrom(metadata);
+
+  string value;
+
+  if (!record.SerializeToString(&value)) {
+    return Error("Failed to serialize record");
+  }
+
+  // We atomically replace the metadata by renaming a synced copy.
+  const string temporary = path::join(path.get(), METADATA + ".tmp");
+
+  Try<int> fd = os::open(
+      temporary,
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error("Failed to open '" + temporary + "': " + fd.error());
+  }
+
+  Try<Nothing> write = os::write(fd.get(), value);
+  if (write.isError()) {
+    os::close(fd.get());
+    return Error("Failed to write '" + temporary + "': " + write.error());
+  }
+
+  if (::fsync(fd.get()) != 0) {
+    ErrnoError error("Failed to sync '" + temporary + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  os::close(fd.get());
+
+  Try<Nothing> rename = os::rename(temporary, path::join(path.get(), METADATA));
+  if (rename.isError()) {
+    return Error("Failed to rename '" + temporary + "': " + rename.error());
+  }
+
+  Try<Nothing> sync = fsyncDirectory(path.get());
+  if (sync.isError()) {
+    return Error(sync.error());
+  }
+
+  LOG(INFO) << "Persisting metadata (" << value.size()
+            << " bytes) took " << stopwatch.elapsed();
+
+  return Nothing();
+}
+
+
+Try<Nothing> SegmentedStorage::persist(const Action& action)
+{
+  return persist(list<Action>(1, action));
+}
+
+
+Try<Nothing> SegmentedStorage::persist(const list<Action>& actions)
+{
+  CHECK_SOME(path);
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // Append all the records with a single write (and sync).
+  string buffer;
+  list<uint32_t> lengths;
+
+  foreach (const Action& action, actions) {
+    Record record;
+    record.set_type(Record::ACTION);
+    record.mutable_action()->MergeFrom(action);
+
+    string value;
+
+    if (!record.SerializeToString(&value)) {
+      return Error("Failed to serialize record");
+    }
+
+    Header header;
+    header.length = value.size();
+    header.checksum = checksum(value.data(), value.size());
+
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    buffer.append(value);
+
+    lengths.push_back(header.length);
+  }
+
+  if (segments.empty() ||
+      segments.rbegin()->second.sealed ||
+      segments.rbegin()->second.offset + buffer.size() >
+        segments.rbegin()->second.size) {
+    Try<Nothing> rolled = roll(buffer.size());
+    if (rolled.isError()) {
+      return Error("Failed to create segment: " + rolled.error());
+    }
+  }
+
+  const uint64_t id = segments.rbegin()->first;
+  Segment& segment = segments.rbegin()->second;
+
+  size_t written = 0;
+  while (written < buffer.size()) {
+    ssize_t length = ::pwrite(
+        segment.fd,
+        buffer.data() + written,
+        buffer.size() - written,
+        segment.offset + written);
+
+    if (length < 0 && errno == EINTR) {
+      continue;
+    } else if (length < 0) {
+      // Since the records might have been partially written, do not
+      // append to this segment anymore.
+      segment.sealed = true;
+      return ErrnoError("Failed to write to segment '" + segment.path + "'");
+    }
+
+    written += length;
+  }
+
+  // The segment is preallocated, hence there is no need to sync its
+  // (file size) metadata.
+  if (::fdatasync(segment.fd) != 0) {
+    segment.sealed = true;
+    return ErrnoError("Failed to sync segment '" + segment.path + "'");
+  }
+
+  foreach (const Action& action, actions) {
+    Location location;
+    location.segment = id;
+    location.offset = segment.offset;
+    location.length = lengths.front();
+
+    index[action.position()] = location;
+
+    segment.last = max(segment.last, action.position());
+    segment.offset += sizeof(Header) + lengths.front();
+
+    lengths.pop_front();
+  }
+
+  LOG(INFO) << "Persisting " << actions.size() << " action(s) ("
+            << buffer.size() << " bytes) took " << stopwatch.elapsed();
+
+  // Drop the positions (and segments) preceding a learned truncation.
+  foreach (const Action& action, actions) {
+    if (action.has_type() && action.type() == Action::TRUNCATE &&
+        action.has_learned() && action.learned()) {
+      CHECK(action.has_truncate());
+      truncate(action.truncate().to());
+    }
+  }
+
+  return Nothing();
+}
+
+
+Try<Nothing> SegmentedStorage::roll(uint64_t bytes)
+{
+  CHECK_SOME(path);
+
+  const uint64_t id = segments.empty() ? 0 : segments.rbegin()->first + 1;
+
+  Try<string> name = strings::format(
+      "%s%020llu",
+      SEGMENT_PREFIX.c_str(),
+      static_cast<unsigned long long>(id));
+
+  CHECK_SOME(name);
+
+  Segment segment;
+  segment.path = path::join(path.get(), name.get());
+  segment.size = std::max(segmentSize.bytes(), bytes);
+  segment.offset = 0;
+  segment.sealed = false;
+
+  Try<int> fd = os::open(
+      segment.path,
+      O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error(fd.error());
+  }
+
+  segment.fd = fd.get();
+
+  // Preallocate the segment. Fall back to a sparse file if the
+  // filesystem does not support preallocation.
+  int error = ::posix_fallocate(segment.fd, 0, segment.size);
+  if (error != 0) {
+    LOG(WARNING) << "Failed to preallocate segment '" << segment.path
+                 << "': " << strerror(error);
+
+    if (::ftruncate(segment.fd, segment.size) != 0) {
+      ErrnoError error("Failed to resize segment '" + segment.path + "'");
+      os::close(segment.fd);
+      os::rm(segment.path);
+      return error;
+    }
+  }
+
+  if (::fsync(segment.fd) != 0) {
+    ErrnoError error("Failed to sync segment '" + segment.path + "'");
+    os::close(segment.fd);
+    os::rm(segment.path);
+    return error;
+  }
+
+  Try<Nothing> sync = fsyncDirectory(path.get());
+  if (sync.isError()) {
+    os::close(segment.fd);
+    os::rm(segment.path);
+    return Error(sync.error());
+  }
+
+  segments[id] = segment;
+
+  LOG(INFO) << "Created segment '" << segment.path << "' of "
+            << Bytes(segment.size);
+
+  return Nothing();
+}
+
+
+void SegmentedStorage::truncate(uint64_t to)
+{
+  index.erase(index.begin(), index.lower_bound(to));
+
+  // Delete the segments which only hold truncated positions. Note
+  // that we never delete the last segment since it is appended to.
+  // Similar to the leveldb storage, this is best-effort: a segment
+  // which fails to be deleted is deleted on a later truncation.
+  std::map<uint64_t, Segment>::iterator iterator = segments.begin();
+  while (iterator != segments.end() &&
+         iterator->first != segments.rbegin()->first) {
+    const Segment& segment = iterator->second;
+
+    if (segment.last.isSome() && segment.last.get() >= to) {
+      ++iterator;
+      continue;
+    }
+
+    Try<Nothing> rm = os::rm(segment.path);
+    if (rm.isError()) {
+      LOG(WARNING) << "Ignoring failure to delete segment '"
+                   << segment.path << "': " << rm.error();
+      ++iterator;
+      continue;
+    }
+
+    LOG(INFO) << "Deleted segment '" << segment.path << "'";
+
+    os::close(segment.fd);
+    segments.erase(iterator++);
+  }
+}
+
+
+Try<Action> SegmentedStorage::read(uint64_t position)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  if (index.count(position) == 0) {
+    return Error("Position " + stringify(position) + " not found");
+  }
+
+  const Location& location = index[position];
+
+  CHECK_EQ(1u, segments.count(location.segment));
+  const Segment& segment = segments[location.segment];
+
+  string value(location.length, '\0');
+
+  size_t read = 0;
+  while (read < value.size()) {
+    ssize_t length = ::pread(
+        segment.fd,
+        &value[read],
+        value.size() - read,
+        location.offset + sizeof(Header) + read);
+
+    if (length < 0 && errno == EINTR) {
+      continue;
+    } else if (length < 0) {
+      return ErrnoError("Failed to read segment '" + segment.path + "'");
+    } else if (length == 0) {
+      return Error("Unexpected end of segment '" + segment.path + "'");
+    }
+
+    read += length;
+  }
+
+  Record record;
+
+  if (!record.ParseFromString(value)) {
+    return Error("Failed to deserialize record");
+  }
+
+  if (record.type() != Record::ACTION) {
+    return Error("Bad record");
+  }
+
+  LOG(INFO) << "Reading position from segment took " << stopwatch.elapsed();
+
+  return record.action();
+}
+
+} // namespace log {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,123 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LOG_SEGMENTED_HPP__
+#define __LOG_SEGMENTED_HPP__
+
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <string>
+
+#include <stout/bytes.hpp>
+#include <stout/option.hpp>
+
+#include "log/storage.hpp"
+
+namespace mesos {
+namespace internal {
+namespace log {
+
+// Concrete implementation of the storage interface using append-only
+// segment files. Each persisted action is appended as a record to the
+// last segment (records are never updated in place), and an index
+// maps each position to the location of its latest record. Segments
+// are preallocated so that appending a record only requires syncing
+// its data. A learned truncation drops the segments which only hold
+// truncated positions, and recovery replays the segments using
+// memory-mapped reads. The metadata is stored in its own file.
+class SegmentedStorage : public Storage
+{
+public:
+  // The default (preallocated) size of a segment.
+  static const Bytes DEFAULT_SEGMENT_SIZE;
+
+  // Returns true if the specified path holds a segmented log.
+  static bool exists(const std::string& path);
+
+  explicit SegmentedStorage(const Bytes& segmentSize = DEFAULT_SEGMENT_SIZE);
+  virtual ~SegmentedStorage();
+
+  virtual Try<State> restore(const std::string& path);
+  virtual Try<Nothing> persist(const Metadata& metadata);
+  virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::list<Action>& actions);
+  virtual Try<Action> read(uint64_t position);
+
+private:
+  struct Segment
+  {
+    int fd;
+    std::string path;
+    uint64_t size;   // Preallocated size of the segment.
+    uint64_t offset; // End of the records in the segment.
+
+    // Whether the segment ends with a record which might have only
+    // been partially written, in which case we do not append to it.
+    bool sealed;
+
+    // The highest position of the records in the segment. None if
+    // the segment does not have any record.
+    Option<uint64_t> last;
+  };
+
+  // The location of the (latest) record of a position.
+  struct Location
+  {
+    uint64_t segment;
+    uint64_t offset;
+    uint32_t length;
+  };
+
+  // Replays the records of the specified segment, updating the index
+  // and the state. Returns the end of the (valid) records.
+  Try<uint64_t> replay(uint64_t id, Segment* segment, State* state);
+
+  // Creates a new segment to be appended to, which can hold at least
+  // the specified number of bytes.
+  Try<Nothing> roll(uint64_t bytes);
+
+  // Removes the positions preceding the specified position from the
+  // index, and deletes the segments which only hold such positions.
+  void truncate(uint64_t to);
+
+  const Bytes segmentSize;
+
+  Option<std::string> path;
+
+  // The (locked) file which prevents the log from being opened more
+  // than once at the same time.
+  Option<int> lock;
+
+  // All the segments, keyed by a monotonically increasing identifier.
+  // Records are always appended to the last segment.
+  std::map<uint64_t, Segment> segments;
+
+  // The position index, which is dense: every position stored by this
+  // replica has an entry locating its latest record, so that a read
+  // never scans a segment. Holes (and truncated positions) do not
+  // have an entry.
+  std::map<uint64_t, Location> index;
+};
+
+} // namespace log {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __LOG_SEGMENTED_HPP__
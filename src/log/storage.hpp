@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 
+#include <list>
 #include <string>
 
 #include <stout/interval.hpp>
@@ -55,6 +56,10 @@ public:
   virtual Try<State> restore(const std::string& path) = 0;
   virtual Try<Nothing> persist(const Metadata& metadata) = 0;
   virtual Try<Nothing> persist(const Action& action) = 0;
+
+  // Persists the specified actions atomically (i.e., either all or
+  // none of them are persisted).
+  virtual Try<Nothing> persist(const std::list<Action>& actions) = 0;
   virtual Try<Action> read(uint64_t position) = 0;
 };
 
@@ -19,8 +19,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <deque>
 #include <iostream>
 #include <fstream>
+#include <list>
 #include <sstream>
 
 #include <process/clock.hpp>
@@ -44,8 +46,10 @@
 using namespace process;
 
 using std::cout;
+using std::deque;
 using std::endl;
 using std::ifstream;
+using std::list;
 using std::ofstream;
 using std::string;
 using std::vector;
@@ -90,6 +94,23 @@ Benchmark::Flags::Flags()
       "  random: all bits are randomly chosen\n",
       "random");
 
+  add(&Flags::window,
+      "window",
+      "Maximum number of appends in progress at the same time",
+      1);
+
+  add(&Flags::batch,
+      "batch",
+      "Number of consecutive appends written to the replicas at once\n"
+      "(requires all replicas to support batched writes if larger than 1)",
+      1);
+
+  add(&Flags::storage,
+      "storage",
+      "Storage engine of a new log (leveldb, segmented). An existing\n"
+      "log is always opened with the storage engine it was created with",
+      "leveldb");
+
   add(&Flags::initialize,
       "initialize",
       "Whether to initialize the log",
@@ -106,7 +127,8 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
       "replicated log. It takes a trace file of write sizes\n"
       "and replay that trace to measure the latency of each\n"
       "write. The data to be written for each write can be\n"
-      "specified using the --type flag.\n"
+      "specified using the --type flag. Up to --window writes\n"
+      "of --batch appends each are in progress at the same time.\n"
       "\n");
 
   // Configure the tool by parsing command line arguments.
@@ -148,10 +170,19 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     return Error(flags.usage("Missing required option --output"));
   }
 
+  if (flags.window == 0) {
+    return Error(flags.usage("Expecting --window to be positive"));
+  }
+
+  if (flags.batch == 0) {
+    return Error(flags.usage("Expecting --batch to be positive"));
+  }
+
   // Initialize the log.
   if (flags.initialize) {
     Initialize initialize;
     initialize.flags.path = flags.path;
+    initialize.flags.storage = flags.storage;
 
     Try<Nothing> execution = initialize.execute();
     if (execution.isError()) {
@@ -168,7 +199,7 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
       flags.znode.get());
 
   // Create the log writer.
-  Log::Writer writer(&log);
+  Log::Writer writer(&log, flags.window, flags.batch);
 
   Future<Option<Log::Position> > position = writer.start();
 
@@ -185,6 +216,7 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
   vector<Bytes> sizes;
   vector<Duration> durations;
   vector<Time> timestamps;
+  Bytes total;
 
   // Read sizes from the input trace file.
   ifstream input(flags.input.get().c_str());
@@ -200,6 +232,7 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     }
 
     sizes.push_back(size.get());
+    total += size.get();
   }
 
   input.close();
@@ -216,14 +249,43 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     }
   }
 
+  // The writes in progress along with the time they were issued.
+  // They complete in the order they were issued, so we always wait
+  // for the oldest one. Each write appends up to --batch entries.
+  deque<Future<Option<Log::Position> > > appending;
+  deque<Stopwatch> stopwatches;
+  deque<size_t> batches;
+
+  // The number of entries appended by each write.
+  vector<size_t> counts;
+
   Stopwatch stopwatch;
   stopwatch.start();
 
-  for (size_t i = 0; i < sizes.size(); i++) {
-    Stopwatch stopwatch;
-    stopwatch.start();
+  for (size_t i = 0; i < sizes.size() || !appending.empty();) {
+    if (i < sizes.size() && appending.size() < flags.window) {
+      Stopwatch stopwatch;
+      stopwatch.start();
+
+      if (flags.batch == 1) {
+        appending.push_back(writer.append(data[i++]));
+        batches.push_back(1);
+      } else {
+        list<string> entries;
+        while (i < sizes.size() && entries.size() < flags.batch) {
+          entries.push_back(data[i++]);
+        }
+
+        appending.push_back(writer.append(entries));
+        batches.push_back(entries.size());
+      }
+
+      stopwatches.push_back(stopwatch);
+      continue;
+    }
 
-    position = writer.append(data[i]);
+    position = appending.front();
+    appending.pop_front();
 
     if (!position.await(Seconds(10))) {
       return Error("Failed to append: timed out");
@@ -236,12 +298,31 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
       return Error("Failed to append: exclusive write promise lost");
     }
 
-    durations.push_back(stopwatch.elapsed());
+    durations.push_back(stopwatches.front().elapsed());
+    stopwatches.pop_front();
     timestamps.push_back(Clock::now());
+    counts.push_back(batches.front());
+    batches.pop_front();
   }
 
+  const Duration elapsed = stopwatch.elapsed();
+
   cout << "Total number of appends: " << sizes.size() << endl;
-  cout << "Total time used: " << stopwatch.elapsed() << endl;
+  cout << "Total time used: " << elapsed << endl;
+
+  // Each write costs every replica one synchronous write (fsync) to
+  // persist the entries and one to persist that they were learned.
+  cout << "Total number of writes: " << counts.size() << endl;
+
+  if (elapsed > Duration::zero()) {
+    cout << "Throughput: "
+         << sizes.size() / elapsed.secs() << " appends/s, "
+         << Bytes(static_cast<uint64_t>(total.bytes() / elapsed.secs()))
+         << "/s, "
+         << 2 * counts.size() / elapsed.secs() << " fsyncs/s per replica"
+         << " (window " << flags.window
+         << ", batch " << flags.batch << ")" << endl;
+  }
 
   // Ouput statistics.
   ofstream output(flags.output.get().c_str());
@@ -249,10 +330,20 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     return Error("Failed to open the output file " + flags.output.get());
   }
 
-  for (size_t i = 0; i < sizes.size(); i++) {
+  for (size_t i = 0, next = 0; i < counts.size(); i++) {
+    Bytes size;
+    for (size_t j = 0; j < counts[i]; j++) {
+      size += sizes[next++];
+    }
+
     output << timestamps[i]
-           << " Appended " << sizes[i].bytes() << " bytes"
-           << " in " << durations[i].ms() << " ms" << endl;
+           << " Appended " << size.bytes() << " bytes";
+
+    if (flags.batch > 1) {
+      output << " (" << counts[i] << " entries)";
+    }
+
+    output << " in " << durations[i].ms() << " ms" << endl;
   }
 
   return Nothing();
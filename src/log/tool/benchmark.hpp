@@ -46,6 +46,9 @@ public:
     Option<std::string> input;
     Option<std::string> output;
     std::string type;
+    size_t window;
+    size_t batch;
+    std::string storage;
     bool initialize;
     bool help;
   };
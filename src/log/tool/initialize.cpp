@@ -45,6 +45,12 @@ Initialize::Flags::Flags()
       "timeout",
       "Maximum time allowed for the command to finish\n"
       "(e.g., 500ms, 1sec, etc.)");
+
+  add(&Flags::storage,
+      "storage",
+      "Storage engine of a new log (leveldb, segmented). An existing\n"
+      "log is always opened with the storage engine it was created with",
+      "leveldb");
 }
 
 
@@ -75,13 +81,17 @@ Try<Nothing> Initialize::execute(int argc, char** argv)
     return Error(flags.usage("Missing required option --path"));
   }
 
+  if (flags.storage != "leveldb" && flags.storage != "segmented") {
+    return Error(flags.usage("Unknown storage '" + flags.storage + "'"));
+  }
+
   // Setup the timeout if specified.
   Option<Timeout> timeout = None();
   if (flags.timeout.isSome()) {
     timeout = Timeout::in(flags.timeout.get());
   }
 
-  Replica replica(flags.path.get());
+  Replica replica(flags.path.get(), flags.storage);
 
   // Get the current status of the replica.
   Future<Metadata::Status> status = replica.status();
@@ -57,6 +57,12 @@ Replica::Flags::Flags()
       "znode",
       "ZooKeeper znode");
 
+  add(&Flags::storage,
+      "storage",
+      "Storage engine of a new log (leveldb, segmented). An existing\n"
+      "log is always opened with the storage engine it was created with",
+      "leveldb");
+
   add(&Flags::initialize,
       "initialize",
       "Whether to initialize the log",
@@ -107,6 +113,7 @@ Try<Nothing> Replica::execute(int argc, char** argv)
   if (flags.initialize) {
     Initialize initialize;
     initialize.flags.path = flags.path;
+    initialize.flags.storage = flags.storage;
 
     Try<Nothing> execution = initialize.execute();
     if (execution.isError()) {
@@ -247,10 +247,13 @@ protected:
 
   struct Metrics
   {
+    // NOTE: The allocator is not given the flags of the master, thus
+    // its gauge is always sampled at the default interval.
     explicit Metrics(const Self& process)
       : event_queue_dispatches(
             "allocator/event_queue_dispatches",
-            process::defer(process.self(), &Self::_event_queue_dispatches))
+            process::defer(process.self(), &Self::_event_queue_dispatches),
+            DEFAULT_METRICS_SAMPLING_INTERVAL)
     {
       process::metrics::add(event_queue_dispatches);
     }
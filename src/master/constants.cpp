@@ -40,6 +40,7 @@ const size_t MAX_REMOVED_SLAVES = 100000;
 const uint32_t MAX_COMPLETED_FRAMEWORKS = 50;
 const uint32_t MAX_COMPLETED_TASKS_PER_FRAMEWORK = 1000;
 const Duration WHITELIST_WATCH_INTERVAL = Seconds(5);
+const Duration DEFAULT_METRICS_SAMPLING_INTERVAL = Seconds(1);
 const uint32_t TASK_LIMIT = 100;
 const std::string MASTER_INFO_LABEL = "info";
 const std::string MASTER_INFO_JSON_LABEL = "json.info";
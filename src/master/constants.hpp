@@ -100,6 +100,10 @@ extern const uint32_t MAX_COMPLETED_TASKS_PER_FRAMEWORK;
 // Time interval to check for updated watchers list.
 extern const Duration WHITELIST_WATCH_INTERVAL;
 
+// Default minimum interval between two evaluations of a metrics
+// gauge of the master (or the allocator).
+extern const Duration DEFAULT_METRICS_SAMPLING_INTERVAL;
+
 // Default number of tasks (limit) for /master/tasks endpoint.
 extern const uint32_t TASK_LIMIT;
 
@@ -103,6 +103,17 @@ mesos::internal::master::Flags::Flags()
       "after which the operation is considered a failure.",
       Seconds(5));
 
+  add(&Flags::registry_diffs_between_snapshots,
+      "registry_diffs_between_snapshots",
+      "Number of updates of the registry which are written to the\n"
+      "replicated log as deltas (i.e., only the parts of the registry that\n"
+      "changed) before the whole registry is written again. A higher value\n"
+      "reduces the amount of data written for each update, but increases\n"
+      "the number of log entries to read when recovering the registry.\n"
+      "NOTE: Masters before 0.26.0 can not read the deltas, so this should\n"
+      "remain 0 until all masters have been upgraded.",
+      0);
+
   add(&Flags::log_auto_initialize,
       "log_auto_initialize",
       "Whether to automatically initialize the replicated log used for the\n"
@@ -110,6 +121,14 @@ mesos::internal::master::Flags::Flags()
       "initialized when used for the very first time.",
       true);
 
+  add(&Flags::log_storage,
+      "log_storage",
+      "The storage engine of the replicated log used for the registry\n"
+      "(i.e., 'leveldb' or 'segmented'). This only applies when the log\n"
+      "is created: an existing log is always opened with the storage\n"
+      "engine it was created with.",
+      "leveldb");
+
   add(&Flags::slave_reregister_timeout,
       "slave_reregister_timeout",
       "The timeout within which all slaves are expected to re-register\n"
@@ -421,6 +440,15 @@ mesos::internal::master::Flags::Flags()
         return None();
       });
 
+  add(&Flags::metrics_sampling_interval,
+      "metrics_sampling_interval",
+      "Minimum amount of time between two evaluations of a metrics gauge\n"
+      "of the master (e.g., 'master/tasks_running'). In the meantime the\n"
+      "last value of the gauge is reported, so that requests for metrics\n"
+      "do not wait on a busy master. A zero interval evaluates the gauges\n"
+      "on every request.",
+      DEFAULT_METRICS_SAMPLING_INTERVAL);
+
 
   add(&Flags::authorizers,
       "authorizers",
@@ -54,7 +54,9 @@ public:
   bool registry_strict;
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
+  size_t registry_diffs_between_snapshots;
   bool log_auto_initialize;
+  std::string log_storage;
   Duration slave_reregister_timeout;
   std::string recovery_slave_removal_limit;
   Option<std::string> slave_removal_rate_limit;
@@ -63,6 +65,7 @@ public:
   std::string user_sorter;
   std::string framework_sorter;
   Duration allocation_interval;
+  Duration metrics_sampling_interval;
   Option<std::string> cluster;
   Option<std::string> roles;
   Option<std::string> weights;
@@ -273,6 +273,12 @@ int main(int argc, char** argv)
         << "--work_dir needed for replicated log based registry";
     }
 
+    if (flags.log_storage != "leveldb" && flags.log_storage != "segmented") {
+      EXIT(EXIT_FAILURE)
+        << "'" << flags.log_storage << "' is not a supported"
+        << " storage engine for the replicated log";
+    }
+
     Try<Nothing> mkdir = os::mkdir(flags.work_dir.get());
     if (mkdir.isError()) {
       EXIT(EXIT_FAILURE)
@@ -300,16 +306,23 @@ int main(int argc, char** argv)
           flags.zk_session_timeout,
           path::join(url.get().path, "log_replicas"),
           url.get().authentication,
-          flags.log_auto_initialize);
+          flags.log_auto_initialize,
+          flags.log_storage);
     } else {
       // Use replicated log without ZooKeeper.
       log = new Log(
           1,
           path::join(flags.work_dir.get(), "replicated_log"),
           set<UPID>(),
-          flags.log_auto_initialize);
+          flags.log_auto_initialize,
+          flags.log_storage);
     }
-    storage = new state::LogStorage(log);
+    // The registry is only written as deltas when the operator opts
+    // in with '--registry_diffs_between_snapshots'.
+    storage = new state::LogStorage(
+        log,
+        flags.registry_diffs_between_snapshots,
+        true);
   } else {
     EXIT(EXIT_FAILURE)
       << "'" << flags.registry << "' is not a supported"
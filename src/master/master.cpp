@@ -288,7 +288,11 @@ Master::Master(
     detector(_detector),
     authorizer(_authorizer),
     authenticator(None()),
-    metrics(new Metrics(*this)),
+    metrics(new Metrics(
+        *this,
+        _flags.metrics_sampling_interval > Duration::zero()
+          ? Option<Duration>(_flags.metrics_sampling_interval)
+          : None())),
     electedTime(None())
 {
   slaves.limiter = _slaveRemovalLimiter;
@@ -1603,6 +1607,8 @@ void Master::detected(const Future<Option<MasterInfo>>& _leader)
   bool wasElected = elected();
   leader = _leader.get();
 
+  metrics->elected = elected() ? 1 : 0;
+
   LOG(INFO) << "The newly elected leader is "
             << (leader.isSome()
                 ? (leader.get().pid() + " with id " + leader.get().id())
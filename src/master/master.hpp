@@ -1207,11 +1207,6 @@ private:
     return (process::Clock::now() - startTime).secs();
   }
 
-  double _elected()
-  {
-    return elected() ? 1 : 0;
-  }
-
   double _slaves_connected();
   double _slaves_disconnected();
   double _slaves_active();
@@ -39,49 +39,60 @@ namespace master {
 // Message counters are named with "messages_" prefix so they can
 // be grouped together alphabetically in the output.
 // TODO(alexandra.sava): Add metrics for registered and removed slaves.
-Metrics::Metrics(const Master& master)
+Metrics::Metrics(const Master& master, const Option<Duration>& interval)
   : uptime_secs(
         "master/uptime_secs",
-        defer(master, &Master::_uptime_secs)),
-    elected(
-        "master/elected",
-        defer(master, &Master::_elected)),
+        defer(master, &Master::_uptime_secs),
+        interval),
+    elected("master/elected"),
     slaves_connected(
         "master/slaves_connected",
-        defer(master, &Master::_slaves_connected)),
+        defer(master, &Master::_slaves_connected),
+        interval),
     slaves_disconnected(
         "master/slaves_disconnected",
-        defer(master, &Master::_slaves_disconnected)),
+        defer(master, &Master::_slaves_disconnected),
+        interval),
     slaves_active(
         "master/slaves_active",
-        defer(master, &Master::_slaves_active)),
+        defer(master, &Master::_slaves_active),
+        interval),
     slaves_inactive(
         "master/slaves_inactive",
-        defer(master, &Master::_slaves_inactive)),
+        defer(master, &Master::_slaves_inactive),
+        interval),
     frameworks_connected(
         "master/frameworks_connected",
-        defer(master, &Master::_frameworks_connected)),
+        defer(master, &Master::_frameworks_connected),
+        interval),
     frameworks_disconnected(
         "master/frameworks_disconnected",
-        defer(master, &Master::_frameworks_disconnected)),
+        defer(master, &Master::_frameworks_disconnected),
+        interval),
     frameworks_active(
         "master/frameworks_active",
-        defer(master, &Master::_frameworks_active)),
+        defer(master, &Master::_frameworks_active),
+        interval),
     frameworks_inactive(
         "master/frameworks_inactive",
-        defer(master, &Master::_frameworks_inactive)),
+        defer(master, &Master::_frameworks_inactive),
+        interval),
     outstanding_offers(
         "master/outstanding_offers",
-        defer(master, &Master::_outstanding_offers)),
+        defer(master, &Master::_outstanding_offers),
+        interval),
     tasks_staging(
         "master/tasks_staging",
-        defer(master, &Master::_tasks_staging)),
+        defer(master, &Master::_tasks_staging),
+        interval),
     tasks_starting(
         "master/tasks_starting",
-        defer(master, &Master::_tasks_starting)),
+        defer(master, &Master::_tasks_starting),
+        interval),
     tasks_running(
         "master/tasks_running",
-        defer(master, &Master::_tasks_running)),
+        defer(master, &Master::_tasks_running),
+        interval),
     tasks_finished(
         "master/tasks_finished"),
     tasks_failed(
@@ -156,13 +167,16 @@ Metrics::Metrics(const Master& master)
         "master/recovery_slave_removals"),
     event_queue_messages(
         "master/event_queue_messages",
-        defer(master, &Master::_event_queue_messages)),
+        defer(master, &Master::_event_queue_messages),
+        interval),
     event_queue_dispatches(
         "master/event_queue_dispatches",
-        defer(master, &Master::_event_queue_dispatches)),
+        defer(master, &Master::_event_queue_dispatches),
+        interval),
     event_queue_http_requests(
         "master/event_queue_http_requests",
-        defer(master, &Master::_event_queue_http_requests)),
+        defer(master, &Master::_event_queue_http_requests),
+        interval),
     slave_registrations(
         "master/slave_registrations"),
     slave_reregistrations(
@@ -273,15 +287,18 @@ Metrics::Metrics(const Master& master)
   foreach (const string& resource, resources) {
     Gauge total(
         "master/" + resource + "_total",
-        defer(master, &Master::_resources_total, resource));
+        defer(master, &Master::_resources_total, resource),
+        interval);
 
     Gauge used(
         "master/" + resource + "_used",
-        defer(master, &Master::_resources_used, resource));
+        defer(master, &Master::_resources_used, resource),
+        interval);
 
     Gauge percent(
         "master/" + resource + "_percent",
-        defer(master, &Master::_resources_percent, resource));
+        defer(master, &Master::_resources_percent, resource),
+        interval);
 
     resources_total.push_back(total);
     resources_used.push_back(used);
@@ -295,15 +312,18 @@ Metrics::Metrics(const Master& master)
   foreach (const string& resource, resources) {
     Gauge total(
         "master/" + resource + "_revocable_total",
-        defer(master, &Master::_resources_revocable_total, resource));
+        defer(master, &Master::_resources_revocable_total, resource),
+        interval);
 
     Gauge used(
         "master/" + resource + "_revocable_used",
-        defer(master, &Master::_resources_revocable_used, resource));
+        defer(master, &Master::_resources_revocable_used, resource),
+        interval);
 
     Gauge percent(
         "master/" + resource + "_revocable_percent",
-        defer(master, &Master::_resources_revocable_percent, resource));
+        defer(master, &Master::_resources_revocable_percent, resource),
+        interval);
 
     resources_revocable_total.push_back(total);
     resources_revocable_used.push_back(used);
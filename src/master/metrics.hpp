@@ -25,8 +25,11 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/option.hpp>
 
 #include "mesos/mesos.hpp"
 #include "mesos/type_utils.hpp"
@@ -39,12 +42,14 @@ class Master;
 
 struct Metrics
 {
-  explicit Metrics(const Master& master);
+  // The gauges are evaluated at most once per 'interval', if any (see
+  // process::metrics::Gauge).
+  Metrics(const Master& master, const Option<Duration>& interval);
 
   ~Metrics();
 
   process::metrics::Gauge uptime_secs;
-  process::metrics::Gauge elected;
+  process::metrics::PushGauge elected;
 
   process::metrics::Gauge slaves_connected;
   process::metrics::Gauge slaves_disconnected;
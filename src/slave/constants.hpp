@@ -110,6 +110,17 @@ extern const std::string DEFAULT_AUTHENTICATEE;
 // Default maximum storage space to be used by the fetcher cache.
 const Bytes DEFAULT_FETCHER_CACHE_SIZE = Gigabytes(2);
 
+// Default maximum number of threads used to recover the checkpointed
+// frameworks and executors in parallel during slave recovery.
+const size_t DEFAULT_RECOVERY_THREADS = 8;
+
+// Default number of paths the garbage collector removes concurrently.
+const size_t DEFAULT_GC_WORKERS = 2;
+
+// Maximum number of paths the garbage collector removes concurrently,
+// since each of them is removed on a thread of its own.
+const size_t MAX_GC_WORKERS = 16;
+
 // Default maximum number of docker inspect calls docker ps will invoke
 // in parallel to prevent hitting system's open file descriptor limit.
 const int DOCKER_PS_MAX_INSPECT_CALLS = 100;
@@ -83,6 +83,9 @@ public:
   Future<ResourceStatistics> usage(
       const ContainerID& containerId);
 
+  Future<hashmap<ContainerID, ResourceStatistics>> batchUsage(
+      const hashset<ContainerID>& containerIds);
+
   Future<containerizer::Termination> wait(
       const ContainerID& containerId);
 
@@ -223,6 +226,16 @@ Future<ResourceStatistics> ComposingContainerizer::usage(
 }
 
 
+Future<hashmap<ContainerID, ResourceStatistics>>
+ComposingContainerizer::batchUsage(const hashset<ContainerID>& containerIds)
+{
+  return dispatch(
+      process,
+      &ComposingContainerizerProcess::batchUsage,
+      containerIds);
+}
+
+
 Future<containerizer::Termination> ComposingContainerizer::wait(
     const ContainerID& containerId)
 {
@@ -498,6 +511,50 @@ Future<ResourceStatistics> ComposingContainerizerProcess::usage(
 }
 
 
+Future<hashmap<ContainerID, ResourceStatistics>>
+ComposingContainerizerProcess::batchUsage(
+    const hashset<ContainerID>& containerIds)
+{
+  // Hand each of the containerizers the batch of its own containers.
+  hashmap<Containerizer*, hashset<ContainerID>> batches;
+  foreach (const ContainerID& containerId, containerIds) {
+    if (containers_.contains(containerId)) {
+      batches[containers_[containerId]->containerizer].insert(containerId);
+    }
+  }
+
+  typedef hashmap<ContainerID, ResourceStatistics> Statistics;
+
+  list<Future<Statistics>> futures;
+  foreachpair (Containerizer* containerizer,
+               const hashset<ContainerID>& batch,
+               batches) {
+    futures.push_back(containerizer->batchUsage(batch));
+  }
+
+  return await(futures).then(
+      [](const list<Future<Statistics>>& futures) {
+        Statistics result;
+
+        foreach (const Future<Statistics>& future, futures) {
+          if (future.isReady()) {
+            foreachpair (const ContainerID& containerId,
+                         const ResourceStatistics& statistics,
+                         future.get()) {
+              result.put(containerId, statistics);
+            }
+          } else {
+            LOG(WARNING) << "Failed to get resource statistics: "
+                         << (future.isFailed() ? future.failure()
+                                               : "discarded");
+          }
+        }
+
+        return result;
+      });
+}
+
+
 Future<containerizer::Termination> ComposingContainerizerProcess::wait(
     const ContainerID& containerId)
 {
@@ -82,6 +82,9 @@ public:
   virtual process::Future<ResourceStatistics> usage(
       const ContainerID& containerId);
 
+  virtual process::Future<hashmap<ContainerID, ResourceStatistics>>
+    batchUsage(const hashset<ContainerID>& containerIds);
+
   virtual process::Future<containerizer::Termination> wait(
       const ContainerID& containerId);
 
@@ -16,12 +16,15 @@
  * limitations under the License.
  */
 
+#include <list>
 #include <map>
 #include <vector>
 
+#include <process/collect.hpp>
 #include <process/dispatch.hpp>
 #include <process/owned.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/fs.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/os.hpp>
@@ -45,6 +48,7 @@
 
 #include "slave/containerizer/mesos/containerizer.hpp"
 
+using std::list;
 using std::map;
 using std::string;
 using std::vector;
@@ -234,6 +238,40 @@ Try<Containerizer*> Containerizer::create(
 }
 
 
+Future<hashmap<ContainerID, ResourceStatistics>> Containerizer::batchUsage(
+    const hashset<ContainerID>& containerIds)
+{
+  list<ContainerID> containerIds_;
+  list<Future<ResourceStatistics>> futures;
+
+  foreach (const ContainerID& containerId, containerIds) {
+    containerIds_.push_back(containerId);
+    futures.push_back(usage(containerId));
+  }
+
+  return await(futures).then(
+      [containerIds_](const list<Future<ResourceStatistics>>& futures) {
+        hashmap<ContainerID, ResourceStatistics> result;
+
+        list<ContainerID>::const_iterator containerId = containerIds_.begin();
+        foreach (const Future<ResourceStatistics>& future, futures) {
+          if (future.isReady()) {
+            result.put(*containerId, future.get());
+          } else {
+            LOG(WARNING) << "Failed to get resource statistics for container "
+                         << *containerId << ": "
+                         << (future.isFailed() ? future.failure()
+                                               : "discarded");
+          }
+
+          ++containerId;
+        }
+
+        return result;
+      });
+}
+
+
 map<string, string> executorEnvironment(
     const ExecutorInfo& executorInfo,
     const string& directory,
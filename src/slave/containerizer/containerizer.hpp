@@ -31,6 +31,7 @@
 #include <process/process.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
@@ -112,6 +113,13 @@ public:
   virtual process::Future<ResourceStatistics> usage(
       const ContainerID& containerId) = 0;
 
+  // Get resource usage statistics on a batch of containers in a
+  // single pass. Containers whose statistics cannot be collected are
+  // left out of the result. The default implementation calls usage()
+  // for each of the containers.
+  virtual process::Future<hashmap<ContainerID, ResourceStatistics>>
+    batchUsage(const hashset<ContainerID>& containerIds);
+
   // Wait on the container's 'Termination'. If the executor terminates, the
   // containerizer should also destroy the containerized context. The future
   // may be failed if an error occurs during termination of the executor or
@@ -16,13 +16,20 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <unordered_map>
 
 #include <process/async.hpp>
 #include <process/check.hpp>
+#include <process/clock.hpp>
 #include <process/collect.hpp>
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 
+#include <process/metrics/metrics.hpp>
+
+#include <stout/hashset.hpp>
+#include <stout/json.hpp>
 #include <stout/net.hpp>
 #include <stout/path.hpp>
 
@@ -31,6 +38,7 @@
 #include "hdfs/hdfs.hpp"
 
 #include "slave/slave.hpp"
+#include "slave/state.hpp"
 
 #include "slave/containerizer/fetcher.hpp"
 
@@ -41,7 +49,10 @@ using std::string;
 using std::transform;
 using std::vector;
 
+using process::Clock;
 using process::Future;
+using process::Owned;
+using process::Time;
 
 namespace mesos {
 namespace internal {
@@ -52,6 +63,21 @@ static const string FILE_URI_LOCALHOST = "file://localhost";
 
 static const string CACHE_FILE_NAME_PREFIX = "c";
 
+static const string EXTRACTED_PATH_SUFFIX = ".extracted";
+
+// Name of the file in the fetcher cache directory (i.e., outside the
+// cache directories of slaves, which are cleared on recovery) where
+// the usage history of the cache is checkpointed.
+static const string USAGE_FILE_NAME = "usage.json";
+
+// Maximum number of URIs for which usage is kept in the history.
+static const size_t MAX_USAGE_ENTRIES = 4096;
+
+// The usage history is checkpointed at most this often, rather than
+// after every fetch. It is only an optimization, so losing the usage
+// since the last checkpoint when the slave fails is acceptable.
+static const Duration USAGE_CHECKPOINT_INTERVAL = Seconds(30);
+
 
 Fetcher::Fetcher() : process(new FetcherProcess())
 {
@@ -228,12 +254,37 @@ Future<Nothing> Fetcher::fetch(
 }
 
 
+string Fetcher::extractedPath(const string& cacheFile)
+{
+  return cacheFile + EXTRACTED_PATH_SUFFIX;
+}
+
+
 void Fetcher::kill(const ContainerID& containerId)
 {
   dispatch(process.get(), &FetcherProcess::kill, containerId);
 }
 
 
+FetcherProcess::Metrics::Metrics()
+  : cache_hits("containerizer/fetcher/cache_hits"),
+    cache_misses("containerizer/fetcher/cache_misses"),
+    cache_hit_bytes("containerizer/fetcher/cache_hit_bytes")
+{
+  process::metrics::add(cache_hits);
+  process::metrics::add(cache_misses);
+  process::metrics::add(cache_hit_bytes);
+}
+
+
+FetcherProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(cache_hits);
+  process::metrics::remove(cache_misses);
+  process::metrics::remove(cache_hit_bytes);
+}
+
+
 FetcherProcess::~FetcherProcess()
 {
   foreach (const ContainerID& containerId, subprocessPids.keys()) {
@@ -242,6 +293,15 @@ FetcherProcess::~FetcherProcess()
 }
 
 
+void FetcherProcess::finalize()
+{
+  // Do not lose the usage recorded since the last checkpoint.
+  if (checkpointing) {
+    checkpoint();
+  }
+}
+
+
 // Find out how large a potential download from the given URI is.
 static Try<Bytes> fetchSize(
     const string& uri,
@@ -306,11 +366,33 @@ Future<Nothing> FetcherProcess::fetch(
   // always the exact same value.
   cache.setSpace(flags.fetcher_cache_size);
 
+  Try<Nothing> initialize = cache.initialize(
+      flags.fetcher_cache_eviction_policy,
+      path::join(flags.fetcher_cache_dir, USAGE_FILE_NAME));
+
+  if (initialize.isError()) {
+    return Failure("Failed to initialize the fetcher cache: " +
+                   initialize.error());
+  }
+
   Try<Nothing> validated = validateUris(commandInfo);
   if (validated.isError()) {
     return Failure("Could not fetch: " + validated.error());
   }
 
+  // The flag is validated when the slave loads it, so this can only
+  // fail for flags that were constructed in code (e.g., in tests).
+  if (delivery.isNone()) {
+    FetcherInfo::Delivery _delivery;
+    if (!FetcherInfo::Delivery_Parse(
+            strings::upper(flags.fetcher_cache_delivery), &_delivery)) {
+      return Failure("Unknown fetcher cache delivery '" +
+                     flags.fetcher_cache_delivery + "'");
+    }
+
+    delivery = _delivery;
+  }
+
   Option<string> commandUser = user;
   if (commandInfo.has_user()) {
     commandUser = commandInfo.user();
@@ -491,10 +573,16 @@ Future<Nothing> FetcherProcess::__fetch(
         // completion in FetcherProcess::fetch().
         item->set_action(FetcherInfo::Item::DOWNLOAD_AND_CACHE);
         item->set_cache_filename(entry.get()->filename);
+
+        ++metrics.cache_misses;
       } else {
         CHECK_READY(entry.get()->completion());
         item->set_action(FetcherInfo::Item::RETRIEVE_FROM_CACHE);
         item->set_cache_filename(entry.get()->filename);
+
+        ++metrics.cache_hits;
+        metrics.cache_hit_bytes +=
+          (entry.get()->size - entry.get()->extractedSize).bytes();
       }
     } else {
       item->set_action(FetcherInfo::Item::BYPASS_CACHE);
@@ -512,6 +600,12 @@ Future<Nothing> FetcherProcess::__fetch(
     info.set_frameworks_home(flags.frameworks_home);
   }
 
+  // Parsed in FetcherProcess::fetch().
+  CHECK_SOME(delivery);
+  info.set_delivery(delivery.get());
+
+  const Time start = Clock::now();
+
   return run(containerId, sandboxDirectory, user, info, flags)
     .repair(defer(self(), [=](const Future<Nothing>& future) {
       LOG(ERROR) << "Failed to run mesos-fetcher: " << future.failure();
@@ -531,35 +625,88 @@ Future<Nothing> FetcherProcess::__fetch(
       return future; // Always propagate the failure!
     }))
     .then(defer(self(), [=]() {
+      // Attribute the time it took to run the mesos-fetcher to the
+      // entries it downloaded, in proportion to their sizes.
+      const Duration elapsed = Clock::now() - start;
+
+      Bytes downloaded;
       foreachvalue (const Option<shared_ptr<Cache::Entry>>& entry, entries) {
-        if (entry.isSome()) {
-          entry.get()->unreference();
+        if (entry.isSome() && entry.get()->completion().isPending()) {
+          downloaded += entry.get()->size;
+        }
+      }
 
-          if (entry.get()->completion().isPending()) {
-            // Successfully downloaded and cached!
+      foreachvalue (const Option<shared_ptr<Cache::Entry>>& entry, entries) {
+        if (entry.isSome() && entry.get()->completion().isPending()) {
+          cache.downloaded(
+              entry.get(),
+              downloaded > 0
+                ? elapsed * (double(entry.get()->size.bytes()) /
+                             downloaded.bytes())
+                : elapsed);
+        }
+      }
 
+      foreachvalue (const Option<shared_ptr<Cache::Entry>>& entry, entries) {
+        if (entry.isSome()) {
+          // Adjust the cache space while the entry is still referenced,
+          // so that it cannot be evicted itself to make room for its
+          // own extraction (see Cache::adjustExtraction()).
+          if (entry.get()->completion().isPending()) {
             Try<Nothing> adjust = cache.adjust(entry.get());
-            if (adjust.isSome()) {
-              entry.get()->complete();
-            } else {
+            if (adjust.isError()) {
               LOG(WARNING) << "Failed to adjust the cache size for entry '"
                            << entry.get()->key << "' with error: "
                            << adjust.error();
 
               // Successfully fetched, but not reusable from the
               // cache, because we are deleting the entry now.
+              entry.get()->unreference();
               entry.get()->fail();
               cache.remove(entry.get());
+              continue;
             }
           }
+
+          Try<Nothing> adjustExtraction = cache.adjustExtraction(entry.get());
+          if (adjustExtraction.isError()) {
+            LOG(WARNING) << "Failed to account for the extraction of cache "
+                         << "entry '" << entry.get()->key << "' with error: "
+                         << adjustExtraction.error();
+          }
+
+          entry.get()->unreference();
+
+          if (entry.get()->completion().isPending()) {
+            // Successfully downloaded and cached!
+            entry.get()->complete();
+          }
         }
       }
 
+      if (!checkpointing) {
+        checkpointing = true;
+        process::delay(
+            USAGE_CHECKPOINT_INTERVAL, self(), &FetcherProcess::checkpoint);
+      }
+
       return Nothing();
     }));
 }
 
 
+void FetcherProcess::checkpoint()
+{
+  checkpointing = false;
+
+  Try<Nothing> checkpoint = cache.checkpoint();
+  if (checkpoint.isError()) {
+    LOG(WARNING) << "Failed to checkpoint fetcher cache usage: "
+                 << checkpoint.error();
+  }
+}
+
+
 static off_t delta(
     const Bytes& actualSize,
     const shared_ptr<FetcherProcess::Cache::Entry>& entry)
@@ -610,10 +757,29 @@ Try<list<Path>> FetcherProcess::cacheFiles(
                  cacheDirectory + "' with error: " + find.error());
   }
 
-  transform(find.get().begin(),
-            find.get().end(),
-            std::back_inserter(result),
-            [](const string& path) { return Path(path); });
+  // The extractions of cache files (see Fetcher::extractedPath())
+  // are directories next to the cache files.
+  hashset<string> extractions;
+  foreach (const string& path, find.get()) {
+    extractions.insert(Fetcher::extractedPath(path));
+  }
+
+  foreach (const string& path, find.get()) {
+    // Skip the files in extractions of cache files.
+    bool extracted = false;
+    for (string directory = Path(path).dirname();
+         directory.size() > cacheDirectory.size();
+         directory = Path(directory).dirname()) {
+      if (extractions.contains(directory)) {
+        extracted = true;
+        break;
+      }
+    }
+
+    if (!extracted) {
+      result.push_back(Path(path));
+    }
+  }
 
   return result;
 }
@@ -827,6 +993,253 @@ void FetcherProcess::kill(const ContainerID& containerId)
 }
 
 
+// Evicts the least recently used entry first. This is the default.
+class LRUEvictionPolicy : public FetcherProcess::Cache::EvictionPolicy
+{
+public:
+  virtual double priority(
+      const FetcherProcess::Cache::Entry& entry,
+      const FetcherProcess::Cache::Usage& usage,
+      double floor)
+  {
+    return usage.lastAccess;
+  }
+};
+
+
+// Evicts the least frequently used entry first, with dynamic aging:
+// every eviction raises the floor that subsequent accesses start
+// from, so that entries that were popular once but are not used
+// anymore are eventually evicted, too (their priority stays what it
+// was at their last access while the floor rises past it).
+class LFUEvictionPolicy : public FetcherProcess::Cache::EvictionPolicy
+{
+public:
+  virtual double priority(
+      const FetcherProcess::Cache::Entry& entry,
+      const FetcherProcess::Cache::Usage& usage,
+      double floor)
+  {
+    return floor + usage.frequency;
+  }
+};
+
+
+// Greedy-Dual-Size-Frequency: like LFU, but weighs frequency by how
+// long it took to download an entry (i.e., what a hit saves) relative
+// to how much space the entry takes. This evicts large artifacts that
+// are rarely used before small ones that are used often.
+class GDSFEvictionPolicy : public FetcherProcess::Cache::EvictionPolicy
+{
+public:
+  virtual double priority(
+      const FetcherProcess::Cache::Entry& entry,
+      const FetcherProcess::Cache::Usage& usage,
+      double floor)
+  {
+    const double cost = std::max(usage.cost.ms(), 1.0);
+    const double size =
+      std::max(double(entry.size.bytes()) / Megabytes(1).bytes(), 1.0 / 1024);
+
+    return floor + usage.frequency * cost / size;
+  }
+};
+
+
+Try<Owned<FetcherProcess::Cache::EvictionPolicy>>
+FetcherProcess::Cache::EvictionPolicy::create(const string& name)
+{
+  if (name == "lru") {
+    return Owned<EvictionPolicy>(new LRUEvictionPolicy());
+  } else if (name == "lfu") {
+    return Owned<EvictionPolicy>(new LFUEvictionPolicy());
+  } else if (name == "gdsf") {
+    return Owned<EvictionPolicy>(new GDSFEvictionPolicy());
+  }
+
+  return Error("Unknown fetcher cache eviction policy '" + name + "'");
+}
+
+
+FetcherProcess::Cache::Cache()
+  : space(0),
+    tally(0),
+    filenameSerial(0),
+    policy(new LRUEvictionPolicy()),
+    policyName("lru"),
+    initialized(false),
+    clock(0),
+    floor(0) {}
+
+
+Try<Nothing> FetcherProcess::Cache::initialize(
+    const string& evictionPolicy,
+    const string& _usagePath)
+{
+  if (initialized) {
+    return Nothing();
+  }
+
+  Try<Owned<EvictionPolicy>> _policy = EvictionPolicy::create(evictionPolicy);
+  if (_policy.isError()) {
+    return Error(_policy.error());
+  }
+
+  policy = _policy.get();
+  policyName = evictionPolicy;
+  usagePath = _usagePath;
+  initialized = true;
+
+  if (!os::exists(_usagePath)) {
+    return Nothing();
+  }
+
+  // The usage history is only an optimization, so we start over
+  // rather than fail if it cannot be recovered.
+  Try<string> read = os::read(_usagePath);
+  if (read.isError()) {
+    LOG(WARNING) << "Failed to read fetcher cache usage from '"
+                 << _usagePath << "': " << read.error();
+    return Nothing();
+  }
+
+  Try<JSON::Object> object = JSON::parse<JSON::Object>(read.get());
+  if (object.isError()) {
+    LOG(WARNING) << "Failed to parse fetcher cache usage from '"
+                 << _usagePath << "': " << object.error();
+    return Nothing();
+  }
+
+  Result<JSON::Number> _clock = object.get().find<JSON::Number>("clock");
+  if (_clock.isSome()) {
+    clock = _clock.get().as<unsigned long>();
+  }
+
+  // The floor is only meaningful for the policy that computed it.
+  Result<JSON::String> _name = object.get().find<JSON::String>("policy");
+  Result<JSON::Number> _floor = object.get().find<JSON::Number>("floor");
+  if (_name.isSome() && _name.get().value == evictionPolicy &&
+      _floor.isSome()) {
+    floor = _floor.get().as<double>();
+  }
+
+  Result<JSON::Array> entries = object.get().find<JSON::Array>("usage");
+  if (entries.isSome()) {
+    foreach (const JSON::Value& value, entries.get().values) {
+      if (!value.is<JSON::Object>()) {
+        continue;
+      }
+
+      const JSON::Object& entry = value.as<JSON::Object>();
+
+      Result<JSON::String> key = entry.find<JSON::String>("key");
+      Result<JSON::Number> frequency = entry.find<JSON::Number>("frequency");
+      Result<JSON::Number> lastAccess =
+        entry.find<JSON::Number>("last_access");
+      Result<JSON::Number> cost = entry.find<JSON::Number>("cost");
+
+      if (key.isSome() && frequency.isSome() && lastAccess.isSome() &&
+          cost.isSome()) {
+        Usage& _usage = usage[key.get().value];
+        _usage.frequency = frequency.get().as<unsigned long>();
+        _usage.lastAccess = lastAccess.get().as<unsigned long>();
+        _usage.cost = Seconds(cost.get().as<double>());
+
+        // Like the floor, priorities are only meaningful for the
+        // policy that computed them. Otherwise they are computed
+        // again on the next access.
+        Result<JSON::Number> _floor = entry.find<JSON::Number>("floor");
+        Result<JSON::Number> priority = entry.find<JSON::Number>("priority");
+        if (_name.isSome() && _name.get().value == evictionPolicy &&
+            _floor.isSome() && priority.isSome()) {
+          _usage.floor = _floor.get().as<double>();
+          _usage.priority = priority.get().as<double>();
+        }
+      }
+    }
+  }
+
+  VLOG(1) << "Recovered fetcher cache usage of " << usage.size() << " URIs";
+
+  return Nothing();
+}
+
+
+Try<Nothing> FetcherProcess::Cache::checkpoint()
+{
+  if (usagePath.isNone()) {
+    return Nothing();
+  }
+
+  // Bound the history by forgetting the least recently used URIs
+  // that are not in the cache anymore.
+  if (usage.size() > MAX_USAGE_ENTRIES) {
+    vector<std::pair<unsigned long, string>> evicted;
+    foreachpair (const string& key, const Usage& _usage, usage) {
+      if (!table.contains(key)) {
+        evicted.push_back(std::make_pair(_usage.lastAccess, key));
+      }
+    }
+
+    std::sort(evicted.begin(), evicted.end());
+
+    for (size_t i = 0;
+         i < evicted.size() && usage.size() > MAX_USAGE_ENTRIES;
+         i++) {
+      usage.erase(evicted[i].second);
+    }
+  }
+
+  JSON::Array entries;
+  foreachpair (const string& key, const Usage& _usage, usage) {
+    JSON::Object entry;
+    entry.values["key"] = key;
+    entry.values["frequency"] = _usage.frequency;
+    entry.values["last_access"] = _usage.lastAccess;
+    entry.values["cost"] = _usage.cost.secs();
+    entry.values["floor"] = _usage.floor;
+    entry.values["priority"] = _usage.priority;
+    entries.values.push_back(entry);
+  }
+
+  JSON::Object object;
+  object.values["clock"] = clock;
+  object.values["floor"] = floor;
+  object.values["usage"] = entries;
+
+  // Remember which policy computed the floor and the priorities.
+  object.values["policy"] = policyName;
+
+  return state::checkpoint(usagePath.get(), stringify(object));
+}
+
+
+void FetcherProcess::Cache::downloaded(
+    const shared_ptr<Cache::Entry>& entry,
+    const Duration& duration)
+{
+  usage[entry->key].cost = duration;
+  prioritize(entry);
+}
+
+
+void FetcherProcess::Cache::access(const shared_ptr<Cache::Entry>& entry)
+{
+  Usage& _usage = usage[entry->key];
+  _usage.frequency++;
+  _usage.lastAccess = ++clock;
+  _usage.floor = floor;
+  prioritize(entry);
+}
+
+
+void FetcherProcess::Cache::prioritize(const shared_ptr<Cache::Entry>& entry)
+{
+  Usage& _usage = usage[entry->key];
+  _usage.priority = policy->priority(*entry, _usage, _usage.floor);
+}
+
+
 string FetcherProcess::Cache::nextFilename(const CommandInfo::URI& uri)
 {
   // Different URIs may have the same base name, so we need to
@@ -885,7 +1298,7 @@ shared_ptr<FetcherProcess::Cache::Entry> FetcherProcess::Cache::create(
       new Cache::Entry(key, cacheDirectory, filename));
 
   table.put(key, entry);
-  lruSortedEntries.push_back(entry);
+  access(entry);
 
   VLOG(1) << "Created cache entry '" << key << "' with file: " << filename;
 
@@ -902,9 +1315,7 @@ FetcherProcess::Cache::get(
 
   Option<shared_ptr<Entry>> entry = table.get(key);
   if (entry.isSome()) {
-    // Refresh the cache entry by moving it to the back of lruSortedEntries.
-    lruSortedEntries.remove(entry.get());
-    lruSortedEntries.push_back(entry.get());
+    access(entry.get());
   }
 
   return entry;
@@ -972,7 +1383,6 @@ Try<Nothing> FetcherProcess::Cache::remove(
   CHECK(contains(entry));
 
   table.erase(entry->key);
-  lruSortedEntries.remove(entry);
 
   // We may or may not have started downloading. The download may or may
   // not have been partial. In any case, clean up whatever is there.
@@ -986,6 +1396,27 @@ Try<Nothing> FetcherProcess::Cache::remove(
     }
   }
 
+  // The extraction may be unaccounted for, or may not have been
+  // moved into place (see mesos-fetcher), but it is removed anyway.
+  const string extractedName = Fetcher::extractedPath(entry->filename);
+
+  Try<list<string>> names = os::ls(entry->directory);
+  if (names.isSome()) {
+    foreach (const string& name, names.get()) {
+      if (!strings::startsWith(name, extractedName)) {
+        continue;
+      }
+
+      const string extraction = path::join(entry->directory, name);
+
+      Try<Nothing> rmdir = os::rmdir(extraction);
+      if (rmdir.isError()) {
+        LOG(WARNING) << "Could not delete fetcher cache extraction '"
+                     << extraction << "' with error: " << rmdir.error();
+      }
+    }
+  }
+
   // NOTE: There is an assumption that if and only if 'entry->size > 0'
   // then we've claimed cache space for this entry! This currently only
   // gets set in reserveCacheSpace().
@@ -993,28 +1424,53 @@ Try<Nothing> FetcherProcess::Cache::remove(
     releaseSpace(entry->size);
 
     entry->size = 0;
+    entry->extractedSize = 0;
   }
 
   return Nothing();
 }
 
 
-// Select LRU cache entries for cache eviction.
+// Select cache entries for cache eviction in the order of the
+// eviction policy.
 Try<list<shared_ptr<FetcherProcess::Cache::Entry>>>
 FetcherProcess::Cache::selectVictims(const Bytes& requiredSpace)
 {
+  // Candidates sorted by priority, then by last access.
+  typedef std::tuple<double, unsigned long, shared_ptr<Cache::Entry>> Candidate;
+
+  vector<Candidate> candidates;
+
+  foreachvalue (const shared_ptr<Cache::Entry>& entry, table) {
+    if (!entry->isReferenced()) {
+      const Usage& entryUsage = usage[entry->key];
+
+      candidates.push_back(std::make_tuple(
+          entryUsage.priority,
+          entryUsage.lastAccess,
+          entry));
+    }
+  }
+
+  std::sort(
+      candidates.begin(),
+      candidates.end(),
+      [](const Candidate& left, const Candidate& right) {
+        return std::get<0>(left) < std::get<0>(right) ||
+          (std::get<0>(left) == std::get<0>(right) &&
+           std::get<1>(left) < std::get<1>(right));
+      });
+
   list<shared_ptr<FetcherProcess::Cache::Entry>> victims;
 
   Bytes space = 0;
 
-  foreach (const shared_ptr<Cache::Entry>& entry, lruSortedEntries) {
-    if (!entry->isReferenced()) {
-      victims.push_back(entry);
+  foreach (const Candidate& candidate, candidates) {
+    victims.push_back(std::get<2>(candidate));
 
-      space += entry->size;
-      if (space >= requiredSpace) {
-        return victims;
-      }
+    space += std::get<2>(candidate)->size;
+    if (space >= requiredSpace) {
+      return victims;
     }
   }
 
@@ -1037,6 +1493,10 @@ Try<Nothing> FetcherProcess::Cache::reserve(
       return Error("Could not free up enough fetcher cache space");
     }
 
+    // Raise the floor to the priority of the last victim, so that
+    // entries accessed from now on start out above it.
+    floor = std::max(floor, usage[victims.get().back()->key].priority);
+
     foreach (const shared_ptr<Cache::Entry>& entry, victims.get()) {
       Try<Nothing> removal = remove(entry);
       if (removal.isError()) {
@@ -1063,6 +1523,7 @@ Try<Nothing> FetcherProcess::Cache::adjust(
       entry->size = size.get();
 
       releaseSpace(Bytes(d));
+      prioritize(entry);
     } else {
       return Error("More cache size now necessary, not adjusting " +
                    entry->key);
@@ -1077,6 +1538,55 @@ Try<Nothing> FetcherProcess::Cache::adjust(
 }
 
 
+Try<Nothing> FetcherProcess::Cache::adjustExtraction(
+    const shared_ptr<FetcherProcess::Cache::Entry>& entry)
+{
+  CHECK(contains(entry));
+
+  const string extractedPath = Fetcher::extractedPath(entry->path().value);
+
+  if (entry->extracted || !os::exists(extractedPath)) {
+    return Nothing();
+  }
+
+  Try<list<string>> files = os::find(extractedPath, "");
+  if (files.isError()) {
+    return Error("Could not access extraction '" + extractedPath +
+                 "' with error: " + files.error());
+  }
+
+  Bytes size;
+  foreach (const string& file, files.get()) {
+    Try<Bytes> fileSize =
+      os::stat::size(file, os::stat::DO_NOT_FOLLOW_SYMLINK);
+
+    if (fileSize.isSome()) {
+      size += fileSize.get();
+    }
+  }
+
+  // The entry is referenced, so it is not evicted itself. If there is
+  // not enough space, leaving the extraction in place is still better
+  // than removing it from under concurrent fetches; it is accounted
+  // for by the next fetch or removed along with the entry.
+  Try<Nothing> reservation = reserve(size);
+  if (reservation.isError()) {
+    return Error("Failed to reserve space for extraction: " +
+                 reservation.error());
+  }
+
+  claimSpace(size);
+
+  entry->size += size;
+  entry->extracted = true;
+  entry->extractedSize = size;
+
+  prioritize(entry);
+
+  return Nothing();
+}
+
+
 size_t FetcherProcess::Cache::size()
 {
   return table.size();
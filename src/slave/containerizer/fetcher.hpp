@@ -27,11 +27,15 @@
 
 #include <mesos/fetcher/fetcher.hpp>
 
-#include <process/id.hpp>
 #include <process/future.hpp>
+#include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/subprocess.hpp>
 
+#include <process/metrics/counter.hpp>
+
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 
 #include "slave/flags.hpp"
@@ -80,6 +84,11 @@ public:
 
   static bool isNetUri(const std::string& uri);
 
+  // Returns the path of the directory into which the archive in the
+  // given cache file is extracted when delivering from the cache by
+  // link (see the 'fetcher_cache_delivery' flag).
+  static std::string extractedPath(const std::string& cacheFile);
+
   Fetcher();
 
   // This is only public for tests.
@@ -118,7 +127,9 @@ private:
 class FetcherProcess : public process::Process<FetcherProcess>
 {
 public:
-  FetcherProcess() : ProcessBase(process::ID::generate("fetcher")) {}
+  FetcherProcess()
+    : ProcessBase(process::ID::generate("fetcher")),
+      checkpointing(false) {}
 
   virtual ~FetcherProcess();
 
@@ -161,6 +172,7 @@ public:
           directory(directory),
           filename(filename),
           size(0),
+          extracted(false),
           referenceCount(0) {}
 
       ~Entry() {}
@@ -205,6 +217,13 @@ public:
       // different a warning is logged and the field's value adjusted.
       Bytes size;
 
+      // Whether 'size' includes the extraction of the cache file in
+      // the cache (see Fetcher::extractedPath()).
+      bool extracted;
+
+      // The size of the extraction included in 'size', if any.
+      Bytes extractedSize;
+
     private:
       // Concurrent fetch attempts can reference the same entry multiple
       // times.
@@ -214,9 +233,80 @@ public:
       process::Promise<Nothing> promise;
     };
 
-    Cache() : space(0), tally(0), filenameSerial(0) {}
+    // How often and how recently a URI has been fetched through the
+    // cache (per user), and how long downloading it took. This is
+    // kept after the URI's entry has been evicted, and across slave
+    // restarts, so that eviction policies can take history into
+    // account.
+    struct Usage
+    {
+      Usage()
+        : frequency(0),
+          lastAccess(0),
+          cost(Seconds(0)),
+          floor(0),
+          priority(0) {}
+
+      // Number of fetches.
+      unsigned long frequency;
+
+      // Logical time of the last fetch (see Cache::clock).
+      unsigned long lastAccess;
+
+      // Time taken by the last download.
+      Duration cost;
+
+      // The cache's floor at the time of the last fetch.
+      double floor;
+
+      // Eviction priority as of the last fetch (see EvictionPolicy).
+      double priority;
+    };
+
+    // Decides in which order unreferenced entries are evicted from the
+    // cache (see the 'fetcher_cache_eviction_policy' flag).
+    class EvictionPolicy
+    {
+    public:
+      static Try<process::Owned<EvictionPolicy>> create(
+          const std::string& name);
+
+      virtual ~EvictionPolicy() {}
+
+      // Entries with a lower priority are evicted first. Ties are
+      // broken by evicting the least recently used entry first. The
+      // priority is computed when the entry is fetched and kept until
+      // the next fetch. 'floor' is the highest priority of any entry
+      // evicted before that fetch, which policies can add to age out
+      // entries that were popular once but are not used anymore: the
+      // floor keeps rising with evictions, so entries fetched later
+      // start out above entries that have not been fetched since.
+      virtual double priority(
+          const Entry& entry,
+          const Usage& usage,
+          double floor) = 0;
+    };
+
+    Cache();
     virtual ~Cache() {}
 
+    // Selects the eviction policy and recovers the usage history
+    // from the given file, which is updated by checkpoint(). Only
+    // takes effect once.
+    // TODO(bernd-mesos): This method will disappear when injecting 'flags'
+    // into the fetcher instead of passing 'flags' around as parameter.
+    Try<Nothing> initialize(
+        const std::string& evictionPolicy,
+        const std::string& usagePath);
+
+    // Writes the usage history to the file given to initialize().
+    Try<Nothing> checkpoint();
+
+    // Records how long downloading the entry took.
+    void downloaded(
+        const std::shared_ptr<Entry>& entry,
+        const Duration& duration);
+
     // Registers the maximum usable space in the cache directory.
     // TODO(bernd-mesos): This method will disappear when injecting 'flags'
     // into the fetcher instead of passing 'flags' around as parameter.
@@ -268,6 +358,11 @@ public:
     // sizes and adjusts the cache's total amount of space in use.
     Try<Nothing> adjust(const std::shared_ptr<Cache::Entry>& entry);
 
+    // Accounts for the extraction of the entry's cache file in the
+    // cache, if there is one that is not accounted for yet, by adding
+    // its size to the entry's. Evicts other entries as necessary.
+    Try<Nothing> adjustExtraction(const std::shared_ptr<Cache::Entry>& entry);
+
     // Number of entries.
     size_t size();
 
@@ -285,8 +380,32 @@ public:
     // entries.
     hashmap<std::string, std::shared_ptr<Entry>> table;
 
-    // Stores cache file entries sorted from LRU to MRU.
-    std::list<std::shared_ptr<Entry>> lruSortedEntries;
+    // Records an access to the entry's URI in 'usage'.
+    void access(const std::shared_ptr<Entry>& entry);
+
+    // Recomputes the entry's eviction priority after its size or
+    // download time became known, based on the floor at the time of
+    // its last access.
+    void prioritize(const std::shared_ptr<Entry>& entry);
+
+    process::Owned<EvictionPolicy> policy;
+    std::string policyName;
+
+    // Whether initialize() has taken effect.
+    bool initialized;
+
+    // Where the usage history is checkpointed, if anywhere.
+    Option<std::string> usagePath;
+
+    // Maps keys to the usage of their URIs, also for evicted entries.
+    hashmap<std::string, Usage> usage;
+
+    // Incremented for every access, to order accesses in 'usage'.
+    unsigned long clock;
+
+    // The highest priority of any entry evicted so far (see
+    // EvictionPolicy::priority()).
+    double floor;
   };
 
   // Public and virtual for mock testing.
@@ -315,6 +434,9 @@ public:
   // by cache entries. For testing.
   Bytes availableCacheSpace();
 
+protected:
+  virtual void finalize();
+
 private:
   process::Future<Nothing> __fetch(
       const hashmap<CommandInfo::URI,
@@ -332,9 +454,38 @@ private:
       const Try<Bytes>& requestedSpace,
       const std::shared_ptr<Cache::Entry>& entry);
 
+  // Checkpoints the usage history of the cache (see
+  // Cache::checkpoint()). Delayed after fetching, so that the usage
+  // of many fetches is checkpointed at once.
+  void checkpoint();
+
   Cache cache;
 
+  // Whether a checkpoint of the usage history is pending.
+  bool checkpointing;
+
+  // How cache files are delivered into sandboxes, parsed once from
+  // the 'fetcher_cache_delivery' flag (see FetcherProcess::fetch()).
+  Option<FetcherInfo::Delivery> delivery;
+
   hashmap<ContainerID, pid_t> subprocessPids;
+
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    // Number of URIs retrieved from the cache without downloading,
+    // including those that waited for a concurrent download.
+    process::metrics::Counter cache_hits;
+
+    // Number of URIs downloaded into the cache.
+    process::metrics::Counter cache_misses;
+
+    // Bytes of cache files retrieved from the cache without
+    // downloading, not counting their extractions.
+    process::metrics::Counter cache_hit_bytes;
+  } metrics;
 };
 
 } // namespace slave {
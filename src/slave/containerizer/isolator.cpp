@@ -16,8 +16,12 @@
  * limitations under the License.
  */
 
+#include <process/collect.hpp>
 #include <process/dispatch.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/lambda.hpp>
+
 #include "slave/containerizer/isolator.hpp"
 
 using namespace process;
@@ -33,6 +37,62 @@ namespace mesos {
 namespace internal {
 namespace slave {
 
+// Pairs the containers with the statistics gathered for them, in
+// order, leaving out the containers whose statistics could not be
+// gathered.
+static hashmap<ContainerID, ResourceStatistics> _batchUsage(
+    const list<ContainerID>& containerIds,
+    const list<Future<ResourceStatistics>>& statistics)
+{
+  CHECK_EQ(containerIds.size(), statistics.size());
+
+  hashmap<ContainerID, ResourceStatistics> result;
+
+  list<ContainerID>::const_iterator containerId = containerIds.begin();
+  foreach (const Future<ResourceStatistics>& statistic, statistics) {
+    if (statistic.isReady()) {
+      result.put(*containerId, statistic.get());
+    } else {
+      VLOG(1) << "Skipping resource statistics for container "
+              << *containerId << " because: "
+              << (statistic.isFailed() ? statistic.failure() : "discarded");
+    }
+
+    ++containerId;
+  }
+
+  return result;
+}
+
+
+// Gathers the statistics of each container using 'usage'.
+static Future<hashmap<ContainerID, ResourceStatistics>> batchUsage(
+    const hashset<ContainerID>& containerIds,
+    const lambda::function<
+        Future<ResourceStatistics>(const ContainerID&)>& usage)
+{
+  list<ContainerID> containerIds_;
+  list<Future<ResourceStatistics>> futures;
+
+  foreach (const ContainerID& containerId, containerIds) {
+    containerIds_.push_back(containerId);
+    futures.push_back(usage(containerId));
+  }
+
+  return await(futures)
+    .then(lambda::bind(_batchUsage, containerIds_, lambda::_1));
+}
+
+
+Future<hashmap<ContainerID, ResourceStatistics>>
+MesosIsolatorProcess::batchUsage(const hashset<ContainerID>& containerIds)
+{
+  return slave::batchUsage(
+      containerIds,
+      lambda::bind(&MesosIsolatorProcess::usage, this, lambda::_1));
+}
+
+
 MesosIsolator::MesosIsolator(Owned<MesosIsolatorProcess> _process)
   : process(_process)
 {
@@ -113,6 +173,15 @@ Future<ResourceStatistics> MesosIsolator::usage(
 }
 
 
+Future<hashmap<ContainerID, ResourceStatistics>> MesosIsolator::batchUsage(
+    const hashset<ContainerID>& containerIds)
+{
+  return dispatch(process.get(),
+                  &MesosIsolatorProcess::batchUsage,
+                  containerIds);
+}
+
+
 Future<Nothing> MesosIsolator::cleanup(
     const ContainerID& containerId)
 {
@@ -123,4 +192,17 @@ Future<Nothing> MesosIsolator::cleanup(
 
 } // namespace slave {
 } // namespace internal {
+
+
+namespace slave {
+
+Future<hashmap<ContainerID, ResourceStatistics>> Isolator::batchUsage(
+    const hashset<ContainerID>& containerIds)
+{
+  return internal::slave::batchUsage(
+      containerIds,
+      lambda::bind(&Isolator::usage, this, lambda::_1));
+}
+
+} // namespace slave {
 } // namespace mesos {
@@ -67,6 +67,9 @@ public:
   virtual process::Future<ResourceStatistics> usage(
       const ContainerID& containerId);
 
+  virtual process::Future<hashmap<ContainerID, ResourceStatistics>>
+    batchUsage(const hashset<ContainerID>& containerIds);
+
   virtual process::Future<Nothing> cleanup(
       const ContainerID& containerId);
 
@@ -104,6 +107,11 @@ public:
   virtual process::Future<ResourceStatistics> usage(
       const ContainerID& containerId) = 0;
 
+  // The default implementation calls usage() for each container from
+  // within this process, see mesos::slave::Isolator::batchUsage().
+  virtual process::Future<hashmap<ContainerID, ResourceStatistics>>
+    batchUsage(const hashset<ContainerID>& containerIds);
+
   virtual process::Future<Nothing> cleanup(
       const ContainerID& containerId) = 0;
 };
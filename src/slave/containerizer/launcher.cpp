@@ -16,6 +16,13 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <signal.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif // __linux__
+
 #include <mesos/type_utils.hpp>
 
 #include <process/collect.hpp>
@@ -23,6 +30,7 @@
 #include <process/process.hpp>
 #include <process/reap.hpp>
 
+#include <stout/strings.hpp>
 #include <stout/unreachable.hpp>
 
 #include <stout/os/killtree.hpp>
@@ -44,6 +52,92 @@ namespace mesos {
 namespace internal {
 namespace slave {
 
+#ifdef __linux__
+// Stack for a 'vclone'd child. It only needs to hold the frames up to
+// the exec, but 'setup' functions are arbitrary so stay generous.
+// Most of it is never touched and hence never backed by memory.
+static const size_t VCLONE_STACK_SIZE = 1024 * 1024;
+
+
+struct VClone
+{
+  const lambda::function<int()>* func;
+  sigset_t mask;
+};
+
+
+static int vcloneMain(void* arg)
+{
+  const VClone* vclone = (const VClone*) arg;
+
+  // The signal handlers were installed for the parent and would run
+  // on its memory, so restore the default dispositions (but keep any
+  // ignored signals ignored as a fork followed by an exec would).
+  for (int signal = 1; signal < NSIG; signal++) {
+    struct sigaction action;
+    if (::sigaction(signal, NULL, &action) == 0 &&
+        action.sa_handler != SIG_IGN &&
+        action.sa_handler != SIG_DFL) {
+      action.sa_handler = SIG_DFL;
+      action.sa_flags = 0;
+      ::sigemptyset(&action.sa_mask);
+      ::sigaction(signal, &action, NULL);
+    }
+  }
+
+  // Now it is safe to unblock signals again.
+  ::sigprocmask(SIG_SETMASK, &vclone->mask, NULL);
+
+  ::_exit((*vclone->func)());
+}
+
+
+pid_t vclone(const lambda::function<int()>& func, int flags)
+{
+  VClone vclone;
+  vclone.func = &func;
+
+  // Block all signals so that no handler runs in the child before it
+  // has reset the dispositions (see 'vcloneMain').
+  sigset_t all;
+  ::sigfillset(&all);
+  ::pthread_sigmask(SIG_SETMASK, &all, &vclone.mask);
+
+  // NOTE: With CLONE_VFORK we only return once the child has exec'ed
+  // or exited, so the stack is not in use anymore after the clone.
+  unsigned long long* stack =
+    new unsigned long long[VCLONE_STACK_SIZE / sizeof(unsigned long long)];
+
+  pid_t pid = ::clone(
+      vcloneMain,
+      &stack[VCLONE_STACK_SIZE / sizeof(stack[0]) - 1], // Stack grows down.
+      flags | CLONE_VM | CLONE_VFORK | SIGCHLD,
+      (void*) &vclone);
+
+  // Save the errno as the cleanup below might overwrite it.
+  int error = errno;
+
+  delete[] stack;
+
+  ::pthread_sigmask(SIG_SETMASK, &vclone.mask, NULL);
+
+  errno = error;
+  return pid;
+}
+#endif // __linux__
+
+
+bool vcloneable(
+    const string& path,
+    const Option<lambda::function<int()>>& setup)
+{
+#ifdef __linux__
+  return setup.isNone() && strings::startsWith(path, "/");
+#else
+  return false;
+#endif // __linux__
+}
+
 
 Try<Launcher*> PosixLauncher::create(const Flags& flags)
 {
@@ -117,6 +211,15 @@ Try<pid_t> PosixLauncher::fork(
                  stringify(containerId));
   }
 
+  // Avoid copying the slave's address space if we can.
+  Option<lambda::function<pid_t(const lambda::function<int()>&)>> clone;
+
+#ifdef __linux__
+  if (vcloneable(path, setup)) {
+    clone = lambda::bind(&vclone, lambda::_1, 0);
+  }
+#endif // __linux__
+
   Try<Subprocess> child = subprocess(
       path,
       argv,
@@ -125,7 +228,8 @@ Try<pid_t> PosixLauncher::fork(
       err,
       flags,
       environment,
-      lambda::bind(&childSetup, setup));
+      lambda::bind(&childSetup, setup),
+      clone);
 
   if (child.isError()) {
     return Error("Failed to fork a child process: " + child.error());
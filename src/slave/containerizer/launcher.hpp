@@ -80,6 +80,29 @@ public:
 };
 
 
+#ifdef __linux__
+// A vfork style clone: the child shares the address space of the
+// caller until it execs or exits (CLONE_VM | CLONE_VFORK, plus the
+// given 'flags', e.g., namespaces). Unlike fork, none of the (possibly multi-GB)
+// slave address space needs to be copied, so the cost of a launch
+// does not grow with the size of the slave. The calling thread is
+// suspended until the child has exec'ed, hence 'func' must be async
+// signal safe, must not wait on the parent and must not modify memory
+// that the parent relies on. Returns -1 and sets errno on failure.
+pid_t vclone(const lambda::function<int()>& func, int flags = 0);
+#endif // __linux__
+
+
+// Returns true if a child for the given 'path' and 'setup' can be
+// launched through 'vclone' rather than a full fork. A 'setup' function
+// may block on the parent (which is suspended during a 'vclone') so we
+// only do so without one, and only for a path which does not need a
+// PATH lookup (the lookup would have to modify 'environ').
+bool vcloneable(
+    const std::string& path,
+    const Option<lambda::function<int()>>& setup);
+
+
 // Launcher suitable for any POSIX compliant system. Uses process
 // groups and sessions to track processes in a container. POSIX states
 // that process groups cannot migrate between sessions so all
@@ -16,7 +16,9 @@
  * limitations under the License.
  */
 
+#include <fcntl.h>
 #include <sched.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <linux/sched.h>
@@ -27,6 +29,7 @@
 
 #include <stout/abort.hpp>
 #include <stout/check.hpp>
+#include <stout/foreach.hpp>
 #include <stout/hashset.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
@@ -323,6 +326,33 @@ static int childSetup(
 }
 
 
+// The setup function for a child which is cloned with 'vclone'. The
+// parent is suspended until the child execs so, rather than having
+// the parent move it, the child moves itself into its cgroups by
+// writing "0" (i.e., the writer) to the given 'cgroup.procs' files.
+// Any error is stored in 'error', which is shared with the parent.
+static int vcloneSetup(const vector<int>& fds, int* error)
+{
+  foreach (int fd, fds) {
+    ssize_t length;
+    while ((length = ::write(fd, "0", 1)) == -1 && errno == EINTR);
+
+    if (length != 1) {
+      *error = errno;
+      return 1;
+    }
+  }
+
+  // See the comment in 'childSetup' above.
+  if (::setsid() == -1) {
+    *error = errno;
+    return 1;
+  }
+
+  return 0;
+}
+
+
 Try<pid_t> LinuxLauncher::fork(
     const ContainerID& containerId,
     const string& path,
@@ -351,6 +381,76 @@ Try<pid_t> LinuxLauncher::fork(
     }
   }
 
+  // If possible avoid copying the slave's address space, see 'vclone'.
+  if (vcloneable(path, setup)) {
+    vector<string> paths;
+    paths.push_back(path::join(
+        freezerHierarchy, cgroup(containerId), "cgroup.procs"));
+
+    if (systemdHierarchy.isSome()) {
+      paths.push_back(path::join(
+          systemdHierarchy.get(),
+          SYSTEMD_MESOS_EXECUTORS_SLICE,
+          "cgroup.procs"));
+    }
+
+    vector<int> fds;
+    foreach (const string& path, paths) {
+      Try<int> fd = os::open(path, O_WRONLY | O_CLOEXEC);
+      if (fd.isError()) {
+        foreach (int fd, fds) {
+          os::close(fd);
+        }
+        return Error("Failed to open '" + path + "': " + fd.error());
+      }
+      fds.push_back(fd.get());
+    }
+
+    int cloneFlags = namespaces.isSome() ? namespaces.get() : 0;
+
+    LOG(INFO) << "Cloning child process (vfork style) with flags = "
+              << ns::stringify(cloneFlags);
+
+    int error = 0;
+
+    Try<Subprocess> child = subprocess(
+        path,
+        argv,
+        in,
+        out,
+        err,
+        flags,
+        environment,
+        lambda::bind(&vcloneSetup, fds, &error),
+        lambda::bind(&vclone, lambda::_1, cloneFlags));
+
+    foreach (int fd, fds) {
+      os::close(fd);
+    }
+
+    if (child.isError()) {
+      return Error("Failed to clone child process: " + child.error());
+    }
+
+    // The child has either exec'ed or exited by now, see 'vclone'.
+    if (error != 0) {
+      LOG(ERROR) << "Failed to contain process " << child.get().pid()
+                 << " of container '" << containerId << "': "
+                 << strerror(error);
+
+      return Error("Failed to contain process");
+    }
+
+    LOG(INFO) << "Assigned child process '" << child.get().pid() << "' to '"
+              << path::join(freezerHierarchy, cgroup(containerId)) << "'";
+
+    if (!pids.contains(containerId)) {
+      pids.put(containerId, child.get().pid());
+    }
+
+    return child.get().pid();
+  }
+
   // Use a pipe to block the child until it's been moved into the
   // freezer cgroup.
   int pipes[2];
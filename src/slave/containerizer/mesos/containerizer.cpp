@@ -179,6 +179,7 @@ Try<MesosContainerizer*> MesosContainerizer::create(
   };
 
   vector<Owned<Isolator>> isolators;
+  vector<string> types;
 
   foreach (const string& type, strings::tokenize(isolation, ",")) {
     Owned<Isolator> isolator;
@@ -208,8 +209,10 @@ Try<MesosContainerizer*> MesosContainerizer::create(
     // prepared filesystem (e.g., any volume mounts are performed).
     if (strings::contains(type, "filesystem/")) {
       isolators.insert(isolators.begin(), isolator);
+      types.insert(types.begin(), type);
     } else {
       isolators.push_back(isolator);
+      types.push_back(type);
     }
   }
 
@@ -247,7 +250,8 @@ Try<MesosContainerizer*> MesosContainerizer::create(
       local,
       fetcher,
       Owned<Launcher>(launcher.get()),
-      isolators);
+      isolators,
+      types);
 }
 
 
@@ -256,13 +260,15 @@ MesosContainerizer::MesosContainerizer(
     bool local,
     Fetcher* fetcher,
     const Owned<Launcher>& launcher,
-    const vector<Owned<Isolator>>& isolators)
+    const vector<Owned<Isolator>>& isolators,
+    const vector<string>& types)
   : process(new MesosContainerizerProcess(
       flags,
       local,
       fetcher,
       launcher,
-      isolators))
+      isolators,
+      types))
 {
   spawn(process.get());
 }
@@ -356,6 +362,16 @@ Future<ResourceStatistics> MesosContainerizer::usage(
 }
 
 
+Future<hashmap<ContainerID, ResourceStatistics>>
+MesosContainerizer::batchUsage(const hashset<ContainerID>& containerIds)
+{
+  return dispatch(
+      process.get(),
+      &MesosContainerizerProcess::batchUsage,
+      containerIds);
+}
+
+
 Future<containerizer::Termination> MesosContainerizer::wait(
     const ContainerID& containerId)
 {
@@ -378,6 +394,85 @@ Future<hashset<ContainerID>> MesosContainerizer::containers()
 }
 
 
+// Returns the given isolator 'types', or names the isolators by their
+// position if the types are not known.
+static vector<string> isolatorTypes(size_t count, const vector<string>& types)
+{
+  if (types.size() == count) {
+    return types;
+  }
+
+  vector<string> result;
+  for (size_t i = 0; i < count; i++) {
+    result.push_back("isolator" + stringify(i));
+  }
+
+  return result;
+}
+
+
+// Returns, for each isolator type (in the order of preparation), the
+// preceding isolators which have to be prepared before it:
+//   (1) The filesystem isolator is prepared first so that the other
+//       isolators have a consistent view on the prepared filesystem.
+//   (2) The built-in runtime isolators do not depend on each other.
+//   (3) Any other isolator (e.g., a module) is prepared after all
+//       preceding isolators and before all following isolators.
+static vector<vector<size_t>> isolatorDependencies(const vector<string>& types)
+{
+  static const hashset<string> independent = {
+    "posix/cpu",
+    "posix/mem",
+    "posix/disk",
+    "cgroups/cpu",
+    "cgroups/mem",
+    "cgroups/perf_event",
+    "namespaces/pid",
+    "network/port_mapping"
+  };
+
+  vector<vector<size_t>> dependencies(types.size());
+
+  // The last isolator that all following isolators depend on and the
+  // independent isolators since then.
+  Option<size_t> barrier;
+  vector<size_t> since;
+
+  for (size_t i = 0; i < types.size(); i++) {
+    if (barrier.isSome()) {
+      dependencies[i].push_back(barrier.get());
+    }
+
+    if (independent.contains(types[i])) {
+      since.push_back(i);
+    } else {
+      dependencies[i].insert(dependencies[i].end(), since.begin(), since.end());
+      barrier = i;
+      since.clear();
+    }
+  }
+
+  return dependencies;
+}
+
+
+MesosContainerizerProcess::MesosContainerizerProcess(
+    const Flags& _flags,
+    bool _local,
+    Fetcher* _fetcher,
+    const Owned<Launcher>& _launcher,
+    const vector<Owned<Isolator>>& _isolators,
+    const vector<string>& _types)
+  : flags(_flags),
+    local(_local),
+    fetcher(_fetcher),
+    launcher(_launcher),
+    isolators(_isolators),
+    types(isolatorTypes(_isolators.size(), _types)),
+    dependencies(isolatorDependencies(types)),
+    metrics(types) {}
+
+
 Future<Nothing> MesosContainerizerProcess::recover(
     const Option<state::SlaveState>& state)
 {
@@ -640,26 +735,17 @@ Future<bool> MesosContainerizerProcess::launch(
 }
 
 
-static list<Option<ContainerPrepareInfo>> accumulate(
-    list<Option<ContainerPrepareInfo>> l,
-    const Option<ContainerPrepareInfo>& e)
-{
-  l.push_back(e);
-  return l;
-}
-
-
-static Future<list<Option<ContainerPrepareInfo>>> _prepare(
+static Future<Option<ContainerPrepareInfo>> _prepare(
     const Owned<Isolator>& isolator,
+    metrics::Timer<Milliseconds> timer,
     const ContainerID& containerId,
     const ExecutorInfo& executorInfo,
     const string& directory,
     const Option<string>& user,
-    const list<Option<ContainerPrepareInfo>> prepareInfos)
+    const list<Option<ContainerPrepareInfo>>& dependencies)
 {
-  // Propagate any failure.
-  return isolator->prepare(containerId, executorInfo, directory, user)
-    .then(lambda::bind(&accumulate, prepareInfos, lambda::_1));
+  return timer.time(
+      isolator->prepare(containerId, executorInfo, directory, user));
 }
 
 
@@ -671,26 +757,38 @@ Future<list<Option<ContainerPrepareInfo>>> MesosContainerizerProcess::prepare(
 {
   CHECK(containers_.contains(containerId));
 
-  // We prepare the isolators sequentially according to their ordering
-  // to permit basic dependency specification, e.g., preparing a
-  // filesystem isolator before other isolators.
-  Future<list<Option<ContainerPrepareInfo>>> f =
-    list<Option<ContainerPrepareInfo>>();
+  // Each isolator is prepared as soon as the isolators it depends on
+  // have been prepared (e.g., the filesystem isolator before the other
+  // isolators), so independent isolators are prepared concurrently.
+  // If an isolator fails to prepare, the isolators depending on it
+  // are not prepared at all.
+  vector<Future<Option<ContainerPrepareInfo>>> prepares;
+
+  for (size_t i = 0; i < isolators.size(); i++) {
+    list<Future<Option<ContainerPrepareInfo>>> dependencies_;
+    foreach (size_t dependency, dependencies[i]) {
+      dependencies_.push_back(prepares[dependency]);
+    }
 
-  foreach (const Owned<Isolator>& isolator, isolators) {
-    // Chain together preparing each isolator.
-    f = f.then(lambda::bind(&_prepare,
-                            isolator,
-                            containerId,
-                            executorInfo,
-                            directory,
-                            user,
-                            lambda::_1));
+    prepares.push_back(collect(dependencies_)
+      .then(lambda::bind(&_prepare,
+                         isolators[i],
+                         metrics.isolator_prepare[i],
+                         containerId,
+                         executorInfo,
+                         directory,
+                         user,
+                         lambda::_1)));
   }
 
-  containers_[containerId]->prepareInfos = f;
+  list<Future<Option<ContainerPrepareInfo>>> futures(
+      prepares.begin(),
+      prepares.end());
 
-  return f;
+  containers_[containerId]->preparations = await(futures);
+
+  // NOTE: The prepare infos are in the same order as the isolators.
+  return collect(futures);
 }
 
 
@@ -901,8 +999,9 @@ Future<bool> MesosContainerizerProcess::isolate(
   // or destroy because we assume there are no dependencies in
   // isolation.
   list<Future<Nothing>> futures;
-  foreach (const Owned<Isolator>& isolator, isolators) {
-    futures.push_back(isolator->isolate(containerId, _pid));
+  for (size_t i = 0; i < isolators.size(); i++) {
+    futures.push_back(metrics.isolator_isolate[i].time(
+        isolators[i]->isolate(containerId, _pid)));
   }
 
   // Wait for all isolators to complete.
@@ -1056,6 +1155,90 @@ Future<ResourceStatistics> MesosContainerizerProcess::usage(
 }
 
 
+// Merges the statistics gathered by each isolator for each of the
+// containers, see _usage().
+static hashmap<ContainerID, ResourceStatistics> _batchUsage(
+    const hashmap<ContainerID, Resources>& allocated,
+    const list<Future<hashmap<ContainerID, ResourceStatistics>>>& statistics)
+{
+  typedef hashmap<ContainerID, ResourceStatistics> Statistics;
+
+  Statistics result;
+
+  // Set the timestamp now we have all statistics.
+  const double timestamp = Clock::now().secs();
+
+  foreachkey (const ContainerID& containerId, allocated) {
+    result[containerId].set_timestamp(timestamp);
+  }
+
+  foreach (const Future<Statistics>& statistic, statistics) {
+    if (!statistic.isReady()) {
+      LOG(WARNING) << "Skipping resource statistics for "
+                   << allocated.size() << " containers because: "
+                   << (statistic.isFailed() ? statistic.failure()
+                                            : "discarded");
+      continue;
+    }
+
+    foreachpair (const ContainerID& containerId,
+                 const ResourceStatistics& statistics,
+                 statistic.get()) {
+      if (result.contains(containerId)) {
+        result[containerId].MergeFrom(statistics);
+      }
+    }
+  }
+
+  foreachpair (const ContainerID& containerId,
+               const Resources& resources,
+               allocated) {
+    // Set the resource allocations.
+    Option<Bytes> mem = resources.mem();
+    if (mem.isSome()) {
+      result[containerId].set_mem_limit_bytes(mem.get().bytes());
+    }
+
+    Option<double> cpus = resources.cpus();
+    if (cpus.isSome()) {
+      result[containerId].set_cpus_limit(cpus.get());
+    }
+  }
+
+  return result;
+}
+
+
+Future<hashmap<ContainerID, ResourceStatistics>>
+MesosContainerizerProcess::batchUsage(const hashset<ContainerID>& containerIds)
+{
+  hashset<ContainerID> known;
+  hashmap<ContainerID, Resources> resources;
+
+  foreach (const ContainerID& containerId, containerIds) {
+    if (!containers_.contains(containerId)) {
+      VLOG(1) << "Skipping resource statistics for unknown container "
+              << containerId;
+      continue;
+    }
+
+    known.insert(containerId);
+    resources[containerId] = containers_[containerId]->resources;
+  }
+
+  // Each isolator gathers the statistics of all the containers in one
+  // pass, instead of once per container.
+  list<Future<hashmap<ContainerID, ResourceStatistics>>> futures;
+  foreach (const Owned<Isolator>& isolator, isolators) {
+    futures.push_back(isolator->batchUsage(known));
+  }
+
+  // Use await() here so we can return partial usage statistics.
+  return await(futures)
+    .then(lambda::bind(_batchUsage, resources, lambda::_1));
+}
+
+
 void MesosContainerizerProcess::destroy(
     const ContainerID& containerId)
 {
@@ -1083,7 +1266,7 @@ void MesosContainerizerProcess::destroy(
     // We need to wait for the isolators to finish preparing to prevent
     // a race that the destroy method calls isolators' cleanup before
     // it starts preparing.
-    container->prepareInfos
+    container->preparations
       .onAny(defer(
           self(),
           &Self::___destroy,
@@ -1295,17 +1478,38 @@ Future<hashset<ContainerID>> MesosContainerizerProcess::containers()
 }
 
 
-MesosContainerizerProcess::Metrics::Metrics()
+MesosContainerizerProcess::Metrics::Metrics(const vector<string>& types)
   : container_destroy_errors(
         "containerizer/mesos/container_destroy_errors")
 {
   process::metrics::add(container_destroy_errors);
+
+  foreach (const string& type, types) {
+    isolator_prepare.push_back(metrics::Timer<Milliseconds>(
+        "containerizer/mesos/isolators/" + type + "/prepare",
+        Hours(1)));
+
+    isolator_isolate.push_back(metrics::Timer<Milliseconds>(
+        "containerizer/mesos/isolators/" + type + "/isolate",
+        Hours(1)));
+
+    process::metrics::add(isolator_prepare.back());
+    process::metrics::add(isolator_isolate.back());
+  }
 }
 
 
 MesosContainerizerProcess::Metrics::~Metrics()
 {
   process::metrics::remove(container_destroy_errors);
+
+  foreach (const metrics::Timer<Milliseconds>& timer, isolator_prepare) {
+    process::metrics::remove(timer);
+  }
+
+  foreach (const metrics::Timer<Milliseconds>& timer, isolator_isolate) {
+    process::metrics::remove(timer);
+  }
 }
 
 
@@ -20,11 +20,13 @@
 #define __MESOS_CONTAINERIZER_HPP__
 
 #include <list>
+#include <string>
 #include <vector>
 
 #include <mesos/slave/isolator.hpp>
 
 #include <process/metrics/counter.hpp>
+#include <process/metrics/timer.hpp>
 
 #include <stout/hashmap.hpp>
 #include <stout/multihashmap.hpp>
@@ -56,7 +58,8 @@ public:
       bool local,
       Fetcher* fetcher,
       const process::Owned<Launcher>& launcher,
-      const std::vector<process::Owned<mesos::slave::Isolator>>& isolators);
+      const std::vector<process::Owned<mesos::slave::Isolator>>& isolators,
+      const std::vector<std::string>& types = std::vector<std::string>());
 
   // Used for testing.
   MesosContainerizer(const process::Owned<MesosContainerizerProcess>& _process);
@@ -92,6 +95,9 @@ public:
   virtual process::Future<ResourceStatistics> usage(
       const ContainerID& containerId);
 
+  virtual process::Future<hashmap<ContainerID, ResourceStatistics>>
+    batchUsage(const hashset<ContainerID>& containerIds);
+
   virtual process::Future<containerizer::Termination> wait(
       const ContainerID& containerId);
 
@@ -113,12 +119,8 @@ public:
       bool _local,
       Fetcher* _fetcher,
       const process::Owned<Launcher>& _launcher,
-      const std::vector<process::Owned<mesos::slave::Isolator>>& _isolators)
-    : flags(_flags),
-      local(_local),
-      fetcher(_fetcher),
-      launcher(_launcher),
-      isolators(_isolators) {}
+      const std::vector<process::Owned<mesos::slave::Isolator>>& _isolators,
+      const std::vector<std::string>& _types = std::vector<std::string>());
 
   virtual ~MesosContainerizerProcess() {}
 
@@ -142,6 +144,9 @@ public:
   virtual process::Future<ResourceStatistics> usage(
       const ContainerID& containerId);
 
+  virtual process::Future<hashmap<ContainerID, ResourceStatistics>>
+    batchUsage(const hashset<ContainerID>& containerIds);
+
   virtual process::Future<containerizer::Termination> wait(
       const ContainerID& containerId);
 
@@ -237,6 +242,15 @@ private:
   const process::Owned<Launcher> launcher;
   const std::vector<process::Owned<mesos::slave::Isolator>> isolators;
 
+  // The type (e.g., 'cgroups/cpu') of each isolator. When the types
+  // are not known (e.g., in tests) each isolator is named by its
+  // position and treated like a module isolator.
+  const std::vector<std::string> types;
+
+  // For each isolator, the (preceding) isolators which have to be
+  // prepared before it can be prepared, see 'prepare'.
+  const std::vector<std::vector<size_t>> dependencies;
+
   enum State
   {
     PREPARING,
@@ -259,8 +273,12 @@ private:
     // We keep track of the future that is waiting for all the
     // isolators' prepare futures, so that destroy will only start
     // calling cleanup after all isolators has finished preparing.
-    process::Future<std::list<Option<mesos::slave::ContainerPrepareInfo>>>
-      prepareInfos;
+    // NOTE: Unlike the future returned by 'prepare', this one only
+    // completes once every preparation has completed, even if one of
+    // them has already failed.
+    process::Future<
+        std::list<process::Future<Option<mesos::slave::ContainerPrepareInfo>>>>
+      preparations;
 
     // We keep track of the future that is waiting for all the
     // isolators' isolate futures, so that destroy will only start
@@ -285,10 +303,15 @@ private:
 
   struct Metrics
   {
-    Metrics();
+    explicit Metrics(const std::vector<std::string>& types);
     ~Metrics();
 
     process::metrics::Counter container_destroy_errors;
+
+    // The time each isolator takes to prepare and to isolate a
+    // container, indexed like 'isolators'.
+    std::vector<process::metrics::Timer<Milliseconds>> isolator_prepare;
+    std::vector<process::metrics::Timer<Milliseconds>> isolator_isolate;
   } metrics;
 };
 
@@ -462,52 +462,49 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
     result.set_threads(tids.get().size());
   }
 
-  // Get the number of clock ticks, used for cpu accounting.
-  static long ticks = sysconf(_SC_CLK_TCK);
+  // Add the cpuacct.stat information.
+  Try<Owned<cgroups::Control>> control = info->controls.get(
+      hierarchies["cpuacct"], info->cgroup, "cpuacct.stat");
 
-  PCHECK(ticks > 0) << "Failed to get sysconf(_SC_CLK_TCK)";
+  if (control.isError()) {
+    return Failure("Failed to open cpuacct.stat: " + control.error());
+  }
 
-  // Add the cpuacct.stat information.
-  Try<hashmap<string, uint64_t>> stat = cgroups::stat(
-      hierarchies["cpuacct"],
-      info->cgroup,
-      "cpuacct.stat");
+  Try<cgroups::cpuacct::Stats> stat =
+    cgroups::cpuacct::stat(control.get().get());
 
   if (stat.isError()) {
     return Failure("Failed to read cpuacct.stat: " + stat.error());
   }
 
-  // TODO(bmahler): Add namespacing to cgroups to enforce the expected
-  // structure, e.g., cgroups::cpuacct::stat.
-  Option<uint64_t> user = stat.get().get("user");
-  Option<uint64_t> system = stat.get().get("system");
-
-  if (user.isSome() && system.isSome()) {
-    result.set_cpus_user_time_secs((double) user.get() / (double) ticks);
-    result.set_cpus_system_time_secs((double) system.get() / (double) ticks);
-  }
+  result.set_cpus_user_time_secs(stat.get().user.secs());
+  result.set_cpus_system_time_secs(stat.get().system.secs());
 
   // Add the cpu.stat information only if CFS is enabled.
   if (flags.cgroups_enable_cfs) {
-    stat = cgroups::stat(hierarchies["cpu"], info->cgroup, "cpu.stat");
+    control = info->controls.get(
+        hierarchies["cpu"], info->cgroup, "cpu.stat");
+
+    if (control.isError()) {
+      return Failure("Failed to open cpu.stat: " + control.error());
+    }
+
+    Try<cgroups::cpu::Stats> stat = cgroups::cpu::stat(control.get().get());
     if (stat.isError()) {
       return Failure("Failed to read cpu.stat: " + stat.error());
     }
 
-    Option<uint64_t> nr_periods = stat.get().get("nr_periods");
-    if (nr_periods.isSome()) {
-      result.set_cpus_nr_periods(nr_periods.get());
+    if (stat.get().nr_periods.isSome()) {
+      result.set_cpus_nr_periods(stat.get().nr_periods.get());
     }
 
-    Option<uint64_t> nr_throttled = stat.get().get("nr_throttled");
-    if (nr_throttled.isSome()) {
-      result.set_cpus_nr_throttled(nr_throttled.get());
+    if (stat.get().nr_throttled.isSome()) {
+      result.set_cpus_nr_throttled(stat.get().nr_throttled.get());
     }
 
-    Option<uint64_t> throttled_time = stat.get().get("throttled_time");
-    if (throttled_time.isSome()) {
+    if (stat.get().throttled_time.isSome()) {
       result.set_cpus_throttled_time_secs(
-          Nanoseconds(throttled_time.get()).secs());
+          stat.get().throttled_time.get().secs());
     }
   }
 
@@ -528,6 +525,8 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::cleanup(
 
   Info* info = CHECK_NOTNULL(infos[containerId]);
 
+  info->controls.clear();
+
   list<Future<Nothing>> futures;
   foreach (const string& subsystem, subsystems) {
     futures.push_back(cgroups::destroy(
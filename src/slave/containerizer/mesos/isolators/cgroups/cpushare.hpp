@@ -29,6 +29,8 @@
 #include <stout/hashmap.hpp>
 #include <stout/option.hpp>
 
+#include "linux/cgroups.hpp"
+
 #include "slave/flags.hpp"
 
 #include "slave/containerizer/isolator.hpp"
@@ -98,6 +100,9 @@ private:
     Option<Resources> resources;
 
     process::Promise<mesos::slave::ContainerLimitation> limitation;
+
+    // Control files polled by 'usage', kept open across calls.
+    cgroups::Controls controls;
   };
 
   const Flags flags;
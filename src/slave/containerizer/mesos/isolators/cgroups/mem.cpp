@@ -423,7 +423,15 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
   // The rss from memory.stat is wrong in two dimensions:
   //   1. It does not include child cgroups.
   //   2. It does not include any file backed pages.
-  Try<Bytes> usage = cgroups::memory::usage_in_bytes(hierarchy, info->cgroup);
+  Try<Owned<cgroups::Control>> control =
+    info->controls.get(hierarchy, info->cgroup, "memory.usage_in_bytes");
+
+  if (control.isError()) {
+    return Failure(
+        "Failed to open memory.usage_in_bytes: " + control.error());
+  }
+
+  Try<Bytes> usage = cgroups::memory::usage_in_bytes(control.get().get());
   if (usage.isError()) {
     return Failure("Failed to parse memory.usage_in_bytes: " + usage.error());
   }
@@ -431,8 +439,16 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
   result.set_mem_total_bytes(usage.get().bytes());
 
   if (limitSwap) {
+    control = info->controls.get(
+        hierarchy, info->cgroup, "memory.memsw.usage_in_bytes");
+
+    if (control.isError()) {
+      return Failure(
+          "Failed to open memory.memsw.usage_in_bytes: " + control.error());
+    }
+
     Try<Bytes> usage =
-      cgroups::memory::memsw_usage_in_bytes(hierarchy, info->cgroup);
+      cgroups::memory::usage_in_bytes(control.get().get());
     if (usage.isError()) {
       return Failure(
         "Failed to parse memory.memsw.usage_in_bytes: " + usage.error());
@@ -441,45 +457,43 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
     result.set_mem_total_memsw_bytes(usage.get().bytes());
   }
 
-  // TODO(bmahler): Add namespacing to cgroups to enforce the expected
-  // structure, e.g, cgroups::memory::stat.
-  Try<hashmap<string, uint64_t>> stat =
-    cgroups::stat(hierarchy, info->cgroup, "memory.stat");
+  control = info->controls.get(hierarchy, info->cgroup, "memory.stat");
+  if (control.isError()) {
+    return Failure("Failed to open memory.stat: " + control.error());
+  }
+
+  Try<cgroups::memory::Stats> stat =
+    cgroups::memory::stat(control.get().get());
   if (stat.isError()) {
     return Failure("Failed to read memory.stat: " + stat.error());
   }
 
-  Option<uint64_t> total_cache = stat.get().get("total_cache");
-  if (total_cache.isSome()) {
+  if (stat.get().total_cache.isSome()) {
     // TODO(chzhcn): mem_file_bytes is deprecated in 0.23.0 and will
     // be removed in 0.24.0.
-    result.set_mem_file_bytes(total_cache.get());
+    result.set_mem_file_bytes(stat.get().total_cache.get());
 
-    result.set_mem_cache_bytes(total_cache.get());
+    result.set_mem_cache_bytes(stat.get().total_cache.get());
   }
 
-  Option<uint64_t> total_rss = stat.get().get("total_rss");
-  if (total_rss.isSome()) {
+  if (stat.get().total_rss.isSome()) {
     // TODO(chzhcn): mem_anon_bytes is deprecated in 0.23.0 and will
     // be removed in 0.24.0.
-    result.set_mem_anon_bytes(total_rss.get());
+    result.set_mem_anon_bytes(stat.get().total_rss.get());
 
-    result.set_mem_rss_bytes(total_rss.get());
+    result.set_mem_rss_bytes(stat.get().total_rss.get());
   }
 
-  Option<uint64_t> total_mapped_file = stat.get().get("total_mapped_file");
-  if (total_mapped_file.isSome()) {
-    result.set_mem_mapped_file_bytes(total_mapped_file.get());
+  if (stat.get().total_mapped_file.isSome()) {
+    result.set_mem_mapped_file_bytes(stat.get().total_mapped_file.get());
   }
 
-  Option<uint64_t> total_swap = stat.get().get("total_swap");
-  if (total_swap.isSome()) {
-    result.set_mem_swap_bytes(total_swap.get());
+  if (stat.get().total_swap.isSome()) {
+    result.set_mem_swap_bytes(stat.get().total_swap.get());
   }
 
-  Option<uint64_t> total_unevictable = stat.get().get("total_unevictable");
-  if (total_unevictable.isSome()) {
-    result.set_mem_unevictable_bytes(total_unevictable.get());
+  if (stat.get().total_unevictable.isSome()) {
+    result.set_mem_unevictable_bytes(stat.get().total_unevictable.get());
   }
 
   // Get pressure counter readings.
@@ -555,6 +569,8 @@ Future<Nothing> CgroupsMemIsolatorProcess::cleanup(
     info->oomNotifier.discard();
   }
 
+  info->controls.clear();
+
   return cgroups::destroy(hierarchy, info->cgroup, cgroups::DESTROY_TIMEOUT)
     .onAny(defer(PID<CgroupsMemIsolatorProcess>(this),
                  &CgroupsMemIsolatorProcess::_cleanup,
@@ -102,6 +102,9 @@ private:
     // Used to cancel the OOM listening.
     process::Future<Nothing> oomNotifier;
 
+    // Control files polled by 'usage', kept open across calls.
+    cgroups::Controls controls;
+
     hashmap<cgroups::memory::pressure::Level,
             process::Owned<cgroups::memory::pressure::Counter>>
       pressureCounters;
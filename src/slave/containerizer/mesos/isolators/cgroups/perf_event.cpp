@@ -28,7 +28,6 @@
 #include <process/delay.hpp>
 #include <process/io.hpp>
 #include <process/pid.hpp>
-#include <process/reap.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/bytes.hpp>
@@ -60,6 +59,7 @@ using std::vector;
 using process::Clock;
 using process::Failure;
 using process::Future;
+using process::Owned;
 using process::PID;
 using process::Time;
 
@@ -71,10 +71,6 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
 {
   LOG(INFO) << "Creating PerfEvent isolator";
 
-  if (!perf::supported()) {
-    return Error("Perf is not supported");
-  }
-
   if (flags.perf_duration > flags.perf_interval) {
     return Error("Sampling perf for duration (" +
                  stringify(flags.perf_duration) +
@@ -93,9 +89,10 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
     events.insert(event);
   }
 
-  if (!perf::valid(events)) {
-    return Error("Failed to create PerfEvent isolator, invalid events: " +
-                 stringify(events));
+  Try<Owned<perf::Sampler>> sampler = perf::Sampler::create(events);
+  if (sampler.isError()) {
+    return Error("Failed to create PerfEvent isolator, invalid events " +
+                 stringify(events) + ": " + sampler.error());
   }
 
   Try<string> hierarchy = cgroups::prepare(
@@ -107,12 +104,12 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
     return Error("Failed to create perf_event cgroup: " + hierarchy.error());
   }
 
-  LOG(INFO) << "PerfEvent isolator will profile for " << flags.perf_duration
-            << " every " << flags.perf_interval
+  LOG(INFO) << "PerfEvent isolator will sample every " << flags.perf_interval
             << " for events: " << stringify(events);
 
   process::Owned<MesosIsolatorProcess> process(
-      new CgroupsPerfEventIsolatorProcess(flags, hierarchy.get(), events));
+      new CgroupsPerfEventIsolatorProcess(
+          flags, hierarchy.get(), sampler.get()));
 
   return new MesosIsolator(process);
 }
@@ -123,8 +120,11 @@ CgroupsPerfEventIsolatorProcess::~CgroupsPerfEventIsolatorProcess() {}
 
 void CgroupsPerfEventIsolatorProcess::initialize()
 {
-  // Start sampling.
-  sample();
+  // Start sampling. The first sample covers the first interval
+  // since the counters are kept open across samples.
+  delay(flags.perf_interval,
+        PID<CgroupsPerfEventIsolatorProcess>(this),
+        &CgroupsPerfEventIsolatorProcess::sample);
 }
 
 
@@ -163,6 +163,12 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::recover(
     }
 
     infos[containerId] = new Info(containerId, cgroup);
+
+    Try<Nothing> add = sampler->add(hierarchy, cgroup);
+    if (add.isError()) {
+      LOG(ERROR) << "Failed to sample perf events for container "
+                 << containerId << ": " << add.error();
+    }
   }
 
   // Remove orphan cgroups.
@@ -256,6 +262,14 @@ Future<Option<ContainerPrepareInfo>> CgroupsPerfEventIsolatorProcess::prepare(
     }
   }
 
+  // Start counting the events of the cgroup; the processes are
+  // counted as soon as they are assigned to it.
+  Try<Nothing> add = sampler->add(hierarchy, info->cgroup);
+  if (add.isError()) {
+    LOG(ERROR) << "Failed to sample perf events for container "
+               << containerId << ": " << add.error();
+  }
+
   return None();
 }
 
@@ -330,7 +344,8 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::cleanup(
 
   Info* info = CHECK_NOTNULL(infos[containerId]);
 
-  info->destroying = true;
+  // Stop sampling the cgroup, which closes its perf events.
+  sampler->remove(info->cgroup);
 
   return cgroups::destroy(hierarchy, info->cgroup)
     .then(defer(PID<CgroupsPerfEventIsolatorProcess>(this),
@@ -353,79 +368,22 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::_cleanup(
 }
 
 
-Future<hashmap<string, PerfStatistics>> discardSample(
-    Future<hashmap<string, PerfStatistics>> future,
-    const Duration& duration,
-    const Duration& timeout)
-{
-  LOG(ERROR) << "Perf sample of " << stringify(duration)
-             << " failed to complete within " << stringify(timeout)
-             << "; sampling will be halted";
-
-  future.discard();
-
-  return future;
-}
-
-
 void CgroupsPerfEventIsolatorProcess::sample()
 {
-  // Collect a perf sample for all cgroups that are not being
-  // destroyed. Since destroyal is asynchronous, 'perf stat' may
-  // fail if the cgroup is destroyed before running perf.
-  set<string> cgroups;
+  // Store the latest statistics, note that cgroups added in the
+  // interim will be picked up by the next sample.
+  const hashmap<string, PerfStatistics> statistics = sampler->sample();
 
   foreachvalue (Info* info, infos) {
     CHECK_NOTNULL(info);
 
-    if (!info->destroying) {
-      cgroups.insert(info->cgroup);
-    }
-  }
-
-  // The discard timeout includes an allowance of twice the
-  // reaper interval to ensure we see the perf process exit.
-  Duration timeout = flags.perf_duration + process::MAX_REAP_INTERVAL() * 2;
-
-  perf::sample(events, cgroups, flags.perf_duration)
-    .after(timeout,
-           lambda::bind(&discardSample,
-                        lambda::_1,
-                        flags.perf_duration,
-                        timeout))
-    .onAny(defer(PID<CgroupsPerfEventIsolatorProcess>(this),
-                 &CgroupsPerfEventIsolatorProcess::_sample,
-                 Clock::now() + flags.perf_interval,
-                 lambda::_1));
-}
-
-
-void CgroupsPerfEventIsolatorProcess::_sample(
-    const Time& next,
-    const Future<hashmap<string, PerfStatistics>>& statistics)
-{
-  if (!statistics.isReady()) {
-    // In case the failure is transient or this is due to a timeout,
-    // we continue sampling. Note that since sampling is done on an
-    // interval, it should be ok if this is a non-transient failure.
-    LOG(ERROR) << "Failed to get perf sample: "
-               << (statistics.isFailed()
-                   ? statistics.failure()
-                   : "discarded due to timeout");
-  } else {
-    // Store the latest statistics, note that cgroups added in the
-    // interim will be picked up by the next sample.
-    foreachvalue (Info* info, infos) {
-      CHECK_NOTNULL(info);
-
-      if (statistics->contains(info->cgroup)) {
-        info->statistics = statistics->get(info->cgroup).get();
-      }
+    if (statistics.contains(info->cgroup)) {
+      info->statistics = statistics.at(info->cgroup);
     }
   }
 
   // Schedule sample for the next time.
-  delay(next - Clock::now(),
+  delay(flags.perf_interval,
         PID<CgroupsPerfEventIsolatorProcess>(this),
         &CgroupsPerfEventIsolatorProcess::sample);
 }
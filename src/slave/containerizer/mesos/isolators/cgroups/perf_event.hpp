@@ -21,11 +21,14 @@
 
 #include <set>
 
+#include <process/owned.hpp>
 #include <process/time.hpp>
 
 #include <stout/hashmap.hpp>
 #include <stout/nothing.hpp>
 
+#include "linux/perf.hpp"
+
 #include "slave/flags.hpp"
 
 #include "slave/containerizer/isolator.hpp"
@@ -75,23 +78,19 @@ private:
   CgroupsPerfEventIsolatorProcess(
       const Flags& _flags,
       const std::string& _hierarchy,
-      const std::set<std::string>& _events)
+      const process::Owned<perf::Sampler>& _sampler)
     : flags(_flags),
       hierarchy(_hierarchy),
-      events(_events) {}
+      sampler(_sampler) {}
 
   void sample();
 
-  void _sample(
-      const process::Time& next,
-      const process::Future<hashmap<std::string, PerfStatistics>>& statistics);
-
   virtual process::Future<Nothing> _cleanup(const ContainerID& containerId);
 
   struct Info
   {
     Info(const ContainerID& _containerId, const std::string& _cgroup)
-      : containerId(_containerId), cgroup(_cgroup), destroying(false)
+      : containerId(_containerId), cgroup(_cgroup)
     {
       // Ensure the initial statistics include the required fields.
       // Note the duration is set to zero to indicate no sampling has
@@ -104,8 +103,6 @@ private:
     const ContainerID containerId;
     const std::string cgroup;
     PerfStatistics statistics;
-    // Mark a container when we start destruction so we stop sampling it.
-    bool destroying;
   };
 
   const Flags flags;
@@ -113,8 +110,8 @@ private:
   // The path to the cgroups subsystem hierarchy root.
   const std::string hierarchy;
 
-  // Set of events to sample.
-  std::set<std::string> events;
+  // Counts the events of the containers' cgroups.
+  process::Owned<perf::Sampler> sampler;
 
   // TODO(jieyu): Use Owned<Info>.
   hashmap<ContainerID, Info*> infos;
@@ -20,6 +20,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -27,6 +28,7 @@
 
 #include <mesos/mesos.hpp>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/io.hpp>
@@ -227,6 +229,13 @@ static const uint16_t ICMP_FLOWID = 2;
 static const uint16_t CONTAINER_MIN_FLOWID = 3;
 
 
+// How long a dump of the statistics of all links is reused by
+// 'usage()'. Resource monitors poll all containers back to back, so
+// this lets a single netlink dump serve the whole poll instead of
+// dumping every link on the host once per container.
+static const Duration LINK_STATISTICS_TTL = Milliseconds(500);
+
+
 // The well known ports. Used for sanity check.
 static Interval<uint16_t> WELL_KNOWN_PORTS()
 {
@@ -2242,8 +2251,10 @@ Future<Nothing> PortMappingIsolatorProcess::isolate(
 
   // For each port range, add a set of IP packet filters to properly
   // redirect IP traffic to/from containers.
-  foreach (const PortRange& range,
-           getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts)) {
+  vector<PortRange> ranges =
+    getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts);
+
+  foreach (const PortRange& range, ranges) {
     if (info->flowId.isSome()) {
       LOG(INFO) << "Adding IP packet filters with ports " << range
                 << " with flow ID " << info->flowId.get()
@@ -2252,14 +2263,14 @@ Future<Nothing> PortMappingIsolatorProcess::isolate(
       LOG(INFO) << "Adding IP packet filters with ports " << range
                 << " for container " << containerId;
     }
+  }
 
-    Try<Nothing> add = addHostIPFilters(range, info->flowId, veth(pid));
-    if (add.isError()) {
-      return Failure(
-          "Failed to add IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
-          stringify(pid) + ": " + add.error());
-    }
+  Try<Nothing> add = addHostIPFilters(ranges, info->flowId, veth(pid));
+  if (add.isError()) {
+    return Failure(
+        "Failed to add IP packet filters with ports " +
+        stringify(ranges) + " for container with pid " +
+        stringify(pid) + ": " + add.error());
   }
 
   // Relay ICMP packets from veth of the container to host eth0.
@@ -2639,29 +2650,32 @@ Future<Nothing> PortMappingIsolatorProcess::update(
       LOG(INFO) << "Adding IP packet filters with ports " << range
                 << " for container " << containerId;
     }
+  }
 
-    // All IP packets from a container will be assigned a single flow
-    // on host eth0.
-    Try<Nothing> add = addHostIPFilters(range, info->flowId, veth(pid));
-    if (add.isError()) {
-      return Failure(
-          "Failed to add IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
-          stringify(pid) + ": " + add.error());
-    }
+  // All IP packets from a container will be assigned a single flow
+  // on host eth0.
+  Try<Nothing> add = addHostIPFilters(portsToAdd, info->flowId, veth(pid));
+  if (add.isError()) {
+    return Failure(
+        "Failed to add IP packet filters with ports " +
+        stringify(portsToAdd) + " for container with pid " +
+        stringify(pid) + ": " + add.error());
   }
 
   foreach (const PortRange& range, portsToRemove) {
     LOG(INFO) << "Removing IP packet filters with ports " << range
               << " for container with pid " << pid;
+  }
 
-    Try<Nothing> removing = removeHostIPFilters(range, veth(pid));
-    if (removing.isError()) {
-      return Failure(
-          "Failed to remove IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
-          stringify(pid) + ": " + removing.error());
-    }
+  Try<Nothing> removing = removeHostIPFilters(
+      vector<PortRange>(portsToRemove.begin(), portsToRemove.end()),
+      veth(pid));
+
+  if (removing.isError()) {
+    return Failure(
+        "Failed to remove IP packet filters with ports " +
+        stringify(portsToRemove) + " for container with pid " +
+        stringify(pid) + ": " + removing.error());
   }
 
   // Update the non-ephemeral ports of this container.
@@ -2723,7 +2737,7 @@ Future<ResourceStatistics> PortMappingIsolatorProcess::usage(
   }
 
   Result<hashmap<string, uint64_t>> stat =
-    link::statistics(veth(info->pid.get()));
+    linkStatistics(veth(info->pid.get()));
 
   if (stat.isError()) {
     return Failure(
@@ -2788,6 +2802,14 @@ Future<ResourceStatistics> PortMappingIsolatorProcess::usage(
     result.set_net_tx_dropped(tx_dropped.get());
   }
 
+  // The socket statistics have to be collected from inside the
+  // network namespace of the container, which requires launching a
+  // subprocess. Skip it if none of them are enabled.
+  if (!flags.network_enable_socket_statistics_summary &&
+      !flags.network_enable_socket_statistics_details) {
+    return result;
+  }
+
   // Retrieve the socket information from inside the container.
   PortMappingStatistics statistics;
   statistics.flags.pid = info->pid.get();
@@ -2951,20 +2973,22 @@ Try<Nothing> PortMappingIsolatorProcess::_cleanup(
 
   // Remove the IP filters on eth0 and lo for non-ephemeral port
   // ranges and the ephemeral port range.
-  foreach (const PortRange& range,
-           getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts)) {
+  vector<PortRange> ranges =
+    getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts);
+
+  foreach (const PortRange& range, ranges) {
     LOG(INFO) << "Removing IP packet filters with ports " << range
               << " for container with pid " << pid;
+  }
 
-    // No need to remove filters on veth as they will be automatically
-    // removed by the kernel when we remove the link below.
-    Try<Nothing> removing = removeHostIPFilters(range, veth(pid), false);
-    if (removing.isError()) {
-      errors.push_back(
-          "Failed to remove IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
-          stringify(pid) + ": " + removing.error());
-    }
+  // No need to remove filters on veth as they will be automatically
+  // removed by the kernel when we remove the link below.
+  Try<Nothing> removing = removeHostIPFilters(ranges, veth(pid), false);
+  if (removing.isError()) {
+    errors.push_back(
+        "Failed to remove IP packet filters with ports " +
+        stringify(ranges) + " for container with pid " +
+        stringify(pid) + ": " + removing.error());
   }
 
   // Free the ephemeral ports used by this container.
@@ -3190,318 +3214,319 @@ Try<Nothing> PortMappingIsolatorProcess::_cleanup(
 }
 
 
-// Helper function to set up IP filters on the host side for a given
-// port range.
+// Helper function to set up IP filters on the host side for the given
+// port ranges. The filters on each link are added in a single batch.
 Try<Nothing> PortMappingIsolatorProcess::addHostIPFilters(
-    const PortRange& range,
+    const vector<PortRange>& ranges,
     const Option<uint16_t>& flowId,
     const string& veth)
 {
   // NOTE: The order in which these filters are added is important!
-  // For each port range, we need to make sure that we don't try to
-  // add filters on host eth0 and host lo until we have successfully
-  // added filters on veth. This is because the slave could crash
-  // while we are adding filters, we want to make sure we don't leak
-  // any filters on host eth0 and host lo.
-
-  // Add an IP packet filter from veth of the container to host eth0
-  // to properly redirect IP packets sent from one container to
-  // external hosts. This filter has a lower priority compared to the
-  // 'vethToHostLo' filter because it does not check the destination
-  // IP. Notice that here we also check the source port of a packet.
-  // If the source port is not within the port ranges allocated for
-  // the container, the packet will get dropped.
-  Try<bool> vethToHostEth0 = filter::ip::create(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(None(), None(), range, None()),
-      Priority(IP_FILTER_PRIORITY, LOW),
-      action::Redirect(eth0));
+  // We need to make sure that we don't try to add filters on host
+  // eth0 and host lo until we have successfully added filters on
+  // veth. This is because the slave could crash while we are adding
+  // filters, we want to make sure we don't leak any filters on host
+  // eth0 and host lo.
+  filter::Batch<ip::Classifier> vethFilters(veth, ingress::HANDLE);
+  filter::Batch<ip::Classifier> hostEth0Filters(eth0, ingress::HANDLE);
+  filter::Batch<ip::Classifier> hostLoFilters(lo, ingress::HANDLE);
+  filter::Batch<ip::Classifier> hostEth0EgressFilters(
+      eth0,
+      HOST_TX_FQ_CODEL_HANDLE);
 
-  if (vethToHostEth0.isError()) {
+  foreach (const PortRange& range, ranges) {
+    // Add an IP packet filter from veth of the container to host eth0
+    // to properly redirect IP packets sent from one container to
+    // external hosts. This filter has a lower priority compared to
+    // the 'vethToHostLo' filter because it does not check the
+    // destination IP. Notice that here we also check the source port
+    // of a packet. If the source port is not within the port ranges
+    // allocated for the container, the packet will get dropped.
+    vethFilters.create(
+        ip::Classifier(None(), None(), range, None()),
+        Priority(IP_FILTER_PRIORITY, LOW),
+        None(),
+        action::Redirect(eth0));
+
+    // Add two IP packet filters (one for public IP and one for
+    // loopback IP) from veth of the container to host lo to properly
+    // redirect IP packets sent from one container to either the host
+    // or another container. Notice that here we also check the source
+    // port of a packet. If the source port is not within the port
+    // ranges allocated for the container, the packet will get
+    // dropped.
+    vethFilters.create(
+        ip::Classifier(None(), hostIPNetwork.address(), range, None()),
+        Priority(IP_FILTER_PRIORITY, NORMAL),
+        None(),
+        action::Redirect(lo));
+
+    vethFilters.create(
+        ip::Classifier(
+            None(),
+            net::IPNetwork::LOOPBACK_V4().address(),
+            range,
+            None()),
+        Priority(IP_FILTER_PRIORITY, NORMAL),
+        None(),
+        action::Redirect(lo));
+
+    // Add an IP packet filter from host eth0 to veth of the container
+    // such that any incoming IP packet will be properly redirected to
+    // the corresponding container based on its destination port.
+    hostEth0Filters.create(
+        ip::Classifier(hostMAC, hostIPNetwork.address(), None(), range),
+        Priority(IP_FILTER_PRIORITY, NORMAL),
+        None(),
+        action::Redirect(veth));
+
+    // Add an IP packet filter from host lo to veth of the container
+    // such that any internally generated IP packet will be properly
+    // redirected to the corresponding container based on its
+    // destination port.
+    hostLoFilters.create(
+        ip::Classifier(None(), None(), None(), range),
+        Priority(IP_FILTER_PRIORITY, NORMAL),
+        None(),
+        action::Redirect(veth));
+
+    if (flowId.isSome()) {
+      // Add IP packet filters to classify traffic sending to eth0
+      // in the same way so that traffic of each container will be
+      // classified to different flows defined by fq_codel.
+      hostEth0EgressFilters.create(
+          ip::Classifier(None(), None(), range, None()),
+          Priority(IP_FILTER_PRIORITY, LOW),
+          Handle(HOST_TX_FQ_CODEL_HANDLE, flowId.get()),
+          action::Terminal());
+    }
+  }
+
+  Try<vector<bool>> vethCreated = filter::ip::apply(vethFilters);
+  if (vethCreated.isError()) {
     ++metrics.adding_veth_ip_filters_errors;
 
     return Error(
-        "Failed to create an IP packet filter from " + veth +
-        " to host " + eth0 + ": " + vethToHostEth0.error());
-  } else if (!vethToHostEth0.get()) {
-    ++metrics.adding_veth_ip_filters_already_exist;
-
-    return Error(
-        "The IP packet filter from " + veth +
-        " to host " + eth0 + " already exists");
+        "Failed to create IP packet filters from " + veth +
+        " to host " + eth0 + " and host " + lo + ": " +
+        vethCreated.error());
   }
 
-  // Add two IP packet filters (one for public IP and one for loopback
-  // IP) from veth of the container to host lo to properly redirect IP
-  // packets sent from one container to either the host or another
-  // container. Notice that here we also check the source port of a
-  // packet. If the source port is not within the port ranges
-  // allocated for the container, the packet will get dropped.
-  Try<bool> vethToHostLoPublic = filter::ip::create(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(None(), hostIPNetwork.address(), range, None()),
-      Priority(IP_FILTER_PRIORITY, NORMAL),
-      action::Redirect(lo));
+  size_t existing = std::count(
+      vethCreated.get().begin(), vethCreated.get().end(), false);
 
-  if (vethToHostLoPublic.isError()) {
-    ++metrics.adding_veth_ip_filters_errors;
+  if (existing > 0) {
+    metrics.adding_veth_ip_filters_already_exist += existing;
 
     return Error(
-        "Failed to create an IP packet filter (for public IP) from " +
-        veth + " to host " + lo + ": " + vethToHostLoPublic.error());
-  } else if (!vethToHostLoPublic.get()) {
-    ++metrics.adding_veth_ip_filters_already_exist;
+        stringify(existing) + " of the IP packet filters from " + veth +
+        " to host " + eth0 + " and host " + lo + " already exist");
+  }
+
+  Try<vector<bool>> hostEth0Created = filter::ip::apply(hostEth0Filters);
+  if (hostEth0Created.isError()) {
+    ++metrics.adding_eth0_ip_filters_errors;
 
     return Error(
-        "The IP packet filter (for public IP) from " +
-        veth + " to host " + lo + " already exists");
+        "Failed to create IP packet filters from host " +
+        eth0 + " to " + veth + ": " + hostEth0Created.error());
   }
 
-  Try<bool> vethToHostLoLoopback = filter::ip::create(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(
-          None(),
-          net::IPNetwork::LOOPBACK_V4().address(),
-          range,
-          None()),
-      Priority(IP_FILTER_PRIORITY, NORMAL),
-      action::Redirect(lo));
+  existing = std::count(
+      hostEth0Created.get().begin(), hostEth0Created.get().end(), false);
 
-  if (vethToHostLoLoopback.isError()) {
-    ++metrics.adding_veth_ip_filters_errors;
+  if (existing > 0) {
+    metrics.adding_eth0_ip_filters_already_exist += existing;
 
     return Error(
-        "Failed to create an IP packet filter (for loopback IP) from " +
-        veth + " to host " + lo + ": " + vethToHostLoLoopback.error());
-  } else if (!vethToHostLoLoopback.get()) {
-    ++metrics.adding_veth_ip_filters_already_exist;
+        stringify(existing) + " of the IP packet filters from host " +
+        eth0 + " to " + veth + " already exist");
+  }
+
+  Try<vector<bool>> hostLoCreated = filter::ip::apply(hostLoFilters);
+  if (hostLoCreated.isError()) {
+    ++metrics.adding_lo_ip_filters_errors;
 
     return Error(
-        "The IP packet filter (for loopback IP) from " +
-        veth + " to host " + lo + " already exists");
+        "Failed to create IP packet filters from host " +
+        lo + " to " + veth + ": " + hostLoCreated.error());
   }
 
-  // Add an IP packet filter from host eth0 to veth of the container
-  // such that any incoming IP packet will be properly redirected to
-  // the corresponding container based on its destination port.
-  Try<bool> hostEth0ToVeth = filter::ip::create(
-      eth0,
-      ingress::HANDLE,
-      ip::Classifier(hostMAC, hostIPNetwork.address(), None(), range),
-      Priority(IP_FILTER_PRIORITY, NORMAL),
-      action::Redirect(veth));
-
-  if (hostEth0ToVeth.isError()) {
-    ++metrics.adding_eth0_ip_filters_errors;
+  existing = std::count(
+      hostLoCreated.get().begin(), hostLoCreated.get().end(), false);
 
-    return Error(
-        "Failed to create an IP packet filter from host " +
-        eth0 + " to " + veth + ": " + hostEth0ToVeth.error());
-  } else if (!hostEth0ToVeth.get()) {
-    ++metrics.adding_eth0_ip_filters_already_exist;
+  if (existing > 0) {
+    metrics.adding_lo_ip_filters_already_exist += existing;
 
     return Error(
-        "The IP packet filter from host " + eth0 + " to " +
-        veth + " already exists");
+        stringify(existing) + " of the IP packet filters from host " +
+        lo + " to " + veth + " already exist");
   }
 
-  // Add an IP packet filter from host lo to veth of the container
-  // such that any internally generated IP packet will be properly
-  // redirected to the corresponding container based on its
-  // destination port.
-  Try<bool> hostLoToVeth = filter::ip::create(
-      lo,
-      ingress::HANDLE,
-      ip::Classifier(None(), None(), None(), range),
-      Priority(IP_FILTER_PRIORITY, NORMAL),
-      action::Redirect(veth));
+  Try<vector<bool>> hostEth0EgressCreated =
+    filter::ip::apply(hostEth0EgressFilters);
 
-  if (hostLoToVeth.isError()) {
-    ++metrics.adding_lo_ip_filters_errors;
+  if (hostEth0EgressCreated.isError()) {
+    ++metrics.adding_eth0_egress_filters_errors;
 
     return Error(
-        "Failed to create an IP packet filter from host " +
-        lo + " to " + veth + ": " + hostLoToVeth.error());
-  } else if (!hostLoToVeth.get()) {
-    ++metrics.adding_lo_ip_filters_already_exist;
-
-    return Error(
-        "The IP packet filter from host " + lo + " to " +
-        veth + " already exists");
+        "Failed to create flow classifiers for " + veth +
+        " on host " + eth0 + ": " + hostEth0EgressCreated.error());
   }
 
-  if (flowId.isSome()) {
-    // Add IP packet filters to classify traffic sending to eth0
-    // in the same way so that traffic of each container will be
-    // classified to different flows defined by fq_codel.
-    Try<bool> hostEth0Egress = filter::ip::create(
-        eth0,
-        HOST_TX_FQ_CODEL_HANDLE,
-        ip::Classifier(None(), None(), range, None()),
-        Priority(IP_FILTER_PRIORITY, LOW),
-        Handle(HOST_TX_FQ_CODEL_HANDLE, flowId.get()));
-
-    if (hostEth0Egress.isError()) {
-      ++metrics.adding_eth0_egress_filters_errors;
+  existing = std::count(
+      hostEth0EgressCreated.get().begin(),
+      hostEth0EgressCreated.get().end(),
+      false);
 
-      return Error(
-          "Failed to create a flow classifier for " + veth +
-          " on host " + eth0 + ": " + hostEth0Egress.error());
-    } else if (!hostEth0Egress.get()) {
-      ++metrics.adding_eth0_egress_filters_already_exist;
+  if (existing > 0) {
+    metrics.adding_eth0_egress_filters_already_exist += existing;
 
-      return Error(
-          "The flow classifier for veth " + veth +
-          " on host " + eth0 + " already exists");
-    }
+    return Error(
+        stringify(existing) + " of the flow classifiers for " + veth +
+        " on host " + eth0 + " already exist");
   }
 
   return Nothing();
 }
 
 
-// Helper function to remove IP filters from the host side for a given
-// port range. The boolean flag 'removeFiltersOnVeth' indicates if we
-// need to remove filters on veth.
+// Helper function to remove IP filters from the host side for the
+// given port ranges. The filters on each link are removed in a single
+// batch. The boolean flag 'removeFiltersOnVeth' indicates if we need
+// to remove filters on veth.
 Try<Nothing> PortMappingIsolatorProcess::removeHostIPFilters(
-    const PortRange& range,
+    const vector<PortRange>& ranges,
     const string& veth,
     bool removeFiltersOnVeth)
 {
   // NOTE: Similar to above. The order in which these filters are
   // removed is important. We need to remove filters on host eth0 and
   // host lo first before we remove filters on veth.
-
-  // Remove the IP packet filter from host eth0 to veth of the container.
-  Try<bool> hostEth0ToVeth = filter::ip::remove(
+  filter::Batch<ip::Classifier> hostEth0Filters(eth0, ingress::HANDLE);
+  filter::Batch<ip::Classifier> hostLoFilters(lo, ingress::HANDLE);
+  filter::Batch<ip::Classifier> hostEth0EgressFilters(
       eth0,
-      ingress::HANDLE,
-      ip::Classifier(hostMAC, hostIPNetwork.address(), None(), range));
+      HOST_TX_FQ_CODEL_HANDLE);
+  filter::Batch<ip::Classifier> vethFilters(veth, ingress::HANDLE);
 
-  if (hostEth0ToVeth.isError()) {
-    ++metrics.removing_eth0_ip_filters_errors;
+  foreach (const PortRange& range, ranges) {
+    // Remove the IP packet filter from host eth0 to veth of the
+    // container.
+    hostEth0Filters.remove(
+        ip::Classifier(hostMAC, hostIPNetwork.address(), None(), range));
 
-    return Error(
-        "Failed to remove the IP packet filter from host " +
-        eth0 + " to " + veth + ": " + hostEth0ToVeth.error());
-  } else if (!hostEth0ToVeth.get()) {
-    ++metrics.removing_eth0_ip_filters_do_not_exist;
+    // Remove the IP packet filter from host lo to veth of the
+    // container.
+    hostLoFilters.remove(ip::Classifier(None(), None(), None(), range));
 
-    LOG(ERROR) << "The IP packet filter from host " << eth0
-               << " to " << veth << " does not exist";
-  }
-
-  // Remove the IP packet filter from host lo to veth of the container.
-  Try<bool> hostLoToVeth = filter::ip::remove(
-      lo,
-      ingress::HANDLE,
-      ip::Classifier(None(), None(), None(), range));
+    // Remove the egress flow classifier on host eth0.
+    if (flags.egress_unique_flow_per_container) {
+      hostEth0EgressFilters.remove(
+          ip::Classifier(None(), None(), range, None()));
+    }
 
-  if (hostLoToVeth.isError()) {
-    ++metrics.removing_lo_ip_filters_errors;
+    // Remove the IP packet filters from veth of the container to host
+    // lo (for the public IP and the loopback IP) and to host eth0.
+    vethFilters.remove(
+        ip::Classifier(None(), hostIPNetwork.address(), range, None()));
 
-    return Error(
-        "Failed to remove the IP packet filter from host " +
-        lo + " to " + veth + ": " + hostLoToVeth.error());
-  } else if (!hostLoToVeth.get()) {
-    ++metrics.removing_lo_ip_filters_do_not_exist;
+    vethFilters.remove(
+        ip::Classifier(
+            None(),
+            net::IPNetwork::LOOPBACK_V4().address(),
+            range,
+            None()));
 
-    LOG(ERROR) << "The IP packet filter from host " << lo
-               << " to " << veth << " does not exist";
+    vethFilters.remove(ip::Classifier(None(), None(), range, None()));
   }
 
-  if (flags.egress_unique_flow_per_container) {
-    // Remove the egress flow classifier on host eth0.
-    Try<bool> hostEth0Egress = filter::ip::remove(
-        eth0,
-        HOST_TX_FQ_CODEL_HANDLE,
-        ip::Classifier(None(), None(), range, None()));
+  Try<vector<bool>> hostEth0Removed = filter::ip::apply(hostEth0Filters);
+  if (hostEth0Removed.isError()) {
+    ++metrics.removing_eth0_ip_filters_errors;
 
-    if (hostEth0Egress.isError()) {
-      ++metrics.removing_eth0_egress_filters_errors;
+    return Error(
+        "Failed to remove the IP packet filters from host " +
+        eth0 + " to " + veth + ": " + hostEth0Removed.error());
+  }
 
-      return Error(
-          "Failed to remove the flow classifier from host " +
-          eth0 + " for " + veth + ": " + hostEth0Egress.error());
-    } else if (!hostEth0Egress.get()) {
-      ++metrics.removing_eth0_egress_filters_do_not_exist;
+  size_t missing = std::count(
+      hostEth0Removed.get().begin(), hostEth0Removed.get().end(), false);
 
-      LOG(ERROR) << "The flow classifier from host " << eth0
-                 << " for " << range << " does not exist";
-    }
-  }
+  if (missing > 0) {
+    metrics.removing_eth0_ip_filters_do_not_exist += missing;
 
-  // Now, we try to remove filters on veth. No need to proceed if the
-  // user does not ask us to do so.
-  if (!removeFiltersOnVeth) {
-    return Nothing();
+    LOG(ERROR) << missing << " of the IP packet filters from host "
+               << eth0 << " to " << veth << " do not exist";
   }
 
-  // Remove the IP packet filter from veth of the container to
-  // host lo for the public IP.
-  Try<bool> vethToHostLoPublic = filter::ip::remove(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(None(), hostIPNetwork.address(), range, None()));
-
-  if (vethToHostLoPublic.isError()) {
+  Try<vector<bool>> hostLoRemoved = filter::ip::apply(hostLoFilters);
+  if (hostLoRemoved.isError()) {
     ++metrics.removing_lo_ip_filters_errors;
 
     return Error(
-        "Failed to remove the IP packet filter (for public IP) from " +
-        veth + " to host " + lo + ": " + vethToHostLoPublic.error());
-  } else if (!vethToHostLoPublic.get()) {
-    ++metrics.removing_lo_ip_filters_do_not_exist;
+        "Failed to remove the IP packet filters from host " +
+        lo + " to " + veth + ": " + hostLoRemoved.error());
+  }
+
+  missing = std::count(
+      hostLoRemoved.get().begin(), hostLoRemoved.get().end(), false);
+
+  if (missing > 0) {
+    metrics.removing_lo_ip_filters_do_not_exist += missing;
 
-    LOG(ERROR) << "The IP packet filter (for public IP) from "
-               << veth << " to host " << lo << " does not exist";
+    LOG(ERROR) << missing << " of the IP packet filters from host "
+               << lo << " to " << veth << " do not exist";
   }
 
-  // Remove the IP packet filter from veth of the container to
-  // host lo for the loopback IP.
-  Try<bool> vethToHostLoLoopback = filter::ip::remove(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(
-          None(),
-          net::IPNetwork::LOOPBACK_V4().address(),
-          range,
-          None()));
+  Try<vector<bool>> hostEth0EgressRemoved =
+    filter::ip::apply(hostEth0EgressFilters);
 
-  if (vethToHostLoLoopback.isError()) {
-    ++metrics.removing_veth_ip_filters_errors;
+  if (hostEth0EgressRemoved.isError()) {
+    ++metrics.removing_eth0_egress_filters_errors;
 
     return Error(
-        "Failed to remove the IP packet filter (for loopback IP) from " +
-        veth + " to host " + lo + ": " + vethToHostLoLoopback.error());
-  } else if (!vethToHostLoLoopback.get()) {
-    ++metrics.removing_veth_ip_filters_do_not_exist;
+        "Failed to remove the flow classifiers from host " +
+        eth0 + " for " + veth + ": " + hostEth0EgressRemoved.error());
+  }
+
+  missing = std::count(
+      hostEth0EgressRemoved.get().begin(),
+      hostEth0EgressRemoved.get().end(),
+      false);
+
+  if (missing > 0) {
+    metrics.removing_eth0_egress_filters_do_not_exist += missing;
 
-    LOG(ERROR) << "The IP packet filter (for loopback IP) from "
-               << veth << " to host " << lo << " does not exist";
+    LOG(ERROR) << missing << " of the flow classifiers from host "
+               << eth0 << " for " << veth << " do not exist";
   }
 
-  // Remove the IP packet filter from veth of the container to
-  // host eth0.
-  Try<bool> vethToHostEth0 = filter::ip::remove(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(None(), None(), range, None()));
+  // Now, we try to remove filters on veth. No need to proceed if the
+  // user does not ask us to do so.
+  if (!removeFiltersOnVeth) {
+    return Nothing();
+  }
 
-  if (vethToHostEth0.isError()) {
+  Try<vector<bool>> vethRemoved = filter::ip::apply(vethFilters);
+  if (vethRemoved.isError()) {
     ++metrics.removing_veth_ip_filters_errors;
 
     return Error(
-        "Failed to remove the IP packet filter from " + veth +
-        " to host " + eth0 + ": " + vethToHostEth0.error());
-  } else if (!vethToHostEth0.get()) {
-    ++metrics.removing_veth_ip_filters_do_not_exist;
+        "Failed to remove the IP packet filters from " + veth +
+        " to host " + eth0 + " and host " + lo + ": " +
+        vethRemoved.error());
+  }
+
+  missing = std::count(
+      vethRemoved.get().begin(), vethRemoved.get().end(), false);
+
+  if (missing > 0) {
+    metrics.removing_veth_ip_filters_do_not_exist += missing;
 
-    LOG(ERROR) << "The IP packet filter from " << veth
-               << " to host " << eth0 << " does not exist";
+    LOG(ERROR) << missing << " of the IP packet filters from " << veth
+               << " to host " << eth0 << " and host " << lo
+               << " do not exist";
   }
 
   return Nothing();
@@ -3677,6 +3702,35 @@ uint16_t PortMappingIsolatorProcess::getNextFlowId()
 }
 
 
+Result<hashmap<string, uint64_t>> PortMappingIsolatorProcess::linkStatistics(
+    const string& veth)
+{
+  // Reuse the last dump if it is recent enough and has the link. A
+  // missing link may have been created after the dump (e.g., a
+  // container that was just isolated), so we dump again in that case.
+  if (links.isSome() &&
+      Clock::now() - linksDumpedAt < LINK_STATISTICS_TTL &&
+      links.get().contains(veth)) {
+    return links.get().at(veth);
+  }
+
+  Try<hashmap<string, hashmap<string, uint64_t>>> dump = link::statistics();
+  if (dump.isError()) {
+    links = None();
+    return Error(dump.error());
+  }
+
+  links = dump.get();
+  linksDumpedAt = Clock::now();
+
+  if (!links.get().contains(veth)) {
+    return None();
+  }
+
+  return links.get().at(veth);
+}
+
+
 ////////////////////////////////////////////////////
 // Implementation for the ephemeral ports allocator.
 ////////////////////////////////////////////////////
@@ -28,6 +28,7 @@
 #include <vector>
 
 #include <process/owned.hpp>
+#include <process/time.hpp>
 #include <process/subprocess.hpp>
 
 #include <process/metrics/metrics.hpp>
@@ -41,6 +42,7 @@
 #include <stout/mac.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
+#include <stout/result.hpp>
 #include <stout/subcommand.hpp>
 
 #include "linux/routing/filter/ip.hpp"
@@ -293,12 +295,12 @@ private:
 
   // Helper functions.
   Try<Nothing> addHostIPFilters(
-      const routing::filter::ip::PortRange& range,
+      const std::vector<routing::filter::ip::PortRange>& ranges,
       const Option<uint16_t>& flowId,
       const std::string& veth);
 
   Try<Nothing> removeHostIPFilters(
-      const routing::filter::ip::PortRange& range,
+      const std::vector<routing::filter::ip::PortRange>& ranges,
       const std::string& veth,
       bool removeFiltersOnVeth = true);
 
@@ -307,6 +309,13 @@ private:
 
   uint16_t getNextFlowId();
 
+  // Returns the statistics of the host end of the veth pair of the
+  // given container. The statistics of all links are dumped from the
+  // kernel at once and shared by the 'usage()' calls of all
+  // containers that happen shortly after each other.
+  Result<hashmap<std::string, uint64_t>> linkStatistics(
+      const std::string& veth);
+
   const Flags flags;
 
   const std::string eth0;
@@ -338,6 +347,11 @@ private:
   // Recovered containers from a previous run that weren't managed by
   // the network isolator.
   hashset<ContainerID> unmanaged;
+
+  // The most recent dump of the statistics of all links, keyed by
+  // link name, along with the time it was taken.
+  Option<hashmap<std::string, hashmap<std::string, uint64_t>>> links;
+  process::Time linksDumpedAt;
 };
 
 
@@ -22,6 +22,7 @@
 #include <process/future.hpp>
 
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/os.hpp>
 
 #include <stout/os/pstree.hpp>
@@ -132,6 +133,46 @@ public:
   }
 
 protected:
+  // Gathers the usage of the given containers from a single snapshot
+  // of the process table rather than reading the process table for
+  // each container. Only collects the 'mem_*' values if 'mem' is true
+  // and the 'cpus_*' values if 'cpus' is true.
+  process::Future<hashmap<ContainerID, ResourceStatistics>> _batchUsage(
+      const hashset<ContainerID>& containerIds,
+      bool mem,
+      bool cpus)
+  {
+    Try<std::list<os::Process>> processes = os::processes();
+    if (processes.isError()) {
+      return process::Failure(
+          "Failed to get the process table: " + processes.error());
+    }
+
+    hashmap<ContainerID, ResourceStatistics> result;
+
+    foreach (const ContainerID& containerId, containerIds) {
+      if (!pids.contains(containerId)) {
+        LOG(WARNING) << "No resource usage for unknown container '"
+                     << containerId << "'";
+        result.put(containerId, ResourceStatistics());
+        continue;
+      }
+
+      Try<ResourceStatistics> usage = mesos::internal::usage(
+          pids.get(containerId).get(), processes.get(), mem, cpus);
+
+      if (usage.isError()) {
+        LOG(WARNING) << "Failed to get resource usage for container '"
+                     << containerId << "': " << usage.error();
+        continue;
+      }
+
+      result.put(containerId, usage.get());
+    }
+
+    return result;
+  }
+
   hashmap<ContainerID, pid_t> pids;
   hashmap<ContainerID,
           process::Owned<process::Promise<mesos::slave::ContainerLimitation>>>
@@ -168,6 +209,12 @@ public:
     return usage.get();
   }
 
+  virtual process::Future<hashmap<ContainerID, ResourceStatistics>>
+    batchUsage(const hashset<ContainerID>& containerIds)
+  {
+    return _batchUsage(containerIds, false, true);
+  }
+
 private:
   PosixCpuIsolatorProcess() {}
 };
@@ -202,6 +249,12 @@ public:
     return usage.get();
   }
 
+  virtual process::Future<hashmap<ContainerID, ResourceStatistics>>
+    batchUsage(const hashset<ContainerID>& containerIds)
+  {
+    return _batchUsage(containerIds, true, false);
+  }
+
 private:
   PosixMemIsolatorProcess() {}
 };
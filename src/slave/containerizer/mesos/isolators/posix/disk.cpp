@@ -16,33 +16,43 @@
  * limitations under the License.
  */
 
-#include <signal.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #ifdef __linux__
-#include <sys/prctl.h>
+#include <sys/syscall.h>
 #endif
+#include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <atomic>
 #include <deque>
-#include <tuple>
+#include <list>
+#include <memory>
+#include <set>
+#include <thread>
+#include <utility>
 
 #include <glog/logging.h>
 
 #include <process/check.hpp>
-#include <process/collect.hpp>
+#include <process/clock.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
-#include <process/io.hpp>
-#include <process/subprocess.hpp>
+#include <process/dispatch.hpp>
 
 #include <stout/check.hpp>
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
-#include <stout/numify.hpp>
-#include <stout/strings.hpp>
+#include <stout/path.hpp>
 
 #include <stout/os/exists.hpp>
-#include <stout/os/killtree.hpp>
 
 #include "common/protobuf_utils.hpp"
 
@@ -52,6 +62,8 @@ using namespace process;
 
 using std::deque;
 using std::list;
+using std::pair;
+using std::set;
 using std::string;
 using std::vector;
 
@@ -66,8 +78,6 @@ namespace slave {
 
 Try<Isolator*> PosixDiskIsolatorProcess::create(const Flags& flags)
 {
-  // TODO(jieyu): Check the availability of command 'du'.
-
   return new MesosIsolator(process::Owned<MesosIsolatorProcess>(
         new PosixDiskIsolatorProcess(flags)));
 }
@@ -80,7 +90,10 @@ PosixDiskIsolatorProcess::Info::PathInfo::~PathInfo()
 
 
 PosixDiskIsolatorProcess::PosixDiskIsolatorProcess(const Flags& _flags)
-  : flags(_flags), collector(flags.container_disk_watch_interval) {}
+  : flags(_flags),
+    collector(
+        flags.container_disk_watch_interval,
+        flags.container_disk_watch_concurrency) {}
 
 
 PosixDiskIsolatorProcess::~PosixDiskIsolatorProcess() {}
@@ -310,10 +323,250 @@ Future<Nothing> PosixDiskIsolatorProcess::cleanup(
 }
 
 
+// The listing of a directory, which is reused by subsequent walks
+// as long as the modification time of the directory is unchanged,
+// i.e., no entry has been added, removed or renamed since.
+struct Listing
+{
+  struct timespec mtime;
+  vector<string> names;
+};
+
+
+// Directory listings of a walked path, keyed by directory path.
+typedef hashmap<string, Listing> Listings;
+
+
+// Maximum number of names cached for a walked path. The listings of
+// the directories walked once the limit is reached are not cached,
+// thus those directories are read again by the next walk.
+static const size_t MAX_CACHED_NAMES = 64 * 1024;
+
+
+// The cached listings of a path are dropped if the path has not been
+// requested again for this long after its last walk completed, e.g.,
+// because its container has been destroyed.
+static const Duration LISTINGS_IDLE_TIMEOUT = Minutes(1);
+
+
+static struct timespec mtime(const struct stat& s)
+{
+#ifdef __APPLE__
+  return s.st_mtimespec;
+#else
+  return s.st_mtim;
+#endif
+}
+
+
+// Adds up the blocks allocated to the entries of the given directory
+// and pushes its subdirectories onto 'directories'. The listing is
+// taken from 'listings' when the directory is unchanged, otherwise it
+// is read with readdir(3) (i.e., getdents(2) on Linux). Every entry is
+// stat'ed regardless since files may grow without the modification
+// time of their directory changing. The listing is added to 'seen' as
+// long as 'budget' names can still be cached.
+static Try<uint64_t> scan(
+    const string& directory,
+    DIR* dir,
+    time_t start,
+    Listings* listings,
+    Listings* seen,
+    size_t* budget,
+    set<pair<dev_t, ino_t>>* links,
+    vector<string>* directories,
+    std::atomic<uint64_t>* reads)
+{
+  struct stat s;
+  if (::fstat(::dirfd(dir), &s) < 0) {
+    return ErrnoError("Failed to stat '" + directory + "'");
+  }
+
+  Listing listing;
+  listing.mtime = mtime(s);
+
+  if (listings->contains(directory) &&
+      listings->at(directory).mtime.tv_sec == listing.mtime.tv_sec &&
+      listings->at(directory).mtime.tv_nsec == listing.mtime.tv_nsec) {
+    listing.names = std::move(listings->at(directory).names);
+  } else {
+    ++(*reads);
+
+    while (true) {
+      errno = 0;
+      struct dirent* entry = ::readdir(dir);
+
+      if (entry == NULL) {
+        if (errno != 0) {
+          return ErrnoError("Failed to read '" + directory + "'");
+        }
+        break;
+      }
+
+      if (strcmp(entry->d_name, ".") == 0 ||
+          strcmp(entry->d_name, "..") == 0) {
+        continue;
+      }
+
+      listing.names.push_back(entry->d_name);
+    }
+  }
+
+  uint64_t blocks = 0;
+
+  foreach (const string& name, listing.names) {
+    if (::fstatat(::dirfd(dir), name.c_str(), &s, AT_SYMLINK_NOFOLLOW) < 0) {
+      // The entry may have been removed since it was listed.
+      if (errno == ENOENT) {
+        continue;
+      }
+
+      return ErrnoError(
+          "Failed to stat '" + path::join(directory, name) + "'");
+    }
+
+    if (S_ISDIR(s.st_mode)) {
+      directories->push_back(path::join(directory, name));
+    } else if (s.st_nlink > 1 &&
+               !links->insert(std::make_pair(s.st_dev, s.st_ino)).second) {
+      // Like 'du', count hard linked files only once.
+      continue;
+    }
+
+    blocks += s.st_blocks;
+  }
+
+  // A directory modified within the current second of the walk could
+  // be modified again without its modification time changing on file
+  // systems with a coarse timestamp granularity, so it is not cached.
+  if (listing.mtime.tv_sec < start && listing.names.size() <= *budget) {
+    *budget -= listing.names.size();
+    (*seen)[directory] = std::move(listing);
+  }
+
+  return blocks;
+}
+
+
+// Returns the disk usage rooted at 'root' the same way 'du -s' does:
+// the blocks allocated to all files and directories are summed up,
+// symbolic links are not followed and hard links are counted once.
+// The cached 'listings' are replaced by the listings of this walk.
+static Try<Bytes> walk(
+    const string& root,
+    Listings* listings,
+    const std::atomic_bool& cancelled,
+    std::atomic<uint64_t>* reads)
+{
+  const time_t start = ::time(NULL);
+
+  struct stat s;
+  if (::lstat(root.c_str(), &s) < 0) {
+    return ErrnoError("Failed to stat '" + root + "'");
+  }
+
+  // NOTE: 'st_blocks' is in 512 byte units on all platforms.
+  uint64_t blocks = s.st_blocks;
+
+  if (!S_ISDIR(s.st_mode)) {
+    return Bytes(blocks * 512);
+  }
+
+  // Take the cached listings so that they are dropped if the walk
+  // fails half way, as some of them may have been consumed.
+  Listings cached = std::move(*listings);
+  listings->clear();
+
+  Listings seen;
+  size_t budget = MAX_CACHED_NAMES;
+  set<pair<dev_t, ino_t>> links;
+  vector<string> directories = {root};
+
+  while (!directories.empty()) {
+    if (cancelled.load()) {
+      return Error("Collection was cancelled");
+    }
+
+    const string directory = directories.back();
+    directories.pop_back();
+
+    int fd = ::open(
+        directory.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+    if (fd < 0) {
+      // The directory may have been removed since it was listed.
+      if (errno == ENOENT) {
+        continue;
+      }
+
+      return ErrnoError("Failed to open '" + directory + "'");
+    }
+
+    DIR* dir = ::fdopendir(fd);
+    if (dir == NULL) {
+      Error error = ErrnoError("Failed to open '" + directory + "'");
+      ::close(fd);
+      return error;
+    }
+
+    Try<uint64_t> scanned =
+      scan(directory,
+           dir,
+           start,
+           &cached,
+           &seen,
+           &budget,
+           &links,
+           &directories,
+           reads);
+
+    ::closedir(dir);
+
+    if (scanned.isError()) {
+      return Error(scanned.error());
+    }
+
+    blocks += scanned.get();
+  }
+
+  *listings = std::move(seen);
+
+  return Bytes(blocks * 512);
+}
+
+
+#ifdef __linux__
+// Lowers the I/O priority of the calling thread to the idle class so
+// that walking large sandboxes does not compete with the containers'
+// own I/O. The constants are from <linux/ioprio.h>, which is not
+// exported to userspace.
+static void setIdleIOPriority()
+{
+  const int IOPRIO_WHO_PROCESS = 1;
+  const int IOPRIO_CLASS_IDLE = 3;
+  const int IOPRIO_CLASS_SHIFT = 13;
+
+  // NOTE: A 'who' of 0 refers to the calling thread.
+  if (::syscall(
+          SYS_ioprio_set,
+          IOPRIO_WHO_PROCESS,
+          0,
+          IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) < 0) {
+    PLOG(WARNING) << "Failed to set the I/O priority for disk usage collection";
+  }
+}
+#endif // __linux__
+
+
 class DiskUsageCollectorProcess : public Process<DiskUsageCollectorProcess>
 {
 public:
-  DiskUsageCollectorProcess(const Duration& _interval) : interval(_interval) {}
+  DiskUsageCollectorProcess(const Duration& _interval, size_t _concurrency)
+    : interval(_interval),
+      concurrency(_concurrency),
+      cancelled(new std::atomic_bool(false)),
+      reads_(new std::atomic<uint64_t>(0)) {}
+
   virtual ~DiskUsageCollectorProcess() {}
 
   Future<Bytes> usage(const string& path)
@@ -324,8 +577,17 @@ public:
       }
     }
 
+    foreach (const Owned<Entry>& entry, walking) {
+      if (entry->path == path) {
+        return entry->promise.future();
+      }
+    }
+
     entries.push_back(Owned<Entry>(new Entry(path)));
 
+    // Keep the cached listings of the path for its upcoming walk.
+    idle.erase(path);
+
     // Install onDiscard callback.
     Future<Bytes> future = entries.back()->promise.future();
     future.onDiscard(defer(self(), &Self::discard, path));
@@ -333,21 +595,35 @@ public:
     return future;
   }
 
+  uint64_t reads()
+  {
+    return reads_->load();
+  }
+
 protected:
   void initialize()
   {
-    schedule();
+    // Each of the 'concurrency' schedules walks one path at a time.
+    for (size_t i = 0; i < std::max(concurrency, (size_t) 1); i++) {
+      schedule();
+    }
   }
 
   void finalize()
   {
+    // Stop the walks in flight; their results are dropped.
+    cancelled->store(true);
+
     foreach (const Owned<Entry>& entry, entries) {
-      if (entry->du.isSome() && entry->du.get().status().isPending()) {
-        os::killtree(entry->du.get().pid(), SIGKILL);
-      }
+      entry->promise.fail("DiskUsageCollector is destroyed");
+    }
 
+    foreach (const Owned<Entry>& entry, walking) {
       entry->promise.fail("DiskUsageCollector is destroyed");
     }
+
+    listings.clear();
+    idle.clear();
   }
 
 private:
@@ -357,152 +633,141 @@ private:
     explicit Entry(const string& _path) : path(_path) {}
 
     string path;
-    Option<Subprocess> du;
     Promise<Bytes> promise;
   };
 
-  // This function is invoked right before each 'du' is exec'ed. Note
-  // that this function needs to be async signal safe.
-  static int setupChild()
-  {
-#ifdef __linux__
-    // Kill the child process if the parent exits.
-    // NOTE: This function should never returns non-zero because we
-    // are passing in a valid signal.
-    return ::prctl(PR_SET_PDEATHSIG, SIGKILL);
-#else
-    return 0;
-#endif
-  }
-
   void discard(const string& path)
   {
+    // We only cancel those checks which are not being walked yet.
     for (auto it = entries.begin(); it != entries.end(); ++it) {
-      // We only cancel those checks whose 'du' haven't been launched.
-      if ((*it)->path == path && (*it)->du.isNone()) {
+      if ((*it)->path == path) {
         (*it)->promise.discard();
         entries.erase(it);
         break;
       }
     }
+
+    // The path is no longer watched by the caller. A walk in flight
+    // keeps updating its own copy of the listings, which is dropped
+    // once the walk completes.
+    listings.erase(path);
+    idle.erase(path);
+  }
+
+  // Drops the cached listings of the paths which have not been
+  // requested again since their last walk completed a while ago.
+  void expire()
+  {
+    foreach (const string& path, idle.keys()) {
+      if (Clock::now() - idle[path] >= LISTINGS_IDLE_TIMEOUT) {
+        listings.erase(path);
+        idle.erase(path);
+      }
+    }
   }
 
-  // Schedule a 'du' to be invoked. The current implementation does
-  // not allow multiple 'du's running concurrently. The minimal
-  // interval between two subsequent 'du's is controlled by 'interval'
-  // for throttling purpose.
+  // Schedule a walk of the least recently requested path. Up to
+  // 'concurrency' walks are run at a time, and the minimal interval
+  // between two subsequent walks of the same schedule is controlled
+  // by 'interval' for throttling purpose.
+  //
+  // NOTE: The walks run on threads of the slave and it will be the
+  // slave's cgroup that is charged for (a) memory to cache the fs
+  // data structures, (b) disk I/O to read those structures, and (c)
+  // the cpu time to traverse.
   void schedule()
   {
+    expire();
+
     if (entries.empty()) {
       delay(interval, self(), &Self::schedule);
       return;
     }
 
-    const Owned<Entry>& entry = entries.front();
-
-    // Invoke 'du' and report number of 1K-byte blocks. We fix the
-    // block size here so that we can get consistent results on all
-    // platforms (e.g., OS X uses 512 byte blocks).
-    //
-    // NOTE: The 'du' processes are run in the slave's cgroup and it
-    // will be that cgroup that is charged for (a) memory to cache the
-    // fs data structures, (b) disk I/O to read those structures, and
-    // (c) the cpu time to traverse.
-    Try<Subprocess> s = subprocess(
-        "du",
-        vector<string>({"du", "-k", "-s", entry->path}),
-        Subprocess::PATH("/dev/null"),
-        Subprocess::PIPE(),
-        Subprocess::PIPE(),
-        None(),
-        None(),
-        setupChild);
-
-    if (s.isError()) {
-      entry->promise.fail("Failed to exec 'du': " + s.error());
-
-      entries.pop_front();
-      delay(interval, self(), &Self::schedule);
-      return;
+    const Owned<Entry> entry = entries.front();
+    entries.pop_front();
+    walking.push_back(entry);
+
+    if (!listings.contains(entry->path)) {
+      listings[entry->path] = std::make_shared<Listings>();
     }
 
-    entry->du = s.get();
+    const string path = entry->path;
+    const std::shared_ptr<Listings> cache = listings[entry->path];
+    const std::shared_ptr<std::atomic_bool> cancelled = this->cancelled;
+    const std::shared_ptr<std::atomic<uint64_t>> reads = reads_;
+    const PID<DiskUsageCollectorProcess> pid = self();
+
+    // The walk blocks on disk I/O, hence it runs on its own thread
+    // rather than on one of the libprocess worker threads.
+    std::thread([=]() {
+#ifdef __linux__
+      setIdleIOPriority();
+#endif
+      Try<Bytes> usage = walk(path, cache.get(), *cancelled, reads.get());
 
-    await(s.get().status(),
-          io::read(s.get().out().get()),
-          io::read(s.get().err().get()))
-      .onAny(defer(self(), &Self::_schedule, lambda::_1));
+      dispatch(pid, &DiskUsageCollectorProcess::_schedule, path, usage);
+    }).detach();
   }
 
-  void _schedule(const Future<std::tuple<
-      Future<Option<int>>,
-      Future<string>,
-      Future<string>>>& future)
+  void _schedule(const string& path, const Try<Bytes>& usage)
   {
-    CHECK_READY(future);
-    CHECK(!entries.empty());
-
-    const Owned<Entry>& entry = entries.front();
-    CHECK_SOME(entry->du);
-
-    Future<Option<int>> status = std::get<0>(future.get());
-
-    if (!status.isReady()) {
-      entry->promise.fail(
-          "Failed to perform 'du': " +
-          (status.isFailed() ? status.failure() : "discarded"));
-    } else if (status.get().isNone()) {
-      entry->promise.fail("Failed to reap the status of 'du'");
-    } else if (status.get().get() != 0) {
-      Future<string> error = std::get<2>(future.get());
-      if (!error.isReady()) {
-        entry->promise.fail(
-            "Failed to perform 'du'. Reading stderr failed: " +
-            (error.isFailed() ? error.failure() : "discarded"));
-      } else {
-        entry->promise.fail("Failed to perform 'du': " + error.get());
-      }
-    } else {
-      Future<string> output = std::get<1>(future.get());
-      if (!output.isReady()) {
-        entry->promise.fail(
-            "Failed to read stdout from 'du': " +
-            (output.isFailed() ? output.failure() : "discarded"));
-      } else {
-        // Parsing the output from 'du'. The following is a sample
-        // output. Tab is used as the delimiter between the number of
-        // blocks and the checked path.
-        // $ du /var/lib/mesos/.../runs/container_id
-        // 1024   /var/lib/mesos/.../runs/container_id
-        vector<string> tokens = strings::tokenize(output.get(), " \t");
-        if (tokens.empty()) {
-          entry->promise.fail("Unexpected output from 'du': " + output.get());
+    for (auto it = walking.begin(); it != walking.end(); ++it) {
+      if ((*it)->path == path) {
+        if (usage.isError()) {
+          (*it)->promise.fail(
+              "Failed to collect disk usage: " + usage.error());
         } else {
-          Try<size_t> value = numify<size_t>(tokens[0]);
-          if (value.isError()) {
-            entry->promise.fail("Unexpected output from 'du': " + output.get());
-          } else {
-            // Notify the callers.
-            entry->promise.set(Kilobytes(value.get()));
-          }
+          (*it)->promise.set(usage.get());
         }
+
+        walking.erase(it);
+        break;
       }
     }
 
-    entries.pop_front();
+    // Keep the listings for the next walk of the path unless the walk
+    // failed, in which case they may be incomplete.
+    if (usage.isError()) {
+      listings.erase(path);
+    } else if (listings.contains(path)) {
+      idle[path] = Clock::now();
+    }
+
     delay(interval, self(), &Self::schedule);
   }
 
   const Duration interval;
+  const size_t concurrency;
+
+  // Set when the collector is destroyed to stop the walks in flight.
+  const std::shared_ptr<std::atomic_bool> cancelled;
+
+  // The number of directories read by the walks (rather than taken
+  // from the cached listings).
+  const std::shared_ptr<std::atomic<uint64_t>> reads_;
 
   // A queue of pending checks.
   deque<Owned<Entry>> entries;
+
+  // The checks whose paths are being walked.
+  list<Owned<Entry>> walking;
+
+  // Cached directory listings of each path, shared with its walk.
+  hashmap<string, std::shared_ptr<Listings>> listings;
+
+  // The times at which the last walks of the paths with cached
+  // listings completed, for the paths which are not requested again
+  // yet. See 'expire()'.
+  hashmap<string, Time> idle;
 };
 
 
-DiskUsageCollector::DiskUsageCollector(const Duration& interval)
+DiskUsageCollector::DiskUsageCollector(
+    const Duration& interval,
+    size_t concurrency)
 {
-  process = new DiskUsageCollectorProcess(interval);
+  process = new DiskUsageCollectorProcess(interval, concurrency);
   spawn(process);
 }
 
@@ -520,6 +785,12 @@ Future<Bytes> DiskUsageCollector::usage(const string& path)
   return dispatch(process, &DiskUsageCollectorProcess::usage, path);
 }
 
+
+Future<uint64_t> DiskUsageCollector::reads()
+{
+  return dispatch(process, &DiskUsageCollectorProcess::reads);
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
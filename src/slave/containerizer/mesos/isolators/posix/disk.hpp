@@ -19,6 +19,8 @@
 #ifndef __POSIX_DISK_ISOLATOR_HPP__
 #define __POSIX_DISK_ISOLATOR_HPP__
 
+#include <stdint.h>
+
 #include <string>
 
 #include <process/owned.hpp>
@@ -41,17 +43,26 @@ class DiskUsageCollectorProcess;
 
 
 // Responsible for collecting disk usage for paths, while ensuring
-// that an interval elapses between each collection.
+// that an interval elapses between each collection. The usage is
+// collected by walking the directory tree in-process, with up to
+// 'concurrency' paths walked in parallel on dedicated threads.
+// NOTE: There is no inotify or project quota based backend: both need
+// file system specific setup (e.g., 'prjquota' mounts and project id
+// assignment) which this isolator cannot assume.
 class DiskUsageCollector
 {
 public:
-  DiskUsageCollector(const Duration& interval);
+  DiskUsageCollector(const Duration& interval, size_t concurrency = 1);
   ~DiskUsageCollector();
 
   // Returns the disk usage rooted at 'path'. The user can discard the
   // returned future to cancel the check.
   process::Future<Bytes> usage(const std::string& path);
 
+  // Returns the number of directories that were read so far, i.e.,
+  // whose cached listing could not be reused. Exposed for testing.
+  process::Future<uint64_t> reads();
+
 private:
   DiskUsageCollectorProcess* process;
 };
@@ -60,8 +71,8 @@ private:
 // This isolator monitors the disk usage for containers, and reports
 // ContainerLimitation when a container exceeds its disk quota. This
 // leverages the DiskUsageCollector to ensure that we don't induce too
-// much CPU usage and disk caching effects from running 'du' too
-// often.
+// much CPU usage and disk caching effects from walking the sandboxes
+// too often.
 //
 // NOTE: Currently all containers are processed in the same queue,
 // which means that when a container starts, it could take many disk
@@ -24,6 +24,8 @@
 
 #include "slave/containerizer/mesos/provisioner/backends/bind.hpp"
 #include "slave/containerizer/mesos/provisioner/backends/copy.hpp"
+#include "slave/containerizer/mesos/provisioner/backends/hardlink.hpp"
+#include "slave/containerizer/mesos/provisioner/backends/overlay.hpp"
 
 using namespace process;
 
@@ -39,8 +41,10 @@ hashmap<string, Owned<Backend>> Backend::create(const Flags& flags)
 
 #ifdef __linux__
   creators.put("bind", &BindBackend::create);
+  creators.put("overlay", &OverlayBackend::create);
 #endif // __linux__
   creators.put("copy", &CopyBackend::create);
+  creators.put("hardlink", &HardlinkBackend::create);
 
   hashmap<string, Owned<Backend>> backends;
 
@@ -0,0 +1,306 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <list>
+
+#include <process/async.hpp>
+#include <process/dispatch.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+
+#include "slave/containerizer/mesos/provisioner/backends/hardlink.hpp"
+
+using namespace process;
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+class HardlinkBackendProcess : public Process<HardlinkBackendProcess>
+{
+public:
+  Future<Nothing> provision(const vector<string>& layers, const string& rootfs);
+
+  Future<bool> destroy(const string& rootfs);
+};
+
+
+// Copies the non-directory 'source' (with status 's') to 'target',
+// for when it cannot be hard linked.
+static Try<Nothing> copy(
+    const string& source,
+    const string& target,
+    const struct stat& s)
+{
+  if (S_ISLNK(s.st_mode)) {
+    char buffer[PATH_MAX];
+    ssize_t length = ::readlink(source.c_str(), buffer, sizeof(buffer) - 1);
+    if (length < 0) {
+      return ErrnoError("Failed to read link '" + source + "'");
+    }
+
+    buffer[length] = '\0';
+
+    if (::symlink(buffer, target.c_str()) < 0) {
+      return ErrnoError("Failed to create link '" + target + "'");
+    }
+  } else if (S_ISREG(s.st_mode)) {
+    Try<int> from = os::open(source, O_RDONLY | O_CLOEXEC);
+    if (from.isError()) {
+      return Error("Failed to open '" + source + "': " + from.error());
+    }
+
+    Try<int> to = os::open(
+        target,
+        O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+        s.st_mode & 07777);
+
+    if (to.isError()) {
+      os::close(from.get());
+      return Error("Failed to create '" + target + "': " + to.error());
+    }
+
+    Option<Error> error;
+
+    char buffer[64 * 1024];
+    ssize_t length;
+    while ((length = ::read(from.get(), buffer, sizeof(buffer))) > 0) {
+      Try<Nothing> write =
+        os::write(to.get(), string(buffer, static_cast<size_t>(length)));
+
+      if (write.isError()) {
+        error = Error("Failed to write '" + target + "': " + write.error());
+        break;
+      }
+    }
+
+    if (length < 0) {
+      error = ErrnoError("Failed to read '" + source + "'");
+    }
+
+    os::close(from.get());
+    os::close(to.get());
+
+    if (error.isSome()) {
+      return error.get();
+    }
+  } else if (::mknod(target.c_str(), s.st_mode, s.st_rdev) < 0) {
+    return ErrnoError("Failed to create '" + target + "'");
+  }
+
+  // As with 'cp -a', failing to preserve the ownership is not an
+  // error for a non-root user.
+  if (::lchown(target.c_str(), s.st_uid, s.st_gid) < 0 && errno != EPERM) {
+    return ErrnoError("Failed to change ownership of '" + target + "'");
+  }
+
+  return Nothing();
+}
+
+
+// Replicates the tree of the layer at 'source' into the existing
+// directory 'target', replacing anything an earlier layer put at the
+// same path. Directories are created, everything else is linked.
+static Try<Nothing> link(const string& source, const string& target)
+{
+  Try<list<string>> entries = os::ls(source);
+  if (entries.isError()) {
+    return Error("Failed to list '" + source + "': " + entries.error());
+  }
+
+  foreach (const string& entry, entries.get()) {
+    const string from = path::join(source, entry);
+    const string to = path::join(target, entry);
+
+    struct stat s;
+    if (::lstat(from.c_str(), &s) < 0) {
+      return ErrnoError("Failed to stat '" + from + "'");
+    }
+
+    struct stat t;
+    bool exists = ::lstat(to.c_str(), &t) == 0;
+
+    if (exists && (!S_ISDIR(s.st_mode) || !S_ISDIR(t.st_mode))) {
+      Try<Nothing> rm = S_ISDIR(t.st_mode) ? os::rmdir(to) : os::rm(to);
+      if (rm.isError()) {
+        return Error("Failed to remove '" + to + "': " + rm.error());
+      }
+
+      exists = false;
+    }
+
+    if (S_ISDIR(s.st_mode)) {
+      // Start out with a directory we can populate and only apply
+      // the permissions of the layer once it has been populated.
+      if (!exists && ::mkdir(to.c_str(), S_IRWXU) < 0) {
+        return ErrnoError("Failed to create directory '" + to + "'");
+      }
+
+      Try<Nothing> linked = link(from, to);
+      if (linked.isError()) {
+        return linked;
+      }
+
+      if (::lchown(to.c_str(), s.st_uid, s.st_gid) < 0 && errno != EPERM) {
+        return ErrnoError("Failed to change ownership of '" + to + "'");
+      }
+
+      if (::chmod(to.c_str(), s.st_mode & 07777) < 0) {
+        return ErrnoError("Failed to change permissions of '" + to + "'");
+      }
+
+      continue;
+    }
+
+    // NOTE: Unlike 'link', 'linkat' without AT_SYMLINK_FOLLOW is
+    // guaranteed not to dereference a symbolic link.
+    if (::linkat(AT_FDCWD, from.c_str(), AT_FDCWD, to.c_str(), 0) < 0) {
+      if (errno != EXDEV && errno != EMLINK) {
+        return ErrnoError("Failed to link '" + from + "' to '" + to + "'");
+      }
+
+      Try<Nothing> copied = copy(from, to, s);
+      if (copied.isError()) {
+        return copied;
+      }
+    }
+  }
+
+  return Nothing();
+}
+
+
+static Try<Nothing> provision(const vector<string>& layers, const string& rootfs)
+{
+  Try<Nothing> mkdir = os::mkdir(rootfs);
+  if (mkdir.isError()) {
+    return Error("Failed to create rootfs directory: " + mkdir.error());
+  }
+
+  foreach (const string& layer, layers) {
+    VLOG(1) << "Linking layer path '" << layer << "' into rootfs '"
+            << rootfs << "'";
+
+    Try<Nothing> linked = link(layer, rootfs);
+    if (linked.isError()) {
+      return Error(
+          "Failed to link layer '" + layer + "': " + linked.error());
+    }
+  }
+
+  return Nothing();
+}
+
+
+Try<Owned<Backend>> HardlinkBackend::create(const Flags&)
+{
+  return Owned<Backend>(new HardlinkBackend(
+      Owned<HardlinkBackendProcess>(new HardlinkBackendProcess())));
+}
+
+
+HardlinkBackend::~HardlinkBackend()
+{
+  terminate(process.get());
+  wait(process.get());
+}
+
+
+HardlinkBackend::HardlinkBackend(Owned<HardlinkBackendProcess> _process)
+  : process(_process)
+{
+  spawn(CHECK_NOTNULL(process.get()));
+}
+
+
+Future<Nothing> HardlinkBackend::provision(
+    const vector<string>& layers,
+    const string& rootfs)
+{
+  return dispatch(
+      process.get(), &HardlinkBackendProcess::provision, layers, rootfs);
+}
+
+
+Future<bool> HardlinkBackend::destroy(const string& rootfs)
+{
+  return dispatch(process.get(), &HardlinkBackendProcess::destroy, rootfs);
+}
+
+
+Future<Nothing> HardlinkBackendProcess::provision(
+    const vector<string>& layers,
+    const string& rootfs)
+{
+  if (layers.size() == 0) {
+    return Failure("No filesystem layers provided");
+  }
+
+  if (os::exists(rootfs)) {
+    return Failure("Rootfs is already provisioned");
+  }
+
+  // Walk the layers on a separate thread as it may take a while for
+  // large images.
+  return async(&slave::provision, layers, rootfs)
+    .then([](const Try<Nothing>& provision) -> Future<Nothing> {
+      if (provision.isError()) {
+        return Failure(provision.error());
+      }
+
+      return Nothing();
+    });
+}
+
+
+Future<bool> HardlinkBackendProcess::destroy(const string& rootfs)
+{
+  if (!os::exists(rootfs)) {
+    return false;
+  }
+
+  // Removing the links leaves the layers in the store untouched.
+  return async([rootfs]() { return os::rmdir(rootfs); })
+    .then([rootfs](const Try<Nothing>& rmdir) -> Future<bool> {
+      if (rmdir.isError()) {
+        return Failure(
+            "Failed to destroy rootfs '" + rootfs + "': " + rmdir.error());
+      }
+
+      return true;
+    });
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,72 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PROVISIONER_BACKENDS_HARDLINK_HPP__
+#define __PROVISIONER_BACKENDS_HARDLINK_HPP__
+
+#include "slave/containerizer/mesos/provisioner/backend.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Forward declaration.
+class HardlinkBackendProcess;
+
+
+// A userspace alternative to the overlay backend for hosts without
+// overlayfs: the rootfs is a tree of directories in which every other
+// file is a hard link to the file of the topmost layer providing it.
+// Provisioning costs a directory walk but no data is copied and the
+// layers in the store are shared by all the containers using them.
+// NOTE:
+// 1) The files are shared with the store (and all other containers
+//    using the same layers). A container replacing or removing a file
+//    only affects its own rootfs, but a container modifying a file in
+//    place modifies it for everyone! Only use this backend for images
+//    whose files are not modified in place.
+// 2) Layers on a different filesystem than the rootfs cannot be hard
+//    linked and are copied instead.
+class HardlinkBackend : public Backend
+{
+public:
+  virtual ~HardlinkBackend();
+
+  // HardlinkBackend doesn't use any flag.
+  static Try<process::Owned<Backend>> create(const Flags&);
+
+  virtual process::Future<Nothing> provision(
+      const std::vector<std::string>& layers,
+      const std::string& rootfs);
+
+  virtual process::Future<bool> destroy(const std::string& rootfs);
+
+private:
+  explicit HardlinkBackend(process::Owned<HardlinkBackendProcess> process);
+
+  HardlinkBackend(const HardlinkBackend&); // Not copyable.
+  HardlinkBackend& operator=(const HardlinkBackend&); // Not assignable.
+
+  process::Owned<HardlinkBackendProcess> process;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __PROVISIONER_BACKENDS_HARDLINK_HPP__
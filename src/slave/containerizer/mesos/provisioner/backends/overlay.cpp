@@ -0,0 +1,264 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <process/dispatch.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
+
+#include "linux/fs.hpp"
+
+#include "slave/containerizer/mesos/provisioner/backends/overlay.hpp"
+
+using namespace process;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// The overlayfs mount options are passed in a single page.
+static const size_t MAX_OVERLAY_OPTIONS_SIZE = 4096;
+
+
+class OverlayBackendProcess : public Process<OverlayBackendProcess>
+{
+public:
+  Future<Nothing> provision(const vector<string>& layers, const string& rootfs);
+
+  Future<bool> destroy(const string& rootfs);
+
+private:
+  // Removes the directories created for a rootfs which could not be
+  // provisioned.
+  void cleanup(const string& rootfs);
+};
+
+
+// Returns the directory holding the upper and work directories of
+// the overlayfs mounted at 'rootfs', i.e., for a rootfs at
+// '<backend_dir>/rootfses/<rootfs_id>' this is
+// '<backend_dir>/scratch/<rootfs_id>'. It must not be in 'rootfses'
+// or the provisioner would take it for a rootfs when recovering.
+static string scratch(const string& rootfs)
+{
+  const string rootfses = Path(rootfs).dirname();
+
+  return path::join(
+      Path(rootfses).dirname(),
+      "scratch",
+      Path(rootfs).basename());
+}
+
+
+Try<Owned<Backend>> OverlayBackend::create(const Flags&)
+{
+  Result<string> user = os::user();
+  if (!user.isSome()) {
+    return Error("Failed to determine user: " +
+                 (user.isError() ? user.error() : "username not found"));
+  }
+
+  if (user.get() != "root") {
+    return Error("OverlayBackend requires root privileges");
+  }
+
+  Try<bool> supported = fs::supported("overlay");
+  if (supported.isError()) {
+    return Error(
+        "Failed to check overlayfs availability: " + supported.error());
+  }
+
+  if (!supported.get()) {
+    return Error(
+        "Overlayfs is not supported by the kernel, consider the "
+        "'hardlink' backend instead");
+  }
+
+  return Owned<Backend>(new OverlayBackend(
+      Owned<OverlayBackendProcess>(new OverlayBackendProcess())));
+}
+
+
+OverlayBackend::~OverlayBackend()
+{
+  terminate(process.get());
+  wait(process.get());
+}
+
+
+OverlayBackend::OverlayBackend(Owned<OverlayBackendProcess> _process)
+  : process(_process)
+{
+  spawn(CHECK_NOTNULL(process.get()));
+}
+
+
+Future<Nothing> OverlayBackend::provision(
+    const vector<string>& layers,
+    const string& rootfs)
+{
+  return dispatch(
+      process.get(), &OverlayBackendProcess::provision, layers, rootfs);
+}
+
+
+Future<bool> OverlayBackend::destroy(const string& rootfs)
+{
+  return dispatch(process.get(), &OverlayBackendProcess::destroy, rootfs);
+}
+
+
+Future<Nothing> OverlayBackendProcess::provision(
+    const vector<string>& layers,
+    const string& rootfs)
+{
+  if (layers.size() == 0) {
+    return Failure("No filesystem layers provided");
+  }
+
+  if (os::exists(rootfs)) {
+    return Failure("Rootfs is already provisioned");
+  }
+
+  // The topmost layer comes first in 'lowerdir' while the layers are
+  // given bottom up.
+  vector<string> lowerdirs;
+  foreach (const string& layer, layers) {
+    // These characters separate the mount options.
+    if (strings::contains(layer, ":") || strings::contains(layer, ",")) {
+      return Failure("Unsupported character in layer path '" + layer + "'");
+    }
+
+    lowerdirs.insert(lowerdirs.begin(), layer);
+  }
+
+  const string upperdir = path::join(scratch(rootfs), "upperdir");
+  const string workdir = path::join(scratch(rootfs), "workdir");
+
+  const string options =
+    "lowerdir=" + strings::join(":", lowerdirs) +
+    ",upperdir=" + upperdir +
+    ",workdir=" + workdir;
+
+  if (options.size() >= MAX_OVERLAY_OPTIONS_SIZE) {
+    return Failure(
+        "Too many layers (" + stringify(layers.size()) + ") for overlayfs");
+  }
+
+  const vector<string> directories = {upperdir, workdir, rootfs};
+
+  foreach (const string& directory, directories) {
+    Try<Nothing> mkdir = os::mkdir(directory);
+    if (mkdir.isError()) {
+      cleanup(rootfs);
+
+      return Failure(
+          "Failed to create directory '" + directory + "': " + mkdir.error());
+    }
+  }
+
+  VLOG(1) << "Provisioning rootfs '" << rootfs << "' with overlayfs options '"
+          << options << "'";
+
+  Try<Nothing> mount = fs::mount("overlay", rootfs, "overlay", 0, options);
+
+  if (mount.isError()) {
+    cleanup(rootfs);
+
+    return Failure(
+        "Failed to mount overlayfs rootfs '" + rootfs + "': " +
+        mount.error());
+  }
+
+  return Nothing();
+}
+
+
+void OverlayBackendProcess::cleanup(const string& rootfs)
+{
+  // Nothing is mounted at 'rootfs' yet, thus only the directories
+  // created by 'provision' need to be removed.
+  Try<Nothing> rmdir = os::rmdir(scratch(rootfs));
+  if (rmdir.isError()) {
+    LOG(WARNING) << "Failed to remove scratch directory of rootfs '"
+                 << rootfs << "': " << rmdir.error();
+  }
+
+  if (os::exists(rootfs)) {
+    rmdir = os::rmdir(rootfs);
+    if (rmdir.isError()) {
+      LOG(WARNING) << "Failed to remove rootfs mount point '" << rootfs
+                   << "': " << rmdir.error();
+    }
+  }
+}
+
+
+Future<bool> OverlayBackendProcess::destroy(const string& rootfs)
+{
+  Try<fs::MountInfoTable> mountTable = fs::MountInfoTable::read();
+
+  if (mountTable.isError()) {
+    return Failure("Failed to read mount table: " + mountTable.error());
+  }
+
+  foreach (const fs::MountInfoTable::Entry& entry, mountTable.get().entries) {
+    if (entry.target == rootfs) {
+      // NOTE: This would fail if the rootfs is still in use.
+      Try<Nothing> unmount = fs::unmount(entry.target);
+      if (unmount.isError()) {
+        return Failure(
+            "Failed to destroy overlayfs rootfs '" + rootfs + "': " +
+            unmount.error());
+      }
+
+      // See the comment in BindBackendProcess::destroy about EBUSY.
+      if (::rmdir(rootfs.c_str()) != 0 && errno != EBUSY) {
+        return Failure(
+            "Failed to remove rootfs mount point '" + rootfs + "': " +
+            strerror(errno));
+      }
+
+      // Remove what has been written by the container.
+      Try<Nothing> rmdir = os::rmdir(scratch(rootfs));
+      if (rmdir.isError()) {
+        return Failure(
+            "Failed to remove scratch directory of rootfs '" + rootfs +
+            "': " + rmdir.error());
+      }
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,70 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PROVISIONER_BACKENDS_OVERLAY_HPP__
+#define __PROVISIONER_BACKENDS_OVERLAY_HPP__
+
+#include "slave/containerizer/mesos/provisioner/backend.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Forward declaration.
+class OverlayBackendProcess;
+
+
+// This backend stacks the layers with an overlayfs mount rather than
+// copying them, so the layers in the store are shared by all the
+// containers using them and a rootfs can be provisioned in (nearly)
+// constant time regardless of the size of the image. NOTE:
+// 1) OverlayBackend requires root privileges and a kernel supporting
+//    overlayfs (Linux >= 3.18).
+// 2) Writes by the container go into a per rootfs upper directory
+//    which is kept next to the 'rootfses' directory, i.e., in
+//    '<backend_dir>/scratch/<rootfs_id>' (see provisioner/paths.hpp),
+//    and which is removed when the rootfs is destroyed.
+// 3) The layers must not be modified while they are in use.
+class OverlayBackend : public Backend
+{
+public:
+  virtual ~OverlayBackend();
+
+  // OverlayBackend doesn't use any flag.
+  static Try<process::Owned<Backend>> create(const Flags&);
+
+  virtual process::Future<Nothing> provision(
+      const std::vector<std::string>& layers,
+      const std::string& rootfs);
+
+  virtual process::Future<bool> destroy(const std::string& rootfs);
+
+private:
+  explicit OverlayBackend(process::Owned<OverlayBackendProcess> process);
+
+  OverlayBackend(const OverlayBackend&); // Not copyable.
+  OverlayBackend& operator=(const OverlayBackend&); // Not assignable.
+
+  process::Owned<OverlayBackendProcess> process;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __PROVISIONER_BACKENDS_OVERLAY_HPP__
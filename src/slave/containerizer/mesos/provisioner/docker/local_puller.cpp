@@ -17,10 +17,12 @@
  */
 
 #include <list>
+#include <queue>
 #include <vector>
 
 #include <glog/logging.h>
 
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
 #include <stout/result.hpp>
@@ -30,6 +32,9 @@
 #include <process/dispatch.hpp>
 #include <process/subprocess.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+
 #include "common/status_utils.hpp"
 
 #include "slave/containerizer/mesos/provisioner/docker/local_puller.hpp"
@@ -40,6 +45,7 @@ using namespace process;
 
 using std::list;
 using std::pair;
+using std::queue;
 using std::string;
 using std::vector;
 
@@ -48,10 +54,17 @@ namespace internal {
 namespace slave {
 namespace docker {
 
+// Maximum number of layers extracted at the same time. Extraction is
+// mostly bound by disk throughput, so extracting every layer of an
+// image (or of several images) at once only adds seeks.
+static const size_t MAX_CONCURRENT_EXTRACTIONS = 4;
+
+
 class LocalPullerProcess : public process::Process<LocalPullerProcess>
 {
 public:
-  LocalPullerProcess(const Flags& _flags) : flags(_flags) {}
+  LocalPullerProcess(const Flags& _flags)
+    : flags(_flags), extractions(0) {}
 
   ~LocalPullerProcess() {}
 
@@ -66,20 +79,83 @@ private:
 
   process::Future<list<pair<string, string>>> putImage(
       const Image::Name& name,
+      const std::string& tarPath,
       const std::string& directory);
 
   process::Future<list<pair<string, string>>> putLayers(
+      const std::string& tarPath,
       const std::string& directory,
       const std::vector<std::string>& layerIds);
 
   process::Future<pair<string, string>> putLayer(
+      const std::string& tarPath,
       const std::string& directory,
       const std::string& layerId);
 
+  process::Future<string> extractLayer(
+      const std::string& tarPath,
+      const std::string& layerId);
+
+  process::Future<Nothing> untarLayer(
+      const std::string& tarPath,
+      const std::string& staging,
+      const std::string& layerId);
+
+  process::Future<string> _extractLayer(
+      const std::string& staging,
+      const std::string& layerId);
+
+  process::Future<Nothing> acquire();
+  void release();
+
   const Flags flags;
+
+  // Layers being extracted, keyed by layer id, so that concurrent
+  // pulls of images sharing a layer only extract it once. The value
+  // is the rootfs path of the layer in the store: shared layers are
+  // extracted into a staging directory owned by the puller rather
+  // than by the pull that started the extraction, since that pull
+  // may fail (and remove its staging directory) before the others
+  // have moved the layer.
+  hashmap<string, process::Future<string>> extracting;
+
+  // Number of running extractions and the extractions waiting for
+  // one of them to finish (see MAX_CONCURRENT_EXTRACTIONS).
+  size_t extractions;
+  queue<process::Owned<process::Promise<Nothing>>> waiters;
+
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    // Layers that were already in the store or being extracted.
+    process::metrics::Counter layer_cache_hits;
+
+    // Layers that had to be extracted.
+    process::metrics::Counter layer_cache_misses;
+  } metrics;
 };
 
 
+LocalPullerProcess::Metrics::Metrics()
+  : layer_cache_hits(
+        "containerizer/mesos/provisioner/docker_store/layer_cache_hits"),
+    layer_cache_misses(
+        "containerizer/mesos/provisioner/docker_store/layer_cache_misses")
+{
+  process::metrics::add(layer_cache_hits);
+  process::metrics::add(layer_cache_misses);
+}
+
+
+LocalPullerProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(layer_cache_hits);
+  process::metrics::remove(layer_cache_misses);
+}
+
+
 LocalPuller::LocalPuller(const Flags& flags)
 {
   process = Owned<LocalPullerProcess>(new LocalPullerProcess(flags));
@@ -116,7 +192,7 @@ Future<list<pair<string, string>>> LocalPullerProcess::pull(
   }
 
   return untarImage(tarPath, directory)
-    .then(defer(self(), &Self::putImage, name, directory));
+    .then(defer(self(), &Self::putImage, name, tarPath, directory));
 }
 
 
@@ -127,7 +203,9 @@ Future<Nothing> LocalPullerProcess::untarImage(
   VLOG(1) << "Untarring image from '" << tarPath
           << "' to '" << directory << "'";
 
-  // Untar store_discovery_local_dir/name.tar into directory/.
+  // Untar store_discovery_local_dir/name.tar into directory/, except
+  // for the layer tarballs: these are streamed out of the archive
+  // when (and only if) the layer is not in the store yet.
   // TODO(tnachen): Terminate tar process when slave exits.
   const vector<string> argv = {
     "tar",
@@ -135,7 +213,9 @@ Future<Nothing> LocalPullerProcess::untarImage(
     directory,
     "-x",
     "-f",
-    tarPath
+    tarPath,
+    "--exclude=layer.tar",
+    "--exclude=*/layer.tar"
   };
 
   Try<Subprocess> s = subprocess(
@@ -194,6 +274,7 @@ static Result<string> getParentId(
 
 Future<list<pair<string, string>>> LocalPullerProcess::putImage(
     const Image::Name& name,
+    const string& tarPath,
     const string& directory)
 {
   Try<string> value =
@@ -256,17 +337,18 @@ Future<list<pair<string, string>>> LocalPullerProcess::putImage(
                    "': " + parentId.error());
   }
 
-  return putLayers(directory, layerIds);
+  return putLayers(tarPath, directory, layerIds);
 }
 
 
 Future<list<pair<string, string>>> LocalPullerProcess::putLayers(
+    const string& tarPath,
     const string& directory,
     const vector<string>& layerIds)
 {
   list<Future<pair<string, string>>> futures;
   foreach (const string& layerId, layerIds) {
-    futures.push_back(putLayer(directory, layerId));
+    futures.push_back(putLayer(tarPath, directory, layerId));
   }
 
   return collect(futures);
@@ -274,81 +356,248 @@ Future<list<pair<string, string>>> LocalPullerProcess::putLayers(
 
 
 Future<pair<string, string>> LocalPullerProcess::putLayer(
+    const string& tarPath,
     const string& directory,
     const string& layerId)
 {
-  // We untar the layer from source into a directory, then move the
-  // layer into store. We do this instead of untarring directly to
-  // store to make sure we don't end up with partially untarred layer
-  // rootfs.
+  // Layers are immutable and identified by their id, so a layer that
+  // is already in the store does not need to be extracted again. The
+  // store leaves such a layer in place when moving the layers.
+  const string storeRootfsPath =
+    paths::getImageLayerRootfsPath(flags.docker_store_dir, layerId);
 
-  const string localRootfsPath =
-    paths::getImageArchiveLayerRootfsPath(directory, layerId);
-
-  // Image layer has been untarred but is not present in the store directory.
-  if (os::exists(localRootfsPath)) {
-    LOG(WARNING) << "Image layer '" << layerId << "' rootfs present at but not "
-                 << "in store directory '" << localRootfsPath << "'. Removing "
-                 << "staged rootfs and untarring layer again.";
-
-    Try<Nothing> rmdir = os::rmdir(localRootfsPath);
-    if (rmdir.isError()) {
-      return Failure("Failed to remove incomplete staged rootfs for layer '" +
-                     layerId + "': " + rmdir.error());
-    }
+  if (os::exists(storeRootfsPath)) {
+    VLOG(1) << "Image layer '" << layerId << "' is already in the store";
+
+    ++metrics.layer_cache_hits;
+    return pair<string, string>(layerId, storeRootfsPath);
+  }
+
+  Future<string> extraction;
+
+  if (extracting.contains(layerId)) {
+    VLOG(1) << "Image layer '" << layerId << "' is already being extracted";
+
+    ++metrics.layer_cache_hits;
+    extraction = extracting[layerId];
+  } else {
+    ++metrics.layer_cache_misses;
+
+    extraction = acquire()
+      .then(defer(self(), &Self::extractLayer, tarPath, layerId))
+      .onAny(defer(self(), &Self::release));
+
+    extracting[layerId] = extraction;
+
+    extraction
+      .onAny(defer(self(), [=](const Future<string>& future) {
+        // Only remove our own extraction: once it has completed, a
+        // later pull may have started a new one for the same layer.
+        if (extracting.contains(layerId) && extracting[layerId] == future) {
+          extracting.erase(layerId);
+        }
+      }));
+  }
+
+  // Give each pull its own future so that one of them being discarded
+  // does not discard the extraction shared with the other pulls.
+  Owned<Promise<string>> promise(new Promise<string>());
+
+  extraction
+    .onAny([promise](const Future<string>& rootfsPath) {
+      promise->associate(rootfsPath);
+    });
+
+  return promise->future()
+    .then([layerId](const string& rootfsPath) {
+      return pair<string, string>(layerId, rootfsPath);
+    });
+}
+
+
+Future<string> LocalPullerProcess::extractLayer(
+    const string& tarPath,
+    const string& layerId)
+{
+  // We untar the layer from source into a staging directory of its
+  // own, then move the layer into the store. We do this instead of
+  // untarring directly to the store to make sure we don't end up
+  // with partially untarred layer rootfs.
+  Try<string> staging =
+    os::mkdtemp(paths::getStagingTempDir(flags.docker_store_dir));
+
+  if (staging.isError()) {
+    return Failure("Failed to create staging directory for layer '" +
+                   layerId + "': " + staging.error());
   }
 
+  return untarLayer(tarPath, staging.get(), layerId)
+    .then(defer(self(), &Self::_extractLayer, staging.get(), layerId))
+    .onAny([staging]() {
+      Try<Nothing> rmdir = os::rmdir(staging.get());
+      if (rmdir.isError()) {
+        LOG(WARNING) << "Failed to remove staging directory: " << rmdir.error();
+      }
+    });
+}
+
+
+Future<Nothing> LocalPullerProcess::untarLayer(
+    const string& tarPath,
+    const string& staging,
+    const string& layerId)
+{
+  const string localRootfsPath =
+    paths::getImageArchiveLayerRootfsPath(staging, layerId);
+
   Try<Nothing> mkdir = os::mkdir(localRootfsPath);
   if (mkdir.isError()) {
     return Failure("Failed to create rootfs path '" + localRootfsPath +
                    "': " + mkdir.error());
   }
 
-  // Untar directory/id/layer.tar into directory/id/rootfs.
-  // The tar file will be removed when the staging directory is
-  // removed.
-  const vector<string> argv = {
+  // Stream id/layer.tar out of the image archive into a second tar
+  // which untars it into staging/id/rootfs, so that the layer
+  // tarball is never written to disk. Archives created by 'docker
+  // save' may or may not prefix their entries with './', hence the
+  // unanchored pattern (which still only matches whole components).
+  // A layer is only stored once in an archive, so tar stops reading
+  // the archive as soon as it has found the layer.
+  const vector<string> read = {
     "tar",
-    "-C",
-    localRootfsPath,
     "-x",
+    "-O",
     "-f",
-    paths::getImageArchiveLayerTarPath(directory, layerId)
+    tarPath,
+    "--occurrence=1",
+    "--wildcards",
+    "--no-anchored",
+    path::join(layerId, "layer.tar")
   };
 
-  Try<Subprocess> s = subprocess(
+  Try<Subprocess> reader = subprocess(
       "tar",
-      argv,
+      read,
       Subprocess::PATH("/dev/null"),
+      Subprocess::PIPE(),
+      Subprocess::PATH("/dev/null"));
+
+  if (reader.isError()) {
+    return Failure("Failed to create tar subprocess: " + reader.error());
+  }
+
+  const vector<string> extract = {
+    "tar",
+    "-C",
+    localRootfsPath,
+    "-x"
+  };
+
+  Try<Subprocess> extractor = subprocess(
+      "tar",
+      extract,
+      Subprocess::FD(reader.get().out().get()),
       Subprocess::PATH("/dev/null"),
       Subprocess::PATH("/dev/null"));
 
-  if (s.isError()) {
-    return Failure("Failed to create tar subprocess: " + s.error());
+  if (extractor.isError()) {
+    ::kill(reader.get().pid(), SIGKILL);
+    return Failure("Failed to create tar subprocess: " + extractor.error());
   }
 
-  return s.get().status()
-    .then([directory, layerId](
-        const Option<int>& status) -> Future<pair<string, string>> {
-      if (status.isNone()) {
-        return Failure("Failed to reap subprocess to untar image");
-      } else if (!WIFEXITED(status.get()) || WEXITSTATUS(status.get()) != 0) {
-        return Failure("Untar failed with exit code: " +
-                        WSTRINGIFY(status.get()));
-      }
+  list<Future<Option<int>>> statuses = {
+    reader.get().status(),
+    extractor.get().status()
+  };
 
-      const string rootfsPath =
-        paths::getImageArchiveLayerRootfsPath(directory, layerId);
+  return collect(statuses)
+    .then([localRootfsPath, layerId](
+        const list<Option<int>>& statuses) -> Future<Nothing> {
+      foreach (const Option<int>& status, statuses) {
+        if (status.isNone()) {
+          return Failure("Failed to reap subprocess to untar image");
+        } else if (!WIFEXITED(status.get()) || WEXITSTATUS(status.get()) != 0) {
+          return Failure("Untar failed with exit code: " +
+                          WSTRINGIFY(status.get()));
+        }
+      }
 
-      if (!os::exists(rootfsPath)) {
+      if (!os::exists(localRootfsPath)) {
         return Failure("Failed to find the rootfs path after extracting layer"
                        " '" + layerId + "'");
       }
 
-      return pair<string, string>(layerId, rootfsPath);
+      return Nothing();
     });
 }
 
+
+Future<string> LocalPullerProcess::_extractLayer(
+    const string& staging,
+    const string& layerId)
+{
+  const string storeRootfsPath =
+    paths::getImageLayerRootfsPath(flags.docker_store_dir, layerId);
+
+  // The store leaves a layer that is already in place alone (see
+  // 'StoreProcess::moveLayer'), so every pull sharing this layer can
+  // use the store path without depending on each other's staging.
+  if (os::exists(storeRootfsPath)) {
+    return storeRootfsPath;
+  }
+
+  const string storeLayerPath =
+    paths::getImageLayerPath(flags.docker_store_dir, layerId);
+
+  if (!os::exists(storeLayerPath)) {
+    Try<Nothing> mkdir = os::mkdir(storeLayerPath);
+    if (mkdir.isError()) {
+      return Failure("Failed to create layer path in store for id '" +
+                     layerId + "': " + mkdir.error());
+    }
+  }
+
+  Try<Nothing> rename = os::rename(
+      paths::getImageArchiveLayerRootfsPath(staging, layerId),
+      storeRootfsPath);
+
+  if (rename.isError()) {
+    return Failure("Failed to move layer '" + layerId +
+                   "' to store directory: " + rename.error());
+  }
+
+  return storeRootfsPath;
+}
+
+
+Future<Nothing> LocalPullerProcess::acquire()
+{
+  if (extractions < MAX_CONCURRENT_EXTRACTIONS) {
+    extractions++;
+    return Nothing();
+  }
+
+  Owned<Promise<Nothing>> waiter(new Promise<Nothing>());
+  waiters.push(waiter);
+
+  return waiter->future();
+}
+
+
+void LocalPullerProcess::release()
+{
+  // Hand the slot over to the next waiting extraction, if any.
+  if (!waiters.empty()) {
+    Owned<Promise<Nothing>> waiter = waiters.front();
+    waiters.pop();
+    waiter->set(Nothing());
+    return;
+  }
+
+  CHECK_GT(extractions, 0u);
+  extractions--;
+}
+
 } // namespace docker {
 } // namespace slave {
 } // namespace internal {
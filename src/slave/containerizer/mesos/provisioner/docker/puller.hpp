@@ -47,7 +47,9 @@ public:
    * Pull a Docker image layers into the specified directory, and
    * return the list of layer ids in that image in the right
    * dependency order, and also return the directory where
-   * the puller puts its changeset.
+   * the puller puts its changeset. Layers that are already in the
+   * store need not be pulled again, in which case their directory
+   * in the store is returned instead.
    *
    * @param name The name of the image.
    * @param directory The target directory to store the layers.
@@ -23,6 +23,7 @@
 
 #include <glog/logging.h>
 
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
 #include <stout/result.hpp>
@@ -87,6 +88,10 @@ private:
   const Flags flags;
   Owned<MetadataManager> metadataManager;
   Owned<Puller> puller;
+
+  // Images being pulled, keyed by image name, so that containers
+  // launched concurrently with the same image share a single pull.
+  hashmap<string, Owned<Promise<Image>>> pulling;
 };
 
 
@@ -173,22 +178,49 @@ Future<Image> StoreProcess::_get(
     return image.get();
   }
 
-  Try<string> staging =
-    os::mkdtemp(paths::getStagingTempDir(flags.docker_store_dir));
+  const string key = stringify(name);
+
+  if (pulling.contains(key)) {
+    VLOG(1) << "Image '" << key << "' is already being pulled";
+  } else {
+    Try<string> staging =
+      os::mkdtemp(paths::getStagingTempDir(flags.docker_store_dir));
+
+    if (staging.isError()) {
+      return Failure("Failed to create a staging directory");
+    }
+
+    Owned<Promise<Image>> promise(new Promise<Image>());
+    pulling.put(key, promise);
+
+    promise->associate(puller->pull(name, staging.get())
+      .then(defer(self(), &Self::moveLayers, staging.get(), lambda::_1))
+      .then(defer(self(), &Self::storeImage, name, lambda::_1))
+      .onAny([staging]() {
+        Try<Nothing> rmdir = os::rmdir(staging.get());
+        if (rmdir.isError()) {
+          LOG(WARNING) << "Failed to remove staging directory: "
+                       << rmdir.error();
+        }
+      }));
 
-  if (staging.isError()) {
-    return Failure("Failed to create a staging directory");
+    promise->future()
+      .onAny(defer(self(), [=](const Future<Image>&) {
+        pulling.erase(key);
+      }));
   }
 
-  return puller->pull(name, staging.get())
-    .then(defer(self(), &Self::moveLayers, staging.get(), lambda::_1))
-    .then(defer(self(), &Self::storeImage, name, lambda::_1))
-    .onAny([staging]() {
-      Try<Nothing> rmdir = os::rmdir(staging.get());
-      if (rmdir.isError()) {
-        LOG(WARNING) << "Failed to remove staging directory: " << rmdir.error();
-      }
+  // Give each caller its own future so that one of them discarding it
+  // (e.g., a container being destroyed while provisioning) does not
+  // discard the pull shared with the other callers.
+  Owned<Promise<Image>> promise(new Promise<Image>());
+
+  pulling[key]->future()
+    .onAny([promise](const Future<Image>& image) {
+      promise->associate(image);
     });
+
+  return promise->future();
 }
 
 
@@ -242,6 +274,16 @@ Future<Image> StoreProcess::storeImage(
 
 Future<Nothing> StoreProcess::moveLayer(const pair<string, string>& layerPath)
 {
+  const string imageLayerRootfsPath =
+    paths::getImageLayerRootfsPath(flags.docker_store_dir, layerPath.first);
+
+  // The layer is shared with an image that is already in the store,
+  // or it was extracted by another pull which moved it first. Either
+  // way the copy in the store is identical: layers are immutable.
+  if (os::exists(imageLayerRootfsPath)) {
+    return Nothing();
+  }
+
   if (!os::exists(layerPath.second)) {
     return Failure("Unable to find layer '" + layerPath.first + "' in '" +
                    layerPath.second + "'");
@@ -258,10 +300,7 @@ Future<Nothing> StoreProcess::moveLayer(const pair<string, string>& layerPath)
     }
   }
 
-  Try<Nothing> status = os::rename(
-      layerPath.second,
-      paths::getImageLayerRootfsPath(
-          flags.docker_store_dir, layerPath.first));
+  Try<Nothing> status = os::rename(layerPath.second, imageLayerRootfsPath);
 
   if (status.isError()) {
     return Failure("Failed to move layer '" + layerPath.first +
@@ -22,9 +22,12 @@
 #include <stout/flags.hpp>
 #include <stout/json.hpp>
 #include <stout/option.hpp>
+#include <stout/strings.hpp>
 
 #include <mesos/type_utils.hpp>
 
+#include <mesos/fetcher/fetcher.hpp>
+
 #include "common/parse.hpp"
 
 #include "slave/constants.hpp"
@@ -85,7 +88,12 @@ mesos::internal::slave::Flags::Flags()
   add(&Flags::image_provisioner_backend,
       "image_provisioner_backend",
       "Strategy for provisioning container rootfs from images,\n"
-      "e.g., 'bind', 'copy'.",
+      "e.g., 'bind', 'copy', 'hardlink', 'overlay'.\n"
+      "'overlay' stacks the image layers with overlayfs instead of\n"
+      "copying them. Where overlayfs is not available, 'hardlink'\n"
+      "links the files of the layers into the rootfs instead (NOTE:\n"
+      "such files are shared with the image store, so they must not\n"
+      "be modified in place).",
       "copy");
 
   add(&Flags::appc_store_dir,
@@ -141,6 +149,39 @@ mesos::internal::slave::Flags::Flags()
       "(one subdirectory per slave).",
       "/tmp/mesos/fetch");
 
+  add(&Flags::fetcher_cache_delivery,
+      "fetcher_cache_delivery",
+      "How the fetcher retrieves resources from its cache into sandboxes.\n"
+      "'copy' copies the cache file into the sandbox, or extracts it there.\n"
+      "'reflink' and 'hardlink' keep archives extracted in the cache and\n"
+      "clone, respectively hard link, the cache file or the files of its\n"
+      "extraction into the sandbox, falling back to copying where the\n"
+      "file system does not allow this. NOTE: With 'hardlink', a task that\n"
+      "modifies such a file in place also modifies it for other tasks.\n"
+      "Resources fetched for a task which runs as a user are copied\n"
+      "instead of hard linked, since the sandbox is chowned to the user.",
+      "copy",
+      [](const std::string& value) -> Option<Error> {
+        mesos::fetcher::FetcherInfo::Delivery delivery;
+        if (!mesos::fetcher::FetcherInfo::Delivery_Parse(
+                strings::upper(value), &delivery)) {
+          return Error("Unknown fetcher cache delivery '" + value + "'");
+        }
+        return None();
+      });
+
+  add(&Flags::fetcher_cache_eviction_policy,
+      "fetcher_cache_eviction_policy",
+      "Which cache files the fetcher evicts first when it needs space.\n"
+      "'lru' evicts the least recently used file. 'lfu' evicts the least\n"
+      "frequently used file, aging out files that have not been used for\n"
+      "a while. 'gdsf' weighs the frequency of use by how long the\n"
+      "download took and how large the file is, so that large files that\n"
+      "are rarely used are evicted before small ones that are used often.\n"
+      "The usage history is kept in the fetcher cache directory across\n"
+      "restarts.",
+      "lru");
+
   add(&Flags::work_dir,
       "work_dir",
       "Directory path to place framework work directories\n", "/tmp/mesos");
@@ -240,6 +281,29 @@ mesos::internal::slave::Flags::Flags()
       "be a value between 0.0 and 1.0",
       GC_DISK_HEADROOM);
 
+  add(&Flags::gc_workers,
+      "gc_workers",
+      "Maximum number of directories the garbage collector deletes\n"
+      "concurrently, each on a thread of its own (at most " +
+      stringify(MAX_GC_WORKERS) + ").\n"
+      "When pruning under disk pressure, the largest directories are\n"
+      "deleted first.",
+      DEFAULT_GC_WORKERS,
+      [](size_t value) -> Option<Error> {
+        if (value < 1 || value > MAX_GC_WORKERS) {
+          return Error("Expected --gc_workers to be between 1 and " +
+                       stringify(MAX_GC_WORKERS));
+        }
+        return None();
+      });
+
+  add(&Flags::gc_removal_rate,
+      "gc_removal_rate",
+      "Maximum number of files and directories per second that the\n"
+      "garbage collector deletes across all of its workers, to bound\n"
+      "the I/O it competes with tasks for (e.g., 5000). Unlimited if\n"
+      "not set.");
+
   add(&Flags::disk_watch_interval,
       "disk_watch_interval",
       "Periodic time interval (e.g., 10secs, 2mins, etc)\n"
@@ -265,6 +329,13 @@ mesos::internal::slave::Flags::Flags()
       "waiting to reconnect to the slave will self-terminate.\n",
       RECOVERY_TIMEOUT);
 
+  add(&Flags::recovery_threads,
+      "recovery_threads",
+      "Maximum number of threads used to read the checkpointed frameworks\n"
+      "and executors in parallel during recovery. Set to 1 to recover the\n"
+      "checkpointed state serially.\n",
+      DEFAULT_RECOVERY_THREADS);
+
   add(&Flags::strict,
       "strict",
       "If strict=true, any and all recovery errors are considered fatal.\n"
@@ -322,17 +393,19 @@ mesos::internal::slave::Flags::Flags()
 
   add(&Flags::perf_interval,
       "perf_interval",
-      "Interval between the start of perf stat samples. Perf samples are\n"
-      "obtained periodically according to perf_interval and the most\n"
-      "recently obtained sample is returned rather than sampling on\n"
-      "demand. For this reason, perf_interval is independent of the\n"
-      "resource monitoring interval",
+      "Interval between perf samples. The perf events are counted\n"
+      "continuously and each sample covers the preceding perf_interval.\n"
+      "Perf samples are obtained periodically according to perf_interval\n"
+      "and the most recently obtained sample is returned rather than\n"
+      "sampling on demand. For this reason, perf_interval is independent\n"
+      "of the resource monitoring interval",
       Seconds(60));
 
   add(&Flags::perf_duration,
       "perf_duration",
       "Duration of a perf stat sample. The duration must be less\n"
-      "than the perf_interval.",
+      "than the perf_interval. NOTE: This flag is deprecated since\n"
+      "samples now cover the whole perf_interval.",
       Seconds(10));
 
   add(&Flags::revocable_cpu_low_priority,
@@ -530,6 +603,14 @@ mesos::internal::slave::Flags::Flags()
       "used for the 'posix/disk' isolator.",
       Seconds(15));
 
+  add(&Flags::container_disk_watch_concurrency,
+      "container_disk_watch_concurrency",
+      "The maximum number of container paths whose disk usage is collected\n"
+      "concurrently. Each collection walks the path on its own thread with\n"
+      "an idle I/O priority (on Linux). This flag is used for the\n"
+      "'posix/disk' isolator.",
+      2);
+
   // TODO(jieyu): Consider enabling this flag by default. Remember
   // to update the user doc if we decide to do so.
   add(&Flags::enforce_container_disk_quota,
@@ -607,6 +688,16 @@ mesos::internal::slave::Flags::Flags()
       "qos_controller",
       "The name of the QoS Controller to use for oversubscription.");
 
+  add(&Flags::resource_usage_cache_interval,
+      "resource_usage_cache_interval",
+      "The resource usage of the containers is shared between the\n"
+      "consumers of it (the '/monitor/statistics' endpoint, the QoS\n"
+      "Controller and the Resource Estimator). Requests for the resource\n"
+      "usage made while it is being collected are always served by that\n"
+      "collection. This flag controls for how long a completed collection\n"
+      "keeps being served before the resource usage is collected again.",
+      Seconds(0));
+
   add(&Flags::qos_correction_interval_min,
       "qos_correction_interval_min",
       "The slave polls and carries out QoS corrections from the QoS\n"
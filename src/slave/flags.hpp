@@ -61,6 +61,8 @@ public:
   Option<std::string> attributes;
   Bytes fetcher_cache_size;
   std::string fetcher_cache_dir;
+  std::string fetcher_cache_delivery;
+  std::string fetcher_cache_eviction_policy;
   std::string work_dir;
   std::string launcher_dir;
   std::string hadoop_home; // TODO(benh): Make an Option.
@@ -72,10 +74,13 @@ public:
   Duration executor_shutdown_grace_period;
   Duration gc_delay;
   double gc_disk_headroom;
+  size_t gc_workers;
+  Option<double> gc_removal_rate;
   Duration disk_watch_interval;
 
   std::string recover;
   Duration recovery_timeout;
+  size_t recovery_threads;
   bool strict;
   Duration register_retry_interval_min;
 #ifdef __linux__
@@ -114,11 +119,13 @@ public:
   bool network_enable_socket_statistics_details;
 #endif
   Duration container_disk_watch_interval;
+  size_t container_disk_watch_concurrency;
   bool enforce_container_disk_quota;
   Option<Modules> modules;
   std::string authenticatee;
   Option<std::string> hooks;
   Option<std::string> resource_estimator;
+  Duration resource_usage_cache_interval;
   Option<std::string> qos_controller;
   Duration qos_correction_interval_min;
   Duration oversubscribed_resources_interval;
@@ -16,36 +16,231 @@
  * limitations under the License.
  */
 
+#include <fts.h>
+
+#include <algorithm>
+#include <chrono>
 #include <list>
+#include <mutex>
+#include <thread>
 
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
+#include <process/id.hpp>
+
+#include <process/metrics/metrics.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/os.hpp>
+#include <stout/synchronized.hpp>
 
 #include "logging/logging.hpp"
 
+#include "slave/constants.hpp"
 #include "slave/gc.hpp"
 
 using namespace process;
 
 using process::wait; // Necessary on some OS's to disambiguate.
 
+using process::metrics::Counter;
+
 using std::list;
 using std::map;
+using std::shared_ptr;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
 namespace slave {
 
+// Limits the rate at which the workers remove files and directories.
+// Workers that get ahead of the rate sleep off the difference, which
+// they do in batches of at least 10ms to keep the overhead low.
+class Throttle
+{
+public:
+  explicit Throttle(const Option<double>& rate)
+    : interval(rate.isSome() && rate.get() > 0
+               ? Option<std::chrono::duration<double>>(
+                     std::chrono::duration<double>(1 / rate.get()))
+               : None()) {}
+
+  void acquire()
+  {
+    if (interval.isNone()) {
+      return;
+    }
+
+    const Clock::time_point now = Clock::now();
+
+    Clock::duration wait;
+
+    synchronized (mutex) {
+      next = std::max(next, now);
+      wait = next - now;
+      next += std::chrono::duration_cast<Clock::duration>(interval.get());
+    }
+
+    if (wait >= std::chrono::milliseconds(10)) {
+      std::this_thread::sleep_for(wait);
+    }
+  }
+
+private:
+  // Not the libprocess clock, which tests may pause.
+  typedef std::chrono::steady_clock Clock;
+
+  const Option<std::chrono::duration<double>> interval;
+
+  std::mutex mutex;
+  Clock::time_point next;
+};
+
+
+// Removes the file or directory tree at 'path' bottom-up like
+// os::rmdir(), but throttled, and counting the removed files and the
+// reclaimed space as it goes.
+static Try<Nothing> removeTree(
+    const string& path,
+    const shared_ptr<Throttle>& throttle,
+    Counter files,
+    Counter bytes)
+{
+  if (!os::exists(path)) {
+    return Error("No such file or directory");
+  }
+
+  char* paths[] = {const_cast<char*>(path.c_str()), NULL};
+
+  FTS* tree = fts_open(paths, FTS_NOCHDIR | FTS_PHYSICAL, NULL);
+  if (tree == NULL) {
+    return ErrnoError();
+  }
+
+  errno = 0;
+
+  FTSENT* node;
+  while ((node = fts_read(tree)) != NULL) {
+    switch (node->fts_info) {
+      case FTS_DP:
+        throttle->acquire();
+
+        if (::rmdir(node->fts_path) < 0 && errno != ENOENT) {
+          Error error = ErrnoError();
+          fts_close(tree);
+          return error;
+        }
+        break;
+      case FTS_F:
+      case FTS_SL:
+      case FTS_SLNONE:
+      case FTS_DEFAULT:
+        throttle->acquire();
+
+        if (::unlink(node->fts_path) < 0) {
+          if (errno != ENOENT) {
+            Error error = ErrnoError();
+            fts_close(tree);
+            return error;
+          }
+          break;
+        }
+
+        ++files;
+
+        // Space is only reclaimed once the last link is gone.
+        if (node->fts_statp->st_nlink <= 1) {
+          bytes += node->fts_statp->st_blocks * 512;
+        }
+        break;
+      default:
+        break;
+    }
+
+    errno = 0;
+  }
+
+  if (errno != 0) {
+    Error error = ErrnoError();
+    fts_close(tree);
+    return error;
+  }
+
+  if (fts_close(tree) < 0) {
+    return ErrnoError();
+  }
+
+  return Nothing();
+}
+
+
+// Returns the space taken by each of the paths, or None for those
+// that cannot be measured. Unlike 'du', hard links are counted once
+// per link.
+static vector<Option<Bytes>> measure(const vector<string>& paths)
+{
+  vector<Option<Bytes>> sizes;
+
+  foreach (const string& path, paths) {
+    char* _paths[] = {const_cast<char*>(path.c_str()), NULL};
+
+    FTS* tree = fts_open(_paths, FTS_NOCHDIR | FTS_PHYSICAL, NULL);
+    if (tree == NULL) {
+      sizes.push_back(None());
+      continue;
+    }
+
+    Bytes size;
+
+    FTSENT* node;
+    while ((node = fts_read(tree)) != NULL) {
+      switch (node->fts_info) {
+        case FTS_F:
+        case FTS_SL:
+        case FTS_SLNONE:
+        case FTS_DEFAULT:
+        case FTS_DP:
+          size += node->fts_statp->st_blocks * 512;
+          break;
+        default:
+          break;
+      }
+    }
+
+    fts_close(tree);
+
+    sizes.push_back(size);
+  }
+
+  return sizes;
+}
+
+
+GarbageCollectorProcess::GarbageCollectorProcess(
+    size_t _workers,
+    const Option<double>& removalRate)
+  : ProcessBase(process::ID::generate("garbage-collector")),
+    metrics(*this),
+    workers(std::min(std::max(_workers, (size_t) 1), MAX_GC_WORKERS)),
+    throttle(new Throttle(removalRate)) {}
+
 
 GarbageCollectorProcess::~GarbageCollectorProcess()
 {
   foreachvalue (const PathInfo& info, paths) {
     info.promise->discard();
   }
+
+  foreach (const Removal& removal, queue) {
+    removal.info.promise->discard();
+  }
+
+  foreachvalue (const PathInfo& info, removing) {
+    info.promise->discard();
+  }
 }
 
 
@@ -57,7 +252,7 @@ Future<Nothing> GarbageCollectorProcess::schedule(
 
   // If there's an existing schedule for this path, we must remove
   // it here in order to reschedule.
-  if (timeouts.contains(path)) {
+  if (timeouts.contains(path) || queued(path)) {
     CHECK(unschedule(path));
   }
 
@@ -83,7 +278,16 @@ bool GarbageCollectorProcess::unschedule(const string& path)
 {
   LOG(INFO) << "Unscheduling '" << path << "' from gc";
 
+  // A path that is due but not being removed yet is still queued.
   if (!timeouts.contains(path)) {
+    for (list<Removal>::iterator it = queue.begin(); it != queue.end(); ++it) {
+      if (it->info.path == path) {
+        it->info.promise->discard();
+        queue.erase(it);
+        return true;
+      }
+    }
+
     return false;
   }
 
@@ -126,28 +330,15 @@ void GarbageCollectorProcess::reset()
 
 void GarbageCollectorProcess::remove(const Timeout& removalTime)
 {
-  // TODO(bmahler): Other dispatches can block waiting for a removal
-  // operation. To fix this, the removal operation can be done
-  // asynchronously in another thread.
   if (paths.count(removalTime) > 0) {
+    vector<PathInfo> infos;
     foreach (const PathInfo& info, paths.get(removalTime)) {
-      LOG(INFO) << "Deleting " << info.path;
-
-      Try<Nothing> rmdir = os::rmdir(info.path);
-
-      if (rmdir.isError()) {
-        LOG(WARNING) << "Failed to delete '" << info.path << "': "
-                     << rmdir.error();
-        info.promise->fail(rmdir.error());
-      } else {
-        LOG(INFO) << "Deleted '" << info.path << "'";
-        info.promise->set(rmdir.get());
-      }
-
-      timeouts.erase(info.path);
+      infos.push_back(info);
     }
 
     paths.remove(removalTime);
+
+    enqueue(infos);
   } else {
     // This occurs when either:
     //   1. The path(s) has already been removed (e.g. by prune()).
@@ -160,21 +351,204 @@ void GarbageCollectorProcess::remove(const Timeout& removalTime)
 }
 
 
+void GarbageCollectorProcess::enqueue(const vector<PathInfo>& infos)
+{
+  foreach (const PathInfo& info, infos) {
+    // Queued paths are unscheduled from the queue instead.
+    timeouts.erase(info.path);
+
+    queue.push_back(Removal(info));
+  }
+
+  next();
+}
+
+
+bool GarbageCollectorProcess::queued(const string& path)
+{
+  foreach (const Removal& removal, queue) {
+    if (removal.info.path == path) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+void GarbageCollectorProcess::measured(
+    const vector<string>& _paths,
+    const vector<Option<Bytes>>& sizes)
+{
+  CHECK_EQ(_paths.size(), sizes.size());
+
+  hashmap<string, Bytes> measurements;
+  for (size_t i = 0; i < _paths.size(); i++) {
+    if (sizes[i].isSome()) {
+      measurements[_paths[i]] = sizes[i].get();
+    }
+  }
+
+  // Paths may have been removed or be being removed in the meantime.
+  foreach (Removal& removal, queue) {
+    if (measurements.contains(removal.info.path)) {
+      removal.size = measurements[removal.info.path];
+    }
+  }
+}
+
+
+void GarbageCollectorProcess::next()
+{
+  while (removing.size() < workers && !queue.empty()) {
+    // Reclaim space from the largest paths first, otherwise remove
+    // paths in the order they became due.
+    list<Removal>::iterator largest = queue.begin();
+    for (list<Removal>::iterator it = queue.begin(); it != queue.end(); ++it) {
+      if (it->size.isSome() &&
+          (largest->size.isNone() || it->size.get() > largest->size.get())) {
+        largest = it;
+      }
+    }
+
+    const PathInfo info = largest->info;
+    queue.erase(largest);
+
+    LOG(INFO) << "Deleting " << info.path;
+
+    removing.put(info.path, info);
+
+    const string path = info.path;
+    const shared_ptr<Throttle> throttle = this->throttle;
+    const Counter files = metrics.files_removed;
+    const Counter bytes = metrics.bytes_reclaimed;
+    const PID<GarbageCollectorProcess> pid = self();
+
+    // The removal blocks on disk I/O and on the throttle, hence it
+    // runs on its own thread rather than on one of the libprocess
+    // worker threads. There are at most 'workers' of these threads.
+    std::thread([=]() {
+      Try<Nothing> removal = removeTree(path, throttle, files, bytes);
+
+      dispatch(pid, &GarbageCollectorProcess::removed, path, removal);
+    }).detach();
+  }
+}
+
+
+void GarbageCollectorProcess::removed(
+    const string& path,
+    const Try<Nothing>& removal)
+{
+  CHECK(removing.contains(path));
+
+  const PathInfo info = removing.at(path);
+  removing.erase(path);
+
+  if (removal.isSome()) {
+    LOG(INFO) << "Deleted '" << path << "'";
+    ++metrics.path_removals_succeeded;
+    info.promise->set(Nothing());
+  } else {
+    LOG(WARNING) << "Failed to delete '" << path << "': " << removal.error();
+    ++metrics.path_removals_failed;
+    info.promise->fail(removal.error());
+  }
+
+  next();
+}
+
+
 void GarbageCollectorProcess::prune(const Duration& d)
 {
+  vector<PathInfo> infos;
+  vector<string> _paths;
+
   foreach (const Timeout& removalTime, paths.keys()) {
     if (removalTime.remaining() <= d) {
       LOG(INFO) << "Pruning directories with remaining removal time "
                 << removalTime.remaining();
-      dispatch(self(), &GarbageCollectorProcess::remove, removalTime);
+
+      foreach (const PathInfo& info, paths.get(removalTime)) {
+        infos.push_back(info);
+        _paths.push_back(info.path);
+      }
+
+      paths.remove(removalTime);
     }
   }
+
+  if (infos.empty()) {
+    return;
+  }
+
+  reset(); // The next scheduled removal may have been pruned.
+
+  // Measure the paths to reclaim space from the largest ones first.
+  // Workers start removing paths in the meantime. Like the removals,
+  // this walks the paths on its own thread.
+  if (infos.size() > workers) {
+    const PID<GarbageCollectorProcess> pid = self();
+
+    std::thread([=]() {
+      vector<Option<Bytes>> sizes = measure(_paths);
+
+      dispatch(pid, &GarbageCollectorProcess::measured, _paths, sizes);
+    }).detach();
+  }
+
+  enqueue(infos);
+}
+
+
+GarbageCollectorProcess::Metrics::Metrics(const GarbageCollectorProcess& gc)
+  : path_removals_pending(
+        "gc/path_removals_pending",
+        defer(gc, &GarbageCollectorProcess::_path_removals_pending)),
+    path_removals_active(
+        "gc/path_removals_active",
+        defer(gc, &GarbageCollectorProcess::_path_removals_active)),
+    path_removals_succeeded(
+        "gc/path_removals_succeeded"),
+    path_removals_failed(
+        "gc/path_removals_failed"),
+    files_removed(
+        "gc/files_removed"),
+    bytes_reclaimed(
+        "gc/bytes_reclaimed")
+{
+  process::metrics::add(path_removals_pending);
+  process::metrics::add(path_removals_active);
+  process::metrics::add(path_removals_succeeded);
+  process::metrics::add(path_removals_failed);
+  process::metrics::add(files_removed);
+  process::metrics::add(bytes_reclaimed);
+}
+
+
+GarbageCollectorProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(path_removals_pending);
+  process::metrics::remove(path_removals_active);
+  process::metrics::remove(path_removals_succeeded);
+  process::metrics::remove(path_removals_failed);
+  process::metrics::remove(files_removed);
+  process::metrics::remove(bytes_reclaimed);
 }
 
 
 GarbageCollector::GarbageCollector()
 {
-  process = new GarbageCollectorProcess();
+  process = new GarbageCollectorProcess(DEFAULT_GC_WORKERS, None());
+  spawn(process);
+}
+
+
+GarbageCollector::GarbageCollector(
+    size_t workers,
+    const Option<double>& removalRate)
+{
+  process = new GarbageCollectorProcess(workers, removalRate);
   spawn(process);
 }
 
@@ -19,6 +19,8 @@
 #ifndef __SLAVE_GC_HPP__
 #define __SLAVE_GC_HPP__
 
+#include <list>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -28,10 +30,15 @@
 #include <process/timeout.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
+
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/multimap.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/try.hpp>
 
 namespace mesos {
@@ -40,6 +47,7 @@ namespace slave {
 
 // Forward declarations.
 class GarbageCollectorProcess;
+class Throttle;
 
 // Provides an abstraction for removing files and directories after
 // some point at which they are no longer considered necessary to keep
@@ -52,6 +60,13 @@ class GarbageCollector
 {
 public:
   GarbageCollector();
+
+  // Deletes up to 'workers' paths concurrently (at most
+  // MAX_GC_WORKERS), each on a thread of its own, removing at most
+  // 'removalRate' files and directories per second across all
+  // workers, if specified.
+  GarbageCollector(size_t workers, const Option<double>& removalRate);
+
   virtual ~GarbageCollector();
 
   // Schedules the specified path for removal after the specified
@@ -76,7 +91,8 @@ public:
   virtual process::Future<bool> unschedule(const std::string& path);
 
   // Deletes all the directories, whose scheduled garbage collection time
-  // is within the next 'd' duration of time.
+  // is within the next 'd' duration of time. The largest directories
+  // are deleted first.
   virtual void prune(const Duration& d);
 
 private:
@@ -88,6 +104,8 @@ class GarbageCollectorProcess :
     public process::Process<GarbageCollectorProcess>
 {
 public:
+  GarbageCollectorProcess(size_t workers, const Option<double>& removalRate);
+
   virtual ~GarbageCollectorProcess();
 
   process::Future<Nothing> schedule(
@@ -118,6 +136,63 @@ private:
     const process::Owned<process::Promise<Nothing> > promise;
   };
 
+  // A path that is due for removal, with the space that removing it
+  // reclaims, once known (see prune()).
+  struct Removal
+  {
+    explicit Removal(const PathInfo& _info) : info(_info) {}
+
+    PathInfo info;
+    Option<Bytes> size;
+  };
+
+  // Queues the paths for removal by the workers.
+  void enqueue(const std::vector<PathInfo>& infos);
+
+  // Returns whether the path is queued for removal.
+  bool queued(const std::string& path);
+
+  // Orders queued paths by the sizes measured for them.
+  void measured(
+      const std::vector<std::string>& paths,
+      const std::vector<Option<Bytes>>& sizes);
+
+  // Starts removing queued paths while there are idle workers, the
+  // largest known ones first.
+  void next();
+
+  void removed(const std::string& path, const Try<Nothing>& removal);
+
+  double _path_removals_pending() { return queue.size(); }
+  double _path_removals_active() { return removing.size(); }
+
+  struct Metrics
+  {
+    explicit Metrics(const GarbageCollectorProcess& gc);
+    ~Metrics();
+
+    process::metrics::Gauge path_removals_pending;
+    process::metrics::Gauge path_removals_active;
+    process::metrics::Counter path_removals_succeeded;
+    process::metrics::Counter path_removals_failed;
+
+    // Updated by the workers while they delete.
+    process::metrics::Counter files_removed;
+    process::metrics::Counter bytes_reclaimed;
+  } metrics;
+
+  // Maximum number of paths removed concurrently.
+  const size_t workers;
+
+  // Limits the rate of file and directory removals across workers.
+  const std::shared_ptr<Throttle> throttle;
+
+  // Paths due for removal, which are not being removed yet.
+  std::list<Removal> queue;
+
+  // Paths being removed.
+  hashmap<std::string, PathInfo> removing;
+
   // Store all the timeouts and corresponding paths to delete.
   // NOTE: We are using Multimap here instead of Multihashmap, because
   // we need the keys of the map (deletion time) to be sorted.
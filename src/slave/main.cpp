@@ -252,7 +252,7 @@ int main(int argc, char** argv)
   }
 
   Files files;
-  GarbageCollector gc;
+  GarbageCollector gc(flags.gc_workers, flags.gc_removal_rate);
   StatusUpdateManager statusUpdateManager(flags);
 
   Try<ResourceEstimator*> resourceEstimator =
@@ -589,7 +589,7 @@ void Slave::initialize()
   }
 
   // Do recovery.
-  async(&state::recover, metaDir, flags.strict)
+  async(&state::recover, metaDir, flags.strict, flags.recovery_threads)
     .then(defer(self(), &Slave::recover, lambda::_1))
     .then(defer(self(), &Slave::_recover))
     .onAny(defer(self(), &Slave::__recover, lambda::_1));
@@ -4582,13 +4582,41 @@ void Slave::_qosCorrections(const Future<list<QoSCorrection>>& future)
 
 
 Future<ResourceUsage> Slave::usage()
+{
+  // Share the collection in progress, or the most recent one if it
+  // is recent enough, between the consumers of the resource usage.
+  if (resourceUsage.isNone() ||
+      (!resourceUsage.get().isPending() &&
+       (!resourceUsage.get().isReady() ||
+        Clock::now() - resourceUsageTime >=
+          flags.resource_usage_cache_interval))) {
+    resourceUsage = _usage();
+    resourceUsageTime = Clock::now();
+  }
+
+  // Give each consumer its own future so that one of them discarding
+  // it (e.g., an HTTP client going away or an estimator timing out)
+  // does not discard the shared collection for the others.
+  std::shared_ptr<Promise<ResourceUsage>> promise(
+      new Promise<ResourceUsage>());
+
+  resourceUsage.get()
+    .onAny([promise](const Future<ResourceUsage>& usage) {
+      promise->associate(usage);
+    });
+
+  return promise->future();
+}
+
+
+Future<ResourceUsage> Slave::_usage()
 {
   // NOTE: We use 'Owned' here trying to avoid the expensive copy.
   // C++11 lambda only supports capturing variables that have copy
   // constructors. Revisit once we remove the copy constructor for
   // Owned (or C++14 lambda generalized capture is supported).
   Owned<ResourceUsage> usage(new ResourceUsage());
-  list<Future<ResourceStatistics>> futures;
+  hashset<ContainerID> containerIds;
 
   foreachvalue (const Framework* framework, frameworks) {
     foreachvalue (const Executor* executor, framework->executors) {
@@ -4597,7 +4625,7 @@ Future<ResourceUsage> Slave::usage()
       entry->mutable_allocated()->CopyFrom(executor->resources);
       entry->mutable_container_id()->CopyFrom(executor->containerId);
 
-      futures.push_back(containerizer->usage(executor->containerId));
+      containerIds.insert(executor->containerId);
     }
   }
 
@@ -4612,26 +4640,22 @@ Future<ResourceUsage> Slave::usage()
 
   usage->mutable_total()->CopyFrom(totalResources.get());
 
-  return await(futures).then(
-      [usage](const list<Future<ResourceStatistics>>& futures) {
-        // NOTE: We add ResourceUsage::Executor to 'usage' the same
-        // order as we push future to 'futures'. So the variables
-        // 'future' and 'executor' below should be in sync.
-        CHECK_EQ(futures.size(), (size_t) usage->executors_size());
+  // Collect the statistics of all the containers in one batch.
+  return containerizer->batchUsage(containerIds).then(
+      [usage](const hashmap<ContainerID, ResourceStatistics>& statistics) {
+        for (int i = 0; i < usage->executors_size(); i++) {
+          ResourceUsage::Executor* executor = usage->mutable_executors(i);
 
-        size_t i = 0;
-        foreach (const Future<ResourceStatistics>& future, futures) {
-          ResourceUsage::Executor* executor = usage->mutable_executors(i++);
+          Option<ResourceStatistics> statistic =
+            statistics.get(executor->container_id());
 
-          if (future.isReady()) {
-            executor->mutable_statistics()->CopyFrom(future.get());
+          if (statistic.isSome()) {
+            executor->mutable_statistics()->CopyFrom(statistic.get());
           } else {
             LOG(WARNING) << "Failed to get resource statistics for executor '"
                          << executor->executor_info().executor_id() << "'"
                          << " of framework "
-                         << executor->executor_info().framework_id() << ": "
-                         << (future.isFailed() ? future.failure()
-                                               : "discarded");
+                         << executor->executor_info().framework_id();
           }
         }
 
@@ -373,10 +373,15 @@ public:
       const process::Future<std::list<
           mesos::slave::QoSCorrection>>& correction);
 
-  // Returns the resource usage information for all executors.
+  // Returns the resource usage information for all executors. The
+  // result is shared by concurrent callers, see the
+  // '--resource_usage_cache_interval' flag.
   process::Future<ResourceUsage> usage();
 
 private:
+  // Collects the resource usage information for all executors.
+  process::Future<ResourceUsage> _usage();
+
   void _authenticate();
   void authenticationTimeout(process::Future<bool> future);
 
@@ -558,6 +563,11 @@ private:
   // The most recent estimate of the total amount of oversubscribed
   // (allocated and oversubscribable) resources.
   Option<Resources> oversubscribedResources;
+
+  // The most recent (possibly still pending) collection of resource
+  // usage returned by 'usage()' and when it was started.
+  Option<process::Future<ResourceUsage>> resourceUsage;
+  process::Time resourceUsageTime;
 };
 
 
@@ -20,13 +20,18 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <process/pid.hpp>
 
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/format.hpp>
+#include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
@@ -47,9 +52,41 @@ namespace state {
 using std::list;
 using std::string;
 using std::max;
+using std::min;
+using std::vector;
+
+
+// Invokes 'f' once for every index in [0, count) using at most
+// 'threads' threads, including the calling thread. Returns once all
+// the invocations have completed. It is up to 'f' to store its
+// result at the given index; 'f' must be safe to invoke concurrently.
+static void parallel(
+    size_t count,
+    size_t threads,
+    const lambda::function<void(size_t)>& f)
+{
+  std::atomic<size_t> next(0);
+
+  auto worker = [&next, count, &f]() {
+    for (size_t i = next++; i < count; i = next++) {
+      f(i);
+    }
+  };
+
+  vector<std::thread> workers;
+  for (size_t i = 1; i < min(threads, count); i++) {
+    workers.push_back(std::thread(worker));
+  }
+
+  worker();
+
+  foreach (std::thread& thread, workers) {
+    thread.join();
+  }
+}
 
 
-Result<State> recover(const string& rootDir, bool strict)
+Result<State> recover(const string& rootDir, bool strict, size_t threads)
 {
   LOG(INFO) << "Recovering state from '" << rootDir << "'";
 
@@ -110,7 +147,8 @@ Result<State> recover(const string& rootDir, bool strict)
   SlaveID slaveId;
   slaveId.set_value(Path(directory.get()).basename());
 
-  Try<SlaveState> slave = SlaveState::recover(rootDir, slaveId, strict);
+  Try<SlaveState> slave =
+    SlaveState::recover(rootDir, slaveId, strict, max(threads, (size_t) 1));
   if (slave.isError()) {
     return Error(slave.error());
   }
@@ -124,7 +162,8 @@ Result<State> recover(const string& rootDir, bool strict)
 Try<SlaveState> SlaveState::recover(
     const string& rootDir,
     const SlaveID& slaveId,
-    bool strict)
+    bool strict,
+    size_t threads)
 {
   SlaveState state;
   state.id = slaveId;
@@ -169,13 +208,34 @@ Try<SlaveState> SlaveState::recover(
                  ": " + frameworks.error());
   }
 
-  // Recover each of the frameworks.
+  vector<FrameworkID> frameworkIds;
   foreach (const string& path, frameworks.get()) {
     FrameworkID frameworkId;
     frameworkId.set_value(Path(path).basename());
+    frameworkIds.push_back(frameworkId);
+  }
+
+  // Recover the frameworks in parallel. The threads are split between
+  // the frameworks and their executors so that no more than 'threads'
+  // threads are used in total.
+  const size_t executorThreads =
+    max(threads / max(frameworkIds.size(), (size_t) 1), (size_t) 1);
+
+  vector<Option<Try<FrameworkState>>> recovered(frameworkIds.size());
+
+  parallel(frameworkIds.size(), threads, [&](size_t i) {
+    recovered[i] = FrameworkState::recover(
+        rootDir, slaveId, frameworkIds[i], strict, executorThreads);
+  });
 
-    Try<FrameworkState> framework =
-      FrameworkState::recover(rootDir, slaveId, frameworkId, strict);
+  // NOTE: We look at the results in the order in which the frameworks
+  // were found so that the same error is returned as when recovering
+  // the frameworks serially.
+  for (size_t i = 0; i < frameworkIds.size(); i++) {
+    const FrameworkID& frameworkId = frameworkIds[i];
+
+    CHECK_SOME(recovered[i]);
+    const Try<FrameworkState>& framework = recovered[i].get();
 
     if (framework.isError()) {
       return Error("Failed to recover framework " + frameworkId.value() +
@@ -194,7 +254,8 @@ Try<FrameworkState> FrameworkState::recover(
     const string& rootDir,
     const SlaveID& slaveId,
     const FrameworkID& frameworkId,
-    bool strict)
+    bool strict,
+    size_t threads)
 {
   FrameworkState state;
   state.id = frameworkId;
@@ -278,13 +339,29 @@ Try<FrameworkState> FrameworkState::recover(
         ": " + executors.error());
   }
 
-  // Recover the executors.
+  vector<ExecutorID> executorIds;
   foreach (const string& path, executors.get()) {
     ExecutorID executorId;
     executorId.set_value(Path(path).basename());
+    executorIds.push_back(executorId);
+  }
+
+  // Recover the executors in parallel.
+  vector<Option<Try<ExecutorState>>> recovered(executorIds.size());
 
-    Try<ExecutorState> executor =
-      ExecutorState::recover(rootDir, slaveId, frameworkId, executorId, strict);
+  parallel(executorIds.size(), threads, [&](size_t i) {
+    recovered[i] = ExecutorState::recover(
+        rootDir, slaveId, frameworkId, executorIds[i], strict);
+  });
+
+  // NOTE: We look at the results in the order in which the executors
+  // were found so that the same error is returned as when recovering
+  // the executors serially.
+  for (size_t i = 0; i < executorIds.size(); i++) {
+    const ExecutorID& executorId = executorIds[i];
+
+    CHECK_SOME(recovered[i]);
+    const Try<ExecutorState>& executor = recovered[i].get();
 
     if (executor.isError()) {
       return Error("Failed to recover executor '" + executorId.value() +
@@ -322,7 +399,8 @@ Try<ExecutorState> ExecutorState::recover(
                  "': " + runs.error());
   }
 
-  // Recover the runs.
+  // Find the latest run first, so that we know which of the runs
+  // only need to be garbage collected by the slave.
   foreach (const string& path, runs.get()) {
     if (Path(path).basename() == paths::LATEST_SYMLINK) {
       const Result<string>& latest = os::realpath(path);
@@ -339,23 +417,48 @@ Try<ExecutorState> ExecutorState::recover(
       ContainerID containerId;
       containerId.set_value(Path(latest.get()).basename());
       state.latest = containerId;
-    } else {
-      ContainerID containerId;
-      containerId.set_value(Path(path).basename());
+    }
+  }
 
-      Try<RunState> run = RunState::recover(
-          rootDir, slaveId, frameworkId, executorId, containerId, strict);
+  // Recover the runs.
+  foreach (const string& path, runs.get()) {
+    if (Path(path).basename() == paths::LATEST_SYMLINK) {
+      continue;
+    }
 
-      if (run.isError()) {
-        return Error(
-            "Failed to recover run " + containerId.value() +
-            " of executor '" + executorId.value() +
-            "': " + run.error());
-      }
+    ContainerID containerId;
+    containerId.set_value(Path(path).basename());
+
+    // A completed run that is not the latest run is only scheduled
+    // for garbage collection by the slave, so we skip reading its
+    // tasks and status updates.
+    if (state.latest.isSome() &&
+        state.latest.get() != containerId &&
+        os::exists(paths::getExecutorSentinelPath(
+            rootDir, slaveId, frameworkId, executorId, containerId))) {
+      VLOG(1) << "Skipping recovery of completed run " << containerId
+              << " of executor '" << executorId << "'";
+
+      RunState run;
+      run.id = containerId;
+      run.completed = true;
+
+      state.runs[containerId] = run;
+      continue;
+    }
+
+    Try<RunState> run = RunState::recover(
+        rootDir, slaveId, frameworkId, executorId, containerId, strict);
 
-      state.runs[containerId] = run.get();
-      state.errors += run.get().errors;
+    if (run.isError()) {
+      return Error(
+          "Failed to recover run " + containerId.value() +
+          " of executor '" + executorId.value() +
+          "': " + run.error());
     }
+
+    state.runs[containerId] = run.get();
+    state.errors += run.get().errors;
   }
 
   // Find the latest executor.
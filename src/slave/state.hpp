@@ -40,6 +40,8 @@
 
 #include "messages/messages.hpp"
 
+#include "slave/constants.hpp"
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -66,7 +68,17 @@ struct TaskState;
 // includes the 'errors' encountered recursively. In other words,
 // 'State.errors' is the sum total of all recovery errors. If the
 // machine has rebooted since the last slave run, None is returned.
-Result<State> recover(const std::string& rootDir, bool strict);
+//
+// The frameworks and executors are recovered in parallel using at
+// most 'threads' threads. The result (including the first error
+// returned in strict mode) is the same as for a serial recovery.
+// Runs of an executor that are completed and not the latest run are
+// not recovered beyond their ids, since the slave only schedules
+// them for garbage collection.
+Result<State> recover(
+    const std::string& rootDir,
+    bool strict,
+    size_t threads = DEFAULT_RECOVERY_THREADS);
 
 
 namespace internal {
@@ -243,7 +255,8 @@ struct FrameworkState
       const std::string& rootDir,
       const SlaveID& slaveId,
       const FrameworkID& frameworkId,
-      bool strict);
+      bool strict,
+      size_t threads = 1);
 
   FrameworkID id;
   Option<FrameworkInfo> info;
@@ -277,7 +290,8 @@ struct SlaveState
   static Try<SlaveState> recover(
       const std::string& rootDir,
       const SlaveID& slaveId,
-      bool strict);
+      bool strict,
+      size_t threads = 1);
 
   SlaveID id;
   Option<SlaveInfo> info;
@@ -0,0 +1,310 @@
+/**
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <google/protobuf/wire_format_lite.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/multihashmap.hpp>
+#include <stout/option.hpp>
+#include <stout/stringify.hpp>
+
+#include "state/delta.hpp"
+
+using google::protobuf::internal::WireFormatLite;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace state {
+namespace delta {
+
+// The minimum size of a length-delimited field for us to descend into
+// it (if it looks like a message). Smaller fields are copied or
+// included as a whole, which keeps the number of fields to compare
+// (and the number of chunks of a delta) low.
+static const size_t MIN_NESTED_FIELD_SIZE = 1024;
+
+// The maximum depth of the nested messages we descend into.
+static const size_t MAX_NESTED_FIELD_DEPTH = 16;
+
+
+// A range of bytes of a value, e.g., a field or the tag and length of
+// a nested message.
+struct Range
+{
+  Range(size_t _offset, size_t _length) : offset(_offset), length(_length) {}
+
+  size_t offset;
+  size_t length;
+};
+
+
+static bool readVarint(
+    const string& value,
+    size_t end,
+    size_t* position,
+    uint64_t* result)
+{
+  *result = 0;
+
+  for (int shift = 0; shift < 64 && *position < end; shift += 7) {
+    const uint8_t byte = static_cast<uint8_t>(value[(*position)++]);
+
+    *result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+// Splits the message serialized in value[begin, end) into the ranges
+// of its fields, descending into the large length-delimited fields
+// which look like messages themselves. Returns false, without adding
+// any range, if the bytes do not look like a serialized message.
+// NOTE: A 'bytes' or 'string' field might look like a message. This
+// is fine as the ranges are only used to find the bytes which did
+// not change.
+static bool split(
+    const string& value,
+    size_t begin,
+    size_t end,
+    size_t depth,
+    vector<Range>* ranges)
+{
+  const size_t size = ranges->size();
+
+  size_t position = begin;
+
+  while (position < end) {
+    const size_t offset = position;
+
+    uint64_t tag;
+    if (!readVarint(value, end, &position, &tag) ||
+        WireFormatLite::GetTagFieldNumber(tag) == 0) {
+      ranges->erase(ranges->begin() + size, ranges->end());
+      return false;
+    }
+
+    bool valid = true;
+
+    switch (WireFormatLite::GetTagWireType(tag)) {
+      case WireFormatLite::WIRETYPE_VARINT: {
+        uint64_t ignored;
+        valid = readVarint(value, end, &position, &ignored);
+        break;
+      }
+
+      case WireFormatLite::WIRETYPE_FIXED64:
+        position += 8;
+        valid = position <= end;
+        break;
+
+      case WireFormatLite::WIRETYPE_FIXED32:
+        position += 4;
+        valid = position <= end;
+        break;
+
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        uint64_t length;
+        if (!readVarint(value, end, &position, &length) ||
+            length > end - position) {
+          valid = false;
+          break;
+        }
+
+        const size_t nested = position;
+        position += length;
+
+        if (length >= MIN_NESTED_FIELD_SIZE &&
+            depth < MAX_NESTED_FIELD_DEPTH) {
+          // The tag and the length of the field come first.
+          ranges->push_back(Range(offset, nested - offset));
+
+          if (split(value, nested, position, depth + 1, ranges)) {
+            continue;
+          }
+
+          ranges->pop_back();
+        }
+        break;
+      }
+
+      default:
+        // Groups are deprecated, thus we do not expect any.
+        valid = false;
+        break;
+    }
+
+    if (!valid) {
+      ranges->erase(ranges->begin() + size, ranges->end());
+      return false;
+    }
+
+    ranges->push_back(Range(offset, position - offset));
+  }
+
+  return true;
+}
+
+
+static vector<Range> split(const string& value)
+{
+  vector<Range> ranges;
+
+  if (!split(value, 0, value.size(), 0, &ranges)) {
+    ranges.push_back(Range(0, value.size()));
+  }
+
+  return ranges;
+}
+
+
+static size_t hash(const string& value, const Range& range)
+{
+  const char* data = value.data() + range.offset;
+  return boost::hash_range(data, data + range.length);
+}
+
+
+static bool equal(
+    const string& left,
+    const Range& leftRange,
+    const string& right,
+    const Range& rightRange)
+{
+  return leftRange.length == rightRange.length &&
+    memcmp(left.data() + leftRange.offset,
+           right.data() + rightRange.offset,
+           leftRange.length) == 0;
+}
+
+
+Try<Operation::Delta> create(const string& from, const string& to)
+{
+  const vector<Range> before = split(from);
+  const vector<Range> after = split(to);
+
+  // Index the ranges of 'from' by their content.
+  multihashmap<size_t, size_t> index;
+  for (size_t i = 0; i < before.size(); i++) {
+    index.put(hash(from, before[i]), i);
+  }
+
+  Operation::Delta delta;
+  Operation::Delta::Chunk* chunk = NULL;
+
+  // The range of 'from' following the last copied range, which is
+  // most likely to be the next one copied.
+  size_t next = 0;
+
+  foreach (const Range& range, after) {
+    Option<size_t> found = None();
+
+    if (next < before.size() && equal(from, before[next], to, range)) {
+      found = next;
+    } else {
+      foreach (size_t i, index.get(hash(to, range))) {
+        if (equal(from, before[i], to, range)) {
+          found = i;
+          break;
+        }
+      }
+    }
+
+    if (found.isSome()) {
+      const Range& copied = before[found.get()];
+
+      // Extend the last chunk if it copies the preceding bytes.
+      if (chunk != NULL &&
+          !chunk->has_data() &&
+          chunk->offset() + chunk->length() == copied.offset) {
+        chunk->set_length(chunk->length() + copied.length);
+      } else {
+        chunk = delta.add_chunks();
+        chunk->set_offset(copied.offset);
+        chunk->set_length(copied.length);
+      }
+
+      next = found.get() + 1;
+    } else {
+      if (chunk == NULL || !chunk->has_data()) {
+        chunk = delta.add_chunks();
+        chunk->set_data("");
+      }
+
+      chunk->mutable_data()->append(to, range.offset, range.length);
+    }
+  }
+
+  return delta;
+}
+
+
+Try<string> apply(const string& from, const Operation::Delta& delta)
+{
+  size_t size = 0;
+
+  foreach (const Operation::Delta::Chunk& chunk, delta.chunks()) {
+    if (chunk.has_data()) {
+      size += chunk.data().size();
+    } else if (chunk.has_offset() &&
+               chunk.has_length() &&
+               chunk.offset() <= from.size() &&
+               chunk.length() <= from.size() - chunk.offset()) {
+      size += chunk.length();
+    } else {
+      return Error(
+          "Invalid chunk (offset " + stringify(chunk.offset()) +
+          ", length " + stringify(chunk.length()) + ") for a value of " +
+          stringify(from.size()) + " bytes");
+    }
+  }
+
+  string value;
+  value.reserve(size);
+
+  foreach (const Operation::Delta::Chunk& chunk, delta.chunks()) {
+    if (chunk.has_data()) {
+      value.append(chunk.data());
+    } else {
+      value.append(from, chunk.offset(), chunk.length());
+    }
+  }
+
+  return value;
+}
+
+} // namespace delta {
+} // namespace state {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,54 @@
+/**
+* Licensed to the Apache Software Foundation (ASF) under one
+* or more contributor license agreements.  See the NOTICE file
+* distributed with this work for additional information
+* regarding copyright ownership.  The ASF licenses this file
+* to you under the Apache License, Version 2.0 (the
+* "License"); you may not use this file except in compliance
+* with the License.  You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License
+*/
+
+#ifndef __STATE_DELTA_HPP__
+#define __STATE_DELTA_HPP__
+
+#include <string>
+
+#include <stout/try.hpp>
+
+#include "messages/state.hpp"
+
+namespace mesos {
+namespace internal {
+namespace state {
+namespace delta {
+
+// Returns a delta which transforms the value 'from' into the value
+// 'to', where both values are expected to be serialized protocol
+// buffers (e.g., the values of a protobuf::Variable). The values are
+// split along the boundaries of their fields, descending into large
+// nested messages (e.g., into each element of a large repeated
+// field), and the delta copies the fields which did not change from
+// 'from'. Thus, its size is proportional to the size of the change
+// rather than to the size of the values. A value which is not a
+// serialized protocol buffer is still handled, but the delta then
+// includes it as a whole.
+Try<Operation::Delta> create(const std::string& from, const std::string& to);
+
+
+// Returns the value after applying the specified delta to 'from'.
+Try<std::string> apply(const std::string& from, const Operation::Delta& delta);
+
+} // namespace delta {
+} // namespace state {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __STATE_DELTA_HPP__
@@ -45,6 +45,7 @@
 
 #include "log/log.hpp"
 
+#include "state/delta.hpp"
 #include "state/log.hpp"
 
 using namespace mesos::internal::log;
@@ -78,7 +79,7 @@ namespace state {
 class LogStorageProcess : public Process<LogStorageProcess>
 {
 public:
-  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots);
+  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots, bool deltas);
 
   virtual ~LogStorageProcess();
 
@@ -131,6 +132,9 @@ private:
 
   const size_t diffsBetweenSnapshots;
 
+  // Whether to write deltas instead of SVN diffs.
+  const bool deltas;
+
   // Used to serialize Log::Writer::append/truncate operations.
   Mutex mutex;
 
@@ -177,6 +181,26 @@ private:
       return Snapshot(position, entry, diffs + 1);
     }
 
+    // Returns a snapshot after having applied the specified delta.
+    Try<Snapshot> patch(const Operation::Delta& delta) const
+    {
+      if (delta.name() != entry.name()) {
+        return Error("Attempted to patch the wrong snapshot");
+      }
+
+      Try<string> value = delta::apply(entry.value(), delta);
+
+      if (value.isError()) {
+        return Error(value.error());
+      }
+
+      Entry entry(this->entry);
+      entry.set_uuid(delta.uuid());
+      entry.set_value(value.get());
+
+      return Snapshot(position, entry, diffs + 1);
+    }
+
     // Position in the log where this snapshot is located. NOTE: if
     // 'diffs' is greater than 0 this still represents the location of
     // the snapshot, not the last DIFF record in the log.
@@ -216,10 +240,14 @@ private:
 };
 
 
-LogStorageProcess::LogStorageProcess(Log* log, size_t diffsBetweenSnapshots)
+LogStorageProcess::LogStorageProcess(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    bool deltas)
   : reader(log),
     writer(log),
-    diffsBetweenSnapshots(diffsBetweenSnapshots) {}
+    diffsBetweenSnapshots(diffsBetweenSnapshots),
+    deltas(deltas) {}
 
 
 LogStorageProcess::~LogStorageProcess() {}
@@ -347,6 +375,25 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
           break;
         }
 
+        case Operation::DELTA: {
+          CHECK(operation.has_delta());
+
+          Option<Snapshot> snapshot =
+            snapshots.get(operation.delta().name());
+
+          CHECK_SOME(snapshot);
+
+          Try<Snapshot> patched = snapshot.get().patch(operation.delta());
+
+          if (patched.isError()) {
+            return Failure("Failed to apply the delta: " + patched.error());
+          }
+
+          // Replace the snapshot with the patched snapshot.
+          snapshots.put(patched.get().entry.name(), patched.get());
+          break;
+        }
+
         case Operation::EXPUNGE: {
           CHECK(operation.has_expunge());
           snapshots.erase(operation.expunge().name());
@@ -485,37 +532,67 @@ Future<bool> LogStorageProcess::__set(
 
   // Check if we should try to compute a diff.
   if (snapshot.isSome() && snapshot.get().diffs < diffsBetweenSnapshots) {
+    Operation operation;
+
     // Keep metrics for the time to calculate diffs.
     metrics.diff.start();
 
-    // Construct the diff of the last snapshot.
-    Try<svn::Diff> diff = svn::diff(
-        snapshot.get().entry.value(),
-        entry.value());
+    if (deltas) {
+      // Construct the delta of the last snapshot. Unlike an SVN diff,
+      // a delta is computed over the fields of the serialized protocol
+      // buffer, thus its size is proportional to the size of the
+      // change. NOTE: Readers before 0.26.0 can not apply a delta.
+      Try<Operation::Delta> delta = delta::create(
+          snapshot.get().entry.value(),
+          entry.value());
 
-    Duration elapsed = metrics.diff.stop();
+      if (delta.isError()) {
+        metrics.diff.stop();
 
-    if (diff.isError()) {
-      // TODO(benh): Fallback and try and write a whole snapshot?
-      return Failure("Failed to construct diff: " + diff.error());
-    }
+        // TODO(benh): Fallback and try and write a whole snapshot?
+        return Failure("Failed to construct delta: " + delta.error());
+      }
 
-    VLOG(1) << "Created an SVN diff in " << elapsed
-            << " of size " << Bytes(diff.get().data.size()) << " which is "
-            << (diff.get().data.size() / (double) entry.value().size()) * 100.0
-            << "% the original size (" << Bytes(entry.value().size()) << ")";
+      operation.set_type(Operation::DELTA);
+      operation.mutable_delta()->CopyFrom(delta.get());
+      operation.mutable_delta()->set_name(entry.name());
+      operation.mutable_delta()->set_uuid(entry.uuid());
+    } else {
+      // Construct the diff of the last snapshot.
+      Try<svn::Diff> diff = svn::diff(
+          snapshot.get().entry.value(),
+          entry.value());
+
+      if (diff.isError()) {
+        metrics.diff.stop();
+
+        // TODO(benh): Fallback and try and write a whole snapshot?
+        return Failure("Failed to construct diff: " + diff.error());
+      }
 
-    // Only write the diff if it provides a reduction in size.
-    if (diff.get().data.size() < entry.value().size()) {
-      // Append a diff operation.
-      Operation operation;
       operation.set_type(Operation::DIFF);
       operation.mutable_diff()->mutable_entry()->CopyFrom(entry);
       operation.mutable_diff()->mutable_entry()->set_value(diff.get().data);
+    }
+
+    Duration elapsed = metrics.diff.stop();
+
+    const size_t size = deltas
+      ? operation.delta().ByteSize()
+      : operation.diff().entry().value().size();
 
+    VLOG(1) << "Created " << (deltas ? "a delta" : "an SVN diff")
+            << " in " << elapsed << " of size " << Bytes(size) << " which is "
+            << (size / (double) entry.value().size()) * 100.0
+            << "% the original size (" << Bytes(entry.value().size()) << ")";
+
+    // Only write the diff if it provides a reduction in size.
+    if (size < entry.value().size()) {
       string value;
       if (!operation.SerializeToString(&value)) {
-        return Failure("Failed to serialize DIFF Operation");
+        return Failure(
+            "Failed to serialize " + Operation::Type_Name(operation.type()) +
+            " Operation");
       }
 
       return writer.append(value)
@@ -651,9 +728,9 @@ Future<std::set<string> > LogStorageProcess::_names()
 }
 
 
-LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots)
+LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots, bool deltas)
 {
-  process = new LogStorageProcess(log, diffsBetweenSnapshots);
+  process = new LogStorageProcess(log, diffsBetweenSnapshots, deltas);
   spawn(process);
 }
 
@@ -44,7 +44,15 @@ class LogStorageProcess;
 class LogStorage : public Storage
 {
 public:
-  LogStorage(log::Log* log, size_t diffsBetweenSnapshots = 0);
+  // Writes a diff of each update of an entry, up to the specified
+  // number of diffs between two snapshots of the entry. The diffs
+  // are SVN diffs unless 'deltas' is true, in which case they are
+  // deltas over the fields of the stored protocol buffers (see
+  // state/delta.hpp), which can not be read before 0.26.0.
+  LogStorage(
+      log::Log* log,
+      size_t diffsBetweenSnapshots = 0,
+      bool deltas = false);
 
   virtual ~LogStorage();
 
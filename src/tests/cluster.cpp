@@ -397,7 +397,8 @@ Try<process::PID<slave::Slave>> Cluster::Slaves::start(
 
   // Create a garbage collector if one wasn't provided.
   if (gc.isNone()) {
-    slave.gc.reset(new slave::GarbageCollector());
+    slave.gc.reset(
+        new slave::GarbageCollector(flags.gc_workers, flags.gc_removal_rate));
   }
 
   // Create a status update manager if one wasn't provided.
@@ -24,7 +24,9 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <iostream>
 #include <set>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
@@ -47,6 +49,7 @@
 #include <stout/os.hpp>
 #include <stout/path.hpp>
 #include <stout/proc.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
@@ -63,8 +66,14 @@ using namespace process;
 using cgroups::memory::pressure::Level;
 using cgroups::memory::pressure::Counter;
 
+using std::cout;
+using std::endl;
+using std::istringstream;
 using std::set;
 using std::string;
+using std::vector;
+
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -1032,6 +1041,110 @@ TEST_F(CgroupsAnyHierarchyWithPerfEventTest, ROOT_CGROUPS_Perf)
 }
 
 
+// Tests that the in-process perf sampler counts the events of the
+// processes in a cgroup. Only software events are used so that the
+// test also runs where hardware counters are not available.
+TEST_F(CgroupsAnyHierarchyWithPerfEventTest, ROOT_CGROUPS_PerfSampler)
+{
+  string hierarchy = path::join(baseHierarchy, "perf_event");
+  ASSERT_SOME(cgroups::create(hierarchy, TEST_CGROUPS_ROOT));
+
+  Try<Owned<perf::Sampler>> sampler =
+    perf::Sampler::create({"task-clock", "context-switches"});
+
+  ASSERT_SOME(sampler);
+  ASSERT_SOME(sampler.get()->add(hierarchy, TEST_CGROUPS_ROOT));
+
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+
+  if (pid == 0) {
+    // In child process.
+    while (true) {
+      // Don't sleep so there is something to count.
+    }
+
+    ABORT("Child should not reach here");
+  }
+
+  ASSERT_SOME(cgroups::assign(hierarchy, TEST_CGROUPS_ROOT, pid));
+
+  os::sleep(Seconds(1));
+
+  hashmap<string, mesos::PerfStatistics> statistics =
+    sampler.get()->sample();
+
+  ASSERT_TRUE(statistics.contains(TEST_CGROUPS_ROOT));
+  EXPECT_LT(0.0, statistics.at(TEST_CGROUPS_ROOT).duration());
+
+  ASSERT_TRUE(statistics.at(TEST_CGROUPS_ROOT).has_task_clock());
+  EXPECT_LT(0.0, statistics.at(TEST_CGROUPS_ROOT).task_clock());
+
+  EXPECT_TRUE(statistics.at(TEST_CGROUPS_ROOT).has_context_switches());
+
+  // The next sample starts where the previous one ended.
+  const double end =
+    statistics.at(TEST_CGROUPS_ROOT).timestamp() +
+    statistics.at(TEST_CGROUPS_ROOT).duration();
+
+  statistics = sampler.get()->sample();
+
+  ASSERT_TRUE(statistics.contains(TEST_CGROUPS_ROOT));
+  EXPECT_DOUBLE_EQ(end, statistics.at(TEST_CGROUPS_ROOT).timestamp());
+
+  sampler.get()->remove(TEST_CGROUPS_ROOT);
+  EXPECT_TRUE(sampler.get()->sample().empty());
+
+  // Kill the child process.
+  ASSERT_NE(-1, ::kill(pid, SIGKILL));
+
+  int status;
+  EXPECT_NE(-1, ::waitpid(pid, &status, 0));
+
+  AWAIT_READY(cgroups::destroy(hierarchy, TEST_CGROUPS_ROOT));
+}
+
+
+// Tests that the perf sampler does not hold more descriptors than its
+// limit: a cgroup which would exceed it is not sampled until enough
+// descriptors are released.
+TEST_F(CgroupsAnyHierarchyWithPerfEventTest, ROOT_CGROUPS_PerfSamplerLimit)
+{
+  string hierarchy = path::join(baseHierarchy, "perf_event");
+
+  const string cgroup1 = path::join(TEST_CGROUPS_ROOT, "1");
+  const string cgroup2 = path::join(TEST_CGROUPS_ROOT, "2");
+
+  ASSERT_SOME(cgroups::create(hierarchy, cgroup1, true));
+  ASSERT_SOME(cgroups::create(hierarchy, cgroup2, true));
+
+  Try<long> cpus = os::cpus();
+  ASSERT_SOME(cpus);
+
+  // Room for a single cgroup counting one event on every cpu.
+  Try<Owned<perf::Sampler>> sampler =
+    perf::Sampler::create({"task-clock"}, 1 + cpus.get());
+
+  ASSERT_SOME(sampler);
+
+  ASSERT_SOME(sampler.get()->add(hierarchy, cgroup1));
+  EXPECT_ERROR(sampler.get()->add(hierarchy, cgroup2));
+
+  sampler.get()->remove(cgroup1);
+  ASSERT_SOME(sampler.get()->add(hierarchy, cgroup2));
+
+  hashmap<string, mesos::PerfStatistics> statistics =
+    sampler.get()->sample();
+
+  EXPECT_FALSE(statistics.contains(cgroup1));
+  EXPECT_TRUE(statistics.contains(cgroup2));
+
+  sampler.get()->remove(cgroup2);
+
+  AWAIT_READY(cgroups::destroy(hierarchy, TEST_CGROUPS_ROOT));
+}
+
+
 class CgroupsAnyHierarchyMemoryPressureTest
   : public CgroupsAnyHierarchyTest
 {
@@ -1247,6 +1360,228 @@ TEST_F(CgroupsAnyHierarchyWithCpuAcctMemoryTest, ROOT_CGROUPS_CpuAcctsStats)
   AWAIT_READY(cgroups::destroy(hierarchy, TEST_CGROUPS_ROOT));
 }
 
+
+// Control file contents as exposed by a 3.x kernel, used to exercise
+// the parsers without requiring a mounted hierarchy.
+static const char MEMORY_STAT[] =
+  "cache 1466368\n"
+  "rss 4190208\n"
+  "rss_huge 0\n"
+  "mapped_file 552960\n"
+  "writeback 0\n"
+  "swap 0\n"
+  "pgpgin 3162\n"
+  "pgpgout 1778\n"
+  "pgfault 6361\n"
+  "pgmajfault 10\n"
+  "inactive_anon 0\n"
+  "active_anon 4190208\n"
+  "inactive_file 782336\n"
+  "active_file 684032\n"
+  "unevictable 0\n"
+  "hierarchical_memory_limit 33554432\n"
+  "hierarchical_memsw_limit 9223372036854771712\n"
+  "total_cache 1466368\n"
+  "total_rss 4190208\n"
+  "total_rss_huge 0\n"
+  "total_mapped_file 552960\n"
+  "total_writeback 0\n"
+  "total_swap 0\n"
+  "total_pgpgin 3162\n"
+  "total_pgpgout 1778\n"
+  "total_pgfault 6361\n"
+  "total_pgmajfault 10\n"
+  "total_inactive_anon 0\n"
+  "total_active_anon 4190208\n"
+  "total_inactive_file 782336\n"
+  "total_active_file 684032\n"
+  "total_unevictable 0\n";
+
+
+static const char CPU_STAT[] =
+  "nr_periods 1200\n"
+  "nr_throttled 35\n"
+  "throttled_time 2000000000\n";
+
+
+class CgroupsControlTest : public TemporaryDirectoryTest {};
+
+
+// Tests that the stat parsers read the fields of a control file, and
+// that a control kept open picks up the new contents on every read.
+TEST_F(CgroupsControlTest, Stat)
+{
+  const string path = path::join(os::getcwd(), "memory.stat");
+  ASSERT_SOME(os::write(path, MEMORY_STAT));
+
+  Try<Owned<cgroups::Control>> control = cgroups::Control::open(path);
+  ASSERT_SOME(control);
+
+  Try<cgroups::memory::Stats> memory =
+    cgroups::memory::stat(control.get().get());
+
+  ASSERT_SOME(memory);
+  EXPECT_SOME_EQ(4190208u, memory.get().rss);
+  EXPECT_SOME_EQ(4190208u, memory.get().total_rss);
+  EXPECT_SOME_EQ(1466368u, memory.get().total_cache);
+  EXPECT_SOME_EQ(552960u, memory.get().total_mapped_file);
+  EXPECT_SOME_EQ(0u, memory.get().total_swap);
+
+  ASSERT_SOME(os::write(path, "total_rss 8192\n"));
+
+  memory = cgroups::memory::stat(control.get().get());
+
+  ASSERT_SOME(memory);
+  EXPECT_SOME_EQ(8192u, memory.get().total_rss);
+  EXPECT_NONE(memory.get().total_cache);
+
+  ASSERT_SOME(os::write(path, "total_rss -1\n"));
+  EXPECT_ERROR(cgroups::memory::stat(control.get().get()));
+
+  ASSERT_SOME(os::write(path, CPU_STAT));
+
+  Try<cgroups::cpu::Stats> cpu = cgroups::cpu::stat(control.get().get());
+
+  ASSERT_SOME(cpu);
+  EXPECT_SOME_EQ(1200u, cpu.get().nr_periods);
+  EXPECT_SOME_EQ(35u, cpu.get().nr_throttled);
+  EXPECT_SOME_EQ(Seconds(2), cpu.get().throttled_time);
+
+  ASSERT_SOME(os::write(path, "user 100\n"));
+  EXPECT_ERROR(cgroups::cpuacct::stat(control.get().get()));
+
+  ASSERT_SOME(os::write(path, "user 100\nsystem 50\n"));
+  EXPECT_SOME(cgroups::cpuacct::stat(control.get().get()));
+
+  ASSERT_SOME(os::write(path, "33554432\n"));
+
+  Try<Bytes> usage = cgroups::memory::usage_in_bytes(control.get().get());
+  EXPECT_SOME_EQ(Megabytes(32), usage);
+}
+
+
+// Tests that a control is read up to its end, even if its contents
+// do not fit into the initial buffer.
+TEST_F(CgroupsControlTest, Large)
+{
+  const string path = path::join(os::getcwd(), "memory.stat");
+
+  // Pad the fields of interest with unknown fields to well beyond
+  // the initial size of the buffer.
+  string contents;
+  for (int i = 0; i < 2048; i++) {
+    contents += "unknown_" + stringify(i) + " " + stringify(i) + "\n";
+  }
+
+  contents += "total_rss 8192\n";
+
+  ASSERT_SOME(os::write(path, contents));
+
+  Try<Owned<cgroups::Control>> control = cgroups::Control::open(path);
+  ASSERT_SOME(control);
+
+  Try<cgroups::memory::Stats> memory =
+    cgroups::memory::stat(control.get().get());
+
+  ASSERT_SOME(memory);
+  EXPECT_EQ(contents.size(), control.get()->size());
+  EXPECT_SOME_EQ(8192u, memory.get().total_rss);
+
+  // The buffer is reused once the contents shrink again.
+  ASSERT_SOME(os::write(path, "total_rss 4096\n"));
+
+  memory = cgroups::memory::stat(control.get().get());
+
+  ASSERT_SOME(memory);
+  EXPECT_SOME_EQ(4096u, memory.get().total_rss);
+}
+
+
+class CgroupsControl_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t> {};
+
+
+// The control benchmark tests are parameterized by the number of
+// cgroups polled.
+INSTANTIATE_TEST_CASE_P(
+    CgroupCount,
+    CgroupsControl_BENCHMARK_Test,
+    ::testing::Values(100U, 500U, 1000U));
+
+
+// Compares polling 'memory.stat' of synthetic cgroups by reopening
+// the file and parsing it into a hashmap, as cgroups::stat does,
+// against re-reading an open control with cgroups::memory::stat.
+TEST_P(CgroupsControl_BENCHMARK_Test, MemoryStat)
+{
+  const size_t cgroupCount = GetParam();
+  const size_t pollCount = 10;
+
+  vector<string> paths;
+  for (size_t i = 0; i < cgroupCount; i++) {
+    const string cgroup = path::join(os::getcwd(), stringify(i));
+    ASSERT_SOME(os::mkdir(cgroup));
+
+    paths.push_back(path::join(cgroup, "memory.stat"));
+    ASSERT_SOME(os::write(paths.back(), MEMORY_STAT));
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t poll = 0; poll < pollCount; poll++) {
+    foreach (const string& path, paths) {
+      Try<string> read = os::read(path);
+      ASSERT_SOME(read);
+
+      hashmap<string, uint64_t> stat;
+      foreach (const string& line, strings::split(read.get(), "\n")) {
+        if (strings::trim(line).empty()) {
+          continue;
+        }
+
+        string name;
+        uint64_t value;
+
+        istringstream stream(line);
+        stream >> name >> value;
+        ASSERT_FALSE(stream.fail());
+
+        stat[name] = value;
+      }
+
+      ASSERT_TRUE(stat.contains("total_rss"));
+    }
+  }
+
+  cout << "Polled memory.stat of " << cgroupCount << " cgroups "
+       << pollCount << " times by reopening and parsing into a hashmap"
+       << " in " << watch.elapsed() << endl;
+
+  vector<Owned<cgroups::Control>> controls;
+  foreach (const string& path, paths) {
+    Try<Owned<cgroups::Control>> control = cgroups::Control::open(path);
+    ASSERT_SOME(control);
+
+    controls.push_back(control.get());
+  }
+
+  watch.start();
+
+  for (size_t poll = 0; poll < pollCount; poll++) {
+    foreach (const Owned<cgroups::Control>& control, controls) {
+      Try<cgroups::memory::Stats> stat = cgroups::memory::stat(control.get());
+      ASSERT_SOME(stat);
+      ASSERT_SOME(stat.get().total_rss);
+    }
+  }
+
+  cout << "Polled memory.stat of " << cgroupCount << " cgroups "
+       << pollCount << " times by re-reading open controls"
+       << " in " << watch.elapsed() << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
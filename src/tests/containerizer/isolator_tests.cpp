@@ -871,10 +871,8 @@ TEST_F(PerfEventIsolatorTest, ROOT_CGROUPS_Sample)
   EXPECT_TRUE(statistics1.get().perf().has_timestamp());
   EXPECT_TRUE(statistics1.get().perf().has_duration());
 
-  // Wait until we get the next sample. We use a generous timeout of
-  // two seconds because we currently have a one second reap interval;
-  // when running perf with perf_duration of 250ms we won't notice the
-  // exit for up to one second.
+  // Wait until we get the next sample, which is taken every
+  // perf_interval. We use a generous timeout of two seconds.
   ResourceStatistics statistics2;
   Duration waited = Duration::zero();
   do {
@@ -16,9 +16,13 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <iostream>
 #include <list>
 #include <map>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -27,19 +31,30 @@
 
 #include <mesos/slave/isolator.hpp>
 
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
 #include <stout/net.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
+#include <stout/uuid.hpp>
 
 #include "slave/flags.hpp"
 
 #include "slave/containerizer/fetcher.hpp"
 #include "slave/containerizer/launcher.hpp"
+#ifdef __linux__
+#include "slave/containerizer/linux_launcher.hpp"
+#endif // __linux__
 
 #include "slave/containerizer/mesos/containerizer.hpp"
 
+#ifdef __linux__
+#include "linux/cgroups.hpp"
+#include "linux/ns.hpp"
+#endif // __linux__
+
 #include "tests/flags.hpp"
 #include "tests/mesos.hpp"
 #include "tests/utils.hpp"
@@ -53,6 +68,9 @@ using mesos::internal::master::Master;
 
 using mesos::internal::slave::Fetcher;
 using mesos::internal::slave::Launcher;
+#ifdef __linux__
+using mesos::internal::slave::LinuxLauncher;
+#endif // __linux__
 using mesos::internal::slave::MesosContainerizer;
 using mesos::internal::slave::MesosContainerizerProcess;
 using mesos::internal::slave::PosixLauncher;
@@ -68,6 +86,8 @@ using mesos::slave::ContainerPrepareInfo;
 using mesos::slave::ContainerState;
 using mesos::slave::Isolator;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::map;
 using std::string;
@@ -77,6 +97,7 @@ using testing::_;
 using testing::DoAll;
 using testing::Invoke;
 using testing::Return;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -446,13 +467,15 @@ public:
       bool local,
       Fetcher* fetcher,
       const Owned<Launcher>& launcher,
-      const vector<Owned<Isolator>>& isolators)
+      const vector<Owned<Isolator>>& isolators,
+      const vector<string>& types = vector<string>())
     : MesosContainerizerProcess(
           flags,
           local,
           fetcher,
           launcher,
-          isolators)
+          isolators,
+          types)
   {
     // NOTE: See TestContainerizer::setup for why we use
     // 'EXPECT_CALL' and 'WillRepeatedly' here instead of
@@ -673,6 +696,111 @@ TEST_F(MesosContainerizerDestroyTest, DestroyWhilePreparing)
 }
 
 
+// Isolators which do not depend on each other should be prepared
+// concurrently, while the filesystem isolator is prepared before all
+// other isolators. A failure to prepare should fail the launch and
+// the container should only be destroyed after all isolators have
+// finished preparing.
+TEST_F(MesosContainerizerDestroyTest, ConcurrentPrepare)
+{
+  slave::Flags flags = CreateSlaveFlags();
+
+  Try<Launcher*> launcher = PosixLauncher::create(flags);
+  ASSERT_SOME(launcher);
+
+  MockIsolator* filesystem = new MockIsolator();
+  MockIsolator* cpu = new MockIsolator();
+  MockIsolator* mem = new MockIsolator();
+
+  Promise<Option<ContainerPrepareInfo>> filesystemPromise;
+  Promise<Option<ContainerPrepareInfo>> cpuPromise;
+  Promise<Option<ContainerPrepareInfo>> memPromise;
+
+  Future<Nothing> filesystemPrepare;
+  EXPECT_CALL(*filesystem, prepare(_, _, _, _))
+    .WillOnce(DoAll(FutureSatisfy(&filesystemPrepare),
+                    Return(filesystemPromise.future())));
+
+  Future<Nothing> cpuPrepare;
+  EXPECT_CALL(*cpu, prepare(_, _, _, _))
+    .WillOnce(DoAll(FutureSatisfy(&cpuPrepare),
+                    Return(cpuPromise.future())));
+
+  Future<Nothing> memPrepare;
+  EXPECT_CALL(*mem, prepare(_, _, _, _))
+    .WillOnce(DoAll(FutureSatisfy(&memPrepare),
+                    Return(memPromise.future())));
+
+  Fetcher fetcher;
+
+  MockMesosContainerizerProcess* process = new MockMesosContainerizerProcess(
+      flags,
+      true,
+      &fetcher,
+      Owned<Launcher>(launcher.get()),
+      {Owned<Isolator>(filesystem),
+       Owned<Isolator>(cpu),
+       Owned<Isolator>(mem)},
+      {"filesystem/posix", "cgroups/cpu", "cgroups/mem"});
+
+  MesosContainerizer containerizer((Owned<MesosContainerizerProcess>(process)));
+
+  ContainerID containerId;
+  containerId.set_value("test_container");
+
+  TaskInfo taskInfo;
+  CommandInfo commandInfo;
+  taskInfo.mutable_command()->MergeFrom(commandInfo);
+
+  Future<bool> launch = containerizer.launch(
+      containerId,
+      taskInfo,
+      CREATE_EXECUTOR_INFO("executor", "exit 0"),
+      os::getcwd(),
+      None(),
+      SlaveID(),
+      PID<Slave>(),
+      false);
+
+  Future<containerizer::Termination> wait = containerizer.wait(containerId);
+
+  AWAIT_READY(filesystemPrepare);
+
+  // The other isolators must wait for the filesystem isolator.
+  Clock::pause();
+  Clock::settle();
+
+  EXPECT_TRUE(cpuPrepare.isPending());
+  EXPECT_TRUE(memPrepare.isPending());
+
+  Clock::resume();
+
+  filesystemPromise.set(Option<ContainerPrepareInfo>::none());
+
+  // Both runtime isolators are preparing at the same time.
+  AWAIT_READY(cpuPrepare);
+  AWAIT_READY(memPrepare);
+
+  // The launch fails as soon as one isolator fails to prepare.
+  cpuPromise.fail("Failed to prepare");
+
+  AWAIT_FAILED(launch);
+
+  containerizer.destroy(containerId);
+
+  // The container should not be destroyed while 'mem' is preparing.
+  ASSERT_TRUE(wait.isPending());
+
+  memPromise.set(Option<ContainerPrepareInfo>::none());
+
+  AWAIT_READY(wait);
+
+  EXPECT_EQ(
+      "Container destroyed while preparing isolators",
+      wait.get().message());
+}
+
+
 // This action destroys the container using the real launcher and
 // waits until the destroy is complete.
 ACTION_P(InvokeDestroyAndWait, launcher)
@@ -805,6 +933,199 @@ TEST_F(MesosContainerizerRecoverTest, SkipRecoverNonMesosContainers)
   delete containerizer.get();
 }
 
+static int noopSetup()
+{
+  return 0;
+}
+
+
+class PosixLauncher_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t> {};
+
+
+// The amount of resident memory (in MB) of the simulated slave.
+INSTANTIATE_TEST_CASE_P(
+    ResidentMemory,
+    PosixLauncher_BENCHMARK_Test,
+    ::testing::Values(0U, 512U, 2048U));
+
+
+// Measures the latency of launching bursts of containers from a slave
+// with a given amount of resident memory. A launch with a 'setup'
+// function needs a full fork, which copies the page tables of the
+// slave, whereas one without is cloned through 'vclone' on Linux.
+// The containers of a burst are launched concurrently from several
+// threads, each with a launcher of its own.
+TEST_P(PosixLauncher_BENCHMARK_Test, Launch)
+{
+  const size_t megabytes = GetParam();
+  const size_t bursts = 5;
+  const size_t burst = 100;
+  const size_t threads = 4;
+
+  // Simulate a large slave; this touches every page.
+  vector<char> memory(megabytes * 1024 * 1024, 1);
+
+  vector<Owned<Launcher>> launchers;
+  for (size_t i = 0; i < threads; i++) {
+    Try<Launcher*> create = PosixLauncher::create(slave::Flags());
+    ASSERT_SOME(create);
+
+    launchers.push_back(Owned<Launcher>(create.get()));
+  }
+
+  vector<string> argv;
+  argv.push_back("sleep");
+  argv.push_back("1000");
+
+  const Option<lambda::function<int()>> setups[] = {
+    lambda::function<int()>(&noopSetup),
+    None()
+  };
+
+  foreach (const Option<lambda::function<int()>>& setup, setups) {
+    vector<Duration> latencies;
+
+    for (size_t i = 0; i < bursts; i++) {
+      vector<vector<Duration>> _latencies(threads);
+      vector<list<ContainerID>> containerIds(threads);
+      vector<std::thread> workers;
+
+      for (size_t t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&, t]() {
+          for (size_t j = t; j < burst; j += threads) {
+            ContainerID containerId;
+            containerId.set_value(UUID::random().toString());
+
+            Stopwatch watch;
+            watch.start();
+
+            Try<pid_t> pid = launchers[t]->fork(
+                containerId,
+                "/bin/sleep",
+                argv,
+                Subprocess::FD(STDIN_FILENO),
+                Subprocess::FD(STDOUT_FILENO),
+                Subprocess::FD(STDERR_FILENO),
+                None(),
+                None(),
+                setup,
+                None());
+
+            _latencies[t].push_back(watch.elapsed());
+
+            EXPECT_SOME(pid);
+
+            if (pid.isSome()) {
+              containerIds[t].push_back(containerId);
+            }
+          }
+        }));
+      }
+
+      foreach (std::thread& worker, workers) {
+        worker.join();
+      }
+
+      list<Future<Nothing>> destroys;
+      for (size_t t = 0; t < threads; t++) {
+        latencies.insert(
+            latencies.end(), _latencies[t].begin(), _latencies[t].end());
+
+        foreach (const ContainerID& containerId, containerIds[t]) {
+          destroys.push_back(launchers[t]->destroy(containerId));
+        }
+      }
+
+      AWAIT_READY(collect(destroys));
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    cout << "Launched " << latencies.size() << " containers "
+         << (setup.isSome() ? "with fork" : "with vclone")
+         << " in bursts from " << threads << " threads"
+         << " of a slave with " << megabytes << " MB resident memory:"
+         << " p50 " << latencies[latencies.size() / 2]
+         << ", p99 " << latencies[latencies.size() * 99 / 100] << endl;
+  }
+}
+
+
+#ifdef __linux__
+class LinuxLauncherTest
+  : public ContainerizerTest<slave::MesosContainerizer> {};
+
+
+// Verifies that a child launched without a 'setup' function, which
+// the LinuxLauncher clones through 'vclone', ends up in the requested
+// namespaces and in the freezer cgroup of its container.
+TEST_F(LinuxLauncherTest, ROOT_CGROUPS_VcloneNamespaces)
+{
+  slave::Flags flags = CreateSlaveFlags();
+
+  Try<Launcher*> create = LinuxLauncher::create(flags);
+  ASSERT_SOME(create);
+
+  Owned<Launcher> launcher(create.get());
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  vector<string> argv;
+  argv.push_back("sleep");
+  argv.push_back("1000");
+
+  Try<pid_t> pid = launcher->fork(
+      containerId,
+      "/bin/sleep",
+      argv,
+      Subprocess::FD(STDIN_FILENO),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO),
+      None(),
+      None(),
+      None(),
+      CLONE_NEWNS | CLONE_NEWUTS);
+
+  ASSERT_SOME(pid);
+
+  Future<Option<int>> status = process::reap(pid.get());
+
+  // The child has exec'ed by the time 'fork' returns, see 'vclone'.
+  foreach (const string& ns, vector<string>({"mnt", "uts"})) {
+    Try<ino_t> parent = ns::getns(::getpid(), ns);
+    ASSERT_SOME(parent);
+
+    Try<ino_t> child = ns::getns(pid.get(), ns);
+    ASSERT_SOME(child);
+
+    EXPECT_NE(parent.get(), child.get()) << ns;
+  }
+
+  // The namespaces which were not requested are shared.
+  Try<ino_t> parent = ns::getns(::getpid(), "net");
+  ASSERT_SOME(parent);
+
+  Try<ino_t> child = ns::getns(pid.get(), "net");
+  ASSERT_SOME(child);
+
+  EXPECT_EQ(parent.get(), child.get());
+
+  // The child moved itself into the freezer cgroup of the container.
+  Try<std::set<pid_t>> pids = cgroups::processes(
+      path::join(flags.cgroups_hierarchy, "freezer"),
+      path::join(flags.cgroups_root, containerId.value()));
+
+  ASSERT_SOME(pids);
+  EXPECT_EQ(1u, pids.get().count(pid.get()));
+
+  AWAIT_READY(launcher->destroy(containerId));
+  AWAIT_READY(status);
+}
+#endif // __linux__
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
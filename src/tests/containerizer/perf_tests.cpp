@@ -64,6 +64,17 @@ TEST_F(PerfTest, ROOT_Sample)
 }
 
 
+TEST_F(PerfTest, SamplerEvents)
+{
+  // Events without a field in the PerfStatistics protobuf.
+  EXPECT_ERROR(perf::Sampler::create({"invalid-event"}));
+  EXPECT_ERROR(perf::Sampler::create({"cpu-cycles"}));
+
+  // No events.
+  EXPECT_ERROR(perf::Sampler::create({}));
+}
+
+
 TEST_F(PerfTest, Parse)
 {
   // Parse multiple cgroups with uint64 and floats.
@@ -16,13 +16,20 @@
  * limitations under the License.
  */
 
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+#include <iostream>
+
 #include <process/gtest.hpp>
 
 #include <stout/foreach.hpp>
+#include <stout/fs.hpp>
 #include <stout/gtest.hpp>
 #include <stout/os.hpp>
 #include <stout/os/permissions.hpp>
 #include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 
 #include <stout/tests/utils.hpp>
@@ -33,6 +40,8 @@
 
 #include "slave/containerizer/mesos/provisioner/backends/bind.hpp"
 #include "slave/containerizer/mesos/provisioner/backends/copy.hpp"
+#include "slave/containerizer/mesos/provisioner/backends/hardlink.hpp"
+#include "slave/containerizer/mesos/provisioner/backends/overlay.hpp"
 
 #include "tests/flags.hpp"
 
@@ -40,9 +49,13 @@ using namespace process;
 
 using namespace mesos::internal::slave;
 
+using std::cout;
+using std::endl;
 using std::string;
 using std::vector;
 
+using testing::WithParamInterface;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -99,6 +112,81 @@ TEST_F(BindBackendTest, ROOT_BindBackend)
 
   EXPECT_FALSE(os::exists(target));
 }
+
+
+class OverlayBackendTest : public BindBackendTest {};
+
+
+// Provision a rootfs using multiple layers with the overlay backend
+// and verify that writes to the rootfs do not reach the layers.
+TEST_F(OverlayBackendTest, ROOT_OverlayBackend)
+{
+  string layer1 = path::join(os::getcwd(), "source1");
+  ASSERT_SOME(os::mkdir(path::join(layer1, "dir1")));
+  ASSERT_SOME(os::write(path::join(layer1, "dir1", "1"), "1"));
+  ASSERT_SOME(os::write(path::join(layer1, "file"), "test1"));
+
+  string layer2 = path::join(os::getcwd(), "source2");
+  ASSERT_SOME(os::mkdir(path::join(layer2, "dir2")));
+  ASSERT_SOME(os::write(path::join(layer2, "dir2", "2"), "2"));
+  ASSERT_SOME(os::write(path::join(layer2, "file"), "test2"));
+
+  hashmap<string, Owned<Backend>> backends = Backend::create(slave::Flags());
+  ASSERT_TRUE(backends.contains("overlay"));
+
+  // See OverlayBackend for where the upper directory is kept.
+  string rootfs = path::join(os::getcwd(), "rootfses", "rootfs");
+  string scratch = path::join(os::getcwd(), "scratch", "rootfs");
+
+  AWAIT_READY(backends["overlay"]->provision({layer1, layer2}, rootfs));
+
+  EXPECT_SOME_EQ("1", os::read(path::join(rootfs, "dir1", "1")));
+  EXPECT_SOME_EQ("2", os::read(path::join(rootfs, "dir2", "2")));
+
+  // Last layer should overwrite existing file.
+  EXPECT_SOME_EQ("test2", os::read(path::join(rootfs, "file")));
+
+  // Writes go to the upper directory, not to the layers.
+  ASSERT_SOME(os::write(path::join(rootfs, "dir1", "1"), "written"));
+  EXPECT_SOME_EQ("written", os::read(path::join(rootfs, "dir1", "1")));
+  EXPECT_SOME_EQ("1", os::read(path::join(layer1, "dir1", "1")));
+  EXPECT_TRUE(os::exists(scratch));
+
+  AWAIT_EXPECT_EQ(true, backends["overlay"]->destroy(rootfs));
+
+  EXPECT_FALSE(os::exists(rootfs));
+  EXPECT_FALSE(os::exists(scratch));
+  EXPECT_TRUE(os::exists(path::join(layer1, "dir1", "1")));
+}
+
+
+// Verify that the overlay backend removes the directories it created
+// for a rootfs when mounting the rootfs fails.
+TEST_F(OverlayBackendTest, ROOT_OverlayBackendMountFailure)
+{
+  string layer = path::join(os::getcwd(), "source");
+  ASSERT_SOME(os::mkdir(layer));
+
+  hashmap<string, Owned<Backend>> backends = Backend::create(slave::Flags());
+  ASSERT_TRUE(backends.contains("overlay"));
+
+  string rootfs = path::join(os::getcwd(), "rootfses", "rootfs");
+  string scratch = path::join(os::getcwd(), "scratch", "rootfs");
+
+  // Overlayfs refuses to mount a lower directory which does not exist.
+  string missing = path::join(os::getcwd(), "missing");
+
+  AWAIT_FAILED(backends["overlay"]->provision({layer, missing}, rootfs));
+
+  EXPECT_FALSE(os::exists(rootfs));
+  EXPECT_FALSE(os::exists(scratch));
+
+  // The rootfs can be provisioned once the layers are in place.
+  ASSERT_SOME(os::mkdir(missing));
+
+  AWAIT_READY(backends["overlay"]->provision({layer, missing}, rootfs));
+  AWAIT_EXPECT_EQ(true, backends["overlay"]->destroy(rootfs));
+}
 #endif // __linux__
 
 
@@ -149,6 +237,139 @@ TEST_F(CopyBackendTest, ROOT_CopyBackend)
   EXPECT_FALSE(os::exists(rootfs));
 }
 
+class HardlinkBackendTest : public TemporaryDirectoryTest {};
+
+
+// Provision a rootfs using multiple layers with the hardlink backend
+// and verify that the files are shared with the layers.
+TEST_F(HardlinkBackendTest, HardlinkBackend)
+{
+  string layer1 = path::join(os::getcwd(), "source1");
+  ASSERT_SOME(os::mkdir(path::join(layer1, "dir1")));
+  ASSERT_SOME(os::write(path::join(layer1, "dir1", "1"), "1"));
+  ASSERT_SOME(os::write(path::join(layer1, "file"), "test1"));
+  ASSERT_SOME(os::mkdir(path::join(layer1, "replaced")));
+  ASSERT_SOME(::fs::symlink("dir1/1", path::join(layer1, "link")));
+
+  string layer2 = path::join(os::getcwd(), "source2");
+  ASSERT_SOME(os::mkdir(path::join(layer2, "dir1")));
+  ASSERT_SOME(os::write(path::join(layer2, "dir1", "2"), "2"));
+  ASSERT_SOME(os::write(path::join(layer2, "file"), "test2"));
+  ASSERT_SOME(os::write(path::join(layer2, "replaced"), "file"));
+
+  string rootfs = path::join(os::getcwd(), "rootfs");
+
+  hashmap<string, Owned<Backend>> backends = Backend::create(slave::Flags());
+  ASSERT_TRUE(backends.contains("hardlink"));
+
+  AWAIT_READY(backends["hardlink"]->provision({layer1, layer2}, rootfs));
+
+  // Directories of both layers are merged.
+  EXPECT_SOME_EQ("1", os::read(path::join(rootfs, "dir1", "1")));
+  EXPECT_SOME_EQ("2", os::read(path::join(rootfs, "dir1", "2")));
+
+  // Last layer should overwrite existing file (or directory).
+  EXPECT_SOME_EQ("test2", os::read(path::join(rootfs, "file")));
+  EXPECT_SOME_EQ("file", os::read(path::join(rootfs, "replaced")));
+
+  // Symbolic links are linked rather than followed.
+  EXPECT_TRUE(os::stat::islink(path::join(rootfs, "link")));
+  EXPECT_SOME_EQ("1", os::read(path::join(rootfs, "link")));
+
+  // The files are shared with the layers.
+  struct stat source;
+  ASSERT_EQ(0, ::stat(path::join(layer2, "file").c_str(), &source));
+
+  struct stat target;
+  ASSERT_EQ(0, ::stat(path::join(rootfs, "file").c_str(), &target));
+
+  EXPECT_EQ(source.st_ino, target.st_ino);
+
+  AWAIT_EXPECT_EQ(true, backends["hardlink"]->destroy(rootfs));
+
+  EXPECT_FALSE(os::exists(rootfs));
+  EXPECT_SOME_EQ("test2", os::read(path::join(layer2, "file")));
+}
+
+
+class ProvisionerBackend_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<string> {};
+
+
+INSTANTIATE_TEST_CASE_P(
+    Backend,
+    ProvisionerBackend_BENCHMARK_Test,
+    ::testing::Values("copy", "hardlink", "overlay"));
+
+
+// Measures the time and disk space it takes to provision rootfses
+// for a multi-layer image with each backend.
+TEST_P(ProvisionerBackend_BENCHMARK_Test, Provision)
+{
+  const string backend = GetParam();
+
+  hashmap<string, Owned<Backend>> backends = Backend::create(slave::Flags());
+  if (!backends.contains(backend)) {
+    cout << "Backend '" << backend << "' is not available" << endl;
+    return;
+  }
+
+  const size_t layers = 5;
+  const size_t directories = 20;
+  const size_t files = 50;
+  const size_t rootfses = 10;
+
+  // Each layer holds 1000 files of 16KB, i.e., the image is ~80MB.
+  const string data(16 * 1024, 'x');
+
+  vector<string> paths;
+  for (size_t i = 0; i < layers; i++) {
+    string layer = path::join(os::getcwd(), "layers", stringify(i));
+
+    for (size_t j = 0; j < directories; j++) {
+      string directory = path::join(layer, stringify(j));
+      ASSERT_SOME(os::mkdir(directory));
+
+      for (size_t k = 0; k < files; k++) {
+        ASSERT_SOME(os::write(path::join(directory, stringify(k)), data));
+      }
+    }
+
+    paths.push_back(layer);
+  }
+
+  struct statvfs before;
+  ASSERT_EQ(0, ::statvfs(os::getcwd().c_str(), &before));
+
+  Stopwatch watch;
+  watch.start();
+
+  vector<string> provisioned;
+  for (size_t i = 0; i < rootfses; i++) {
+    string rootfs = path::join(os::getcwd(), "rootfses", stringify(i));
+    AWAIT_READY_FOR(backends[backend]->provision(paths, rootfs), Minutes(5));
+    provisioned.push_back(rootfs);
+  }
+
+  watch.stop();
+
+  struct statvfs after;
+  ASSERT_EQ(0, ::statvfs(os::getcwd().c_str(), &after));
+
+  const Bytes used = Bytes(
+      (before.f_bfree - std::min(before.f_bfree, after.f_bfree)) *
+      before.f_frsize);
+
+  cout << "Provisioned " << rootfses << " rootfses of " << layers
+       << " layers with the '" << backend << "' backend in "
+       << watch.elapsed() << " using " << used << " of disk space" << endl;
+
+  foreach (const string& rootfs, provisioned) {
+    AWAIT_READY(backends[backend]->destroy(rootfs));
+  }
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -25,10 +25,12 @@
 #include <stout/json.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
 #include <process/address.hpp>
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/owned.hpp>
@@ -37,6 +39,8 @@
 
 #include <process/ssl/gtest.hpp>
 
+#include "slave/containerizer/mesos/provisioner/docker/local_puller.hpp"
+#include "slave/containerizer/mesos/provisioner/docker/message.hpp"
 #include "slave/containerizer/mesos/provisioner/docker/metadata_manager.hpp"
 #include "slave/containerizer/mesos/provisioner/docker/paths.hpp"
 #include "slave/containerizer/mesos/provisioner/docker/registry_client.hpp"
@@ -47,8 +51,11 @@
 #include "tests/mesos.hpp"
 #include "tests/utils.hpp"
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::map;
+using std::pair;
 using std::string;
 using std::vector;
 
@@ -58,6 +65,8 @@ using process::Owned;
 
 using process::network::Socket;
 
+using testing::WithParamInterface;
+
 using namespace process;
 using namespace mesos::internal::slave;
 using namespace mesos::internal::slave::docker;
@@ -1150,6 +1159,281 @@ TEST_F(ProvisionerDockerLocalStoreTest, MetadataManagerInitialization)
   verifyLocalDockerImage(flags, layers.get());
 }
 
+
+// This test verifies that concurrent pulls of the same image only
+// extract its layers once, and that layers already in the store are
+// not extracted again.
+TEST_F(ProvisionerDockerLocalStoreTest, ConcurrentPull)
+{
+  slave::Flags flags;
+  flags.docker_puller = "local";
+  flags.docker_store_dir = path::join(os::getcwd(), "store");
+  flags.docker_local_archives_dir = path::join(os::getcwd(), "images");
+
+  Try<Owned<slave::Store>> store = slave::docker::Store::create(flags);
+  ASSERT_SOME(store);
+
+  Image image;
+  image.set_type(Image::DOCKER);
+  image.mutable_docker()->set_name("abc");
+
+  Future<vector<string>> layers1 = store.get()->get(image);
+  Future<vector<string>> layers2 = store.get()->get(image);
+
+  AWAIT_READY(layers1);
+  AWAIT_READY(layers2);
+
+  verifyLocalDockerImage(flags, layers1.get());
+  EXPECT_EQ(layers1.get(), layers2.get());
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(
+      2u,
+      metrics.values[
+          "containerizer/mesos/provisioner/docker_store/layer_cache_misses"]);
+  EXPECT_EQ(
+      0u,
+      metrics.values[
+          "containerizer/mesos/provisioner/docker_store/layer_cache_hits"]);
+
+  // Forget about the image but keep its layers in the store.
+  store.get().reset();
+  ASSERT_SOME(os::rm(getStoredImagesPath(flags.docker_store_dir)));
+
+  store = slave::docker::Store::create(flags);
+  ASSERT_SOME(store);
+  AWAIT_READY(store.get()->recover());
+
+  Future<vector<string>> layers3 = store.get()->get(image);
+  AWAIT_READY(layers3);
+
+  verifyLocalDockerImage(flags, layers3.get());
+
+  metrics = Metrics();
+
+  EXPECT_EQ(
+      0u,
+      metrics.values[
+          "containerizer/mesos/provisioner/docker_store/layer_cache_misses"]);
+  EXPECT_EQ(
+      2u,
+      metrics.values[
+          "containerizer/mesos/provisioner/docker_store/layer_cache_hits"]);
+}
+
+
+// This test verifies that pulls sharing a layer being extracted get
+// a rootfs which does not live in the staging directory of the pull
+// that started the extraction, so they are not affected when that
+// pull removes its staging directory (e.g., because it failed).
+TEST_F(ProvisionerDockerLocalStoreTest, PullerCoalescing)
+{
+  slave::Flags flags;
+  flags.docker_puller = "local";
+  flags.docker_store_dir = path::join(os::getcwd(), "store");
+  flags.docker_local_archives_dir = path::join(os::getcwd(), "images");
+
+  ASSERT_SOME(os::mkdir(getStagingDir(flags.docker_store_dir)));
+
+  const string directory1 = path::join(os::getcwd(), "pull1");
+  const string directory2 = path::join(os::getcwd(), "pull2");
+  ASSERT_SOME(os::mkdir(directory1));
+  ASSERT_SOME(os::mkdir(directory2));
+
+  LocalPuller puller(flags);
+
+  const slave::docker::Image::Name name = parseImageName("abc");
+
+  Future<list<pair<string, string>>> layers1 = puller.pull(name, directory1);
+  Future<list<pair<string, string>>> layers2 = puller.pull(name, directory2);
+
+  AWAIT_READY(layers1);
+  AWAIT_READY(layers2);
+
+  // The staging directory of the first pull is removed before the
+  // second pull's layers are moved into the store.
+  ASSERT_SOME(os::rmdir(directory1));
+
+  ASSERT_EQ(2u, layers2.get().size());
+  foreach (const auto& layer, layers2.get()) {
+    EXPECT_EQ(
+        getImageLayerRootfsPath(flags.docker_store_dir, layer.first),
+        layer.second);
+    EXPECT_TRUE(os::exists(layer.second));
+  }
+
+  EXPECT_EQ(layers1.get(), layers2.get());
+
+  // Each layer is extracted only once, whether the second pull found
+  // it being extracted or already in the store.
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(
+      2u,
+      metrics.values[
+          "containerizer/mesos/provisioner/docker_store/layer_cache_misses"]);
+  EXPECT_EQ(
+      2u,
+      metrics.values[
+          "containerizer/mesos/provisioner/docker_store/layer_cache_hits"]);
+
+  // No per-layer staging directory is left behind.
+  Try<list<string>> staging = os::ls(getStagingDir(flags.docker_store_dir));
+  ASSERT_SOME(staging);
+  EXPECT_TRUE(staging.get().empty());
+}
+
+
+class ProvisionerDockerLocalStore_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t>
+{
+protected:
+  // Creates the archive '<directory>/<repository>:latest.tar' of an
+  // image made of the given layers (base layer first), the way
+  // 'docker save' would, each layer holding 'files' files of 16KB.
+  void createImage(
+      const string& directory,
+      const string& repository,
+      const vector<string>& layerIds,
+      size_t files)
+  {
+    const string cwd = os::getcwd();
+    const string image = path::join(directory, repository + ":latest");
+    const string data(16 * 1024, 'x');
+
+    ASSERT_SOME(os::mkdir(image));
+    ASSERT_SOME(os::write(
+        path::join(image, "repositories"),
+        "{\"" + repository + "\": {\"latest\": \"" +
+        layerIds.back() + "\"}}"));
+
+    for (size_t i = 0; i < layerIds.size(); i++) {
+      const string layer = path::join(image, layerIds[i]);
+      const string parent = i == 0 ? "" : layerIds[i - 1];
+
+      ASSERT_SOME(os::mkdir(layer));
+      ASSERT_SOME(os::write(
+          path::join(layer, "json"),
+          "{\"parent\": \"" + parent + "\"}"));
+
+      ASSERT_SOME(os::mkdir(path::join(layer, "layer", layerIds[i])));
+
+      for (size_t j = 0; j < files; j++) {
+        ASSERT_SOME(os::write(
+            path::join(layer, "layer", layerIds[i], stringify(j)), data));
+      }
+
+      ASSERT_SOME(os::chdir(path::join(layer, "layer")));
+      ASSERT_SOME(os::tar(".", "../layer.tar"));
+      ASSERT_SOME(os::chdir(cwd));
+      ASSERT_SOME(os::rmdir(path::join(layer, "layer")));
+    }
+
+    ASSERT_SOME(os::chdir(image));
+    ASSERT_SOME(os::tar(".", "../" + repository + ":latest.tar"));
+    ASSERT_SOME(os::chdir(cwd));
+    ASSERT_SOME(os::rmdir(image));
+  }
+};
+
+
+INSTANTIATE_TEST_CASE_P(
+    Layers,
+    ProvisionerDockerLocalStore_BENCHMARK_Test,
+    ::testing::Values(5U, 20U));
+
+
+// Measures how long it takes the store to pull an image from a local
+// archive directory when the image is not in the store yet (cold),
+// when it is (warm), when all but its top layer are in the store
+// (shared), and when the same image is pulled for many containers at
+// once (concurrent).
+TEST_P(ProvisionerDockerLocalStore_BENCHMARK_Test, Pull)
+{
+  const size_t layers = GetParam();
+  const size_t files = 100;
+  const size_t concurrency = 10;
+
+  const string archives = path::join(os::getcwd(), "images");
+
+  vector<string> base;
+  for (size_t i = 0; i < layers - 1; i++) {
+    base.push_back("base" + stringify(i));
+  }
+
+  vector<string> concurrent;
+  for (size_t i = 0; i < layers; i++) {
+    concurrent.push_back("concurrent" + stringify(i));
+  }
+
+  vector<string> cold = base;
+  cold.push_back("cold");
+
+  vector<string> shared = base;
+  shared.push_back("shared");
+
+  createImage(archives, "cold", cold, files);
+  createImage(archives, "shared", shared, files);
+  createImage(archives, "concurrent", concurrent, files);
+
+  slave::Flags flags;
+  flags.docker_puller = "local";
+  flags.docker_store_dir = path::join(os::getcwd(), "store");
+  flags.docker_local_archives_dir = archives;
+
+  Try<Owned<slave::Store>> store = slave::docker::Store::create(flags);
+  ASSERT_SOME(store);
+
+  Image image;
+  image.set_type(Image::DOCKER);
+
+  Stopwatch watch;
+
+  image.mutable_docker()->set_name("cold");
+
+  watch.start();
+  AWAIT_READY_FOR(store.get()->get(image), Minutes(5));
+  cout << "Cold pull of " << layers << " layers took "
+       << watch.elapsed() << endl;
+
+  watch.start();
+  AWAIT_READY_FOR(store.get()->get(image), Minutes(5));
+  cout << "Warm pull of " << layers << " layers took "
+       << watch.elapsed() << endl;
+
+  image.mutable_docker()->set_name("shared");
+
+  watch.start();
+  AWAIT_READY_FOR(store.get()->get(image), Minutes(5));
+  cout << "Pull of " << layers << " layers sharing " << base.size()
+       << " layers took " << watch.elapsed() << endl;
+
+  image.mutable_docker()->set_name("concurrent");
+
+  list<Future<vector<string>>> futures;
+
+  watch.start();
+  for (size_t i = 0; i < concurrency; i++) {
+    futures.push_back(store.get()->get(image));
+  }
+
+  AWAIT_READY_FOR(collect(futures), Minutes(5));
+  cout << concurrency << " concurrent pulls of " << layers
+       << " layers took " << watch.elapsed() << endl;
+
+  JSON::Object metrics = Metrics();
+
+  cout << "Extracted "
+       << metrics.values[
+           "containerizer/mesos/provisioner/docker_store/layer_cache_misses"]
+       << " layers, found "
+       << metrics.values[
+           "containerizer/mesos/provisioner/docker_store/layer_cache_hits"]
+       << " layers in the store" << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
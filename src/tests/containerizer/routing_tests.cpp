@@ -35,6 +35,7 @@
 #include <stout/ip.hpp>
 #include <stout/mac.hpp>
 #include <stout/net.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
 #include "linux/routing/handle.hpp"
@@ -61,6 +62,7 @@ using namespace routing;
 using namespace routing::filter;
 using namespace routing::queueing;
 
+using std::cout;
 using std::endl;
 using std::set;
 using std::string;
@@ -202,6 +204,21 @@ TEST_F(RoutingTest, LinkStatistics)
   }
 
   EXPECT_NONE(link::statistics("not-exist"));
+
+  // Test that all the links are returned by a single dump.
+  Try<hashmap<string, hashmap<string, uint64_t>>> statistics =
+    link::statistics();
+
+  ASSERT_SOME(statistics);
+  EXPECT_FALSE(statistics.get().contains("not-exist"));
+
+  foreach (const string& link, links.get()) {
+    ASSERT_TRUE(statistics.get().contains(link));
+    EXPECT_TRUE(statistics.get().at(link).contains("rx_packets"));
+    EXPECT_TRUE(statistics.get().at(link).contains("rx_bytes"));
+    EXPECT_TRUE(statistics.get().at(link).contains("tx_packets"));
+    EXPECT_TRUE(statistics.get().at(link).contains("tx_bytes"));
+  }
 }
 
 
@@ -1338,6 +1355,102 @@ TEST_F(RoutingVethTest, ROOT_IPFilterRemove)
 }
 
 
+TEST_F(RoutingVethTest, ROOT_IPFilterBatch)
+{
+  ASSERT_SOME(link::create(TEST_VETH_LINK, TEST_PEER_LINK, None()));
+
+  EXPECT_SOME_TRUE(link::exists(TEST_VETH_LINK));
+  EXPECT_SOME_TRUE(link::exists(TEST_PEER_LINK));
+
+  ASSERT_SOME_TRUE(ingress::create(TEST_VETH_LINK));
+
+  vector<ip::Classifier> classifiers;
+  for (uint16_t port = 1024; port < 1024 + 16 * 8; port += 8) {
+    Try<ip::PortRange> ports = ip::PortRange::fromBeginEnd(port, port + 7);
+    ASSERT_SOME(ports);
+
+    classifiers.push_back(ip::Classifier(None(), None(), ports.get(), None()));
+  }
+
+  // Create the first filter on its own so that the batch below has a
+  // duplicate in it.
+  EXPECT_SOME_TRUE(ip::create(
+      TEST_VETH_LINK,
+      ingress::HANDLE,
+      classifiers[0],
+      Priority(1, 1),
+      action::Redirect(TEST_PEER_LINK)));
+
+  filter::Batch<ip::Classifier> batch(TEST_VETH_LINK, ingress::HANDLE);
+  foreach (const ip::Classifier& classifier, classifiers) {
+    batch.create(
+        classifier,
+        Priority(1, 1),
+        None(),
+        action::Redirect(TEST_PEER_LINK));
+  }
+
+  Try<vector<bool>> results = ip::apply(batch);
+  ASSERT_SOME(results);
+  ASSERT_EQ(classifiers.size(), results.get().size());
+
+  EXPECT_FALSE(results.get()[0]);
+  for (size_t i = 1; i < classifiers.size(); i++) {
+    EXPECT_TRUE(results.get()[i]);
+  }
+
+  foreach (const ip::Classifier& classifier, classifiers) {
+    EXPECT_SOME_TRUE(ip::exists(TEST_VETH_LINK, ingress::HANDLE, classifier));
+  }
+
+  // Remove every other filter, along with one that does not exist.
+  batch = filter::Batch<ip::Classifier>(TEST_VETH_LINK, ingress::HANDLE);
+  for (size_t i = 0; i < classifiers.size(); i += 2) {
+    batch.remove(classifiers[i]);
+  }
+
+  batch.remove(
+      ip::Classifier(None(), None(), None(), classifiers[0].sourcePorts));
+
+  results = ip::apply(batch);
+  ASSERT_SOME(results);
+  ASSERT_EQ(classifiers.size() / 2 + 1, results.get().size());
+
+  for (size_t i = 0; i < classifiers.size() / 2; i++) {
+    EXPECT_TRUE(results.get()[i]);
+  }
+
+  EXPECT_FALSE(results.get().back());
+
+  for (size_t i = 0; i < classifiers.size(); i++) {
+    EXPECT_SOME_EQ(
+        i % 2 == 1,
+        ip::exists(TEST_VETH_LINK, ingress::HANDLE, classifiers[i]));
+  }
+
+  // A batch that fails does not leave any of its filters behind.
+  batch = filter::Batch<ip::Classifier>(TEST_VETH_LINK, ingress::HANDLE);
+  batch.create(
+      classifiers[0],
+      Priority(1, 1),
+      None(),
+      action::Redirect(TEST_PEER_LINK));
+
+  batch.create(
+      classifiers[2],
+      Priority(1, 1),
+      None(),
+      action::Redirect("not-exist"));
+
+  EXPECT_ERROR(ip::apply(batch));
+
+  EXPECT_SOME_FALSE(
+      ip::exists(TEST_VETH_LINK, ingress::HANDLE, classifiers[0]));
+  EXPECT_SOME_FALSE(
+      ip::exists(TEST_VETH_LINK, ingress::HANDLE, classifiers[2]));
+}
+
+
 // Test the workaround introduced for MESOS-1617.
 TEST_F(RoutingVethTest, ROOT_HandleGeneration)
 {
@@ -1411,6 +1524,163 @@ TEST_F(RoutingVethTest, ROOT_HandleGeneration)
   EXPECT_SOME_TRUE(ip::remove(TEST_VETH_LINK, ingress::HANDLE, classifier2));
 }
 
+
+class Routing_BENCHMARK_Test
+  : public RoutingTest,
+    public ::testing::WithParamInterface<size_t>
+{
+protected:
+  virtual void TearDown()
+  {
+    for (size_t i = 0; i < GetParam(); i++) {
+      link::remove(veth(i));
+    }
+  }
+
+  static string veth(size_t i) { return "bench-veth" + stringify(i); }
+  static string peer(size_t i) { return "bench-peer" + stringify(i); }
+};
+
+
+// The number of veth pairs (i.e., containers) on the host.
+INSTANTIATE_TEST_CASE_P(
+    Links,
+    Routing_BENCHMARK_Test,
+    ::testing::Values(10U, 100U, 500U));
+
+
+// Compares sampling the statistics of the host end of every veth
+// pair one link at a time, as the port mapping isolator used to do
+// for each container, against a single dump of all the links.
+TEST_P(Routing_BENCHMARK_Test, ROOT_LinkStatistics)
+{
+  const size_t links = GetParam();
+
+  for (size_t i = 0; i < links; i++) {
+    link::remove(veth(i));
+    ASSERT_SOME_TRUE(link::create(veth(i), peer(i), None()));
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < links; i++) {
+    ASSERT_SOME(link::statistics(veth(i)));
+  }
+
+  Duration elapsed = watch.elapsed();
+
+  cout << "Retrieving the statistics of " << links << " links one at a"
+       << " time took " << elapsed << " (" << elapsed / links
+       << " per link)" << endl;
+
+  watch.start();
+
+  Try<hashmap<string, hashmap<string, uint64_t>>> statistics =
+    link::statistics();
+
+  ASSERT_SOME(statistics);
+
+  for (size_t i = 0; i < links; i++) {
+    ASSERT_TRUE(statistics.get().contains(veth(i)));
+  }
+
+  elapsed = watch.elapsed();
+
+  cout << "Retrieving the statistics of " << links << " links at once"
+       << " took " << elapsed << " (" << elapsed / links
+       << " per link)" << endl;
+}
+
+
+class RoutingFilter_BENCHMARK_Test
+  : public RoutingVethTest,
+    public ::testing::WithParamInterface<size_t> {};
+
+
+// The number of IP packet filters, e.g., one per port range of the
+// containers on the host.
+INSTANTIATE_TEST_CASE_P(
+    Filters,
+    RoutingFilter_BENCHMARK_Test,
+    ::testing::Values(16U, 128U, 1024U));
+
+
+// Compares creating and removing IP packet filters one at a time
+// against doing so in a single batch.
+TEST_P(RoutingFilter_BENCHMARK_Test, ROOT_IPFilters)
+{
+  const size_t filters = GetParam();
+
+  ASSERT_SOME(link::create(TEST_VETH_LINK, TEST_PEER_LINK, None()));
+  ASSERT_SOME_TRUE(ingress::create(TEST_VETH_LINK));
+
+  vector<ip::Classifier> classifiers;
+  for (size_t i = 0; i < filters; i++) {
+    Try<ip::PortRange> ports =
+      ip::PortRange::fromBeginEnd(1024 + i, 1024 + i);
+
+    ASSERT_SOME(ports);
+
+    classifiers.push_back(ip::Classifier(None(), None(), ports.get(), None()));
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (const ip::Classifier& classifier, classifiers) {
+    ASSERT_SOME_TRUE(ip::create(
+        TEST_VETH_LINK,
+        ingress::HANDLE,
+        classifier,
+        Priority(1, 1),
+        action::Redirect(TEST_PEER_LINK)));
+  }
+
+  cout << "Creating " << filters << " IP packet filters one at a time"
+       << " took " << watch.elapsed() << endl;
+
+  watch.start();
+
+  foreach (const ip::Classifier& classifier, classifiers) {
+    ASSERT_SOME_TRUE(ip::remove(TEST_VETH_LINK, ingress::HANDLE, classifier));
+  }
+
+  cout << "Removing " << filters << " IP packet filters one at a time"
+       << " took " << watch.elapsed() << endl;
+
+  filter::Batch<ip::Classifier> creations(TEST_VETH_LINK, ingress::HANDLE);
+  filter::Batch<ip::Classifier> removals(TEST_VETH_LINK, ingress::HANDLE);
+
+  foreach (const ip::Classifier& classifier, classifiers) {
+    creations.create(
+        classifier,
+        Priority(1, 1),
+        None(),
+        action::Redirect(TEST_PEER_LINK));
+
+    removals.remove(classifier);
+  }
+
+  watch.start();
+
+  Try<vector<bool>> results = ip::apply(creations);
+  ASSERT_SOME(results);
+  EXPECT_EQ(vector<bool>(filters, true), results.get());
+
+  cout << "Creating " << filters << " IP packet filters in a batch"
+       << " took " << watch.elapsed() << endl;
+
+  watch.start();
+
+  results = ip::apply(removals);
+  ASSERT_SOME(results);
+  EXPECT_EQ(vector<bool>(filters, true), results.get());
+
+  cout << "Removing " << filters << " IP packet filters in a batch"
+       << " took " << watch.elapsed() << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -16,6 +16,8 @@
  * limitations under the License.
  */
 
+#include <sys/time.h>
+
 #include <string>
 #include <vector>
 
@@ -143,6 +145,94 @@ TEST_F(DiskUsageCollectorTest, SymbolicLink)
 }
 
 
+// This test verifies that hard linked files are only counted once.
+TEST_F(DiskUsageCollectorTest, HardLink)
+{
+  string file = path::join(os::getcwd(), "file");
+  ASSERT_SOME(os::write(file, string(Kilobytes(64).bytes(), 'x')));
+
+  string link = path::join(os::getcwd(), "link");
+  ASSERT_EQ(0, ::link(file.c_str(), link.c_str()));
+
+  DiskUsageCollector collector(Milliseconds(1));
+
+  Future<Bytes> usage = collector.usage(os::getcwd());
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(64));
+  EXPECT_LT(usage.get(), Kilobytes(128));
+}
+
+
+// Sets the modification time of 'path' to the given number of
+// seconds in the past, so that its listing can be cached by the
+// collector (listings modified within the current second are not).
+static void age(const string& path, time_t seconds)
+{
+  const time_t time = ::time(NULL) - seconds;
+
+  struct timeval times[2];
+  times[0].tv_sec = times[1].tv_sec = time;
+  times[0].tv_usec = times[1].tv_usec = 0;
+
+  ASSERT_EQ(0, ::utimes(path.c_str(), times)) << strerror(errno);
+}
+
+
+// This test verifies that subsequent collections pick up files that
+// grow or are added after a directory has been walked, and that they
+// only read the directories which changed.
+TEST_F(DiskUsageCollectorTest, Incremental)
+{
+  string dir = path::join(os::getcwd(), "dir");
+  string file1 = path::join(dir, "file1");
+  string file2 = path::join(dir, "file2");
+
+  ASSERT_SOME(os::mkdir(dir));
+  ASSERT_SOME(os::write(file1, string(Kilobytes(8).bytes(), 'x')));
+
+  age(dir, 60);
+  age(os::getcwd(), 60);
+
+  DiskUsageCollector collector(Milliseconds(1), 2);
+
+  Future<Bytes> usage1 = collector.usage(os::getcwd());
+  AWAIT_READY(usage1);
+
+  EXPECT_GE(usage1.get(), Kilobytes(8));
+
+  Future<uint64_t> reads1 = collector.reads();
+  AWAIT_READY(reads1);
+  EXPECT_LE(2u, reads1.get());
+
+  // Growing a file does not change its directory while adding one
+  // does, so only 'dir' gets read again.
+  ASSERT_SOME(os::write(file1, string(Kilobytes(64).bytes(), 'x')));
+  ASSERT_SOME(os::write(file2, string(Kilobytes(64).bytes(), 'y')));
+
+  age(dir, 30);
+
+  Future<Bytes> usage2 = collector.usage(os::getcwd());
+  AWAIT_READY(usage2);
+
+  EXPECT_GE(usage2.get(), Kilobytes(128));
+
+  Future<uint64_t> reads2 = collector.reads();
+  AWAIT_READY(reads2);
+  EXPECT_EQ(reads1.get() + 1, reads2.get());
+
+  // Nothing changed, so all the cached listings are reused.
+  Future<Bytes> usage3 = collector.usage(os::getcwd());
+  AWAIT_READY(usage3);
+
+  EXPECT_EQ(usage2.get(), usage3.get());
+
+  Future<uint64_t> reads3 = collector.reads();
+  AWAIT_READY(reads3);
+  EXPECT_EQ(reads2.get(), reads3.get());
+}
+
+
 class DiskQuotaTest : public MesosTest {};
 
 
@@ -156,8 +246,8 @@ TEST_F(DiskQuotaTest, DiskUsageExceedsQuota)
   slave::Flags flags = CreateSlaveFlags();
   flags.isolation = "posix/cpu,posix/mem,posix/disk";
 
-  // NOTE: We can't pause the clock because we need the reaper to reap
-  // the 'du' subprocess.
+  // NOTE: We can't pause the clock because the disk usage collector
+  // relies on timers between its collections.
   flags.container_disk_watch_interval = Milliseconds(1);
   flags.enforce_container_disk_quota = true;
 
@@ -223,8 +313,8 @@ TEST_F(DiskQuotaTest, NoQuotaEnforcement)
   slave::Flags flags = CreateSlaveFlags();
   flags.isolation = "posix/cpu,posix/mem,posix/disk";
 
-  // NOTE: We can't pause the clock because we need the reaper to reap
-  // the 'du' subprocess.
+  // NOTE: We can't pause the clock because the disk usage collector
+  // relies on timers between its collections.
   flags.container_disk_watch_interval = Milliseconds(1);
   flags.enforce_container_disk_quota = false;
 
@@ -320,8 +410,8 @@ TEST_F(DiskQuotaTest, ResourceStatistics)
   slave::Flags flags = CreateSlaveFlags();
   flags.isolation = "posix/cpu,posix/mem,posix/disk";
 
-  // NOTE: We can't pause the clock because we need the reaper to reap
-  // the 'du' subprocess.
+  // NOTE: We can't pause the clock because the disk usage collector
+  // relies on timers between its collections.
   flags.container_disk_watch_interval = Milliseconds(1);
 
   Fetcher fetcher;
@@ -497,8 +587,8 @@ TEST_F(DiskQuotaTest, SlaveRecovery)
   // Ensure the slave considers itself recovered.
   Clock::advance(slave::EXECUTOR_REREGISTER_TIMEOUT);
 
-  // NOTE: We resume the clock because we need the reaper to reap the
-  // 'du' subprocess.
+  // NOTE: We resume the clock because the disk usage collector relies
+  // on timers between its collections.
   Clock::resume();
 
   // Wait for the slave to re-register.
@@ -20,8 +20,11 @@
 
 #include <gmock/gmock.h>
 
+#include <cmath>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -40,9 +43,11 @@
 #include <process/queue.hpp>
 #include <process/subprocess.hpp>
 
+#include <stout/json.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/try.hpp>
 
 #include "master/flags.hpp"
@@ -81,6 +86,7 @@ using process::Subprocess;
 using std::cout;
 using std::endl;
 using std::list;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 
@@ -90,6 +96,7 @@ using testing::DoDefault;
 using testing::Eq;
 using testing::Invoke;
 using testing::InvokeWithoutArgs;
+using testing::WithParamInterface;
 using testing::Return;
 
 namespace mesos {
@@ -788,6 +795,64 @@ TEST_F(FetcherCacheTest, LocalCachedExtract)
 }
 
 
+// Tests that archives are extracted into the cache only once, and
+// that the extracted files are hard linked into the sandboxes.
+TEST_F(FetcherCacheTest, LocalCachedExtractHardlink)
+{
+  flags.fetcher_cache_delivery = "hardlink";
+
+  startSlave();
+  driver->start();
+
+  for (size_t i = 0; i < 3; i++) {
+    CommandInfo::URI uri;
+    uri.set_value(archivePath);
+    uri.set_extract(true);
+    uri.set_cache(true);
+
+    CommandInfo commandInfo;
+    commandInfo.set_value("./" + ARCHIVED_COMMAND_NAME + " " + taskName(i));
+    commandInfo.add_uris()->CopyFrom(uri);
+
+    const Try<Task> task = launchTask(commandInfo, i);
+    ASSERT_SOME(task);
+
+    AWAIT_READY(awaitFinished(task.get()));
+
+    EXPECT_FALSE(os::exists(
+        path::join(task.get().runDirectory.value, ARCHIVE_NAME)));
+
+    const string path =
+      path::join(task.get().runDirectory.value, ARCHIVED_COMMAND_NAME);
+    EXPECT_TRUE(isExecutable(path));
+    EXPECT_TRUE(os::exists(path + taskName(i)));
+
+    EXPECT_EQ(1u, fetcherProcess->cacheSize());
+    Try<list<Path>> cacheFiles = fetcherProcess->cacheFiles(slaveId, flags);
+    ASSERT_SOME(cacheFiles);
+    ASSERT_EQ(1u, cacheFiles.get().size());
+
+    // The command in the sandbox is the one extracted in the cache.
+    const string extractedPath = path::join(
+        Fetcher::extractedPath(cacheFiles.get().front().value),
+        ARCHIVED_COMMAND_NAME);
+
+    struct stat cached;
+    ASSERT_EQ(0, ::stat(extractedPath.c_str(), &cached));
+
+    struct stat delivered;
+    ASSERT_EQ(0, ::stat(path.c_str(), &delivered));
+
+    EXPECT_EQ(cached.st_ino, delivered.st_ino);
+  }
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(1u, metrics.values["containerizer/fetcher/cache_misses"]);
+  EXPECT_EQ(2u, metrics.values["containerizer/fetcher/cache_hits"]);
+}
+
+
 class FetcherCacheHttpTest : public FetcherCacheTest
 {
 public:
@@ -1540,6 +1605,348 @@ TEST_F(FetcherCacheTest, RemoveLRUCacheEntries)
   EXPECT_TRUE(cmd2Found);
 }
 
+
+class FetcherCacheEvictionTest : public TemporaryDirectoryTest
+{
+protected:
+  // Fetches the URI through the cache as the fetcher would, without
+  // actually downloading anything. Returns whether it was a hit.
+  bool fetch(
+      FetcherProcess::Cache& cache,
+      const string& uri,
+      const Bytes& size,
+      const Duration& cost = Seconds(1))
+  {
+    if (cache.get(None(), uri).isSome()) {
+      return true;
+    }
+
+    CommandInfo::URI _uri;
+    _uri.set_value(uri);
+
+    shared_ptr<FetcherProcess::Cache::Entry> entry =
+      cache.create(os::getcwd(), None(), _uri);
+
+    EXPECT_SOME(cache.reserve(size));
+
+    cache.claimSpace(size);
+    entry->size = size;
+    entry->complete();
+
+    cache.downloaded(entry, cost);
+    entry->unreference();
+
+    return false;
+  }
+
+  // Returns the keys of the entries that would be evicted first to
+  // make room for the given amount of space.
+  vector<string> victims(FetcherProcess::Cache& cache, const Bytes& space)
+  {
+    Try<list<shared_ptr<FetcherProcess::Cache::Entry>>> victims =
+      cache.selectVictims(space);
+
+    vector<string> keys;
+    if (victims.isSome()) {
+      foreach (const shared_ptr<FetcherProcess::Cache::Entry>& entry,
+               victims.get()) {
+        keys.push_back(entry->key);
+      }
+    }
+
+    return keys;
+  }
+};
+
+
+// Tests that the LFU eviction policy evicts the least frequently
+// fetched entries first, regardless of how recently they were used.
+TEST_F(FetcherCacheEvictionTest, LFU)
+{
+  FetcherProcess::Cache cache;
+  cache.setSpace(Megabytes(3));
+  ASSERT_SOME(cache.initialize("lfu", path::join(os::getcwd(), "usage.json")));
+
+  for (int i = 0; i < 3; i++) {
+    fetch(cache, "a", Megabytes(1));
+  }
+
+  fetch(cache, "b", Megabytes(1));
+
+  for (int i = 0; i < 2; i++) {
+    fetch(cache, "c", Megabytes(1));
+  }
+
+  EXPECT_EQ(vector<string>({"b"}), victims(cache, Megabytes(1)));
+  EXPECT_EQ(vector<string>({"b", "c"}), victims(cache, Megabytes(2)));
+  EXPECT_EQ(vector<string>({"b", "c", "a"}), victims(cache, Megabytes(3)));
+}
+
+
+// Tests that the GDSF eviction policy evicts large entries that were
+// quick to download before small ones that took long, given the same
+// frequency, and that frequency can outweigh size.
+TEST_F(FetcherCacheEvictionTest, GDSF)
+{
+  FetcherProcess::Cache cache;
+  cache.setSpace(Megabytes(8));
+  ASSERT_SOME(cache.initialize("gdsf", path::join(os::getcwd(), "usage.json")));
+
+  fetch(cache, "small", Megabytes(1), Seconds(1));
+  fetch(cache, "large", Megabytes(4), Seconds(1));
+
+  EXPECT_EQ(vector<string>({"large"}), victims(cache, Megabytes(1)));
+
+  // Fetching the large entry more often than it is larger keeps it.
+  for (int i = 0; i < 4; i++) {
+    fetch(cache, "large", Megabytes(4), Seconds(1));
+  }
+
+  EXPECT_EQ(vector<string>({"small"}), victims(cache, Megabytes(1)));
+
+  // A slow download is worth more than a fast one of the same size.
+  fetch(cache, "slow", Megabytes(1), Seconds(10));
+
+  EXPECT_EQ(
+      vector<string>({"small", "large", "slow"}),
+      victims(cache, Megabytes(6)));
+}
+
+
+// Tests that the LFU eviction policy ages out an entry that was
+// fetched often once but is not fetched anymore: every eviction
+// raises the floor that later fetches start from, while the popular
+// entry keeps the priority of its last fetch.
+TEST_F(FetcherCacheEvictionTest, Aging)
+{
+  FetcherProcess::Cache cache;
+  cache.setSpace(Megabytes(2));
+  ASSERT_SOME(cache.initialize("lfu", path::join(os::getcwd(), "usage.json")));
+
+  for (int i = 0; i < 5; i++) {
+    fetch(cache, "popular", Megabytes(1));
+  }
+
+  // Entries that are fetched only once evict each other at first.
+  size_t fetches = 0;
+  for (; fetches < 4; fetches++) {
+    fetch(cache, "once-" + stringify(fetches), Megabytes(1));
+    EXPECT_TRUE(cache.contains(None(), "popular"));
+  }
+
+  // Eventually the floor rises above the popular entry's priority.
+  for (; fetches < 100 && cache.contains(None(), "popular"); fetches++) {
+    fetch(cache, "once-" + stringify(fetches), Megabytes(1));
+  }
+
+  EXPECT_FALSE(cache.contains(None(), "popular"));
+}
+
+
+// Tests that the usage history, including the floor and the
+// priorities, is checkpointed and recovered for the same policy.
+TEST_F(FetcherCacheEvictionTest, Recovery)
+{
+  const string usagePath = path::join(os::getcwd(), "usage.json");
+
+  {
+    FetcherProcess::Cache cache;
+    cache.setSpace(Megabytes(2));
+    ASSERT_SOME(cache.initialize("lfu", usagePath));
+
+    for (int i = 0; i < 3; i++) {
+      fetch(cache, "popular", Megabytes(1));
+    }
+
+    fetch(cache, "once-0", Megabytes(1));
+    fetch(cache, "once-1", Megabytes(1));
+
+    ASSERT_SOME(cache.checkpoint());
+  }
+
+  Try<string> read = os::read(usagePath);
+  ASSERT_SOME(read);
+
+  Try<JSON::Object> object = JSON::parse<JSON::Object>(read.get());
+  ASSERT_SOME(object);
+
+  Result<JSON::Number> floor = object.get().find<JSON::Number>("floor");
+  ASSERT_SOME(floor);
+  EXPECT_EQ(1.0, floor.get().as<double>());
+
+  Result<JSON::Array> usage = object.get().find<JSON::Array>("usage");
+  ASSERT_SOME(usage);
+  EXPECT_EQ(3u, usage.get().values.size());
+
+  foreach (const JSON::Value& value, usage.get().values) {
+    const JSON::Object& entry = value.as<JSON::Object>();
+
+    Result<JSON::String> key = entry.find<JSON::String>("key");
+    Result<JSON::Number> priority = entry.find<JSON::Number>("priority");
+    ASSERT_SOME(key);
+    ASSERT_SOME(priority);
+
+    if (key.get().value == "popular") {
+      EXPECT_EQ(3.0, priority.get().as<double>());
+    } else {
+      EXPECT_EQ(1.0, priority.get().as<double>());
+    }
+  }
+
+  // The cache starts out empty, but the recovered history still
+  // favors the popular entry and entries fetched from now on start
+  // out from the recovered floor.
+  FetcherProcess::Cache cache;
+  cache.setSpace(Megabytes(2));
+  ASSERT_SOME(cache.initialize("lfu", usagePath));
+
+  EXPECT_FALSE(fetch(cache, "popular", Megabytes(1)));
+  EXPECT_FALSE(fetch(cache, "once-2", Megabytes(1)));
+
+  EXPECT_EQ(vector<string>({"once-2"}), victims(cache, Megabytes(1)));
+
+  ASSERT_SOME(cache.checkpoint());
+
+  read = os::read(usagePath);
+  ASSERT_SOME(read);
+
+  object = JSON::parse<JSON::Object>(read.get());
+  ASSERT_SOME(object);
+
+  usage = object.get().find<JSON::Array>("usage");
+  ASSERT_SOME(usage);
+
+  foreach (const JSON::Value& value, usage.get().values) {
+    const JSON::Object& entry = value.as<JSON::Object>();
+
+    Result<JSON::String> key = entry.find<JSON::String>("key");
+    Result<JSON::Number> priority = entry.find<JSON::Number>("priority");
+    ASSERT_SOME(key);
+    ASSERT_SOME(priority);
+
+    if (key.get().value == "popular") {
+      EXPECT_EQ(5.0, priority.get().as<double>());
+    } else if (key.get().value == "once-2") {
+      EXPECT_EQ(2.0, priority.get().as<double>());
+    }
+  }
+}
+
+
+class FetcherCache_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<string> {};
+
+
+INSTANTIATE_TEST_CASE_P(
+    EvictionPolicy,
+    FetcherCache_BENCHMARK_Test,
+    ::testing::Values("lru", "lfu", "gdsf"));
+
+
+// Replays a synthetic trace of fetches against the fetcher cache with
+// the given eviction policy: many small artifacts with a skewed
+// (Zipf-like) popularity, interspersed with large artifacts that are
+// each only fetched once, which displace the small ones under LRU.
+// The cache bookkeeping is exercised as in the fetcher, but no files
+// are actually downloaded.
+TEST_P(FetcherCache_BENCHMARK_Test, Replay)
+{
+  const size_t artifacts = 2000;
+  const size_t accesses = 50000;
+  const size_t largeInterval = 25;
+  const Bytes cacheSize = Gigabytes(2);
+
+  // Estimated download time: latency plus transfer time.
+  const Duration latency = Milliseconds(200);
+  const double bytesPerSecond = Megabytes(50).bytes();
+
+  std::mt19937 generator(42);
+
+  vector<Bytes> sizes;
+  vector<double> weights;
+  for (size_t i = 0; i < artifacts; i++) {
+    sizes.push_back(Megabytes(1 + generator() % 8));
+    weights.push_back(1.0 / std::pow(i + 1, 0.9));
+  }
+
+  std::discrete_distribution<size_t> popularity(
+      weights.begin(), weights.end());
+
+  FetcherProcess::Cache cache;
+  cache.setSpace(cacheSize);
+
+  ASSERT_SOME(cache.initialize(
+      GetParam(),
+      path::join(os::getcwd(), "usage.json")));
+
+  const string directory = os::getcwd();
+
+  size_t hits = 0;
+  Bytes bytes;
+  Bytes hitBytes;
+  Duration saved;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < accesses; i++) {
+    string uri;
+    Bytes size;
+
+    if (i % largeInterval == largeInterval - 1) {
+      uri = "http://artifacts/large-" + stringify(i) + ".tar.gz";
+      size = Megabytes(256 + generator() % 768);
+    } else {
+      const size_t artifact = popularity(generator);
+      uri = "http://artifacts/small-" + stringify(artifact) + ".tar.gz";
+      size = sizes[artifact];
+    }
+
+    const Duration cost =
+      latency +
+      Milliseconds(static_cast<int64_t>(1000 * size.bytes() / bytesPerSecond));
+
+    bytes += size;
+
+    Option<shared_ptr<FetcherProcess::Cache::Entry>> entry =
+      cache.get(None(), uri);
+
+    if (entry.isSome()) {
+      hits++;
+      hitBytes += size;
+      saved += cost;
+      continue;
+    }
+
+    CommandInfo::URI _uri;
+    _uri.set_value(uri);
+
+    shared_ptr<FetcherProcess::Cache::Entry> created =
+      cache.create(directory, None(), _uri);
+
+    ASSERT_SOME(cache.reserve(size));
+
+    cache.claimSpace(size);
+    created->size = size;
+    created->complete();
+
+    cache.downloaded(created, cost);
+    created->unreference();
+  }
+
+  watch.stop();
+
+  ASSERT_SOME(cache.checkpoint());
+
+  cout << "Replaying " << accesses << " fetches with eviction policy '"
+       << GetParam() << "' took " << watch.elapsed()
+       << ", hit ratio " << (100.0 * hits / accesses) << "%"
+       << ", byte hit ratio "
+       << (100.0 * hitBytes.bytes() / bytes.bytes()) << "%"
+       << ", saved fetch time " << saved << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -18,6 +18,8 @@
 
 #include <unistd.h>
 
+#include <iostream>
+#include <list>
 #include <map>
 #include <string>
 
@@ -36,6 +38,7 @@
 #include <stout/os.hpp>
 #include <stout/path.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 
@@ -61,9 +64,14 @@ using mesos::internal::slave::Fetcher;
 using process::Subprocess;
 using process::Future;
 
+using std::cout;
+using std::endl;
+using std::list;
 using std::map;
 using std::string;
 
+using testing::WithParamInterface;
+
 
 namespace mesos {
 namespace internal {
@@ -144,6 +152,69 @@ TEST_F(FetcherTest, InvalidUser)
 }
 
 
+// Tests that resources fetched from the cache for a user are copied
+// rather than hard linked into the sandbox, since the sandbox gets
+// chowned to the user, which would also chown the cache entries.
+TEST_F(FetcherTest, ROOT_HardlinkDeliveryWithUser)
+{
+  string fromDir = path::join(os::getcwd(), "from");
+  ASSERT_SOME(os::mkdir(fromDir));
+  string testFile = path::join(fromDir, "test");
+  EXPECT_SOME(os::write(testFile, "data"));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.fetcher_cache_dir = path::join(os::getcwd(), "cache");
+  flags.fetcher_cache_delivery = "hardlink";
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("file://" + testFile);
+  uri->set_cache(true);
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+  slaveId.set_value(UUID::random().toString());
+
+  // Fetch the same URI twice for each of the users, so that the
+  // second fetch of each user is served from the cache.
+  const string users[] = {"nobody", "root", "nobody", "root"};
+
+  for (size_t i = 0; i < 4; i++) {
+    const string sandbox = path::join(os::getcwd(), "sandbox" + stringify(i));
+    ASSERT_SOME(os::mkdir(sandbox));
+
+    ContainerID containerId;
+    containerId.set_value(UUID::random().toString());
+
+    Future<Nothing> fetch = fetcher.fetch(
+        containerId, commandInfo, sandbox, users[i], slaveId, flags);
+    AWAIT_READY(fetch);
+
+    const string localFile = path::join(sandbox, "test");
+    EXPECT_SOME_EQ("data", os::read(localFile));
+
+    Result<uid_t> uid = os::getuid(users[i]);
+    ASSERT_SOME(uid);
+
+    struct stat s;
+    ASSERT_EQ(0, ::stat(localFile.c_str(), &s));
+
+    // The file is owned by the user and not linked to the cache.
+    EXPECT_EQ(uid.get(), s.st_uid);
+    EXPECT_EQ(1u, s.st_nlink);
+  }
+
+  // The files delivered to the other user did not change hands.
+  struct stat s;
+  ASSERT_EQ(0, ::stat(path::join(os::getcwd(), "sandbox0/test").c_str(), &s));
+
+  Result<uid_t> nobody = os::getuid("nobody");
+  ASSERT_SOME(nobody);
+  EXPECT_EQ(nobody.get(), s.st_uid);
+}
+
+
 // Negative test: URI leading to non-existing file. Copied from FileTest,
 // but here the resource is missing. So we check for fetch failure.
 TEST_F(FetcherTest, NonExistingFile)
@@ -280,9 +351,11 @@ public:
   HttpProcess()
   {
     route("/test", None(), &HttpProcess::test);
+    route("/archive.tar.gz", None(), &HttpProcess::archive);
   }
 
   MOCK_METHOD1(test, Future<http::Response>(const http::Request&));
+  MOCK_METHOD1(archive, Future<http::Response>(const http::Request&));
 };
 
 
@@ -579,6 +652,125 @@ TEST_F(FetcherTest, ExtractGzipFile)
 }
 
 
+// Tests that an archive fetched over HTTP is extracted into the
+// sandbox while it is being downloaded, without being stored there.
+TEST_F(FetcherTest, ExtractWhileDownloading)
+{
+  HttpProcess process;
+
+  spawn(process);
+
+  const network::Address& address = process.self().address;
+
+  process::http::URL url(
+      "http",
+      address.ip,
+      address.port,
+      path::join(process.self().id, "archive.tar.gz"));
+
+  ASSERT_SOME(os::mkdir("archive"));
+  ASSERT_SOME(os::write(path::join("archive", "file"), "hello world"));
+  ASSERT_SOME(os::shell("tar -czf archive.tar.gz archive"));
+  ASSERT_SOME(os::rmdir("archive"));
+
+  Try<string> archive = os::read("archive.tar.gz");
+  ASSERT_SOME(archive);
+  ASSERT_SOME(os::rm("archive.tar.gz"));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value(stringify(url));
+  uri->set_extract(true);
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  EXPECT_CALL(process, archive(_))
+    .WillOnce(Return(http::OK(archive.get())));
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+
+  AWAIT_READY(fetch);
+
+  EXPECT_SOME_EQ("hello world", os::read(path::join("archive", "file")));
+  EXPECT_FALSE(os::exists("archive.tar.gz"));
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Tests that an archive whose download fails while it is extracted
+// into the sandbox does not leave partial output behind.
+TEST_F(FetcherTest, ExtractWhileDownloadingFailure)
+{
+  HttpProcess process;
+
+  spawn(process);
+
+  const network::Address& address = process.self().address;
+
+  process::http::URL url(
+      "http",
+      address.ip,
+      address.port,
+      path::join(process.self().id, "archive.tar.gz"));
+
+  ASSERT_SOME(os::mkdir("archive"));
+  ASSERT_SOME(os::write(path::join("archive", "file"), "hello world"));
+  ASSERT_SOME(os::shell("tar -czf archive.tar.gz archive"));
+  ASSERT_SOME(os::rmdir("archive"));
+
+  Try<string> archive = os::read("archive.tar.gz");
+  ASSERT_SOME(archive);
+  ASSERT_SOME(os::rm("archive.tar.gz"));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value(stringify(url));
+  uri->set_extract(true);
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  // The extractor gets to see a valid archive, but the download
+  // fails due to the status code.
+  EXPECT_CALL(process, archive(_))
+    .WillOnce(Return(http::NotFound(archive.get())));
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+
+  AWAIT_FAILED(fetch);
+
+  EXPECT_FALSE(os::exists("archive"));
+  EXPECT_FALSE(os::exists("archive.tar.gz"));
+
+  Try<list<string>> entries = os::ls(os::getcwd());
+  ASSERT_SOME(entries);
+
+  foreach (const string& entry, entries.get()) {
+    EXPECT_FALSE(strings::startsWith(entry, ".fetch.")) << entry;
+  }
+
+  terminate(process);
+  wait(process);
+}
+
+
 // Tests fetching via the local HDFS client. Since we cannot rely on
 // Hadoop being installed, we use our own mock version that works on
 // the local file system only, but this lets us exercise the exact
@@ -661,6 +853,94 @@ TEST_F(FetcherTest, HdfsURI)
   EXPECT_TRUE(os::exists(localFile));
 }
 
+
+class Fetcher_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t> {};
+
+
+INSTANTIATE_TEST_CASE_P(
+    Megabytes,
+    Fetcher_BENCHMARK_Test,
+    ::testing::Values(16U, 128U));
+
+
+// Compares fetching an archive over HTTP while extracting it with
+// downloading it into the sandbox and extracting it afterwards.
+TEST_P(Fetcher_BENCHMARK_Test, ExtractWhileDownloading)
+{
+  HttpProcess process;
+
+  spawn(process);
+
+  const network::Address& address = process.self().address;
+
+  process::http::URL url(
+      "http",
+      address.ip,
+      address.port,
+      path::join(process.self().id, "archive.tar.gz"));
+
+  // Random data so that the archive is as large as its content.
+  ASSERT_SOME(os::mkdir("archive"));
+  ASSERT_SOME(os::shell(
+      "head -c " + stringify(GetParam()) + "M /dev/urandom > archive/file"));
+  ASSERT_SOME(os::shell("tar -czf archive.tar.gz archive"));
+  ASSERT_SOME(os::rmdir("archive"));
+
+  Try<string> archive = os::read("archive.tar.gz");
+  ASSERT_SOME(archive);
+  ASSERT_SOME(os::rm("archive.tar.gz"));
+
+  EXPECT_CALL(process, archive(_))
+    .WillRepeatedly(Return(http::OK(archive.get())));
+
+  const string twoPhase = path::join(os::getcwd(), "two-phase");
+  ASSERT_SOME(os::mkdir(twoPhase));
+
+  Stopwatch watch;
+  watch.start();
+
+  const string path = path::join(twoPhase, "archive.tar.gz");
+
+  Try<int> download = net::download(stringify(url), path);
+  ASSERT_SOME_EQ(200, download);
+  ASSERT_SOME(os::shell("tar -C '" + twoPhase + "' -xf '" + path + "'"));
+
+  cout << "Downloading and then extracting " << GetParam()
+       << "MB took " << watch.elapsed() << endl;
+
+  const string streaming = path::join(os::getcwd(), "streaming");
+  ASSERT_SOME(os::mkdir(streaming));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value(stringify(url));
+  uri->set_extract(true);
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  watch.start();
+
+  AWAIT_READY_FOR(
+      fetcher.fetch(
+          containerId, commandInfo, streaming, None(), slaveId, flags),
+      Minutes(5));
+
+  cout << "Extracting " << GetParam() << "MB while downloading took "
+       << watch.elapsed() << endl;
+
+  terminate(process);
+  wait(process);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -16,6 +16,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <string>
 
 #include <gmock/gmock.h>
@@ -26,7 +27,9 @@
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
 #include <stout/stringify.hpp>
@@ -41,6 +44,7 @@ using process::http::BadRequest;
 using process::http::NotFound;
 using process::http::OK;
 using process::http::Response;
+using process::http::Status;
 
 using std::string;
 
@@ -49,7 +53,23 @@ namespace internal {
 namespace tests {
 
 
-class FilesTest : public TemporaryDirectoryTest {};
+class FilesTest : public TemporaryDirectoryTest
+{
+protected:
+  // Appends to the file, unlike os::write() which truncates it first
+  // and thereby lets a follower see the file shrink.
+  Try<Nothing> append(const string& path, const string& data)
+  {
+    Try<int> fd = os::open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd.isError()) {
+      return Error(fd.error());
+    }
+
+    Try<Nothing> write = os::write(fd.get(), data);
+    os::close(fd.get());
+    return write;
+  }
+};
 
 
 TEST_F(FilesTest, AttachTest)
@@ -136,6 +156,123 @@ TEST_F(FilesTest, ReadTest)
 }
 
 
+TEST_F(FilesTest, ReadRawTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::write("file", "0123456789"));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  Future<Response> response =
+    process::http::get(upid, "read", "path=myname&format=raw&offset=0");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+
+  response = process::http::get(upid, "read", "path=myname&format=xml");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+
+  // Without a range, the whole file is returned.
+  response = process::http::get(upid, "read", "path=myname&format=raw");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes", "Accept-Ranges", response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("0123456789", response);
+
+  process::http::Headers headers;
+  headers["Range"] = "bytes=2-5";
+
+  response = process::http::get(
+      upid, "read", "path=myname&format=raw", headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Status::string(Status::PARTIAL_CONTENT),
+      response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 2-5/10", "Content-Range", response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("2345", response);
+
+  headers["Range"] = "bytes=-3";
+
+  response = process::http::get(
+      upid, "read", "path=myname&format=raw", headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Status::string(Status::PARTIAL_CONTENT),
+      response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("789", response);
+
+  headers["Range"] = "bytes=10-";
+
+  response = process::http::get(
+      upid, "read", "path=myname&format=raw", headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Status::string(Status::REQUESTED_RANGE_NOT_SATISFIABLE),
+      response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes */10", "Content-Range", response);
+
+  // Following a range beyond the end of the file waits for the file
+  // to grow.
+  response = process::http::get(
+      upid, "read", "path=myname&format=raw&follow=true", headers);
+
+  ASSERT_TRUE(response.isPending());
+
+  ASSERT_SOME(append("file", "abc"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Status::string(Status::PARTIAL_CONTENT),
+      response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("abc", response);
+}
+
+
+TEST_F(FilesTest, ReadFollowTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::write("file", "body"));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  Future<Response> response =
+    process::http::get(upid, "read", "path=myname&follow=true&timeout=hello");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+
+  // Nothing is appended, so the request times out with no data.
+  JSON::Object expected;
+  expected.values["offset"] = 4;
+  expected.values["data"] = "";
+
+  response = process::http::get(
+      upid, "read", "path=myname&offset=4&follow=true&timeout=10ms");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+
+  // Data appended while following is returned.
+  response = process::http::get(
+      upid, "read", "path=myname&offset=4&follow=true");
+
+  ASSERT_TRUE(response.isPending());
+
+  // Changes that do not grow the file leave the request waiting.
+  ASSERT_SOME(os::chmod("file", S_IRUSR | S_IWUSR));
+  os::sleep(Milliseconds(100));
+
+  ASSERT_TRUE(response.isPending());
+
+  ASSERT_SOME(append("file", " and more"));
+
+  expected.values["data"] = " and more";
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+}
+
+
 TEST_F(FilesTest, ResolveTest)
 {
   Files files;
@@ -237,21 +374,36 @@ TEST_F(FilesTest, BrowseTest)
   expected.values.push_back(jsonFileInfo("one/two", s));
 
   Future<Response> response =
-      process::http::get(upid, "browse", "path=one/");
+      process::http::get(upid, "browse", "path=one/&sort=true");
 
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
   AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
 
-  response = process::http::get(upid, "browse", "path=one%2F");
+  response = process::http::get(upid, "browse", "path=one%2F&sort=true");
 
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
   AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
 
-  response = process::http::get(upid, "browse", "path=one");
+  response = process::http::get(upid, "browse", "path=one&sort=true");
 
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
   AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
 
+  // By default the same entries are listed in directory order.
+  response = process::http::get(upid, "browse", "path=one");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Array> unsorted = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(unsorted);
+  ASSERT_EQ(expected.values.size(), unsorted.get().values.size());
+
+  foreach (const JSON::Value& value, unsorted.get().values) {
+    EXPECT_NE(
+        expected.values.end(),
+        std::find(expected.values.begin(), expected.values.end(), value));
+  }
+
   // Empty listing.
   response = process::http::get(upid, "browse", "path=one/2");
 
@@ -265,6 +417,110 @@ TEST_F(FilesTest, BrowseTest)
 }
 
 
+TEST_F(FilesTest, BrowsePaginationTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::mkdir("1/d"));
+  ASSERT_SOME(os::write("1/a", "a"));
+  ASSERT_SOME(os::write("1/b", "b"));
+  ASSERT_SOME(os::write("1/c", "c"));
+
+  AWAIT_EXPECT_READY(files.attach("1", "one"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "browse", "path=one&limit=hello"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "browse", "path=one&sort=hello"));
+
+  // Sorted pages, continued by the cursor.
+  struct stat s;
+  JSON::Array entries;
+  ASSERT_EQ(0, stat("1/a", &s));
+  entries.values.push_back(jsonFileInfo("one/a", s));
+  ASSERT_EQ(0, stat("1/b", &s));
+  entries.values.push_back(jsonFileInfo("one/b", s));
+
+  JSON::Object expected;
+  expected.values["entries"] = entries;
+  expected.values["cursor"] = "b";
+
+  Future<Response> response =
+    process::http::get(upid, "browse", "path=one&limit=2&sort=true");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+
+  entries.values.clear();
+  ASSERT_EQ(0, stat("1/c", &s));
+  entries.values.push_back(jsonFileInfo("one/c", s));
+  ASSERT_EQ(0, stat("1/d", &s));
+  entries.values.push_back(jsonFileInfo("one/d", s));
+
+  expected.values.clear();
+  expected.values["entries"] = entries;
+
+  response = process::http::get(
+      upid, "browse", "path=one&limit=2&sort=true&cursor=b");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+
+  // Unsorted pages without stat'ing entries: all entries are listed
+  // exactly once across pages.
+  hashmap<string, string> listed;
+  Option<string> cursor;
+
+  do {
+    string query = "path=one&limit=3&sort=false&stat=false";
+    if (cursor.isSome()) {
+      query += "&cursor=" + cursor.get();
+    }
+
+    response = process::http::get(upid, "browse", query);
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+    Try<JSON::Object> page = JSON::parse<JSON::Object>(response.get().body);
+    ASSERT_SOME(page);
+
+    Result<JSON::Array> _entries = page.get().find<JSON::Array>("entries");
+    ASSERT_SOME(_entries);
+
+    foreach (const JSON::Value& value, _entries.get().values) {
+      ASSERT_TRUE(value.is<JSON::Object>());
+      const JSON::Object& entry = value.as<JSON::Object>();
+
+      Result<JSON::String> path = entry.find<JSON::String>("path");
+      ASSERT_SOME(path);
+      EXPECT_FALSE(listed.contains(path.get().value));
+
+      Result<JSON::String> type = entry.find<JSON::String>("type");
+      listed[path.get().value] = type.isSome() ? type.get().value : "";
+    }
+
+    Result<JSON::String> next = page.get().find<JSON::String>("cursor");
+    ASSERT_FALSE(next.isError());
+
+    cursor = next.isSome() ? Option<string>(next.get().value) : None();
+  } while (cursor.isSome());
+
+  EXPECT_EQ(4u, listed.size());
+  EXPECT_TRUE(listed.contains("one/a"));
+  EXPECT_TRUE(listed.contains("one/d"));
+
+  // Not all file systems report the type.
+  if (!listed["one/d"].empty()) {
+    EXPECT_EQ("d", listed["one/d"]);
+    EXPECT_EQ("-", listed["one/a"]);
+  }
+}
+
+
 TEST_F(FilesTest, DownloadTest)
 {
   Files files;
@@ -297,6 +553,19 @@ TEST_F(FilesTest, DownloadTest)
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
   AWAIT_EXPECT_RESPONSE_HEADER_EQ("image/gif", "Content-Type", response);
   AWAIT_EXPECT_RESPONSE_BODY_EQ(data, response);
+
+  process::http::Headers headers;
+  headers["Range"] = "bytes=0-5";
+
+  response = process::http::get(upid, "download", "path=black.gif", headers);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Status::string(Status::PARTIAL_CONTENT),
+      response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      "bytes 0-5/" + stringify(data.size()),
+      "Content-Range",
+      response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(data.substr(0, 6), response);
 }
 
 } // namespace tests {
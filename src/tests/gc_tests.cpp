@@ -35,9 +35,13 @@
 #include <process/process.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 
 #include "logging/logging.hpp"
 
@@ -246,6 +250,99 @@ TEST_F(GarbageCollectorTest, Prune)
 }
 
 
+// This test ensures that pruning removes directories on concurrent,
+// throttled workers, and that the removal is reflected in metrics.
+TEST_F(GarbageCollectorTest, PruneThrottled)
+{
+  // At most 200 files and directories per second.
+  GarbageCollector gc(2, 200);
+
+  const size_t directories = 4;
+  const size_t files = 15;
+
+  vector<string> paths;
+  for (size_t i = 0; i < directories; i++) {
+    const string path = "dir" + stringify(i);
+    ASSERT_SOME(os::mkdir(path));
+
+    // Make the directories differ in size.
+    for (size_t j = 0; j < files; j++) {
+      ASSERT_SOME(os::write(
+          path::join(path, "file" + stringify(j)),
+          string(4096 * (i + 1), 'x')));
+    }
+
+    paths.push_back(path);
+  }
+
+  list<Future<Nothing>> schedules;
+  foreach (const string& path, paths) {
+    schedules.push_back(gc.schedule(Seconds(10), path));
+  }
+
+  // Ensure that a missing path fails.
+  Future<Nothing> missing = gc.schedule(Seconds(10), "missing");
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  gc.prune(Seconds(10));
+
+  foreach (const Future<Nothing>& schedule, schedules) {
+    AWAIT_READY(schedule);
+  }
+
+  AWAIT_FAILED(missing);
+
+  // Removing 64 files and directories takes at least a quarter of a
+  // second at 200 per second, allowing for the first 10ms of each
+  // worker (see Throttle).
+  EXPECT_LE(Milliseconds(250), stopwatch.elapsed());
+
+  foreach (const string& path, paths) {
+    EXPECT_FALSE(os::exists(path));
+  }
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(directories, metrics.values["gc/path_removals_succeeded"]);
+  EXPECT_EQ(1u, metrics.values["gc/path_removals_failed"]);
+  EXPECT_EQ(directories * files, metrics.values["gc/files_removed"]);
+  EXPECT_EQ(0u, metrics.values["gc/path_removals_pending"]);
+  EXPECT_EQ(0u, metrics.values["gc/path_removals_active"]);
+}
+
+
+// This test ensures that a path which is due for removal can still
+// be unscheduled while it waits for a worker.
+TEST_F(GarbageCollectorTest, UnscheduleQueued)
+{
+  // A single worker, which takes a while to remove the first path at
+  // 20 files and directories per second.
+  GarbageCollector gc(1, 20);
+
+  ASSERT_SOME(os::mkdir("removed"));
+  for (size_t i = 0; i < 10; i++) {
+    ASSERT_SOME(os::write(path::join("removed", "file" + stringify(i)), ""));
+  }
+
+  ASSERT_SOME(os::mkdir("queued"));
+
+  Future<Nothing> removed = gc.schedule(Seconds(5), "removed");
+  Future<Nothing> queued = gc.schedule(Seconds(10), "queued");
+
+  gc.prune(Seconds(10));
+
+  AWAIT_ASSERT_EQ(true, gc.unschedule("queued"));
+  AWAIT_DISCARDED(queued);
+
+  AWAIT_READY(removed);
+
+  EXPECT_FALSE(os::exists("removed"));
+  EXPECT_TRUE(os::exists("queued"));
+}
+
+
 class GarbageCollectorIntegrationTest : public MesosTest {};
 
 
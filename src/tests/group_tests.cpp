@@ -18,15 +18,22 @@
 
 #include <gmock/gmock.h>
 
+#include <list>
+#include <set>
 #include <string>
+#include <vector>
 
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 
 #include "tests/zookeeper.hpp"
 
@@ -38,7 +45,11 @@ using zookeeper::GroupProcess;
 
 using process::Future;
 
+using std::cout;
+using std::endl;
+using std::list;
 using std::string;
+using std::vector;
 
 using testing::_;
 
@@ -435,6 +446,184 @@ TEST_F(GroupTest, LabelledGroup)
   ASSERT_TRUE(membership.get().cancelled().get());
 }
 
+
+// Verifies that a group watching the memberships of another group
+// learns about memberships joining and leaving incrementally, that the
+// data of several memberships can be fetched at once and that the
+// memberships get reconciled after a session expiration.
+TEST_F(GroupTest, GroupUpdates)
+{
+  Group group1(server->connectString(), NO_TIMEOUT, "/test/");
+  Group group2(server->connectString(), NO_TIMEOUT, "/test/");
+
+  list<Future<Group::Membership> > joins;
+  for (int i = 0; i < 3; i++) {
+    joins.push_back(group1.join("member " + stringify(i)));
+  }
+
+  Future<list<Group::Membership> > joined = collect(joins);
+
+  AWAIT_READY(joined);
+
+  const vector<Group::Membership> owned(
+      joined.get().begin(), joined.get().end());
+
+  // Wait for 'group2' to learn about all the memberships (see the
+  // MultipleGroups test above for why this can take several watches).
+  Future<std::set<Group::Membership> > memberships = group2.watch();
+
+  AWAIT_READY(memberships);
+
+  while (memberships.get().size() < owned.size()) {
+    memberships = group2.watch(memberships.get());
+    AWAIT_READY(memberships);
+  }
+
+  EXPECT_EQ(owned.size(), memberships.get().size());
+
+  list<Future<Option<string> > > datas;
+  foreach (const Group::Membership& membership, owned) {
+    datas.push_back(group2.data(membership));
+  }
+
+  Future<list<Option<string> > > data = collect(datas);
+
+  AWAIT_READY(data);
+
+  int i = 0;
+  foreach (const Option<string>& result, data.get()) {
+    EXPECT_SOME_EQ("member " + stringify(i++), result);
+  }
+
+  // Now cancel the second membership from 'group1' and make sure
+  // 'group2' only sees the others and does not serve stale data.
+  Future<bool> cancelled;
+  foreach (const Group::Membership& membership, memberships.get()) {
+    if (membership == owned[1]) {
+      cancelled = membership.cancelled();
+    }
+  }
+
+  AWAIT_EXPECT_EQ(true, group1.cancel(owned[1]));
+
+  memberships = group2.watch(memberships.get());
+
+  AWAIT_READY(memberships);
+  EXPECT_EQ(2u, memberships.get().size());
+  EXPECT_EQ(1u, memberships.get().count(owned[0]));
+  EXPECT_EQ(0u, memberships.get().count(owned[1]));
+  EXPECT_EQ(1u, memberships.get().count(owned[2]));
+
+  AWAIT_EXPECT_EQ(false, cancelled);
+
+  Future<Option<string> > removed = group2.data(owned[1]);
+
+  AWAIT_READY(removed);
+  EXPECT_NONE(removed.get());
+
+  Future<Option<string> > remaining = group2.data(owned[2]);
+
+  AWAIT_READY(remaining);
+  EXPECT_SOME_EQ("member 2", remaining.get());
+
+  // After a session expiration 'group2' reconciles the memberships
+  // with ZooKeeper.
+  Future<Option<int64_t> > session = group2.session();
+
+  AWAIT_READY(session);
+  ASSERT_SOME(session.get());
+
+  memberships = group2.watch(memberships.get());
+
+  server->expireSession(session.get().get());
+
+  AWAIT_READY(memberships);
+  EXPECT_EQ(0u, memberships.get().size());
+
+  memberships = group2.watch(memberships.get());
+
+  AWAIT_READY(memberships);
+  EXPECT_EQ(2u, memberships.get().size());
+  EXPECT_EQ(1u, memberships.get().count(owned[0]));
+  EXPECT_EQ(1u, memberships.get().count(owned[2]));
+
+  remaining = group2.data(owned[0]);
+
+  AWAIT_READY(remaining);
+  EXPECT_SOME_EQ("member 0", remaining.get());
+}
+
+
+class Group_BENCHMARK_Test
+  : public ZooKeeperTest,
+    public ::testing::WithParamInterface<size_t> {};
+
+
+// The Group benchmark tests are parameterized by the number of
+// memberships.
+INSTANTIATE_TEST_CASE_P(
+    Memberships,
+    Group_BENCHMARK_Test,
+    ::testing::Values(100U, 1000U, 5000U));
+
+
+// Measures how long it takes for a group to learn about memberships
+// joining one after another (i.e., with one listing per change) and to
+// fetch the data of all of them.
+TEST_P(Group_BENCHMARK_Test, WatchAndData)
+{
+  const size_t count = GetParam();
+
+  Group joiner(server->connectString(), NO_TIMEOUT, "/test/");
+  Group watcher(server->connectString(), NO_TIMEOUT, "/test/");
+
+  Future<std::set<Group::Membership> > memberships = watcher.watch();
+
+  AWAIT_READY(memberships);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < count; i++) {
+    joiner.join("member " + stringify(i));
+  }
+
+  while (memberships.get().size() < count) {
+    memberships = watcher.watch(memberships.get());
+    AWAIT_READY_FOR(memberships, Minutes(5));
+  }
+
+  cout << "Watched " << count << " memberships join in "
+       << watch.elapsed() << endl;
+
+  watch.start();
+
+  list<Future<Option<string> > > datas;
+  foreach (const Group::Membership& membership, memberships.get()) {
+    datas.push_back(watcher.data(membership));
+  }
+
+  Future<list<Option<string> > > data = collect(datas);
+  AWAIT_READY_FOR(data, Minutes(5));
+
+  cout << "Fetched the data of " << count << " memberships in "
+       << watch.elapsed() << endl;
+
+  // The data is cached from now on.
+  watch.start();
+
+  datas.clear();
+  foreach (const Group::Membership& membership, memberships.get()) {
+    datas.push_back(watcher.data(membership));
+  }
+
+  data = collect(datas);
+  AWAIT_READY_FOR(data, Minutes(5));
+
+  cout << "Fetched the (cached) data of " << count << " memberships in "
+       << watch.elapsed() << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -34,12 +34,15 @@
 #include <process/protobuf.hpp>
 #include <process/shared.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include <stout/tests/utils.hpp>
@@ -52,6 +55,7 @@
 #include "log/storage.hpp"
 #include "log/recover.hpp"
 #include "log/replica.hpp"
+#include "log/segmented.hpp"
 #include "log/tool/initialize.hpp"
 
 #include "tests/environment.hpp"
@@ -64,6 +68,8 @@ using namespace mesos::internal::log;
 
 using namespace process;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::set;
 using std::string;
@@ -72,6 +78,7 @@ using testing::_;
 using testing::Eq;
 using testing::Invoke;
 using testing::Return;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -130,7 +137,7 @@ template <typename T>
 class LogStorageTest : public TemporaryDirectoryTest {};
 
 
-typedef ::testing::Types<LevelDBStorage> LogStorageTypes;
+typedef ::testing::Types<LevelDBStorage, SegmentedStorage> LogStorageTypes;
 
 
 TYPED_TEST_CASE(LogStorageTest, LogStorageTypes);
@@ -318,15 +325,354 @@ TYPED_TEST(LogStorageTest, TruncateWithManyHoles)
 }
 
 
-class ReplicaTest : public TemporaryDirectoryTest
+TYPED_TEST(LogStorageTest, Restore)
+{
+  const string path = os::getcwd() + "/.log";
+
+  {
+    TypeParam storage;
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    Metadata metadata;
+    metadata.set_status(Metadata::VOTING);
+    metadata.set_promised(2);
+
+    ASSERT_SOME(storage.persist(metadata));
+
+    // Persist positions 1 to 5 one by one, and positions 6 to 10 at
+    // once. Only the even positions are learned.
+    list<Action> actions;
+    for (uint64_t i = 1; i <= 10; i++) {
+      Action action;
+      action.set_position(i);
+      action.set_promised(2);
+      action.set_performed(2);
+      action.set_learned(i % 2 == 0);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(stringify(i));
+
+      if (i <= 5) {
+        ASSERT_SOME(storage.persist(action));
+      } else {
+        actions.push_back(action);
+      }
+    }
+
+    ASSERT_SOME(storage.persist(actions));
+
+    // Learn position 1 (i.e., persist it again).
+    Try<Action> action = storage.read(1);
+    ASSERT_SOME(action);
+
+    action.get().set_learned(true);
+    ASSERT_SOME(storage.persist(action.get()));
+  }
+
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  EXPECT_EQ(Metadata::VOTING, state.get().metadata.status());
+  EXPECT_EQ(2u, state.get().metadata.promised());
+  EXPECT_EQ(0u, state.get().begin);
+  EXPECT_EQ(10u, state.get().end);
+
+  for (uint64_t i = 1; i <= 10; i++) {
+    const bool learned = i == 1 || i % 2 == 0;
+
+    EXPECT_EQ(learned, state.get().learned.contains(i));
+    EXPECT_NE(learned, state.get().unlearned.contains(i));
+
+    Try<Action> action = storage.read(i);
+    ASSERT_SOME(action);
+
+    EXPECT_EQ(i, action.get().position());
+    EXPECT_EQ(learned, action.get().learned());
+    EXPECT_EQ(stringify(i), action.get().append().bytes());
+  }
+}
+
+
+class SegmentedStorageTest : public TemporaryDirectoryTest
 {
 protected:
+  // Returns the segment files of the log at the specified path.
+  list<string> segments(const string& path)
+  {
+    Try<list<string> > entries = os::ls(path);
+    CHECK_SOME(entries);
+
+    list<string> segments;
+    foreach (const string& entry, entries.get()) {
+      if (strings::startsWith(entry, "SEGMENT-")) {
+        segments.push_back(path::join(path, entry));
+      }
+    }
+
+    return segments;
+  }
+};
+
+
+// Tests that a learned truncation deletes the segments which only
+// hold truncated positions, and that the log restores from the
+// remaining segments.
+TEST_F(SegmentedStorageTest, TruncateDeletesSegments)
+{
+  const string path = os::getcwd() + "/.log";
+
+  {
+    // Each segment holds two of the positions below.
+    SegmentedStorage storage(Kilobytes(4));
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    for (uint64_t i = 0; i < 20; i++) {
+      Action action;
+      action.set_position(i);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_learned(true);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(string(1500, 'a' + i));
+
+      ASSERT_SOME(storage.persist(action));
+    }
+
+    EXPECT_EQ(10u, segments(path).size());
+
+    // Truncate to position 12 (at position 20).
+    Action truncate;
+    truncate.set_position(20);
+    truncate.set_promised(1);
+    truncate.set_performed(1);
+    truncate.set_learned(true);
+    truncate.set_type(Action::TRUNCATE);
+    truncate.mutable_truncate()->set_to(12);
+
+    ASSERT_SOME(storage.persist(truncate));
+
+    // The segments of positions 0 to 11 are deleted.
+    EXPECT_EQ(4u, segments(path).size());
+
+    for (uint64_t i = 0; i < 12; i++) {
+      EXPECT_ERROR(storage.read(i));
+    }
+
+    for (uint64_t i = 12; i < 20; i++) {
+      Try<Action> action = storage.read(i);
+      ASSERT_SOME(action);
+      EXPECT_EQ(string(1500, 'a' + i), action.get().append().bytes());
+    }
+  }
+
+  SegmentedStorage storage(Kilobytes(4));
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  EXPECT_EQ(12u, state.get().begin);
+  EXPECT_EQ(20u, state.get().end);
+
+  for (uint64_t i = 12; i <= 20; i++) {
+    EXPECT_TRUE(state.get().learned.contains(i));
+    EXPECT_SOME(storage.read(i));
+  }
+}
+
+
+// Tests that restoring a segment which ends with a torn record (i.e.,
+// a record whose data did not make it to disk) ignores the record,
+// and that the segment is not appended to anymore.
+TEST_F(SegmentedStorageTest, RestoreTornRecord)
+{
+  const string path = os::getcwd() + "/.log";
+
+  {
+    SegmentedStorage storage(Kilobytes(64));
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    for (uint64_t i = 1; i <= 5; i++) {
+      Action action;
+      action.set_position(i);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_learned(true);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(i < 5 ? stringify(i) : "torn");
+
+      ASSERT_SOME(storage.persist(action));
+    }
+  }
+
+  ASSERT_EQ(1u, segments(path).size());
+
+  // Zero the data of the last record, keeping its header.
+  const string segment = segments(path).front();
+
+  Try<string> data = os::read(segment);
+  ASSERT_SOME(data);
+
+  const size_t offset = data.get().find("torn");
+  ASSERT_NE(string::npos, offset);
+
+  string corrupted = data.get();
+  corrupted.replace(offset, 4, 4, '\0');
+
+  ASSERT_SOME(os::write(segment, corrupted));
+
+  {
+    SegmentedStorage storage(Kilobytes(64));
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    EXPECT_EQ(4u, state.get().end);
+    EXPECT_FALSE(state.get().learned.contains(5));
+    EXPECT_FALSE(state.get().unlearned.contains(5));
+    EXPECT_ERROR(storage.read(5));
+
+    for (uint64_t i = 1; i <= 4; i++) {
+      Try<Action> action = storage.read(i);
+      ASSERT_SOME(action);
+      EXPECT_EQ(stringify(i), action.get().append().bytes());
+    }
+
+    // Position 5 is written again to a new segment, since it is not
+    // known where the torn record ends.
+    Action action;
+    action.set_position(5);
+    action.set_promised(1);
+    action.set_performed(1);
+    action.set_learned(true);
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes("5");
+
+    ASSERT_SOME(storage.persist(action));
+
+    EXPECT_EQ(2u, segments(path).size());
+  }
+
+  SegmentedStorage storage(Kilobytes(64));
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  EXPECT_EQ(5u, state.get().end);
+
+  for (uint64_t i = 1; i <= 5; i++) {
+    EXPECT_TRUE(state.get().learned.contains(i));
+
+    Try<Action> action = storage.read(i);
+    ASSERT_SOME(action);
+    EXPECT_EQ(stringify(i), action.get().append().bytes());
+  }
+}
+
+
+class LogStorage_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t>
+{
+protected:
+  // Persists the specified number of (learned) positions with the
+  // given storage and returns the time it takes to restore them.
+  template <typename T>
+  Duration restore(const string& path, size_t positions)
+  {
+    {
+      T storage;
+
+      Try<Storage::State> state = storage.restore(path);
+      CHECK_SOME(state);
+
+      list<Action> actions;
+      for (uint64_t i = 1; i <= positions; i++) {
+        Action action;
+        action.set_position(i);
+        action.set_promised(1);
+        action.set_performed(1);
+        action.set_learned(true);
+        action.set_type(Action::APPEND);
+        action.mutable_append()->set_bytes(string(1024, 'a'));
+
+        actions.push_back(action);
+
+        if (actions.size() == 1000 || i == positions) {
+          CHECK_SOME(storage.persist(actions));
+          actions.clear();
+        }
+      }
+    }
+
+    T storage;
+
+    Stopwatch stopwatch;
+    stopwatch.start();
+
+    Try<Storage::State> state = storage.restore(path);
+    CHECK_SOME(state);
+    CHECK_EQ(positions, state.get().end);
+
+    return stopwatch.elapsed();
+  }
+};
+
+
+// The storage benchmarks are parameterized by the number of positions.
+INSTANTIATE_TEST_CASE_P(
+    Positions,
+    LogStorage_BENCHMARK_Test,
+    ::testing::Values(10000U, 100000U, 500000U));
+
+
+TEST_P(LogStorage_BENCHMARK_Test, Restore)
+{
+  const size_t positions = GetParam();
+
+  cout << "Restoring " << positions << " positions from leveldb took "
+       << restore<LevelDBStorage>(os::getcwd() + "/.leveldb", positions)
+       << endl;
+
+  cout << "Restoring " << positions << " positions from segments took "
+       << restore<SegmentedStorage>(os::getcwd() + "/.segmented", positions)
+       << endl;
+}
+
+
+class ReplicaTest
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<string>
+{
+protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    // The log is created with the storage engine under test, which
+    // the replicas then open it with.
+    initializer.flags.storage = GetParam();
+  }
+
   // For initializing the log.
   tool::Initialize initializer;
 };
 
 
-TEST_F(ReplicaTest, Promise)
+// The tests are parameterized by the storage engine of the log.
+INSTANTIATE_TEST_CASE_P(
+    Storage,
+    ReplicaTest,
+    ::testing::Values("leveldb", "segmented"));
+
+
+TEST_P(ReplicaTest, Promise)
 {
   const string path = os::getcwd() + "/.log";
   initializer.flags.path = path;
@@ -378,7 +724,7 @@ TEST_F(ReplicaTest, Promise)
 }
 
 
-TEST_F(ReplicaTest, Append)
+TEST_P(ReplicaTest, Append)
 {
   const string path = os::getcwd() + "/.log";
   initializer.flags.path = path;
@@ -439,7 +785,123 @@ TEST_F(ReplicaTest, Append)
 }
 
 
-TEST_F(ReplicaTest, Restore)
+TEST_P(ReplicaTest, AppendBatch)
+{
+  const string path = os::getcwd() + "/.log";
+  initializer.flags.path = path;
+  initializer.execute();
+
+  Replica replica(path);
+
+  const uint64_t proposal = 1;
+
+  PromiseRequest request1;
+  request1.set_proposal(proposal);
+
+  Future<PromiseResponse> future1 =
+    protocol::promise(replica.pid(), request1);
+
+  AWAIT_READY(future1);
+  EXPECT_TRUE(future1.get().okay());
+
+  WriteBatchRequest request2;
+  for (uint64_t position = 1; position <= 3; position++) {
+    WriteRequest* write = request2.add_requests();
+    write->set_proposal(proposal);
+    write->set_position(position);
+    write->set_type(Action::APPEND);
+    write->mutable_append()->set_bytes(stringify(position));
+  }
+
+  Future<WriteBatchResponse> future2 =
+    protocol::writeBatch(replica.pid(), request2);
+
+  AWAIT_READY(future2);
+  ASSERT_EQ(3, future2.get().responses_size());
+
+  for (int i = 0; i < future2.get().responses_size(); i++) {
+    const WriteResponse& response = future2.get().responses(i);
+    EXPECT_EQ(WriteResponse::ACCEPT, response.type());
+    EXPECT_EQ(proposal, response.proposal());
+    EXPECT_EQ(i + 1u, response.position());
+  }
+
+  Future<list<Action> > actions = replica.read(1, 3);
+
+  AWAIT_READY(actions);
+  ASSERT_EQ(3u, actions.get().size());
+
+  foreach (const Action& action, actions.get()) {
+    EXPECT_EQ(proposal, action.performed());
+    EXPECT_FALSE(action.has_learned());
+    EXPECT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+
+  // A batch with a stale proposal is rejected as a whole.
+  WriteBatchRequest request3;
+  WriteRequest* write = request3.add_requests();
+  write->set_proposal(proposal - 1);
+  write->set_position(4);
+  write->set_type(Action::NOP);
+  write->mutable_nop();
+
+  Future<WriteBatchResponse> future3 =
+    protocol::writeBatch(replica.pid(), request3);
+
+  AWAIT_READY(future3);
+  ASSERT_EQ(1, future3.get().responses_size());
+  EXPECT_EQ(WriteResponse::REJECT, future3.get().responses(0).type());
+  EXPECT_EQ(proposal, future3.get().responses(0).proposal());
+}
+
+
+// Tests that a replica opens an existing log with the storage engine
+// it was initialized with.
+TEST_P(ReplicaTest, SegmentedStorage)
+{
+  const string path = os::getcwd() + "/.log";
+  initializer.flags.path = path;
+  initializer.flags.storage = "segmented";
+  initializer.execute();
+
+  EXPECT_TRUE(SegmentedStorage::exists(path));
+
+  Replica replica(path);
+
+  Future<Metadata::Status> status = replica.status();
+  AWAIT_EXPECT_EQ(Metadata::VOTING, status);
+
+  PromiseRequest request1;
+  request1.set_proposal(1);
+
+  Future<PromiseResponse> future1 =
+    protocol::promise(replica.pid(), request1);
+
+  AWAIT_READY(future1);
+  EXPECT_TRUE(future1.get().okay());
+
+  WriteRequest request2;
+  request2.set_proposal(1);
+  request2.set_position(1);
+  request2.set_type(Action::APPEND);
+  request2.mutable_append()->set_bytes("hello world");
+
+  Future<WriteResponse> future2 =
+    protocol::write(replica.pid(), request2);
+
+  AWAIT_READY(future2);
+  EXPECT_TRUE(future2.get().okay());
+
+  Future<list<Action> > actions = replica.read(1, 1);
+
+  AWAIT_READY(actions);
+  ASSERT_EQ(1u, actions.get().size());
+  EXPECT_EQ("hello world", actions.get().front().append().bytes());
+}
+
+
+TEST_P(ReplicaTest, Restore)
 {
   const string path = os::getcwd() + "/.log";
   initializer.flags.path = path;
@@ -526,11 +988,11 @@ TEST_F(ReplicaTest, Restore)
 
 // This test verifies that a non-VOTING replica replies to promise and
 // write requests with an "ignored" response.
-TEST_F(ReplicaTest, NonVoting)
+TEST_P(ReplicaTest, NonVoting)
 {
   const string path = os::getcwd() + "/.log";
 
-  Replica replica(path);
+  Replica replica(path, GetParam());
 
   PromiseRequest promiseRequest;
   promiseRequest.set_proposal(2);
@@ -562,15 +1024,33 @@ TEST_F(ReplicaTest, NonVoting)
 }
 
 
-class CoordinatorTest : public TemporaryDirectoryTest
+class CoordinatorTest
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<string>
 {
 protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    // The log is created with the storage engine under test, which
+    // the replicas then open it with.
+    initializer.flags.storage = GetParam();
+  }
+
   // For initializing the log.
   tool::Initialize initializer;
 };
 
 
-TEST_F(CoordinatorTest, Elect)
+// The tests are parameterized by the storage engine of the log.
+INSTANTIATE_TEST_CASE_P(
+    Storage,
+    CoordinatorTest,
+    ::testing::Values("leveldb", "segmented"));
+
+
+TEST_P(CoordinatorTest, Elect)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -610,7 +1090,7 @@ TEST_F(CoordinatorTest, Elect)
 
 // Verifies that a coordinator can get elected with clock paused (no
 // retry involved) for an empty log.
-TEST_F(CoordinatorTest, ElectWithClockPaused)
+TEST_P(CoordinatorTest, ElectWithClockPaused)
 {
   Clock::pause();
 
@@ -643,7 +1123,7 @@ TEST_F(CoordinatorTest, ElectWithClockPaused)
 }
 
 
-TEST_F(CoordinatorTest, AppendRead)
+TEST_P(CoordinatorTest, AppendRead)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -692,7 +1172,7 @@ TEST_F(CoordinatorTest, AppendRead)
 }
 
 
-TEST_F(CoordinatorTest, AppendReadError)
+TEST_P(CoordinatorTest, AppendReadError)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -738,7 +1218,7 @@ TEST_F(CoordinatorTest, AppendReadError)
 }
 
 
-TEST_F(CoordinatorTest, AppendDiscarded)
+TEST_P(CoordinatorTest, AppendDiscarded)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -787,7 +1267,7 @@ TEST_F(CoordinatorTest, AppendDiscarded)
 }
 
 
-TEST_F(CoordinatorTest, ElectNoQuorum)
+TEST_P(CoordinatorTest, ElectNoQuorum)
 {
   const string path = os::getcwd() + "/.log";
   initializer.flags.path = path;
@@ -815,7 +1295,7 @@ TEST_F(CoordinatorTest, ElectNoQuorum)
 }
 
 
-TEST_F(CoordinatorTest, AppendNoQuorum)
+TEST_P(CoordinatorTest, AppendNoQuorum)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -859,7 +1339,7 @@ TEST_F(CoordinatorTest, AppendNoQuorum)
 }
 
 
-TEST_F(CoordinatorTest, Failover)
+TEST_P(CoordinatorTest, Failover)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -918,7 +1398,7 @@ TEST_F(CoordinatorTest, Failover)
 }
 
 
-TEST_F(CoordinatorTest, Demoted)
+TEST_P(CoordinatorTest, Demoted)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -993,7 +1473,7 @@ TEST_F(CoordinatorTest, Demoted)
 }
 
 
-TEST_F(CoordinatorTest, Fill)
+TEST_P(CoordinatorTest, Fill)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1054,22 +1534,316 @@ TEST_F(CoordinatorTest, Fill)
 
     electing = coord2.elect();
     AWAIT_READY(electing);
-    EXPECT_SOME_EQ(position, electing.get());
+    EXPECT_SOME_EQ(position, electing.get());
+  }
+
+  {
+    Future<list<Action> > actions = replica3->read(position, position);
+    AWAIT_READY(actions);
+    ASSERT_EQ(1u, actions.get().size());
+    EXPECT_EQ(position, actions.get().front().position());
+    ASSERT_TRUE(actions.get().front().has_type());
+    ASSERT_EQ(Action::APPEND, actions.get().front().type());
+    EXPECT_EQ("hello world", actions.get().front().append().bytes());
+  }
+}
+
+
+TEST_P(CoordinatorTest, NotLearnedFill)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+  initializer.flags.path = path3;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  // Drop messages here in order to obtain the pid of replica2. We
+  // only want to drop learned message sent to replica2.
+  DROP_MESSAGES(Eq(LearnedMessage().GetTypeName()), _, Eq(replica2->pid()));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord1(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord1.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  uint64_t position;
+
+  {
+    Future<Option<uint64_t> > appending = coord1.append("hello world");
+    AWAIT_READY(appending);
+    ASSERT_SOME(appending.get());
+    position = appending.get().get();
+    EXPECT_EQ(1u, position);
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.clear();
+  pids.insert(replica2->pid());
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  Coordinator coord2(2, replica3, network2);
+
+  {
+    // Note that the first election should fail because 'coord2' gets
+    // its proposal number from 'replica3' which has an empty log and
+    // thus a second attempt will need to be made.
+    Future<Option<uint64_t> > electing = coord2.elect();
+    AWAIT_READY(electing);
+    ASSERT_NONE(electing.get());
+
+    electing = coord2.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(position, electing.get());
+  }
+
+  {
+    Future<list<Action> > actions = replica3->read(position, position);
+    AWAIT_READY(actions);
+    ASSERT_EQ(1u, actions.get().size());
+    EXPECT_EQ(position, actions.get().front().position());
+    ASSERT_TRUE(actions.get().front().has_type());
+    ASSERT_EQ(Action::APPEND, actions.get().front().type());
+    EXPECT_EQ("hello world", actions.get().front().append().bytes());
+  }
+}
+
+
+TEST_P(CoordinatorTest, MultipleAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t> > appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+  }
+
+  {
+    Future<list<Action> > actions = replica1->read(1, 10);
+    AWAIT_READY(actions);
+    EXPECT_EQ(10u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
+// Tests that appends issued without waiting for the previous ones
+// get consecutive positions and complete in order.
+TEST_P(CoordinatorTest, PipelinedAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network, 4);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  list<Future<Option<uint64_t> > > appending;
+  for (uint64_t position = 1; position <= 4; position++) {
+    appending.push_back(coord.append(stringify(position)));
+  }
+
+  uint64_t position = 1;
+  foreach (const Future<Option<uint64_t> >& future, appending) {
+    AWAIT_READY(future);
+    EXPECT_SOME_EQ(position++, future.get());
+  }
+
+  {
+    Future<Option<uint64_t> > appending = coord.append("5");
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(5u, appending.get());
+  }
+
+  {
+    Future<list<Action> > actions = replica2->read(1, 5);
+    AWAIT_READY(actions);
+    EXPECT_EQ(5u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
+// Tests that discarding a write while later writes are in progress
+// completes all of them as demoted (or discarded), demotes the
+// coordinator once they have completed, and that the next election
+// fills the positions they were written to.
+TEST_P(CoordinatorTest, PipelinedAppendsDiscarded)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network, 3);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  // Only the local replica gets the writes, so they stay in progress.
+  Future<Message> write1 = DROP_MESSAGE(
+      Eq(WriteRequest().GetTypeName()), _, Eq(replica2->pid()));
+  Future<Message> write2 = DROP_MESSAGE(
+      Eq(WriteRequest().GetTypeName()), _, Eq(replica2->pid()));
+  Future<Message> write3 = DROP_MESSAGE(
+      Eq(WriteRequest().GetTypeName()), _, Eq(replica2->pid()));
+
+  Future<Option<uint64_t> > appending1 = coord.append("1");
+  Future<Option<uint64_t> > appending2 = coord.append("2");
+  Future<Option<uint64_t> > appending3 = coord.append("3");
+
+  AWAIT_READY(write1);
+  AWAIT_READY(write2);
+  AWAIT_READY(write3);
+
+  // Discarding a write that waits for the preceding one does not
+  // complete it, nor the others, ahead of the preceding one.
+  appending2.discard();
+
+  EXPECT_TRUE(appending1.isPending());
+  EXPECT_TRUE(appending3.isPending());
+
+  // The coordinator cannot be elected while writes are in progress.
+  AWAIT_FAILED(coord.elect());
+
+  appending1.discard();
+
+  AWAIT_DISCARDED(appending1);
+  AWAIT_DISCARDED(appending2);
+
+  // The write queued behind them is demoted, or discarded.
+  ASSERT_TRUE(appending3.await(Seconds(15)));
+  if (appending3.isReady()) {
+    EXPECT_NONE(appending3.get());
+  } else {
+    EXPECT_TRUE(appending3.isDiscarded());
+  }
+
+  // Let the coordinator finish the writes.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  // The coordinator was demoted.
+  {
+    Future<Option<uint64_t> > appending = coord.append("4");
+    AWAIT_READY(appending);
+    EXPECT_NONE(appending.get());
+  }
+
+  // The local replica accepted the writes, hence the election fills
+  // their positions with them.
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(3u, electing.get());
   }
 
   {
-    Future<list<Action> > actions = replica3->read(position, position);
+    Future<list<Action> > actions = replica2->read(1, 3);
     AWAIT_READY(actions);
-    ASSERT_EQ(1u, actions.get().size());
-    EXPECT_EQ(position, actions.get().front().position());
-    ASSERT_TRUE(actions.get().front().has_type());
-    ASSERT_EQ(Action::APPEND, actions.get().front().type());
-    EXPECT_EQ("hello world", actions.get().front().append().bytes());
+    ASSERT_EQ(3u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+
+  {
+    Future<Option<uint64_t> > appending = coord.append("4");
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(4u, appending.get());
   }
 }
 
 
-TEST_F(CoordinatorTest, NotLearnedFill)
+TEST_P(CoordinatorTest, AppendBatch)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1079,77 +1853,56 @@ TEST_F(CoordinatorTest, NotLearnedFill)
   initializer.flags.path = path2;
   initializer.execute();
 
-  const string path3 = os::getcwd() + "/.log3";
-  initializer.flags.path = path3;
-  initializer.execute();
-
   Shared<Replica> replica1(new Replica(path1));
   Shared<Replica> replica2(new Replica(path2));
 
-  // Drop messages here in order to obtain the pid of replica2. We
-  // only want to drop learned message sent to replica2.
-  DROP_MESSAGES(Eq(LearnedMessage().GetTypeName()), _, Eq(replica2->pid()));
-
   set<UPID> pids;
   pids.insert(replica1->pid());
   pids.insert(replica2->pid());
 
-  Shared<Network> network1(new Network(pids));
+  Shared<Network> network(new Network(pids));
 
-  Coordinator coord1(2, replica1, network1);
+  Coordinator coord(2, replica1, network, 2);
 
   {
-    Future<Option<uint64_t> > electing = coord1.elect();
+    Future<Option<uint64_t> > electing = coord.elect();
     AWAIT_READY(electing);
     EXPECT_SOME_EQ(0u, electing.get());
   }
 
-  uint64_t position;
-
-  {
-    Future<Option<uint64_t> > appending = coord1.append("hello world");
-    AWAIT_READY(appending);
-    ASSERT_SOME(appending.get());
-    position = appending.get().get();
-    EXPECT_EQ(1u, position);
+  list<string> batch1;
+  list<string> batch2;
+  for (uint64_t position = 1; position <= 10; position++) {
+    (position <= 5 ? batch1 : batch2).push_back(stringify(position));
   }
 
-  Shared<Replica> replica3(new Replica(path3));
-
-  pids.clear();
-  pids.insert(replica2->pid());
-  pids.insert(replica3->pid());
-
-  Shared<Network> network2(new Network(pids));
-
-  Coordinator coord2(2, replica3, network2);
+  Future<Option<uint64_t> > appending1 = coord.append(batch1);
+  Future<Option<uint64_t> > appending2 = coord.append(batch2);
 
-  {
-    // Note that the first election should fail because 'coord2' gets
-    // its proposal number from 'replica3' which has an empty log and
-    // thus a second attempt will need to be made.
-    Future<Option<uint64_t> > electing = coord2.elect();
-    AWAIT_READY(electing);
-    ASSERT_NONE(electing.get());
+  AWAIT_READY(appending1);
+  EXPECT_SOME_EQ(5u, appending1.get());
 
-    electing = coord2.elect();
-    AWAIT_READY(electing);
-    EXPECT_SOME_EQ(position, electing.get());
-  }
+  AWAIT_READY(appending2);
+  EXPECT_SOME_EQ(10u, appending2.get());
 
   {
-    Future<list<Action> > actions = replica3->read(position, position);
+    Future<list<Action> > actions = replica2->read(1, 10);
     AWAIT_READY(actions);
-    ASSERT_EQ(1u, actions.get().size());
-    EXPECT_EQ(position, actions.get().front().position());
-    ASSERT_TRUE(actions.get().front().has_type());
-    ASSERT_EQ(Action::APPEND, actions.get().front().type());
-    EXPECT_EQ("hello world", actions.get().front().append().bytes());
+    EXPECT_EQ(10u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
   }
 }
 
 
-TEST_F(CoordinatorTest, MultipleAppends)
+// Tests that a batch is written one position at a time when a quorum
+// of replicas does not answer it in time, e.g., because some of them
+// do not support batches, and that later batches are written that
+// way right away.
+TEST_P(CoordinatorTest, AppendBatchFallback)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1176,14 +1929,38 @@ TEST_F(CoordinatorTest, MultipleAppends)
     EXPECT_SOME_EQ(0u, electing.get());
   }
 
+  // Make the second replica behave like one that predates batches.
+  DROP_MESSAGES(Eq(WriteBatchRequest().GetTypeName()), _, Eq(replica2->pid()));
+  DROP_MESSAGES(
+      Eq(LearnedBatchMessage().GetTypeName()), _, Eq(replica2->pid()));
+
+  list<string> batch1;
+  list<string> batch2;
   for (uint64_t position = 1; position <= 10; position++) {
-    Future<Option<uint64_t> > appending = coord.append(stringify(position));
-    AWAIT_READY(appending);
-    EXPECT_SOME_EQ(position, appending.get());
+    (position <= 5 ? batch1 : batch2).push_back(stringify(position));
   }
 
+  Clock::pause();
+
+  Future<Option<uint64_t> > appending1 = coord.append(batch1);
+
+  Clock::settle();
+  EXPECT_TRUE(appending1.isPending());
+
+  Clock::advance(Seconds(10));
+
+  AWAIT_READY(appending1);
+  EXPECT_SOME_EQ(5u, appending1.get());
+
+  Clock::resume();
+
+  Future<Option<uint64_t> > appending2 = coord.append(batch2);
+
+  AWAIT_READY(appending2);
+  EXPECT_SOME_EQ(10u, appending2.get());
+
   {
-    Future<list<Action> > actions = replica1->read(1, 10);
+    Future<list<Action> > actions = replica2->read(1, 10);
     AWAIT_READY(actions);
     EXPECT_EQ(10u, actions.get().size());
     foreach (const Action& action, actions.get()) {
@@ -1195,7 +1972,7 @@ TEST_F(CoordinatorTest, MultipleAppends)
 }
 
 
-TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
+TEST_P(CoordinatorTest, MultipleAppendsNotLearnedFill)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1272,7 +2049,7 @@ TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
 }
 
 
-TEST_F(CoordinatorTest, Truncate)
+TEST_P(CoordinatorTest, Truncate)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1330,7 +2107,7 @@ TEST_F(CoordinatorTest, Truncate)
 }
 
 
-TEST_F(CoordinatorTest, TruncateNotLearnedFill)
+TEST_P(CoordinatorTest, TruncateNotLearnedFill)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1419,7 +2196,7 @@ TEST_F(CoordinatorTest, TruncateNotLearnedFill)
 }
 
 
-TEST_F(CoordinatorTest, TruncateLearnedFill)
+TEST_P(CoordinatorTest, TruncateLearnedFill)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1507,8 +2284,8 @@ TEST_F(CoordinatorTest, TruncateLearnedFill)
 class MockReplica : public Replica
 {
 public:
-  explicit MockReplica(const string& path) :
-    Replica(path) {}
+  MockReplica(const string& path, const string& storage) :
+    Replica(path, storage) {}
 
   virtual ~MockReplica() {}
 
@@ -1525,15 +2302,15 @@ public:
 // of replicas in VOTING state, the non-VOTING replicas should
 // instruct the coordinator that they have ignored the coordinator's
 // request, so the coordinator can promptly retry. MESOS-3280.
-TEST_F(CoordinatorTest, RecoveryRace)
+TEST_P(CoordinatorTest, RecoveryRace)
 {
   const string path1 = os::getcwd() + "/.log1";
   const string path2 = os::getcwd() + "/.log2";
   const string path3 = os::getcwd() + "/.log3";
 
-  MockReplica* replica1(new MockReplica(path1));
-  MockReplica* replica2(new MockReplica(path2));
-  MockReplica* replica3(new MockReplica(path3));
+  MockReplica* replica1(new MockReplica(path1, GetParam()));
+  MockReplica* replica2(new MockReplica(path2, GetParam()));
+  MockReplica* replica3(new MockReplica(path3, GetParam()));
 
   set<UPID> pids{replica1->pid(), replica2->pid(), replica3->pid()};
   Shared<Network> network(new Network(pids));
@@ -1800,6 +2577,12 @@ TEST_F(RecoverTest, CatchupRetry)
 
   Shared<Network> network2(new Network(pids));
 
+  // Make sure the positions are not transferred from replica1 (the
+  // only replica which has learned them), so that they are caught-up
+  // using Paxos.
+  DROP_MESSAGES(
+      Eq(LearnedRangeRequest().GetTypeName()), _, Eq(replica1->pid()));
+
   // Drop a promise request to replica1 so that the catch-up process
   // won't be able to get a quorum of explicit promises. Also, since
   // learned messages are blocked from being sent replica2, the
@@ -1834,6 +2617,168 @@ TEST_F(RecoverTest, CatchupRetry)
 }
 
 
+// This test verifies that learned positions are caught-up by
+// transferring them from another replica, without any Paxos round.
+TEST_F(RecoverTest, CatchupRange)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t> > appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  // Paxos is not needed to catch-up learned positions.
+  EXPECT_NO_FUTURE_MESSAGES(Eq(PromiseRequest().GetTypeName()), _, _);
+  EXPECT_NO_FUTURE_MESSAGES(Eq(WriteRequest().GetTypeName()), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(catching);
+
+  Future<IntervalSet<uint64_t> > missing = replica3->missing(1, 10);
+  AWAIT_READY(missing);
+  EXPECT_TRUE(missing.get().empty());
+
+  Future<list<Action> > actions = replica3->read(1, 10);
+  AWAIT_READY(actions);
+  ASSERT_EQ(10u, actions.get().size());
+
+  foreach (const Action& action, actions.get()) {
+    ASSERT_TRUE(action.has_type());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+}
+
+
+// Tests that the (empty) response of the local replica to a learned
+// range request does not count toward the quorum of replicas without
+// the requested positions, which would leave them to Paxos.
+TEST_F(RecoverTest, CatchupRangeIgnoresLocalReplica)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  // Replica2 does not learn any of the appended positions.
+  DROP_MESSAGES(Eq(LearnedMessage().GetTypeName()), _, Eq(replica2->pid()));
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t> > appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  // Hold the request to replica1 until replica2 responded without
+  // any action, so that a quorum of (empty) responses would be
+  // reached if the local replica was asked as well.
+  Future<Message> request = DROP_MESSAGE(
+      Eq(LearnedRangeRequest().GetTypeName()), _, Eq(replica1->pid()));
+
+  Future<Message> response = FUTURE_MESSAGE(
+      Eq(LearnedRangeResponse().GetTypeName()), Eq(replica2->pid()), _);
+
+  EXPECT_NO_FUTURE_MESSAGES(
+      Eq(LearnedRangeRequest().GetTypeName()), _, Eq(replica3->pid()));
+
+  EXPECT_NO_FUTURE_MESSAGES(Eq(PromiseRequest().GetTypeName()), _, _);
+  EXPECT_NO_FUTURE_MESSAGES(Eq(WriteRequest().GetTypeName()), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(request);
+  AWAIT_READY(response);
+
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  EXPECT_TRUE(catching.isPending());
+
+  post(request.get().from,
+       request.get().to,
+       request.get().name,
+       request.get().body.data(),
+       request.get().body.size());
+
+  AWAIT_READY(catching);
+
+  Future<IntervalSet<uint64_t> > missing = replica3->missing(1, 10);
+  AWAIT_READY(missing);
+  EXPECT_TRUE(missing.get().empty());
+}
+
+
 TEST_F(RecoverTest, AutoInitialization)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -1972,15 +2917,33 @@ TEST_F(RecoverTest, AutoInitializationRetry)
 }
 
 
-class LogTest : public TemporaryDirectoryTest
+class LogTest
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<string>
 {
 protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    // The log is created with the storage engine under test, which
+    // the replicas then open it with.
+    initializer.flags.storage = GetParam();
+  }
+
   // For initializing the log.
   tool::Initialize initializer;
 };
 
 
-TEST_F(LogTest, WriteRead)
+// The tests are parameterized by the storage engine of the log.
+INSTANTIATE_TEST_CASE_P(
+    Storage,
+    LogTest,
+    ::testing::Values("leveldb", "segmented"));
+
+
+TEST_P(LogTest, WriteRead)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -2022,7 +2985,58 @@ TEST_F(LogTest, WriteRead)
 }
 
 
-TEST_F(LogTest, Position)
+TEST_P(LogTest, AppendBatch)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Replica replica1(path1);
+
+  set<UPID> pids;
+  pids.insert(replica1.pid());
+
+  Log log(2, path2, pids);
+
+  Log::Writer writer(&log, 3);
+
+  Future<Option<Log::Position> > start = writer.start();
+
+  AWAIT_READY(start);
+  ASSERT_SOME(start.get());
+
+  list<string> data;
+  for (int i = 0; i < 10; i++) {
+    data.push_back(stringify(i));
+  }
+
+  Future<Option<Log::Position> > position = writer.append(data);
+
+  AWAIT_READY(position);
+  ASSERT_SOME(position.get());
+
+  Log::Reader reader(&log);
+
+  Future<list<Log::Entry> > entries =
+    reader.read(start.get().get(), position.get().get());
+
+  AWAIT_READY(entries);
+
+  ASSERT_EQ(10u, entries.get().size());
+  EXPECT_EQ(position.get().get(), entries.get().back().position);
+
+  foreach (const Log::Entry& entry, entries.get()) {
+    EXPECT_EQ(data.front(), entry.data);
+    data.pop_front();
+  }
+}
+
+
+TEST_P(LogTest, Position)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -2183,15 +3197,15 @@ TEST_F(LogZooKeeperTest, LostZooKeeper)
 #endif // MESOS_HAS_JAVA
 
 
-TEST_F(CoordinatorTest, RacingElect) {}
+TEST_P(CoordinatorTest, RacingElect) {}
 
-TEST_F(CoordinatorTest, FillNoQuorum) {}
+TEST_P(CoordinatorTest, FillNoQuorum) {}
 
-TEST_F(CoordinatorTest, FillInconsistent) {}
+TEST_P(CoordinatorTest, FillInconsistent) {}
 
-TEST_F(CoordinatorTest, LearnedOnOneReplica_NotLearnedOnAnother) {}
+TEST_P(CoordinatorTest, LearnedOnOneReplica_NotLearnedOnAnother) {}
 
-TEST_F(CoordinatorTest,
+TEST_P(CoordinatorTest,
        LearnedOnOneReplica_NotLearnedOnAnother_AnotherFailsAndRecovers) {}
 
 } // namespace tests {
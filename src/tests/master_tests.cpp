@@ -1619,6 +1619,44 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
 }
 
 
+// Tests that the gauges of the master report their last value until
+// the sampling interval elapsed.
+TEST_F(MasterTest, MetricsSamplingInterval)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.metrics_sampling_interval = Seconds(10);
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  JSON::Object snapshot = Metrics();
+  EXPECT_EQ(0, snapshot.values["master/slaves_active"]);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  Clock::pause();
+
+  // The slave is not reported before the interval elapsed.
+  snapshot = Metrics();
+  EXPECT_EQ(0, snapshot.values["master/slaves_active"]);
+
+  Clock::advance(masterFlags.metrics_sampling_interval);
+
+  snapshot = Metrics();
+  EXPECT_EQ(1, snapshot.values["master/slaves_active"]);
+
+  Clock::resume();
+
+  Shutdown();
+}
+
+
 // Ensures that an empty response arrives if information about
 // registered slaves is requested from a master where no slaves
 // have been registered.
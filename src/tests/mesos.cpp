@@ -94,6 +94,10 @@ master::Flags MesosTest::CreateMasterFlags()
   flags.authenticate_frameworks = true;
   flags.authenticate_slaves = true;
 
+  // Evaluate the metrics gauges on every request, since the tests
+  // expect them to reflect the changes they just made.
+  flags.metrics_sampling_interval = Duration::zero();
+
   // Create a default credentials file.
   const string& path =  path::join(os::getcwd(), "credentials");
 
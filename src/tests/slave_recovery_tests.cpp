@@ -21,6 +21,7 @@
 
 #include <gtest/gtest.h>
 
+#include <iostream>
 #include <string>
 
 #include <mesos/executor.hpp>
@@ -39,6 +40,7 @@
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/uuid.hpp>
 
 #include "common/protobuf_utils.hpp"
@@ -71,6 +73,8 @@ using google::protobuf::RepeatedPtrField;
 
 using mesos::internal::master::Master;
 
+using std::cout;
+using std::endl;
 using std::map;
 using std::string;
 using std::vector;
@@ -81,6 +85,7 @@ using testing::DoAll;
 using testing::Eq;
 using testing::Return;
 using testing::SaveArg;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -133,6 +138,238 @@ TEST_F(SlaveStateTest, CheckpointRepeatedProtobufMessages)
 }
 
 
+// Checkpoints a synthetic slave state under the meta directory
+// 'rootDir' with the given number of frameworks, executors per
+// framework and runs per executor. All but the latest run of each
+// executor are completed. Each run has a single task with a single
+// status update.
+static SlaveID checkpointSlaveState(
+    const string& rootDir,
+    size_t frameworks,
+    size_t executors,
+    size_t runs)
+{
+  SlaveID slaveId;
+  slaveId.set_value(UUID::random().toString());
+
+  SlaveInfo slaveInfo;
+  slaveInfo.set_hostname("localhost");
+  slaveInfo.mutable_id()->CopyFrom(slaveId);
+
+  paths::createSlaveDirectory(rootDir, slaveId);
+
+  CHECK_SOME(slave::state::checkpoint(
+      paths::getSlaveInfoPath(rootDir, slaveId), slaveInfo));
+
+  for (size_t i = 0; i < frameworks; i++) {
+    FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+    frameworkInfo.mutable_id()->set_value("framework-" + stringify(i));
+
+    const FrameworkID& frameworkId = frameworkInfo.id();
+
+    CHECK_SOME(slave::state::checkpoint(
+        paths::getFrameworkInfoPath(rootDir, slaveId, frameworkId),
+        frameworkInfo));
+
+    CHECK_SOME(slave::state::checkpoint(
+        paths::getFrameworkPidPath(rootDir, slaveId, frameworkId),
+        "scheduler@127.0.0.1:5050"));
+
+    for (size_t j = 0; j < executors; j++) {
+      ExecutorInfo executorInfo = DEFAULT_EXECUTOR_INFO;
+      executorInfo.mutable_executor_id()->set_value("executor-" + stringify(j));
+      executorInfo.mutable_framework_id()->CopyFrom(frameworkId);
+
+      const ExecutorID& executorId = executorInfo.executor_id();
+
+      CHECK_SOME(slave::state::checkpoint(
+          paths::getExecutorInfoPath(rootDir, slaveId, frameworkId, executorId),
+          executorInfo));
+
+      for (size_t k = 0; k < runs; k++) {
+        ContainerID containerId;
+        containerId.set_value(UUID::random().toString());
+
+        // NOTE: This also makes this run the latest run.
+        paths::createExecutorDirectory(
+            rootDir, slaveId, frameworkId, executorId, containerId);
+
+        CHECK_SOME(slave::state::checkpoint(
+            paths::getForkedPidPath(
+                rootDir, slaveId, frameworkId, executorId, containerId),
+            "1"));
+
+        CHECK_SOME(slave::state::checkpoint(
+            paths::getLibprocessPidPath(
+                rootDir, slaveId, frameworkId, executorId, containerId),
+            "executor@127.0.0.1:5051"));
+
+        TaskID taskId;
+        taskId.set_value("task-" + stringify(k));
+
+        Task task;
+        task.set_name("test-task");
+        task.mutable_task_id()->CopyFrom(taskId);
+        task.mutable_slave_id()->CopyFrom(slaveId);
+        task.mutable_framework_id()->CopyFrom(frameworkId);
+        task.mutable_executor_id()->CopyFrom(executorId);
+        task.set_state(TASK_RUNNING);
+
+        CHECK_SOME(slave::state::checkpoint(
+            paths::getTaskInfoPath(
+                rootDir, slaveId, frameworkId, executorId, containerId, taskId),
+            task));
+
+        StatusUpdateRecord record;
+        record.set_type(StatusUpdateRecord::UPDATE);
+        record.mutable_update()->CopyFrom(protobuf::createStatusUpdate(
+            frameworkId,
+            slaveId,
+            taskId,
+            TASK_RUNNING,
+            TaskStatus::SOURCE_EXECUTOR,
+            UUID::random()));
+
+        RepeatedPtrField<StatusUpdateRecord> records;
+        records.Add()->CopyFrom(record);
+
+        CHECK_SOME(slave::state::checkpoint(
+            paths::getTaskUpdatesPath(
+                rootDir, slaveId, frameworkId, executorId, containerId, taskId),
+            records));
+
+        if (k + 1 < runs) {
+          CHECK_SOME(slave::state::checkpoint(
+              paths::getExecutorSentinelPath(
+                  rootDir, slaveId, frameworkId, executorId, containerId),
+              ""));
+        }
+      }
+    }
+  }
+
+  return slaveId;
+}
+
+
+// Ensures that recovering the slave state in parallel produces the
+// same state as recovering it serially, and that completed runs
+// which are not the latest runs are not recovered beyond their ids.
+TEST_F(SlaveStateTest, RecoverInParallel)
+{
+  const string rootDir = os::getcwd();
+
+  const SlaveID slaveId = checkpointSlaveState(rootDir, 4, 4, 3);
+
+  Result<slave::state::State> serial =
+    slave::state::recover(rootDir, true, 1);
+
+  ASSERT_SOME(serial);
+  ASSERT_SOME(serial.get().slave);
+
+  Result<slave::state::State> parallel =
+    slave::state::recover(rootDir, true, 8);
+
+  ASSERT_SOME(parallel);
+  ASSERT_SOME(parallel.get().slave);
+
+  const slave::state::SlaveState& state = parallel.get().slave.get();
+
+  EXPECT_EQ(slaveId, state.id);
+  EXPECT_EQ(0u, state.errors);
+  EXPECT_EQ(4u, state.frameworks.size());
+
+  foreachpair (const FrameworkID& frameworkId,
+               const slave::state::FrameworkState& framework,
+               state.frameworks) {
+    ASSERT_TRUE(serial.get().slave.get().frameworks.contains(frameworkId));
+    EXPECT_SOME(framework.info);
+    EXPECT_SOME(framework.pid);
+    EXPECT_EQ(4u, framework.executors.size());
+
+    const slave::state::FrameworkState& expected =
+      serial.get().slave.get().frameworks.get(frameworkId).get();
+
+    foreachpair (const ExecutorID& executorId,
+                 const slave::state::ExecutorState& executor,
+                 framework.executors) {
+      ASSERT_TRUE(expected.executors.contains(executorId));
+      EXPECT_EQ(expected.executors.get(executorId).get().latest,
+                executor.latest);
+
+      ASSERT_SOME(executor.latest);
+      EXPECT_SOME(executor.info);
+      EXPECT_EQ(3u, executor.runs.size());
+
+      foreachvalue (const slave::state::RunState& run, executor.runs) {
+        ASSERT_SOME(run.id);
+
+        if (run.id.get() == executor.latest.get()) {
+          EXPECT_FALSE(run.completed);
+          EXPECT_SOME(run.forkedPid);
+          EXPECT_SOME(run.libprocessPid);
+          ASSERT_EQ(1u, run.tasks.size());
+          EXPECT_EQ(1u, run.tasks.begin()->second.updates.size());
+        } else {
+          EXPECT_TRUE(run.completed);
+          EXPECT_NONE(run.forkedPid);
+          EXPECT_TRUE(run.tasks.empty());
+        }
+      }
+    }
+  }
+}
+
+
+class SlaveState_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<std::tr1::tuple<size_t, size_t>>
+{};
+
+
+// The slave state benchmark tests are parameterized by the number of
+// executors per framework and the number of runs per executor.
+INSTANTIATE_TEST_CASE_P(
+    ExecutorAndRunCount,
+    SlaveState_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(10U, 100U, 500U),
+      ::testing::Values(1U, 10U))
+    );
+
+
+TEST_P(SlaveState_BENCHMARK_Test, Recover)
+{
+  const size_t frameworkCount = 10;
+  const size_t executorCount = std::tr1::get<0>(GetParam());
+  const size_t runCount = std::tr1::get<1>(GetParam());
+
+  const string rootDir = os::getcwd();
+
+  Stopwatch watch;
+  watch.start();
+
+  checkpointSlaveState(rootDir, frameworkCount, executorCount, runCount);
+
+  cout << "Checkpointed " << frameworkCount << " frameworks with "
+       << executorCount << " executors and " << runCount << " runs each"
+       << " in " << watch.elapsed() << endl;
+
+  foreach (size_t threads, vector<size_t>({1u, DEFAULT_RECOVERY_THREADS})) {
+    watch.start();
+
+    Result<slave::state::State> state =
+      slave::state::recover(rootDir, true, threads);
+
+    ASSERT_SOME(state);
+    ASSERT_SOME(state.get().slave);
+
+    cout << "Recovered the slave state using " << threads << " threads"
+         << " in " << watch.elapsed() << endl;
+  }
+}
+
+
 template <typename T>
 class SlaveRecoveryTest : public ContainerizerTest<T>
 {
@@ -2147,6 +2147,114 @@ TEST_F(SlaveTest, ContainerizerUsageFailure)
 }
 
 
+// This test verifies that the resource usage collected by the slave
+// is shared between its consumers for the duration specified by the
+// '--resource_usage_cache_interval' flag.
+TEST_F(SlaveTest, ResourceUsageCache)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+  StandaloneMasterDetector detector(master.get());
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.resource_usage_cache_interval = Seconds(10);
+
+  MockSlave slave(flags, &detector, &containerizer);
+  spawn(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(_, _, _));
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  Future<vector<Offer>> offers;
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  const Offer& offer = offers.get()[0];
+
+  TaskInfo task = createTask(
+      offer.slave_id(),
+      Resources::parse("cpus:0.1;mem:32").get(),
+      "sleep 1000",
+      exec.id);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offer.id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  Clock::pause();
+
+  ResourceStatistics statistics;
+  statistics.set_timestamp(Clock::now().secs());
+
+  // The containerizer should be asked for the usage only once while
+  // the collected resource usage is cached.
+  Promise<ResourceStatistics> promise;
+  EXPECT_CALL(containerizer, usage(_))
+    .WillOnce(Return(promise.future()));
+
+  Future<ResourceUsage> usage1 = slave.usage();
+  Future<ResourceUsage> usage2 = slave.usage();
+
+  // A consumer discarding its future must not discard the collection
+  // shared with the other consumers.
+  usage1.discard();
+
+  promise.set(statistics);
+
+  AWAIT_READY(usage1);
+  ASSERT_EQ(1, usage1.get().executors_size());
+  EXPECT_TRUE(usage1.get().executors(0).has_statistics());
+
+  AWAIT_READY(usage2);
+  ASSERT_EQ(1, usage2.get().executors_size());
+  EXPECT_TRUE(usage2.get().executors(0).has_statistics());
+
+  // Once the interval has elapsed the usage is collected again.
+  Clock::advance(flags.resource_usage_cache_interval);
+
+  EXPECT_CALL(containerizer, usage(_))
+    .WillOnce(Return(Failure("Injected failure")));
+
+  Future<ResourceUsage> usage3 = slave.usage();
+
+  AWAIT_READY(usage3);
+  ASSERT_EQ(1, usage3.get().executors_size());
+  EXPECT_FALSE(usage3.get().executors(0).has_statistics());
+
+  Clock::resume();
+
+  driver.stop();
+  driver.join();
+
+  terminate(slave);
+  wait(slave);
+
+  Shutdown();
+}
+
+
 // This test verifies that label values can be set for tasks and that
 // they are exposed over the slave state endpoint.
 TEST_F(SlaveTest, TaskLabels)
@@ -18,12 +18,15 @@
 
 #include <gmock/gmock.h>
 
+#include <iostream>
 #include <list>
 #include <set>
 #include <string>
 #include <vector>
 
+#include <mesos/attributes.hpp>
 #include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
 #include <mesos/type_utils.hpp>
 
 #include <process/future.hpp>
@@ -35,6 +38,8 @@
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/svn.hpp>
 #include <stout/try.hpp>
 
 #include <stout/tests/utils.hpp>
@@ -48,6 +53,7 @@
 
 #include "messages/state.hpp"
 
+#include "state/delta.hpp"
 #include "state/in_memory.hpp"
 #include "state/leveldb.hpp"
 #include "state/log.hpp"
@@ -63,11 +69,15 @@ using namespace mesos::internal::log;
 
 using namespace process;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::set;
 using std::string;
 using std::vector;
 
+using testing::WithParamInterface;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -515,6 +525,77 @@ protected:
     TemporaryDirectoryTest::TearDown();
   }
 
+  // Stores 1024 slaves and then a 1025th slave, and returns the
+  // operations written to the log.
+  void storeSlaves(vector<Operation>* operations)
+  {
+    Future<Variable<Slaves>> future1 = state->fetch<Slaves>("slaves");
+    AWAIT_READY(future1);
+
+    Variable<Slaves> variable = future1.get();
+
+    Slaves slaves = variable.get();
+    ASSERT_EQ(0, slaves.slaves().size());
+
+    for (size_t i = 0; i < 1024; i++) {
+      Slave* slave = slaves.add_slaves();
+      slave->mutable_info()->set_hostname("localhost" + stringify(i));
+    }
+
+    variable = variable.mutate(slaves);
+
+    Future<Option<Variable<Slaves>>> future2 = state->store(variable);
+    AWAIT_READY(future2);
+    ASSERT_SOME(future2.get());
+
+    variable = future2.get().get();
+
+    Slave* slave = slaves.add_slaves();
+    slave->mutable_info()->set_hostname("localhost1024");
+
+    variable = variable.mutate(slaves);
+
+    future2 = state->store(variable);
+    AWAIT_READY(future2);
+    ASSERT_SOME(future2.get());
+
+    // It's possible that we're doing truncation asynchronously which
+    // will cause the test to fail because we'll end up getting a
+    // pending position from Log::Reader::ending which will cause
+    // Log::Reader::read to fail. To remedy this, we pause the clock and
+    // wait for all executing processe to settle.
+    Clock::pause();
+    Clock::settle();
+    Clock::resume();
+
+    Log::Reader reader(log);
+
+    Future<Log::Position> beginning = reader.beginning();
+    Future<Log::Position> ending = reader.ending();
+
+    AWAIT_READY(beginning);
+    AWAIT_READY(ending);
+
+    Future<list<Log::Entry>> entries =
+      reader.read(beginning.get(), ending.get());
+
+    AWAIT_READY(entries);
+
+    // Convert each Log::Entry to a Operation.
+    foreach (const Log::Entry& entry, entries.get()) {
+      // Parse the Operation from the Log::Entry.
+      Operation operation;
+
+      google::protobuf::io::ArrayInputStream stream(
+          entry.data.data(),
+          entry.data.size());
+
+      ASSERT_TRUE(operation.ParseFromZeroCopyStream(&stream));
+
+      operations->push_back(operation);
+    }
+  }
+
   state::Storage* storage;
   State* state;
 
@@ -613,76 +694,158 @@ TEST_F(LogStateTest, Timeout)
 
 TEST_F(LogStateTest, Diff)
 {
-  Future<Variable<Slaves>> future1 = state->fetch<Slaves>("slaves");
-  AWAIT_READY(future1);
+  vector<Operation> operations;
+  storeSlaves(&operations);
 
-  Variable<Slaves> variable = future1.get();
+  ASSERT_EQ(2u, operations.size());
+  EXPECT_EQ(Operation::SNAPSHOT, operations[0].type());
+  EXPECT_EQ(Operation::DIFF, operations[1].type());
+}
 
-  Slaves slaves = variable.get();
-  ASSERT_EQ(0, slaves.slaves().size());
 
-  for (size_t i = 0; i < 1024; i++) {
-    Slave* slave = slaves.add_slaves();
-    slave->mutable_info()->set_hostname("localhost" + stringify(i));
+// Tests that the storage writes deltas instead of SVN diffs only
+// when deltas are enabled.
+TEST_F(LogStateTest, Delta)
+{
+  delete state;
+  delete storage;
+
+  storage = new state::LogStorage(log, 1024, true);
+  state = new State(storage);
+
+  vector<Operation> operations;
+  storeSlaves(&operations);
+
+  ASSERT_EQ(2u, operations.size());
+  EXPECT_EQ(Operation::SNAPSHOT, operations[0].type());
+  EXPECT_EQ(Operation::DELTA, operations[1].type());
+
+  // The delta gets applied when reading the log again.
+  state::LogStorage storage2(log);
+  State state2(&storage2);
+
+  Future<Variable<Slaves>> future = state2.fetch<Slaves>("slaves");
+  AWAIT_READY(future);
+
+  EXPECT_EQ(1025, future.get().get().slaves().size());
+}
+
+
+// Returns the registered slaves of a cluster with the specified
+// number of slaves.
+static Slaves createSlaves(size_t count)
+{
+  Slaves slaves;
+
+  Attributes attributes = Attributes::parse("foo:bar;baz:quux");
+  Resources resources =
+    Resources::parse("cpus(*):1.0;mem(*):512;disk(*):2048").get();
+
+  for (size_t i = 0; i < count; i++) {
+    SlaveInfo* info = slaves.add_slaves()->mutable_info();
+    info->set_hostname("localhost" + stringify(i));
+    info->mutable_id()->set_value(
+        "201310101658-2280333834-5050-48574-" + stringify(i));
+    info->mutable_resources()->MergeFrom(resources);
+    info->mutable_attributes()->MergeFrom(attributes);
   }
 
-  variable = variable.mutate(slaves);
+  return slaves;
+}
 
-  Future<Option<Variable<Slaves>>> future2 = state->store(variable);
-  AWAIT_READY(future2);
-  ASSERT_SOME(future2.get());
 
-  variable = future2.get().get();
+TEST(DeltaTest, CreateAndApply)
+{
+  Slaves slaves = createSlaves(100);
 
-  Slave* slave = slaves.add_slaves();
-  slave->mutable_info()->set_hostname("localhost1024");
+  const string before = slaves.SerializeAsString();
 
-  variable = variable.mutate(slaves);
+  // Update, remove and add a slave.
+  slaves.mutable_slaves(10)->mutable_info()->set_hostname("updated");
+  slaves.mutable_slaves()->DeleteSubrange(50, 1);
+  slaves.add_slaves()->mutable_info()->set_hostname("added");
 
-  future2 = state->store(variable);
-  AWAIT_READY(future2);
-  ASSERT_SOME(future2.get());
+  const string after = slaves.SerializeAsString();
 
-  // It's possible that we're doing truncation asynchronously which
-  // will cause the test to fail because we'll end up getting a
-  // pending position from Log::Reader::ending which will cause
-  // Log::Reader::read to fail. To remedy this, we pause the clock and
-  // wait for all executing processe to settle.
-  Clock::pause();
-  Clock::settle();
-  Clock::resume();
+  Try<Operation::Delta> delta = state::delta::create(before, after);
+  ASSERT_SOME(delta);
 
-  Log::Reader reader(log);
+  // Only the changed slaves are included in the delta.
+  EXPECT_LT(delta.get().ByteSize(), 1024);
 
-  Future<Log::Position> beginning = reader.beginning();
-  Future<Log::Position> ending = reader.ending();
+  EXPECT_SOME_EQ(after, state::delta::apply(before, delta.get()));
 
-  AWAIT_READY(beginning);
-  AWAIT_READY(ending);
+  // Values which are not protocol buffers can be handled too.
+  delta = state::delta::create("hello world", "goodbye world");
+  ASSERT_SOME(delta);
 
-  Future<list<Log::Entry>> entries = reader.read(beginning.get(), ending.get());
+  EXPECT_SOME_EQ(
+      "goodbye world",
+      state::delta::apply("hello world", delta.get()));
 
-  AWAIT_READY(entries);
+  // A delta can not be applied to a value which is too short.
+  delta = state::delta::create(before, before);
+  ASSERT_SOME(delta);
 
-  // Convert each Log::Entry to a Operation.
-  vector<Operation> operations;
+  EXPECT_ERROR(state::delta::apply("", delta.get()));
+}
 
-  foreach (const Log::Entry& entry, entries.get()) {
-    // Parse the Operation from the Log::Entry.
-    Operation operation;
 
-    google::protobuf::io::ArrayInputStream stream(
-        entry.data.data(),
-        entry.data.size());
+class Delta_BENCHMARK_Test : public ::testing::Test,
+                             public WithParamInterface<size_t> {};
 
-    ASSERT_TRUE(operation.ParseFromZeroCopyStream(&stream));
 
-    operations.push_back(operation);
-  }
+// The delta benchmark tests are parameterized by the number of slaves.
+INSTANTIATE_TEST_CASE_P(
+    SlaveCount,
+    Delta_BENCHMARK_Test,
+    ::testing::Values(10000U, 50000U, 100000U));
 
-  ASSERT_EQ(2u, operations.size());
-  EXPECT_EQ(Operation::SNAPSHOT, operations[0].type());
-  EXPECT_EQ(Operation::DIFF, operations[1].type());
+
+// Compares the deltas to the SVN diffs of the registered slaves when
+// a slave is removed and another one is added.
+TEST_P(Delta_BENCHMARK_Test, CreateAndApply)
+{
+  Slaves slaves = createSlaves(GetParam());
+
+  const string before = slaves.SerializeAsString();
+
+  slaves.mutable_slaves()->DeleteSubrange(slaves.slaves_size() / 2, 1);
+  slaves.add_slaves()->mutable_info()->set_hostname("added");
+
+  const string after = slaves.SerializeAsString();
+
+  Stopwatch watch;
+  watch.start();
+
+  Try<Operation::Delta> delta = state::delta::create(before, after);
+  ASSERT_SOME(delta);
+
+  cout << "Created a delta of " << Bytes(delta.get().ByteSize())
+       << " for " << GetParam() << " slaves (" << Bytes(after.size())
+       << ") in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  Try<string> patched = state::delta::apply(before, delta.get());
+  ASSERT_SOME_EQ(after, patched);
+
+  cout << "Applied the delta in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  Try<svn::Diff> diff = svn::diff(before, after);
+  ASSERT_SOME(diff);
+
+  cout << "Created an SVN diff of " << Bytes(diff.get().data.size())
+       << " in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  patched = svn::patch(before, diff.get());
+  ASSERT_SOME_EQ(after, patched);
+
+  cout << "Applied the SVN diff in " << watch.elapsed() << endl;
 }
 
 
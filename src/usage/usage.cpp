@@ -32,7 +32,23 @@ namespace internal {
 
 Try<ResourceStatistics> usage(pid_t pid, bool mem, bool cpus)
 {
-  Try<os::ProcessTree> pstree = os::pstree(pid);
+  const Try<std::list<os::Process>> processes = os::processes();
+
+  if (processes.isError()) {
+    return Error("Failed to get usage: " + processes.error());
+  }
+
+  return usage(pid, processes.get(), mem, cpus);
+}
+
+
+Try<ResourceStatistics> usage(
+    pid_t pid,
+    const std::list<os::Process>& processes,
+    bool mem,
+    bool cpus)
+{
+  Try<os::ProcessTree> pstree = os::pstree(pid, processes);
 
   if (pstree.isError()) {
     return Error("Failed to get usage: " + pstree.error());
@@ -21,6 +21,12 @@
 
 #include <unistd.h> // For pid_t.
 
+#include <list>
+
+#include <stout/try.hpp>
+
+#include <stout/os/process.hpp>
+
 #include "mesos/mesos.hpp"
 
 namespace mesos {
@@ -31,6 +37,16 @@ namespace internal {
 // values if 'cpus' is true.
 Try<ResourceStatistics> usage(pid_t pid, bool mem = true, bool cpus = true);
 
+
+// Same as above but uses the specified list of processes instead of
+// reading the process table, e.g., so that the usage of many process
+// trees can be collected from a single snapshot of the process table.
+Try<ResourceStatistics> usage(
+    pid_t pid,
+    const std::list<os::Process>& processes,
+    bool mem = true,
+    bool cpus = true);
+
 } // namespace internal {
 } // namespace mesos {
 
@@ -17,6 +17,7 @@
 */
 
 #include <algorithm>
+#include <iterator>
 #include <queue>
 #include <utility>
 #include <vector>
@@ -49,6 +50,7 @@ using namespace process;
 using process::wait; // Necessary on some OS's to disambiguate.
 
 using std::make_pair;
+using std::pair;
 using std::queue;
 using std::set;
 using std::string;
@@ -61,6 +63,35 @@ namespace zookeeper {
 const Duration GroupProcess::RETRY_INTERVAL = Seconds(2);
 
 
+// Returns a random duration in [duration / 2, duration]. The retries
+// are jittered so that the groups which failed at the same time (e.g.,
+// all the clients of a ZooKeeper ensemble that just recovered) do not
+// all hit ZooKeeper again at the same time.
+static Duration jitter(const Duration& duration)
+{
+  return duration / 2 + duration * (((double) ::random() / RAND_MAX) / 2);
+}
+
+
+// Parses the sequence number and the (optional) label of a membership
+// out of its znode basename, e.g., "label_0000000131".
+static Try<pair<int32_t, Option<string> > > parse(const string& node)
+{
+  vector<string> tokens = strings::tokenize(node, "_");
+  Option<string> label = None();
+  if (tokens.size() > 1) {
+    label = tokens[0];
+  }
+
+  Try<int32_t> sequence = numify<int32_t>(tokens.back());
+  if (sequence.isError()) {
+    return Error(sequence.error());
+  }
+
+  return make_pair(sequence.get(), label);
+}
+
+
 // Helper for failing a queue of promises.
 template <typename T>
 void fail(queue<T*>* queue, const string& message)
@@ -103,7 +134,8 @@ GroupProcess::GroupProcess(
     watcher(NULL),
     zk(NULL),
     state(DISCONNECTED),
-    retrying(false)
+    retrying(false),
+    fetching(false)
 {}
 
 
@@ -123,7 +155,8 @@ GroupProcess::GroupProcess(
     watcher(NULL),
     zk(NULL),
     state(DISCONNECTED),
-    retrying(false)
+    retrying(false),
+    fetching(false)
 {}
 
 
@@ -173,7 +206,10 @@ Future<Group::Membership> GroupProcess::join(
 
   if (membership.isNone()) { // Try again later.
     if (!retrying) {
-      delay(RETRY_INTERVAL, self(), &GroupProcess::retry, RETRY_INTERVAL);
+      delay(jitter(RETRY_INTERVAL),
+            self(),
+            &GroupProcess::retry,
+            RETRY_INTERVAL);
       retrying = true;
     }
     Join* join = new Join(data, label);
@@ -214,7 +250,10 @@ Future<bool> GroupProcess::cancel(const Group::Membership& membership)
 
   if (cancellation.isNone()) { // Try again later.
     if (!retrying) {
-      delay(RETRY_INTERVAL, self(), &GroupProcess::retry, RETRY_INTERVAL);
+      delay(jitter(RETRY_INTERVAL),
+            self(),
+            &GroupProcess::retry,
+            RETRY_INTERVAL);
       retrying = true;
     }
     Cancel* cancel = new Cancel(membership);
@@ -232,27 +271,27 @@ Future<Option<string> > GroupProcess::data(const Group::Membership& membership)
 {
   if (error.isSome()) {
     return Failure(error.get());
-  } else if (state != READY) {
-    Data* data = new Data(membership);
-    pending.datas.push(data);
-    return data->promise.future();
   }
 
-  // TODO(benh): Only attempt if the pending queue is empty so that a
-  // client can assume a happens-before ordering of operations (i.e.,
-  // the first request will happen before the second, etc).
+  const string basename = zkBasename(membership);
 
-  Result<Option<string> > result = doData(membership);
+  if (contents.contains(basename)) {
+    return Some(contents[basename]);
+  }
+
+  Data* data = new Data(membership);
+  pending.datas.push(data);
 
-  if (result.isNone()) { // Try again later.
-    Data* data = new Data(membership);
-    pending.datas.push(data);
-    return data->promise.future();
-  } else if (result.isError()) {
-    return Failure(result.error());
+  // Rather than fetching the data right away we dispatch a fetch so
+  // that all the data requests made in the meantime (e.g., by a
+  // client that just learned about a bunch of memberships) get
+  // fetched in a single batch.
+  if (state == READY && !fetching) {
+    dispatch(self(), &GroupProcess::fetch);
+    fetching = true;
   }
 
-  return result.get();
+  return data->promise.future();
 }
 
 
@@ -289,7 +328,10 @@ Future<set<Group::Membership> > GroupProcess::watch(
 
       // Try again later.
       if (!retrying) {
-        delay(RETRY_INTERVAL, self(), &GroupProcess::retry, RETRY_INTERVAL);
+        delay(jitter(RETRY_INTERVAL),
+              self(),
+              &GroupProcess::retry,
+              RETRY_INTERVAL);
         retrying = true;
       }
       Watch* watch = new Watch(expected);
@@ -363,7 +405,10 @@ void GroupProcess::connected(int64_t sessionId, bool reconnect)
   } else if (!synced.get()) {
     // Retryable error.
     if (!retrying) {
-      delay(RETRY_INTERVAL, self(), &GroupProcess::retry, RETRY_INTERVAL);
+      delay(jitter(RETRY_INTERVAL),
+            self(),
+            &GroupProcess::retry,
+            RETRY_INTERVAL);
       retrying = true;
     }
   }
@@ -510,8 +555,13 @@ void GroupProcess::expired(int64_t sessionId)
   update();
 
   // Invalidate the cache so that we'll sync with ZK after
-  // reconnection.
+  // reconnection. The memberships are reconciled with the first
+  // listing in the new session (rather than diffed) since it is not
+  // related to the listings of the expired session.
   memberships = None();
+  children = None();
+  current.clear();
+  contents.clear();
 
   // Set all owned memberships as cancelled.
   foreachpair (int32_t sequence, Promise<bool>* cancelled, utils::copy(owned)) {
@@ -555,7 +605,10 @@ void GroupProcess::updated(int64_t sessionId, const string& path)
 
     // Try again later.
     if (!retrying) {
-      delay(RETRY_INTERVAL, self(), &GroupProcess::retry, RETRY_INTERVAL);
+      delay(jitter(RETRY_INTERVAL),
+            self(),
+            &GroupProcess::retry,
+            RETRY_INTERVAL);
       retrying = true;
     }
   } else {
@@ -652,6 +705,7 @@ Result<bool> GroupProcess::doCancel(const Group::Membership& membership)
   // Invalidate the cache (it will/should get immediately populated
   // via the 'updated' callback of our ZooKeeper watcher).
   memberships = None();
+  contents.erase(zkBasename(membership));
 
   // Let anyone waiting know the membership has been cancelled.
   CHECK(owned.count(membership.id()) == 1);
@@ -664,32 +718,85 @@ Result<bool> GroupProcess::doCancel(const Group::Membership& membership)
 }
 
 
-Result<Option<string> > GroupProcess::doData(
-    const Group::Membership& membership)
+bool GroupProcess::doData()
 {
   CHECK_EQ(state, READY);
 
-  string path = path::join(znode, zkBasename(membership));
+  // Answer the requests whose data is cached and batch the others.
+  vector<Data*> datas;
+  vector<string> paths;
 
-  LOG(INFO) << "Trying to get '" << path << "' in ZooKeeper";
+  while (!pending.datas.empty()) {
+    Data* data = pending.datas.front();
+    pending.datas.pop();
 
-  // Get data associated with ephemeral node.
-  string result;
+    const string basename = zkBasename(data->membership);
 
-  int code = zk->get(path, false, &result, NULL);
+    if (data->promise.future().hasDiscard()) {
+      data->promise.discard();
+      delete data;
+    } else if (contents.contains(basename)) {
+      data->promise.set(Option<string>(contents[basename]));
+      delete data;
+    } else {
+      datas.push_back(data);
+      paths.push_back(path::join(znode, basename));
+    }
+  }
 
-  if (code == ZNONODE) {
-    return Option<string>::none();
-  } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
-    CHECK_NE(zk->getState(), ZOO_AUTH_FAILED_STATE);
-    return None(); // Try again later.
-  } else if (code != ZOK) {
-    return Error(
-        "Failed to get data for ephemeral node '" + path +
-        "' in ZooKeeper: " + zk->message(code));
+  if (datas.empty()) {
+    return true;
+  }
+
+  LOG(INFO) << "Trying to get the data of " << paths.size()
+            << " membership(s) at '" << znode << "' in ZooKeeper";
+
+  // Get data associated with the ephemeral nodes.
+  // NOTE: ZooKeeper multi-ops only support updates, so the reads are
+  // pipelined instead.
+  vector<string> results;
+  vector<int> codes;
+
+  zk->get(paths, &results, &codes);
+
+  for (size_t i = 0; i < datas.size(); i++) {
+    Data* data = datas[i];
+    const int code = codes[i];
+
+    if (code == ZNONODE) {
+      data->promise.set(Option<string>::none());
+    } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+      CHECK_NE(zk->getState(), ZOO_AUTH_FAILED_STATE);
+
+      // Try again later (in order) with the remaining requests.
+      CHECK(pending.datas.empty());
+      for (size_t j = i; j < datas.size(); j++) {
+        pending.datas.push(datas[j]);
+      }
+
+      return false;
+    } else if (code != ZOK) {
+      data->promise.fail(
+          "Failed to get data for ephemeral node '" + paths[i] +
+          "' in ZooKeeper: " + zk->message(code));
+    } else {
+      // Only cache the data of the listed memberships so that it
+      // gets evicted once the membership is removed.
+      const string basename = Path(paths[i]).basename();
+
+      if (children.isSome() &&
+          std::binary_search(
+              children.get().begin(), children.get().end(), basename)) {
+        contents[basename] = results[i];
+      }
+
+      data->promise.set(Option<string>(results[i]));
+    }
+
+    delete data;
   }
 
-  return Some(result);
+  return true;
 }
 
 
@@ -711,70 +818,162 @@ Try<bool> GroupProcess::cache()
                  + "' in ZooKeeper: " + zk->message(code));
   }
 
-  // Convert results to sequence numbers and (optionally) labels.
-  hashmap<int32_t, Option<string> > sequences;
+  // ZooKeeper only tells us that the children changed, so we diff the
+  // listing against the previous one and only process the znodes
+  // that were added or removed (rather than rebuilding all the
+  // memberships for every change).
+  std::sort(results.begin(), results.end());
+
+  if (children.isNone()) {
+    // Reconcile all the memberships with the listing, cancelling the
+    // (owned or unowned) ones that are now missing.
+    hashmap<int32_t, Option<string> > sequences;
+
+    foreach (const string& result, results) {
+      Try<pair<int32_t, Option<string> > > parsed = parse(result);
+
+      // Skip it if it couldn't be converted to a number.
+      // NOTE: This is currently possible when using a replicated log
+      // based registry because the log replicas register under
+      // "/log_replicas" at the same path as the masters' ephemeral
+      // znodes.
+      if (parsed.isError()) {
+        VLOG(1) << "Found non-sequence node '" << result
+                << "' at '" << znode << "' in ZooKeeper";
+        continue;
+      }
 
-  foreach (const string& result, results) {
-    vector<string> tokens = strings::tokenize(result, "_");
-    Option<string> label = None();
-    if (tokens.size() > 1) {
-      label = tokens[0];
+      sequences[parsed.get().first] = parsed.get().second;
     }
 
-    Try<int32_t> sequence = numify<int32_t>(tokens.back());
-
-    // Skip it if it couldn't be converted to a number.
-    // NOTE: This is currently possible when using a replicated log
-    // based registry because the log replicas register under
-    // "/log_replicas" at the same path as the masters' ephemeral
-    // znodes.
-    if (sequence.isError()) {
-      VLOG(1) << "Found non-sequence node '" << result
-              << "' at '" << znode << "' in ZooKeeper";
-      continue;
+    current.clear();
+
+    foreachpair (int32_t sequence,
+                 Promise<bool>* cancelled,
+                 utils::copy(owned)) {
+      if (!sequences.contains(sequence)) {
+        cancelled->set(false);
+        owned.erase(sequence); // Okay since iterating over a copy.
+        delete cancelled;
+      } else {
+        current.insert(Group::Membership(
+            sequence, sequences[sequence], cancelled->future()));
+
+        sequences.erase(sequence);
+      }
     }
 
-    sequences[sequence.get()] = label;
-  }
+    foreachpair (int32_t sequence,
+                 Promise<bool>* cancelled,
+                 utils::copy(unowned)) {
+      if (!sequences.contains(sequence)) {
+        cancelled->set(false);
+        unowned.erase(sequence); // Okay since iterating over a copy.
+        delete cancelled;
+      } else {
+        current.insert(Group::Membership(
+            sequence, sequences[sequence], cancelled->future()));
+
+        sequences.erase(sequence);
+      }
+    }
 
-  // Cache current memberships, cancelling those that are now missing.
-  set<Group::Membership> current;
+    // Add any remaining (i.e., unexpected) sequences.
+    foreachpair (int32_t sequence, const Option<string>& label, sequences) {
+      Promise<bool>* cancelled = new Promise<bool>();
+      unowned[sequence] = cancelled;
+      current.insert(Group::Membership(sequence, label, cancelled->future()));
+    }
 
-  foreachpair (int32_t sequence, Promise<bool>* cancelled, utils::copy(owned)) {
-    if (!sequences.contains(sequence)) {
-      cancelled->set(false);
-      owned.erase(sequence); // Okay since iterating over a copy.
-      delete cancelled;
-    } else {
-      current.insert(Group::Membership(
-          sequence, sequences[sequence], cancelled->future()));
+    // Evict the data of the memberships which are not listed.
+    foreach (const string& basename, contents.keys()) {
+      if (!std::binary_search(results.begin(), results.end(), basename)) {
+        contents.erase(basename);
+      }
+    }
+  } else {
+    vector<string> removed;
+    std::set_difference(
+        children.get().begin(),
+        children.get().end(),
+        results.begin(),
+        results.end(),
+        std::back_inserter(removed));
+
+    vector<string> added;
+    std::set_difference(
+        results.begin(),
+        results.end(),
+        children.get().begin(),
+        children.get().end(),
+        std::back_inserter(added));
+
+    foreach (const string& result, removed) {
+      Try<pair<int32_t, Option<string> > > parsed = parse(result);
+      if (parsed.isError()) {
+        continue; // Not a membership, see above.
+      }
+
+      const int32_t sequence = parsed.get().first;
+
+      // NOTE: Memberships are compared by sequence only.
+      current.erase(
+          Group::Membership(sequence, None(), Future<bool>()));
+
+      contents.erase(result);
 
-      sequences.erase(sequence);
+      // NOTE: The membership is already gone from 'owned' if it was
+      // cancelled via this group.
+      std::map<int32_t, Promise<bool>*>* promises =
+        owned.count(sequence) > 0 ? &owned : &unowned;
+
+      if (promises->count(sequence) > 0) {
+        Promise<bool>* cancelled = (*promises)[sequence];
+        cancelled->set(false);
+        promises->erase(sequence);
+        delete cancelled;
+      }
     }
-  }
 
-  foreachpair (int32_t sequence,
-               Promise<bool>* cancelled,
-               utils::copy(unowned)) {
-    if (!sequences.contains(sequence)) {
-      cancelled->set(false);
-      unowned.erase(sequence); // Okay since iterating over a copy.
-      delete cancelled;
-    } else {
-      current.insert(Group::Membership(
-          sequence, sequences[sequence], cancelled->future()));
+    foreach (const string& result, added) {
+      Try<pair<int32_t, Option<string> > > parsed = parse(result);
+      if (parsed.isError()) {
+        VLOG(1) << "Found non-sequence node '" << result
+                << "' at '" << znode << "' in ZooKeeper";
+        continue;
+      }
 
-      sequences.erase(sequence);
+      const int32_t sequence = parsed.get().first;
+
+      Promise<bool>* cancelled = NULL;
+      if (owned.count(sequence) > 0) {
+        cancelled = owned[sequence];
+      } else if (unowned.count(sequence) > 0) {
+        cancelled = unowned[sequence];
+      } else {
+        cancelled = new Promise<bool>();
+        unowned[sequence] = cancelled;
+      }
+
+      current.insert(Group::Membership(
+          sequence, parsed.get().second, cancelled->future()));
     }
-  }
 
-  // Add any remaining (i.e., unexpected) sequences.
-  foreachpair (int32_t sequence, const Option<string>& label, sequences) {
-    Promise<bool>* cancelled = new Promise<bool>();
-    unowned[sequence] = cancelled;
-    current.insert(Group::Membership(sequence, label, cancelled->future()));
+    // Cancel the owned memberships which were removed before they
+    // were ever listed (there are only a handful of them).
+    foreachpair (int32_t sequence,
+                 Promise<bool>* cancelled,
+                 utils::copy(owned)) {
+      if (current.count(
+              Group::Membership(sequence, None(), Future<bool>())) == 0) {
+        cancelled->set(false);
+        owned.erase(sequence); // Okay since iterating over a copy.
+        delete cancelled;
+      }
+    }
   }
 
+  children = results;
   memberships = current;
 
   return true;
@@ -859,19 +1058,8 @@ Try<bool> GroupProcess::sync()
   }
 
   // Do datas.
-  while (!pending.datas.empty()) {
-    Data* data = pending.datas.front();
-    // TODO(benh): Ignore if future has been discarded?
-    Result<Option<string> > result = doData(data->membership);
-    if (result.isNone()) {
-      return false; // Try again later.
-    } else if (result.isError()) {
-      data->promise.fail(result.error());
-    } else {
-      data->promise.set(result.get());
-    }
-    pending.datas.pop();
-    delete data;
+  if (!doData()) {
+    return false; // Try again later.
   }
 
   // Get cache of memberships if we don't have one. Note that we do
@@ -894,6 +1082,25 @@ Try<bool> GroupProcess::sync()
 }
 
 
+void GroupProcess::fetch()
+{
+  fetching = false;
+
+  // The pending data requests are fetched by sync() otherwise.
+  if (error.isSome() || state != READY) {
+    return;
+  }
+
+  if (!doData() && !retrying) {
+    delay(jitter(RETRY_INTERVAL),
+          self(),
+          &GroupProcess::retry,
+          RETRY_INTERVAL);
+    retrying = true;
+  }
+}
+
+
 void GroupProcess::retry(const Duration& duration)
 {
   if (!retrying) {
@@ -922,7 +1129,7 @@ void GroupProcess::retry(const Duration& duration)
     // Backoff and keep retrying.
     retrying = true;
     Seconds seconds = std::min(duration * 2, Duration(Seconds(60)));
-    delay(seconds, self(), &GroupProcess::retry, seconds);
+    delay(jitter(seconds), self(), &GroupProcess::retry, seconds);
   }
 }
 
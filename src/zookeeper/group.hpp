@@ -22,6 +22,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "process/future.hpp"
 #include "process/timer.hpp"
@@ -29,6 +30,7 @@
 
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
@@ -214,7 +216,12 @@ private:
       const std::string& data,
       const Option<std::string>& label);
   Result<bool> doCancel(const Group::Membership& membership);
-  Result<Option<std::string> > doData(const Group::Membership& membership);
+
+  // Fetches the data of all the pending data requests, issuing a
+  // single batch of ZooKeeper requests for the memberships whose
+  // data is not cached. Returns false if the failure is retryable
+  // (in which case the remaining requests stay pending).
+  bool doData();
 
   // Returns true if authentication is successful, false if the
   // failure is retryable and Error otherwise.
@@ -239,6 +246,10 @@ private:
   // Updates any pending watches.
   void update();
 
+  // Fetches the data of the pending data requests (dispatched by
+  // data() so that the requests made in the meantime are batched).
+  void fetch();
+
   // Generic retry method. This mechanism is "generic" in the sense
   // that it is not specific to any particular operation, but rather
   // attempts to perform all pending operations (including caching
@@ -341,6 +352,22 @@ private:
   // cache and 'Some' represents a valid cache.
   Option<std::set<Group::Membership> > memberships;
 
+  // The (sorted) znodes of the last listing of the group and the
+  // memberships they represent. The next listing is diffed against
+  // them so that only the added and removed znodes get processed.
+  // 'None' means that all the memberships get reconciled with the
+  // next listing instead (e.g., after a session expiration).
+  Option<std::vector<std::string> > children;
+  std::set<Group::Membership> current;
+
+  // The data of the listed memberships, keyed by znode basename.
+  // Membership znodes are never updated so their data is cached
+  // once fetched until the membership is removed.
+  hashmap<std::string, std::string> contents;
+
+  // Indicates there is a pending (dispatched) fetch().
+  bool fetching;
+
   // The timer that determines whether we should quit waiting for the
   // connection to be restored.
   Option<process::Timer> timer;
@@ -19,11 +19,13 @@
 #include <stdint.h>
 
 #include <iostream>
+#include <list>
 #include <map>
 #include <tuple>
 
 #include <glog/logging.h>
 
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
@@ -41,6 +43,7 @@
 
 using namespace process;
 
+using std::list;
 using std::map;
 using std::string;
 using std::tuple;
@@ -333,6 +336,21 @@ public:
     return future;
   }
 
+  Future<list<int> > getAll(
+      const vector<string>& paths,
+      vector<string>* results)
+  {
+    CHECK_EQ(paths.size(), results->size());
+
+    list<Future<int> > futures;
+
+    for (size_t i = 0; i < paths.size(); i++) {
+      futures.push_back(get(paths[i], false, &(*results)[i], NULL));
+    }
+
+    return collect(futures);
+  }
+
   Future<int> getChildren(
       const string& path,
       bool watch,
@@ -618,6 +636,31 @@ int ZooKeeper::get(const string& path, bool watch, string* result, Stat* stat)
 }
 
 
+int ZooKeeper::get(
+    const vector<string>& paths,
+    vector<string>* results,
+    vector<int>* codes)
+{
+  results->assign(paths.size(), string());
+
+  const list<int> returned = dispatch(
+      process,
+      &ZooKeeperProcess::getAll,
+      paths,
+      results).get();
+
+  codes->assign(returned.begin(), returned.end());
+
+  foreach (int code, returned) {
+    if (code != ZOK) {
+      return code;
+    }
+  }
+
+  return ZOK;
+}
+
+
 int ZooKeeper::getChildren(
     const string& path,
     bool watch,
@@ -263,6 +263,27 @@ public:
       std::string* result,
       Stat* stat);
 
+  /**
+   * \brief gets the data associated with several nodes.
+   *
+   * All the requests are issued at once (i.e., they are pipelined
+   * over the connection) so that fetching the data of many nodes
+   * only costs about a single round trip to the server.
+   *
+   * \param paths the names of the nodes. Expressed as file names with
+   *    slashes separating ancestors of the nodes.
+   * \param results the data returned by the server for each node (in
+   *    the same order as the paths).
+   * \param codes the return code of the request for each node (in the
+   *    same order as the paths), see above for the possible values.
+   * \return ZOK if all the requests completed successfully, otherwise
+   *    the first return code which is not ZOK.
+   */
+  int get(
+      const std::vector<std::string>& paths,
+      std::vector<std::string>* results,
+      std::vector<int>* codes);
+
   /**
    * \brief lists the children of a node synchronously.
    *